@@ -5,15 +5,22 @@
 #include <bench/bench.h>
 #include <blockfilter.h>
 
-static void ConstructGCSFilter(benchmark::Bench& bench)
+static GCSFilter::ElementSet GenerateGCSTestElements(int count, unsigned char tag = 0)
 {
     GCSFilter::ElementSet elements;
-    for (int i = 0; i < 10000; ++i) {
+    for (int i = 0; i < count; ++i) {
         GCSFilter::Element element(32);
         element[0] = static_cast<unsigned char>(i);
         element[1] = static_cast<unsigned char>(i >> 8);
+        element[2] = tag;
         elements.insert(std::move(element));
     }
+    return elements;
+}
+
+static void ConstructGCSFilter(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
 
     uint64_t siphash_k0 = 0;
     bench.batch(elements.size()).unit("elem").run([&] {
@@ -23,15 +30,32 @@ static void ConstructGCSFilter(benchmark::Bench& bench)
     });
 }
 
+static void DecodeGCSFilter(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+    const std::vector<unsigned char>& encoded = filter.GetEncoded();
+
+    bench.batch(elements.size()).unit("elem").run([&] {
+        // Reconstructing from an untrusted encoding decodes every element.
+        GCSFilter decoded(filter.GetParams(), encoded);
+    });
+}
+
+static void DecodeGCSFilterElementHashes(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+
+    bench.batch(elements.size()).unit("elem").run([&] {
+        std::vector<uint64_t> hashes = filter.DecodeElementHashes();
+        assert(hashes.size() == elements.size());
+    });
+}
+
 static void MatchGCSFilter(benchmark::Bench& bench)
 {
-    GCSFilter::ElementSet elements;
-    for (int i = 0; i < 10000; ++i) {
-        GCSFilter::Element element(32);
-        element[0] = static_cast<unsigned char>(i);
-        element[1] = static_cast<unsigned char>(i >> 8);
-        elements.insert(std::move(element));
-    }
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
     GCSFilter filter({0, 0, 20, 1 << 20}, elements);
 
     bench.unit("elem").run([&] {
@@ -39,5 +63,33 @@ static void MatchGCSFilter(benchmark::Bench& bench)
     });
 }
 
+static void MatchAnyGCSFilter(benchmark::Bench& bench)
+{
+    // A wallet-sized query set against a large block's filter, mostly not matching.
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
+    GCSFilter::ElementSet queries = GenerateGCSTestElements(1000, 1);
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+
+    bench.batch(queries.size()).unit("elem").run([&] {
+        filter.MatchAny(queries);
+    });
+}
+
+static void MatchAnyDecodedGCSFilter(benchmark::Bench& bench)
+{
+    GCSFilter::ElementSet elements = GenerateGCSTestElements(10000);
+    GCSFilter::ElementSet queries = GenerateGCSTestElements(1000, 1);
+    GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+    const std::vector<uint64_t> hashes = filter.DecodeElementHashes();
+
+    bench.batch(queries.size()).unit("elem").run([&] {
+        filter.MatchAny(queries, hashes);
+    });
+}
+
 BENCHMARK(ConstructGCSFilter);
+BENCHMARK(DecodeGCSFilter);
+BENCHMARK(DecodeGCSFilterElementHashes);
 BENCHMARK(MatchGCSFilter);
+BENCHMARK(MatchAnyGCSFilter);
+BENCHMARK(MatchAnyDecodedGCSFilter);
@@ -0,0 +1,82 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <consensus/params.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <primitives/transaction.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <test_framework/TxBuilder.h>
+
+/** Number of transactions checked */
+static constexpr size_t NUM_TXS = 10000;
+/** Every MWEB_INTERVAL-th transaction is an MWEB transaction, the others are transparent */
+static constexpr size_t MWEB_INTERVAL = 5;
+
+/** Create transactions to check, and add the coins that the transparent ones spend to the chainstate */
+static std::vector<CTransactionRef> CreateTransactions(const CKey& key)
+{
+    const CScript script_pubkey = GetScriptForRawPubKey(key.GetPubKey());
+    std::vector<CTransactionRef> txs;
+    txs.reserve(NUM_TXS);
+    for (size_t i = 0; i < NUM_TXS; ++i) {
+        CMutableTransaction tx;
+        if (i % MWEB_INTERVAL == 0) {
+            tx.mweb_tx = MWEB::Tx(test::TxBuilder().AddInput(10000).AddOutput(9000).AddPlainKernel(1000).Build().GetTransaction());
+            txs.push_back(MakeTransactionRef(std::move(tx)));
+            continue;
+        }
+
+        const COutPoint prevout{InsecureRand256(), 0};
+        WITH_LOCK(cs_main, ::ChainstateActive().CoinsTip().AddCoin(prevout, Coin(CTxOut(COIN, script_pubkey), 1, false, false), false));
+        tx.vin.emplace_back(prevout);
+        tx.vout.emplace_back(COIN - 1000, script_pubkey);
+
+        std::vector<unsigned char> sig;
+        const uint256 hash = SignatureHash(script_pubkey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        assert(key.Sign(hash, sig));
+        sig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << sig;
+        txs.push_back(MakeTransactionRef(std::move(tx)));
+    }
+    return txs;
+}
+
+static void MempoolPreCheck(benchmark::Bench& bench, bool parallel)
+{
+    const std::string activate_mweb = strprintf("-vbparams=mweb:%d:%d", int64_t{Consensus::BIP9Deployment::ALWAYS_ACTIVE}, int64_t{Consensus::BIP9Deployment::NO_TIMEOUT});
+    TestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */ {
+            "-nodebuglogfile",
+            "-nodebug",
+            activate_mweb.c_str(),
+        },
+    };
+    CKey key;
+    key.MakeNewKey(true);
+    const std::vector<CTransactionRef> txs = CreateTransactions(key);
+
+    // Signatures and MWEB proofs are cached once verified, so check each transaction once
+    g_parallel_tx_prechecks = parallel;
+    bench.epochs(1).epochIterations(1).run([&] {
+        for (const TxValidationState& state : PreCheckTransactions(*test_setup.m_node.mempool, txs)) {
+            assert(state.IsValid());
+        }
+    });
+    g_parallel_tx_prechecks = true;
+}
+
+static void MempoolPreCheckSerial(benchmark::Bench& bench) { MempoolPreCheck(bench, false); }
+static void MempoolPreCheckParallel(benchmark::Bench& bench) { MempoolPreCheck(bench, true); }
+
+BENCHMARK(MempoolPreCheckSerial);
+BENCHMARK(MempoolPreCheckParallel);
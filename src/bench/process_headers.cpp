@@ -0,0 +1,69 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <pow.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+#include <versionbits.h>
+
+/** Number of headers in a full headers message */
+static constexpr size_t NUM_HEADERS = 2000;
+/** Number of distinct header chains to process, one per epoch */
+static constexpr size_t NUM_CHAINS = 10;
+
+static std::vector<CBlockHeader> CreateHeaderChain(const CChainParams& chainparams, uint32_t time_offset)
+{
+    const Consensus::Params& consensus = chainparams.GetConsensus();
+    // Space the headers far enough apart that regtest allows minimum difficulty for all of them
+    const int64_t spacing = consensus.nPowTargetSpacing * 2 + 1;
+
+    std::vector<CBlockHeader> headers(NUM_HEADERS);
+    uint256 prev_hash = chainparams.GenesisBlock().GetHash();
+    uint32_t time = chainparams.GenesisBlock().nTime + time_offset;
+    for (CBlockHeader& header : headers) {
+        header.nVersion = VERSIONBITS_TOP_BITS;
+        header.hashPrevBlock = prev_hash;
+        header.hashMerkleRoot = uint256{};
+        header.nTime = time += spacing;
+        header.nBits = UintToArith256(consensus.powLimit).GetCompact();
+        header.nNonce = 0;
+        while (!CheckProofOfWork(header.GetPoWHash(), header.nBits, consensus)) {
+            ++header.nNonce;
+        }
+        prev_hash = header.GetHash();
+    }
+    return headers;
+}
+
+static void ProcessHeaders(benchmark::Bench& bench)
+{
+    TestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */ {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    const CChainParams& chainparams = Params();
+
+    // Every chain forks off genesis, so that each epoch validates new headers.
+    std::vector<std::vector<CBlockHeader>> chains;
+    for (size_t i = 0; i < NUM_CHAINS; ++i) {
+        chains.push_back(CreateHeaderChain(chainparams, i));
+    }
+
+    size_t next_chain = 0;
+    bench.epochs(NUM_CHAINS).epochIterations(1).run([&] {
+        assert(next_chain < chains.size());
+        BlockValidationState state;
+        bool result = test_setup.m_node.chainman->ProcessNewBlockHeaders(chains[next_chain++], state, chainparams);
+        assert(result);
+    });
+}
+
+BENCHMARK(ProcessHeaders);
@@ -0,0 +1,63 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <crypto/sha256.h>
+#include <rpc/executor.h>
+#include <rpc/server.h>
+#include <util/ref.h>
+#include <util/system.h>
+
+#include <univalue.h>
+
+static const int BATCH_SIZE = 1000;
+static const int HASHES_PER_CALL = 200;
+
+// A stand-in for a lookup like gettxout: a bit of CPU work per call.
+static bool BenchHash(const JSONRPCRequest& request, UniValue& result, bool)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE] = {};
+    const int seed = request.params[0].get_int();
+    CSHA256().Write((const unsigned char*)&seed, sizeof(seed)).Finalize(hash);
+    for (int i = 0; i < HASHES_PER_CALL; ++i) {
+        CSHA256().Write(hash, sizeof(hash)).Finalize(hash);
+    }
+    result = UniValue(hash[0]);
+    return true;
+}
+
+static void RpcBatch(benchmark::Bench& bench, int threads)
+{
+    static const CRPCCommand command("hidden", "benchhash", BenchHash, {"seed"}, 0);
+    tableRPC.appendCommand("benchhash", &command);
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+        UniValue params(UniValue::VARR);
+        params.push_back(i);
+        batch.push_back(JSONRPCRequestObj("benchhash", params, i));
+    }
+
+    util::Ref context;
+    const JSONRPCRequest jreq(context);
+    RPCBatchExecutor executor(threads);
+    bench.run([&] {
+        (void)JSONRPCExecBatch(jreq, batch, threads > 1 ? &executor : nullptr);
+    });
+    tableRPC.removeCommand("benchhash", &command);
+}
+
+static void RpcBatchSequential(benchmark::Bench& bench)
+{
+    RpcBatch(bench, 1);
+}
+
+static void RpcBatchParallel(benchmark::Bench& bench)
+{
+    RpcBatch(bench, GetNumCores());
+}
+
+BENCHMARK(RpcBatchSequential);
+BENCHMARK(RpcBatchParallel);
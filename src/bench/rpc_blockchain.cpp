@@ -6,12 +6,23 @@
 #include <bench/data.h>
 
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <streams.h>
+#include <test/util/setup_common.h>
 #include <validation.h>
 
 #include <univalue.h>
 
-static void BlockToJsonVerbose(benchmark::Bench& bench)
+namespace {
+/** Discards the output, like a client that keeps up with the stream */
+class NullSink final : public JSONStreamSink
+{
+public:
+    void Write(std::string&& chunk) override {}
+};
+} // namespace
+
+static CBlock ReadBenchBlock()
 {
     CDataStream stream(benchmark::data::block413567, SER_NETWORK, PROTOCOL_VERSION);
     char a = '\0';
@@ -19,15 +30,40 @@ static void BlockToJsonVerbose(benchmark::Bench& bench)
 
     CBlock block;
     stream >> block;
+    return block;
+}
+
+static void BlockToJsonVerbose(benchmark::Bench& bench)
+{
+    const BasicTestingSetup testing_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+    const CBlock block = ReadBenchBlock();
+
+    CBlockIndex blockindex;
+    const uint256 blockHash = block.GetHash();
+    blockindex.phashBlock = &blockHash;
+    blockindex.nBits = 403014710;
+
+    bench.run([&] {
+        (void)blockToJSON(block, &blockindex, &blockindex, /*verbose*/ true).write();
+    });
+}
+
+static void BlockToJsonVerboseStream(benchmark::Bench& bench)
+{
+    const BasicTestingSetup testing_setup{CBaseChainParams::MAIN, {"-nodebuglogfile", "-nodebug"}};
+    const CBlock block = ReadBenchBlock();
 
     CBlockIndex blockindex;
     const uint256 blockHash = block.GetHash();
     blockindex.phashBlock = &blockHash;
     blockindex.nBits = 403014710;
 
+    NullSink sink;
     bench.run([&] {
-        (void)blockToJSON(block, &blockindex, &blockindex, /*verbose*/ true);
+        JSONWriter writer(sink);
+        blockToJSON(writer, block, &blockindex, &blockindex);
     });
 }
 
 BENCHMARK(BlockToJsonVerbose);
+BENCHMARK(BlockToJsonVerboseStream);
@@ -4,6 +4,7 @@
 
 #include <bench/bench.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <txmempool.h>
 
 #include <univalue.h>
@@ -15,9 +16,8 @@ static void AddTx(const CTransactionRef& tx, const CAmount& fee, CTxMemPool& poo
     pool.addUnchecked(CTxMemPoolEntry(tx, fee, /* time */ 0, /* height */ 1, /* spendsCoinbase */ false, /* sigOpCost */ 4, lp));
 }
 
-static void RpcMempool(benchmark::Bench& bench)
+static void FillMempool(CTxMemPool& pool)
 {
-    CTxMemPool pool;
     LOCK2(cs_main, pool.cs);
 
     for (int i = 0; i < 1000; ++i) {
@@ -31,10 +31,38 @@ static void RpcMempool(benchmark::Bench& bench)
         const CTransactionRef tx_r{MakeTransactionRef(tx)};
         AddTx(tx_r, /* fee */ i, pool);
     }
+}
+
+static void RpcMempool(benchmark::Bench& bench)
+{
+    CTxMemPool pool;
+    FillMempool(pool);
+
+    bench.run([&] {
+        (void)MempoolToJSON(pool, /*verbose*/ true).write();
+    });
+}
+
+namespace {
+/** Discards the output, like a client that keeps up with the stream */
+class NullSink final : public JSONStreamSink
+{
+public:
+    void Write(std::string&& chunk) override {}
+};
+} // namespace
+
+static void RpcMempoolStream(benchmark::Bench& bench)
+{
+    CTxMemPool pool;
+    FillMempool(pool);
 
+    NullSink sink;
     bench.run([&] {
-        (void)MempoolToJSON(pool, /*verbose*/ true);
+        JSONWriter writer(sink);
+        MempoolToJSON(writer, pool);
     });
 }
 
 BENCHMARK(RpcMempool);
+BENCHMARK(RpcMempoolStream);
@@ -0,0 +1,94 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <compat.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <test/util/net.h>
+#include <test/util/setup_common.h>
+#include <util/system.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+static constexpr int NUM_SIMULATED_PEERS = 1000;
+// Only a few peers are active at a time, which is typical for a node with many connections.
+static constexpr int ACTIVE_PEER_INTERVAL = 10;
+
+/**
+ * Simulate many connected peers over socketpairs and measure how long the
+ * socket handler takes to pick up a ping from every tenth peer.
+ */
+static void SocketEvents(benchmark::Bench& bench, bool use_epoll)
+{
+    const BasicTestingSetup testing_setup{CBaseChainParams::REGTEST, {"-nodebuglogfile", "-nodebug"}};
+
+    const int available_fds = RaiseFileDescriptorLimit(2 * NUM_SIMULATED_PEERS + 64);
+    const int num_peers = std::min(NUM_SIMULATED_PEERS, (available_fds - 64) / 2);
+    assert(num_peers > 0);
+
+    ConnmanTestMsg connman{0x1337, 0x1337};
+    CConnman::Options options;
+    options.nReceiveFloodSize = std::numeric_limits<unsigned int>::max();
+    options.m_peer_connect_timeout = std::numeric_limits<int64_t>::max();
+    options.m_use_epoll = use_epoll;
+    connman.InitSocketEvents(options);
+
+    std::vector<CNode*> nodes;
+    std::vector<int> remote_fds;
+    for (int i = 0; i < num_peers; ++i) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) break;
+        CNode* node = new CNode(i, NODE_NETWORK, 0, fds[0], CAddress(), 0, 0, CAddress(), "", ConnectionType::INBOUND);
+        connman.AddSocketTestNode(*node);
+        nodes.push_back(node);
+        remote_fds.push_back(fds[1]);
+    }
+
+    CSerializedNetMsg ping = CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::PING, uint64_t{0});
+    std::vector<unsigned char> ping_bytes;
+    V1TransportSerializer().prepareForTransport(ping, ping_bytes);
+    ping_bytes.insert(ping_bytes.end(), ping.data.begin(), ping.data.end());
+
+    bench.batch(nodes.size() / ACTIVE_PEER_INTERVAL).unit("msg").run([&] {
+        size_t expected = 0;
+        for (size_t i = 0; i < remote_fds.size(); i += ACTIVE_PEER_INTERVAL) {
+            assert(write(remote_fds[i], ping_bytes.data(), ping_bytes.size()) == (ssize_t)ping_bytes.size());
+            ++expected;
+        }
+        size_t received = 0;
+        while (received < expected) {
+            connman.SocketHandlerOnce();
+            received = 0;
+            for (size_t i = 0; i < nodes.size(); i += ACTIVE_PEER_INTERVAL) {
+                LOCK(nodes[i]->cs_vProcessMsg);
+                received += nodes[i]->vProcessMsg.size();
+            }
+        }
+        for (CNode* node : nodes) {
+            LOCK(node->cs_vProcessMsg);
+            node->vProcessMsg.clear();
+            node->nProcessQueueSize = 0;
+        }
+    });
+
+    connman.ClearTestNodes();
+    for (int fd : remote_fds) {
+        close(fd);
+    }
+}
+
+#ifdef USE_EPOLL
+static void SocketEventsEpoll(benchmark::Bench& bench) { SocketEvents(bench, true); }
+BENCHMARK(SocketEventsEpoll);
+#endif
+#ifdef USE_POLL
+static void SocketEventsPoll(benchmark::Bench& bench) { SocketEvents(bench, false); }
+BENCHMARK(SocketEventsPoll);
+#endif
@@ -0,0 +1,90 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockdownload.h>
+
+#include <algorithm>
+#include <cmath>
+
+/** Weight of a new measurement in the moving averages. */
+static constexpr double MEASUREMENT_WEIGHT = 0.125;
+/** Lower bound of a measured service time, as blocks can be delivered back to back. */
+static constexpr std::chrono::microseconds MIN_SERVICE_TIME{1000};
+
+static double ToSeconds(std::chrono::microseconds time) { return time.count() * 1e-6; }
+
+void BlockDownloadScheduler::DisconnectedPeer(NodeId peer)
+{
+    m_peers.erase(peer);
+}
+
+void BlockDownloadScheduler::SetRoundTripTime(NodeId peer, std::chrono::microseconds rtt)
+{
+    m_peers[peer].rtt = rtt;
+}
+
+void BlockDownloadScheduler::BlockReceived(NodeId peer, size_t block_size, std::chrono::microseconds requested_time, std::chrono::microseconds now)
+{
+    PeerInfo& info = m_peers[peer];
+    // With several blocks in flight the peer only starts serving a block after
+    // delivering the previous one, so that's where its service time starts.
+    const std::chrono::microseconds start = std::max(requested_time, info.last_received);
+    const double service_time = ToSeconds(std::max(now - start, MIN_SERVICE_TIME));
+    if (info.avg_service_time == 0) {
+        info.avg_size = block_size;
+        info.avg_service_time = service_time;
+    } else {
+        info.avg_size += MEASUREMENT_WEIGHT * (block_size - info.avg_size);
+        info.avg_service_time += MEASUREMENT_WEIGHT * (service_time - info.avg_service_time);
+    }
+    info.last_received = std::max(info.last_received, now);
+    ++info.blocks_received;
+}
+
+void BlockDownloadScheduler::BlocksReassigned(NodeId peer, size_t count)
+{
+    PeerInfo& info = m_peers[peer];
+    // Halve the estimated rate, and with it the quota.
+    if (info.avg_service_time == 0) {
+        info.avg_service_time = ToSeconds(DEFAULT_BLOCK_STALL_TIMEOUT);
+    } else {
+        info.avg_service_time *= 2;
+    }
+    info.blocks_reassigned += count;
+}
+
+int BlockDownloadScheduler::ComputeQuota(const PeerInfo& info)
+{
+    if (info.avg_service_time == 0) return DEFAULT_BLOCKS_IN_TRANSIT_QUOTA;
+    const double blocks = std::ceil(ToSeconds(info.rtt + BLOCK_DOWNLOAD_BUFFER_TIME) / info.avg_service_time);
+    return (int)std::max<double>(MIN_BLOCKS_IN_TRANSIT_QUOTA, std::min<double>(MAX_BLOCKS_IN_TRANSIT_QUOTA, blocks));
+}
+
+int BlockDownloadScheduler::GetQuota(NodeId peer) const
+{
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end()) return DEFAULT_BLOCKS_IN_TRANSIT_QUOTA;
+    return ComputeQuota(it->second);
+}
+
+std::chrono::microseconds BlockDownloadScheduler::GetStallTimeout(NodeId peer) const
+{
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end() || it->second.avg_service_time == 0) return DEFAULT_BLOCK_STALL_TIMEOUT;
+    const PeerInfo& info = it->second;
+    const std::chrono::microseconds expected = info.rtt + std::chrono::microseconds{std::llround(info.avg_service_time * 1e6)};
+    return std::min(DEFAULT_BLOCK_STALL_TIMEOUT, std::max(MIN_BLOCK_STALL_TIMEOUT, BLOCK_STALL_FACTOR * expected));
+}
+
+bool BlockDownloadScheduler::GetStats(NodeId peer, BlockDownloadStats& stats) const
+{
+    auto it = m_peers.find(peer);
+    if (it == m_peers.end()) return false;
+    const PeerInfo& info = it->second;
+    stats.bytes_per_second = info.avg_service_time == 0 ? 0 : info.avg_size / info.avg_service_time;
+    stats.quota = ComputeQuota(info);
+    stats.blocks_received = info.blocks_received;
+    stats.blocks_reassigned = info.blocks_reassigned;
+    return true;
+}
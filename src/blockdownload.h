@@ -0,0 +1,98 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKDOWNLOAD_H
+#define BITCOIN_BLOCKDOWNLOAD_H
+
+#include <net.h> // For NodeId
+
+#include <chrono>
+#include <map>
+
+#include <stdint.h>
+
+/** Number of blocks that can be in flight from a peer we have no measurements for yet. */
+static constexpr int DEFAULT_BLOCKS_IN_TRANSIT_QUOTA = 16;
+/** Lower bound of the in-flight quota, so that slow peers still contribute. */
+static constexpr int MIN_BLOCKS_IN_TRANSIT_QUOTA = 2;
+/** Upper bound of the in-flight quota, to limit the damage a peer that stops responding can do. */
+static constexpr int MAX_BLOCKS_IN_TRANSIT_QUOTA = 64;
+/** How much data, in time at the peer's delivery rate, to keep queued beyond the round trip time. */
+static constexpr std::chrono::microseconds BLOCK_DOWNLOAD_BUFFER_TIME{std::chrono::seconds{1}};
+/** A block taking this many times longer than expected is considered stalled. */
+static constexpr int BLOCK_STALL_FACTOR = 4;
+/** Minimum time before a block is considered stalled. */
+static constexpr std::chrono::microseconds MIN_BLOCK_STALL_TIMEOUT{std::chrono::seconds{2}};
+/** Time before a block is considered stalled for peers without delivery measurements, and the upper bound
+ *  for peers with measurements, so that a peer that stopped responding can't hold up blocks for long. */
+static constexpr std::chrono::microseconds DEFAULT_BLOCK_STALL_TIMEOUT{std::chrono::seconds{10}};
+
+struct BlockDownloadStats {
+    //! Estimated rate at which the peer delivers requested blocks, or 0 if unknown.
+    double bytes_per_second{0};
+    //! Number of blocks that can be in flight from the peer.
+    int quota{DEFAULT_BLOCKS_IN_TRANSIT_QUOTA};
+    uint64_t blocks_received{0};
+    //! Number of blocks that were taken away from the peer and requested elsewhere.
+    uint64_t blocks_reassigned{0};
+};
+
+/** Measures how fast each peer delivers the blocks we request, to decide how
+ *  many blocks to keep in flight from it, and when a block it is slow to deliver
+ *  should be requested from another peer instead.
+ *
+ *  A peer's delivery rate is estimated from the time it took to serve each
+ *  block: the time from the later of the request and the previous delivery to
+ *  the delivery of the block. The in-flight quota is the number of blocks that
+ *  covers the round trip time plus BLOCK_DOWNLOAD_BUFFER_TIME at that rate (the
+ *  bandwidth-delay product), so that fast peers are kept busy and slow peers
+ *  don't hold on to blocks that everyone else is waiting for.
+ *
+ *  Times are passed in by the caller, so that the scheduler can be simulated.
+ */
+class BlockDownloadScheduler
+{
+public:
+    /** Forget everything about a peer. */
+    void DisconnectedPeer(NodeId peer);
+
+    /** Set the round trip time to a peer, e.g. its minimum ping time. */
+    void SetRoundTripTime(NodeId peer, std::chrono::microseconds rtt);
+
+    /** A block requested at requested_time was received from the peer at time now. */
+    void BlockReceived(NodeId peer, size_t block_size, std::chrono::microseconds requested_time, std::chrono::microseconds now);
+
+    /** Blocks in flight from the peer are being requested from other peers, because they stalled. */
+    void BlocksReassigned(NodeId peer, size_t count);
+
+    /** Number of blocks that can be in flight from the peer. */
+    int GetQuota(NodeId peer) const;
+
+    /** Time after which the block at the front of a peer's queue is considered stalled. */
+    std::chrono::microseconds GetStallTimeout(NodeId peer) const;
+
+    /** Get the download statistics of a peer. Returns false if nothing is known about it. */
+    bool GetStats(NodeId peer, BlockDownloadStats& stats) const;
+
+    /** Number of peers tracked. */
+    size_t Size() const { return m_peers.size(); }
+
+private:
+    struct PeerInfo {
+        std::chrono::microseconds rtt{0};
+        //! Moving averages of the size of the blocks delivered and the time taken to serve them.
+        //! A zero avg_service_time means there are no measurements yet.
+        double avg_size{0};
+        double avg_service_time{0}; // in seconds
+        std::chrono::microseconds last_received{0};
+        uint64_t blocks_received{0};
+        uint64_t blocks_reassigned{0};
+    };
+
+    static int ComputeQuota(const PeerInfo& info);
+
+    std::map<NodeId, PeerInfo> m_peers;
+};
+
+#endif // BITCOIN_BLOCKDOWNLOAD_H
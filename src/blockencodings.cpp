@@ -8,12 +8,15 @@
 #include <chainparams.h>
 #include <crypto/sha256.h>
 #include <crypto/siphash.h>
+#include <mw/consensus/Params.h>
+#include <mw/mmr/MMR.h>
 #include <random.h>
 #include <streams.h>
 #include <txmempool.h>
 #include <validation.h>
 #include <util/system.h>
 
+#include <set>
 #include <unordered_map>
 
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID) :
@@ -34,6 +37,16 @@ CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, bool f
             shorttxids.push_back(GetShortID(fUseWTXID ? tx.GetWitnessHash() : tx.GetHash()));
         }
     }
+
+    // MWEB: Kernel short IDs, for peers that reconstruct the MWEB block from their mempool
+    if (!mweb_block.IsNull()) {
+        mweb_header = mweb_block.GetMWEBHeader();
+        const std::vector<Kernel>& kernels = mweb_block.m_block->GetKernels();
+        mweb_shortids.reserve(kernels.size());
+        for (const Kernel& kernel : kernels) {
+            mweb_shortids.push_back(GetMWEBShortID(kernel.GetKernelID()));
+        }
+    }
 }
 
 void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const {
@@ -52,6 +65,10 @@ uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+uint64_t CBlockHeaderAndShortTxIDs::GetMWEBShortID(const mw::Hash& kernel_id) const {
+    return GetShortID(uint256(kernel_id.vec()));
+}
+
 
 
 ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
@@ -172,11 +189,72 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
             break;
     }
 
+    ReadStatus mweb_status = InitMWEBData(cmpctblock, extra_txn);
+    if (mweb_status != READ_STATUS_OK) return mweb_status;
+
     LogPrint(BCLog::CMPCTBLOCK, "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu\n", cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock, PROTOCOL_VERSION));
 
     return READ_STATUS_OK;
 }
 
+ReadStatus PartiallyDownloadedBlock::InitMWEBData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn) {
+    if (cmpctblock.mweb_header == nullptr) return READ_STATUS_OK;
+    if (cmpctblock.mweb_shortids.size() > mw::MAX_BLOCK_WEIGHT / mw::BASE_KERNEL_WEIGHT)
+        return READ_STATUS_INVALID;
+    if (!cmpctblock.mweb_block.IsNull() || cmpctblock.mweb_header->GetNumKernels() != cmpctblock.mweb_shortids.size())
+        return READ_STATUS_INVALID;
+
+    mweb_header = cmpctblock.mweb_header;
+    mweb_shortids = cmpctblock.mweb_shortids;
+    mweb_txn_available.resize(mweb_shortids.size());
+
+    // Same approach as for the transaction short IDs above, but keyed by the kernel IDs of
+    // the MWEB transactions. A transaction with several kernels fills several positions.
+    std::unordered_map<uint64_t, uint32_t> kernel_shortids(mweb_shortids.size());
+    for (size_t i = 0; i < mweb_shortids.size(); i++) {
+        kernel_shortids[mweb_shortids[i]] = i;
+        if (kernel_shortids.bucket_size(kernel_shortids.bucket(mweb_shortids[i])) > 12)
+            return READ_STATUS_FAILED;
+    }
+    if (kernel_shortids.size() != mweb_shortids.size())
+        return READ_STATUS_FAILED; // Short ID collision
+
+    std::vector<bool> have_kernel(mweb_shortids.size());
+    auto add_mweb_tx = [&](const CTransaction& tx, bool from_extra) {
+        if (!tx.HasMWEBTx()) return;
+        const mw::Transaction::CPtr& mweb_tx = tx.mweb_tx.m_transaction;
+        for (const Kernel& kernel : mweb_tx->GetKernels()) {
+            auto idit = kernel_shortids.find(cmpctblock.GetMWEBShortID(kernel.GetKernelID()));
+            if (idit == kernel_shortids.end()) continue;
+
+            mw::Transaction::CPtr& available = mweb_txn_available[idit->second];
+            if (!have_kernel[idit->second]) {
+                available = mweb_tx;
+                have_kernel[idit->second] = true;
+                mweb_mempool_count++;
+                if (from_extra) extra_count++;
+            } else if (available && available->GetHash() != mweb_tx->GetHash()) {
+                // Two different transactions match the short ID, so request it instead.
+                available.reset();
+                mweb_mempool_count--;
+            }
+        }
+    };
+
+    {
+    LOCK(pool->cs);
+    for (size_t i = 0; i < pool->vTxHashes.size() && mweb_mempool_count < mweb_shortids.size(); i++) {
+        add_mweb_tx(pool->vTxHashes[i].second->GetTx(), false);
+    }
+    }
+
+    for (size_t i = 0; i < extra_txn.size() && mweb_mempool_count < mweb_shortids.size(); i++) {
+        add_mweb_tx(*extra_txn[i].second, true);
+    }
+
+    return READ_STATUS_OK;
+}
+
 bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
 {
     if (header.IsNull()) return false;
@@ -185,7 +263,74 @@ bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
     return txn_available[index] != nullptr;
 }
 
-ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing)
+bool PartiallyDownloadedBlock::IsMWEBKernelAvailable(size_t index) const
+{
+    if (header.IsNull()) return false;
+
+    assert(index < mweb_txn_available.size());
+    return mweb_txn_available[index] != nullptr;
+}
+
+ReadStatus PartiallyDownloadedBlock::FillMWEBBlock(MWEB::Block& block, const std::vector<mw::Transaction::CPtr>& mweb_txn_missing, const MWEB::Block& mweb_block_missing) const
+{
+    if (!mweb_block_missing.IsNull()) {
+        // The sender did not have all requested transactions, and sent us the whole MWEB block.
+        if (!mweb_txn_missing.empty() || mweb_block_missing.GetMWEBHeader()->GetHash() != mweb_header->GetHash())
+            return READ_STATUS_INVALID;
+        block = mweb_block_missing;
+        return READ_STATUS_OK;
+    }
+
+    // The MWEB block body is the aggregate of its transactions, without cut-through,
+    // so it can be rebuilt by merging the transactions' sorted inputs, outputs and kernels.
+    std::set<mw::Hash> tx_hashes;
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Kernel> kernels;
+    auto add_mweb_tx = [&](const mw::Transaction::CPtr& mweb_tx) {
+        if (!tx_hashes.insert(mweb_tx->GetHash()).second) return;
+        inputs.insert(inputs.end(), mweb_tx->GetInputs().cbegin(), mweb_tx->GetInputs().cend());
+        outputs.insert(outputs.end(), mweb_tx->GetOutputs().cbegin(), mweb_tx->GetOutputs().cend());
+        kernels.insert(kernels.end(), mweb_tx->GetKernels().cbegin(), mweb_tx->GetKernels().cend());
+    };
+
+    bool missing = false;
+    for (const mw::Transaction::CPtr& mweb_tx : mweb_txn_available) {
+        if (mweb_tx) {
+            add_mweb_tx(mweb_tx);
+        } else {
+            missing = true;
+        }
+    }
+    if (missing && mweb_txn_missing.empty())
+        return READ_STATUS_INVALID;
+    for (const mw::Transaction::CPtr& mweb_tx : mweb_txn_missing) {
+        if (!mweb_tx) return READ_STATUS_INVALID;
+        add_mweb_tx(mweb_tx);
+    }
+
+    std::sort(inputs.begin(), inputs.end(), InputSort);
+    std::sort(outputs.begin(), outputs.end(), OutputSort);
+    std::sort(kernels.begin(), kernels.end(), KernelSort);
+
+    // The header commits to the kernels, so a mismatch means we picked up the wrong
+    // transactions (or the sender sent the wrong ones). Full validation of the body
+    // happens with the rest of the block.
+    if (kernels.size() != mweb_header->GetNumKernels())
+        return READ_STATUS_FAILED;
+    MemMMR kernel_mmr;
+    for (const Kernel& kernel : kernels) {
+        kernel_mmr.Add(kernel);
+    }
+    if (kernel_mmr.Root() != mweb_header->GetKernelRoot())
+        return READ_STATUS_FAILED;
+
+    block = MWEB::Block(std::make_shared<mw::Block>(mweb_header, TxBody(std::move(inputs), std::move(outputs), std::move(kernels))));
+    return READ_STATUS_OK;
+}
+
+ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing,
+                                               const std::vector<mw::Transaction::CPtr>& mweb_txn_missing, const MWEB::Block& mweb_block_missing)
 {
     if (header.IsNull()) return READ_STATUS_INVALID;
 
@@ -211,6 +356,15 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     if (vtx_missing.size() != tx_missing_offset)
         return READ_STATUS_INVALID;
 
+    if (mweb_header != nullptr) {
+        ReadStatus mweb_status = FillMWEBBlock(block.mweb_block, mweb_txn_missing, mweb_block_missing);
+        mweb_header.reset();
+        mweb_txn_available.clear();
+        if (mweb_status != READ_STATUS_OK) return mweb_status;
+    } else if (!mweb_txn_missing.empty() || !mweb_block_missing.IsNull()) {
+        return READ_STATUS_INVALID;
+    }
+
     BlockValidationState state;
     CheckBlockFn check_block = m_check_block_mock ? m_check_block_mock : CheckBlock;
     if (!check_block(block, state, Params().GetConsensus(), /*fCheckPoW=*/true, /*fCheckMerkleRoot=*/true)) {
@@ -224,6 +378,9 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
     }
 
     LogPrint(BCLog::CMPCTBLOCK, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
+    if (!mweb_shortids.empty()) {
+        LogPrint(BCLog::CMPCTBLOCK, "Reconstructed MWEB block of %s with %lu of %lu kernels from mempool, %lu MWEB txn requested%s\n", hash.ToString(), mweb_mempool_count, mweb_shortids.size(), mweb_txn_missing.size(), mweb_block_missing.IsNull() ? "" : " (full MWEB block received)");
+    }
     if (vtx_missing.size() < 5) {
         for (const auto& tx : vtx_missing) {
             LogPrint(BCLog::CMPCTBLOCK, "Reconstructed block %s required tx %s\n", hash.ToString(), tx->GetHash().ToString());
@@ -232,3 +389,47 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<
 
     return READ_STATUS_OK;
 }
+
+bool FillMWEBBlockTransactions(const CTxMemPool& pool, const CBlock& block, const BlockTransactionsRequest& req, BlockTransactions& resp)
+{
+    if (req.mweb_indexes.empty()) return true;
+    if (block.mweb_block.IsNull()) return false;
+
+    const std::vector<Kernel>& kernels = block.mweb_block.m_block->GetKernels();
+    std::set<mw::Hash> wanted;
+    for (uint32_t index : req.mweb_indexes) {
+        if (index >= kernels.size()) return false;
+        wanted.insert(kernels[index].GetKernelID());
+    }
+
+    // Transactions mined in this block are usually still in the mempool when it is relayed
+    // as a new tip, and in recentTxsByKernel once the block has been connected.
+    std::set<mw::Hash> tx_hashes;
+    auto add_mweb_tx = [&](const mw::Transaction::CPtr& mweb_tx) {
+        for (const Kernel& kernel : mweb_tx->GetKernels()) {
+            wanted.erase(kernel.GetKernelID());
+        }
+        if (tx_hashes.insert(mweb_tx->GetHash()).second) {
+            resp.mweb_txn.push_back(mweb_tx);
+        }
+    };
+
+    {
+    LOCK(pool.cs);
+    for (const mw::Hash& kernel_id : std::vector<mw::Hash>(wanted.begin(), wanted.end())) {
+        if (!wanted.count(kernel_id)) continue; // Found with an earlier kernel of the same transaction
+        if (const CTransaction* tx = pool.mapTxKernels_MWEB.Get(kernel_id)) {
+            add_mweb_tx(tx->mweb_tx.m_transaction);
+        } else if (pool.recentTxsByKernel.Cached(kernel_id)) {
+            const CTransactionRef& ptx = pool.recentTxsByKernel.Get(kernel_id);
+            if (ptx->HasMWEBTx()) add_mweb_tx(ptx->mweb_tx.m_transaction);
+        }
+    }
+    }
+
+    if (!wanted.empty()) {
+        resp.mweb_txn.clear();
+        resp.mweb_block = block.mweb_block;
+    }
+    return true;
+}
@@ -5,6 +5,8 @@
 #ifndef BITCOIN_BLOCKENCODINGS_H
 #define BITCOIN_BLOCKENCODINGS_H
 
+#include <mw/models/block/Header.h>
+#include <mw/models/tx/Transaction.h>
 #include <primitives/block.h>
 
 #include <functional>
@@ -20,6 +22,14 @@ struct Params;
 // an actual formatter here.
 using TransactionCompression = DefaultFormatter;
 
+/**
+ * Serialization flag for cmpctblock, getblocktxn and blocktxn messages exchanged with peers
+ * that negotiated compact block version 4. Instead of the full MWEB block, a cmpctblock then
+ * carries the MWEB header and short IDs of the MWEB kernels, and getblocktxn/blocktxn are
+ * extended to request and return the MWEB transactions the receiver could not find.
+ */
+static const int SERIALIZE_MWEB_SHORTIDS = 0x10000000;
+
 class DifferenceFormatter
 {
     uint64_t m_shift = 0;
@@ -47,10 +57,15 @@ public:
     // A BlockTransactionsRequest message
     uint256 blockhash;
     std::vector<uint16_t> indexes;
+    // Positions of the requested MWEB kernels within the MWEB block
+    std::vector<uint32_t> mweb_indexes;
 
     SERIALIZE_METHODS(BlockTransactionsRequest, obj)
     {
         READWRITE(obj.blockhash, Using<VectorFormatter<DifferenceFormatter>>(obj.indexes));
+        if (s.GetVersion() & SERIALIZE_MWEB_SHORTIDS) {
+            READWRITE(Using<VectorFormatter<DifferenceFormatter>>(obj.mweb_indexes));
+        }
     }
 };
 
@@ -59,6 +74,12 @@ public:
     // A BlockTransactions message
     uint256 blockhash;
     std::vector<CTransactionRef> txn;
+    // MWEB transactions containing the requested kernels. Each transaction is sent once,
+    // even if it contains more than one of the requested kernels.
+    std::vector<mw::Transaction::CPtr> mweb_txn;
+    // The full MWEB block, sent instead of mweb_txn when the sender could not find the
+    // transactions for all of the requested kernels.
+    MWEB::Block mweb_block;
 
     BlockTransactions() {}
     explicit BlockTransactions(const BlockTransactionsRequest& req) :
@@ -67,6 +88,9 @@ public:
     SERIALIZE_METHODS(BlockTransactions, obj)
     {
         READWRITE(obj.blockhash, Using<VectorFormatter<TransactionCompression>>(obj.txn));
+        if (s.GetVersion() & SERIALIZE_MWEB_SHORTIDS) {
+            READWRITE(obj.mweb_txn, obj.mweb_block);
+        }
     }
 };
 
@@ -101,12 +125,15 @@ private:
 protected:
     std::vector<uint64_t> shorttxids;
     std::vector<PrefilledTransaction> prefilledtxn;
+    std::vector<uint64_t> mweb_shortids;
 
 public:
     static constexpr int SHORTTXIDS_LENGTH = 6;
 
     CBlockHeader header;
     MWEB::Block mweb_block;
+    // MWEB header, set when the MWEB block is sent as kernel short IDs instead of in full
+    mw::Header::CPtr mweb_header;
 
     // Dummy for deserialization
     CBlockHeaderAndShortTxIDs() {}
@@ -114,8 +141,10 @@ public:
     CBlockHeaderAndShortTxIDs(const CBlock& block, bool fUseWTXID);
 
     uint64_t GetShortID(const uint256& txhash) const;
+    uint64_t GetMWEBShortID(const mw::Hash& kernel_id) const;
 
     size_t BlockTxCount() const { return shorttxids.size() + prefilledtxn.size(); }
+    size_t MWEBKernelCount() const { return mweb_shortids.size(); }
 
     SERIALIZE_METHODS(CBlockHeaderAndShortTxIDs, obj)
     {
@@ -123,13 +152,20 @@ public:
 		
         READWRITE(obj.header, obj.nonce, Using<VectorFormatter<CustomUintFormatter<SHORTTXIDS_LENGTH>>>(obj.shorttxids), obj.prefilledtxn);
         if (fAllowMWEB) {
-            READWRITE(obj.mweb_block);
+            if (s.GetVersion() & SERIALIZE_MWEB_SHORTIDS) {
+                READWRITE(WrapOptionalPtr(obj.mweb_header), Using<VectorFormatter<CustomUintFormatter<SHORTTXIDS_LENGTH>>>(obj.mweb_shortids));
+            } else {
+                READWRITE(obj.mweb_block);
+            }
         }
 
         if (ser_action.ForRead()) {
             if (obj.BlockTxCount() > std::numeric_limits<uint16_t>::max()) {
                 throw std::ios_base::failure("indexes overflowed 16 bits");
             }
+            if (obj.mweb_header == nullptr && !obj.mweb_shortids.empty()) {
+                throw std::ios_base::failure("MWEB short IDs without MWEB header");
+            }
             obj.FillShortTxIDSelector();
         }
     }
@@ -140,6 +176,16 @@ protected:
     std::vector<CTransactionRef> txn_available;
     size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
     const CTxMemPool* pool;
+
+    // When the MWEB block was sent as kernel short IDs: the MWEB transaction found for each
+    // kernel position, from which the MWEB block body is rebuilt in FillBlock.
+    mw::Header::CPtr mweb_header;
+    std::vector<uint64_t> mweb_shortids;
+    std::vector<mw::Transaction::CPtr> mweb_txn_available;
+    size_t mweb_mempool_count = 0;
+
+    ReadStatus InitMWEBData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
+    ReadStatus FillMWEBBlock(MWEB::Block& block, const std::vector<mw::Transaction::CPtr>& mweb_txn_missing, const MWEB::Block& mweb_block_missing) const;
 public:
     CBlockHeader header;
     MWEB::Block mweb_block;
@@ -153,7 +199,20 @@ public:
     // extra_txn is a list of extra transactions to look at, in <witness hash, reference> form
     ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, CTransactionRef>>& extra_txn);
     bool IsTxAvailable(size_t index) const;
-    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing);
+    bool IsMWEBKernelAvailable(size_t index) const;
+    size_t MWEBKernelCount() const { return mweb_shortids.size(); }
+    // mweb_txn_missing and mweb_block_missing are the MWEB parts of the blocktxn response,
+    // used only when the MWEB block was sent as kernel short IDs.
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing,
+                         const std::vector<mw::Transaction::CPtr>& mweb_txn_missing = {}, const MWEB::Block& mweb_block_missing = {});
 };
 
+/**
+ * Fill in the MWEB part of a blocktxn response: the transactions containing the requested
+ * kernels are looked up in the mempool and in its cache of recently mined MWEB transactions.
+ * If any of them cannot be found, the full MWEB block is sent instead.
+ * Returns false if a requested kernel index is out of bounds.
+ */
+bool FillMWEBBlockTransactions(const CTxMemPool& pool, const CBlock& block, const BlockTransactionsRequest& req, BlockTransactions& resp);
+
 #endif // BITCOIN_BLOCKENCODINGS_H
@@ -78,7 +78,7 @@ GCSFilter::GCSFilter(const Params& params)
     : m_params(params), m_N(0), m_F(0), m_encoded{0}
 {}
 
-GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_filter)
+GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_filter, bool skip_decode_check)
     : m_params(params), m_encoded(std::move(encoded_filter))
 {
     VectorReader stream(GCS_SER_TYPE, GCS_SER_VERSION, m_encoded, 0);
@@ -90,13 +90,15 @@ GCSFilter::GCSFilter(const Params& params, std::vector<unsigned char> encoded_fi
     }
     m_F = static_cast<uint64_t>(m_N) * static_cast<uint64_t>(m_params.m_M);
 
+    if (skip_decode_check) return;
+
     // Verify that the encoded filter contains exactly N elements. If it has too much or too little
     // data, a std::ios_base::failure exception will be raised.
-    BitStreamReader<VectorReader> bitreader(stream);
+    GolombRiceReader reader(MakeSpan(m_encoded).subspan(GetSizeOfCompactSize(m_N)));
     for (uint64_t i = 0; i < m_N; ++i) {
-        GolombRiceDecode(bitreader, m_params.m_P);
+        reader.Decode(m_params.m_P);
     }
-    if (!stream.empty()) {
+    if (reader.GetUnreadBytes() != 0) {
         throw std::ios_base::failure("encoded_filter contains excess data");
     }
 }
@@ -119,32 +121,29 @@ GCSFilter::GCSFilter(const Params& params, const ElementSet& elements)
         return;
     }
 
-    BitStreamWriter<CVectorWriter> bitwriter(stream);
+    // Each element takes at least P + 1 bits.
+    m_encoded.reserve(m_encoded.size() + (static_cast<uint64_t>(m_N) * (m_params.m_P + 2) + 7) / 8);
+    GolombRiceWriter writer(m_encoded);
 
     uint64_t last_value = 0;
     for (uint64_t value : BuildHashedSet(elements)) {
         uint64_t delta = value - last_value;
-        GolombRiceEncode(bitwriter, m_params.m_P, delta);
+        writer.Encode(m_params.m_P, delta);
         last_value = value;
     }
 
-    bitwriter.Flush();
+    writer.Flush();
 }
 
 bool GCSFilter::MatchInternal(const uint64_t* element_hashes, size_t size) const
 {
-    VectorReader stream(GCS_SER_TYPE, GCS_SER_VERSION, m_encoded, 0);
-
-    // Seek forward by size of N
-    uint64_t N = ReadCompactSize(stream);
-    assert(N == m_N);
-
-    BitStreamReader<VectorReader> bitreader(stream);
+    // The encoding of N was validated on construction, so the elements start right after it.
+    GolombRiceReader reader(MakeSpan(m_encoded).subspan(GetSizeOfCompactSize(m_N)));
 
     uint64_t value = 0;
     size_t hashes_index = 0;
     for (uint32_t i = 0; i < m_N; ++i) {
-        uint64_t delta = GolombRiceDecode(bitreader, m_params.m_P);
+        uint64_t delta = reader.Decode(m_params.m_P);
         value += delta;
 
         while (true) {
@@ -175,6 +174,38 @@ bool GCSFilter::MatchAny(const ElementSet& elements) const
     return MatchInternal(queries.data(), queries.size());
 }
 
+std::vector<uint64_t> GCSFilter::DecodeElementHashes() const
+{
+    GolombRiceReader reader(MakeSpan(m_encoded).subspan(GetSizeOfCompactSize(m_N)));
+
+    std::vector<uint64_t> element_hashes;
+    element_hashes.reserve(m_N);
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < m_N; ++i) {
+        value += reader.Decode(m_params.m_P);
+        element_hashes.push_back(value);
+    }
+    return element_hashes;
+}
+
+bool GCSFilter::MatchAny(const ElementSet& elements, const std::vector<uint64_t>& filter_hashes) const
+{
+    const std::vector<uint64_t> queries = BuildHashedSet(elements);
+
+    // Both sides are sorted, so walk them in lockstep.
+    auto filter_it = filter_hashes.begin();
+    auto query_it = queries.begin();
+    while (filter_it != filter_hashes.end() && query_it != queries.end()) {
+        if (*filter_it == *query_it) return true;
+        if (*filter_it < *query_it) {
+            ++filter_it;
+        } else {
+            ++query_it;
+        }
+    }
+    return false;
+}
+
 const std::string& BlockFilterTypeName(BlockFilterType filter_type)
 {
     static std::string unknown_retval = "";
@@ -250,14 +281,14 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock& block,
 }
 
 BlockFilter::BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
-                         std::vector<unsigned char> filter)
+                         std::vector<unsigned char> filter, bool skip_decode_check)
     : m_filter_type(filter_type), m_block_hash(block_hash)
 {
     GCSFilter::Params params;
     if (!BuildParams(params)) {
         throw std::invalid_argument("unknown filter_type");
     }
-    m_filter = GCSFilter(params, std::move(filter));
+    m_filter = GCSFilter(params, std::move(filter), skip_decode_check);
 }
 
 BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo)
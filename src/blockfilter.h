@@ -58,8 +58,12 @@ public:
     /** Constructs an empty filter. */
     explicit GCSFilter(const Params& params = Params());
 
-    /** Reconstructs an already-created filter from an encoding. */
-    GCSFilter(const Params& params, std::vector<unsigned char> encoded_filter);
+    /**
+     * Reconstructs an already-created filter from an encoding. Unless skip_decode_check is set,
+     * the whole filter is decoded to check that it contains exactly N elements. The check may
+     * only be skipped for encodings that are known to be valid, e.g. read back from our own index.
+     */
+    GCSFilter(const Params& params, std::vector<unsigned char> encoded_filter, bool skip_decode_check = false);
 
     /** Builds a new filter from the params and set of elements. */
     GCSFilter(const Params& params, const ElementSet& elements);
@@ -80,6 +84,15 @@ public:
      * efficient that checking Match on multiple elements separately.
      */
     bool MatchAny(const ElementSet& elements) const;
+
+    /**
+     * Decodes the hashes of all elements in the filter, in ascending order. The result can be
+     * kept and passed to MatchAny to match the same filter repeatedly without decoding it again.
+     */
+    std::vector<uint64_t> DecodeElementHashes() const;
+
+    /** MatchAny against the element hashes previously returned by DecodeElementHashes. */
+    bool MatchAny(const ElementSet& elements, const std::vector<uint64_t>& filter_hashes) const;
 };
 
 constexpr uint8_t BASIC_FILTER_P = 19;
@@ -122,7 +135,7 @@ public:
 
     //! Reconstruct a BlockFilter from parts.
     BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
-                std::vector<unsigned char> filter);
+                std::vector<unsigned char> filter, bool skip_decode_check = false);
 
     //! Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo);
@@ -90,6 +90,10 @@ typedef char* sockopt_arg_type;
 // __APPLE__ poll is broke https://github.com/bitcoin/bitcoin/pull/14336#issuecomment-437384408
 #if defined(__linux__)
 #define USE_POLL
+#define USE_EPOLL
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#define USE_ZEROCOPY
+#endif
 #endif
 
 bool static inline IsSelectableSocket(const SOCKET& s) {
@@ -57,23 +57,23 @@ struct Params {
     uint256 hashGenesisBlock;
     int nSubsidyHalvingInterval;
     /** Block height at which BIP16 becomes active */
-    int BIP16Height;
+    int BIP16Height{0};
     /** Block height and hash at which BIP34 becomes active */
-    int BIP34Height;
+    int BIP34Height{0};
     uint256 BIP34Hash;
     /** Block height at which BIP65 becomes active */
-    int BIP65Height;
+    int BIP65Height{0};
     /** Block height at which BIP66 becomes active */
-    int BIP66Height;
+    int BIP66Height{0};
     /** Block height at which CSV (BIP68, BIP112 and BIP113) becomes active */
-    int CSVHeight;
+    int CSVHeight{0};
     /** Block height at which Segwit (BIP141, BIP143 and BIP147) becomes active.
      * Note that segwit v0 script rules are enforced on all blocks except the
      * BIP 16 exception blocks. */
-    int SegwitHeight;
+    int SegwitHeight{0};
     /** Don't warn about unknown BIP 9 activations below this height.
      * This prevents us from warning about the CSV and segwit activations. */
-    int MinBIP9WarningHeight;
+    int MinBIP9WarningHeight{0};
     /**
      * Minimum blocks including miner confirmation of the total of 2016 blocks in a retargeting period,
      * (nPowTargetTimespan / nPowTargetSpacing) which is also used for BIP9 deployments.
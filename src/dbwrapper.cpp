@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <random.h>
+#include <sync.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -13,6 +14,124 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <list>
+#include <unordered_map>
+
+static const DBProfile g_db_profiles[] = {
+    // name         block write table bloom block size  file size
+    {"default",     50,   25,   0,    10,   4 << 10,    2 << 20},
+    // Fewer, larger reads and more bloom bits to avoid seeks on rotational disks.
+    {"hdd",         50,   25,   10,   16,   16 << 10,   32 << 20},
+    // Favour caching over write buffering, e.g. for nodes serving many lookups once synced.
+    {"readheavy",   65,   10,   15,   14,   4 << 10,    2 << 20},
+};
+
+const DBProfile* FindDBProfile(const std::string& name)
+{
+    for (const DBProfile& profile : g_db_profiles) {
+        if (name == profile.name) return &profile;
+    }
+    return nullptr;
+}
+
+const DBProfile& GetDBProfile()
+{
+    const DBProfile* profile = FindDBProfile(gArgs.GetArg("-dbprofile", DEFAULT_DB_PROFILE));
+    return profile ? *profile : g_db_profiles[0];
+}
+
+std::string ListDBProfiles()
+{
+    std::string ret;
+    for (const DBProfile& profile : g_db_profiles) {
+        if (!ret.empty()) ret += ", ";
+        ret += profile.name;
+    }
+    return ret;
+}
+
+/** LRU cache of the raw values of a table, see CDBWrapper::AddTableCache. */
+struct CDBWrapper::TableCache
+{
+    //! Approximate per-entry overhead of the list node and map entry.
+    static constexpr size_t ENTRY_OVERHEAD = 96;
+
+    using Entries = std::list<std::pair<std::string, std::string>>;
+
+    const std::string name;
+    const std::function<bool(const leveldb::Slice&)> match;
+    const size_t max_usage;
+
+    mutable Mutex cs;
+    //! most recently used first
+    Entries entries GUARDED_BY(cs);
+    std::unordered_map<std::string, Entries::iterator> index GUARDED_BY(cs);
+    size_t usage GUARDED_BY(cs){0};
+    //! bumped on every write to the table, so reads that raced with a write don't cache stale values
+    uint64_t generation GUARDED_BY(cs){0};
+    uint64_t hits GUARDED_BY(cs){0};
+    uint64_t misses GUARDED_BY(cs){0};
+
+    TableCache(std::string name_in, std::function<bool(const leveldb::Slice&)> match_in, size_t max_usage_in)
+        : name(std::move(name_in)), match(std::move(match_in)), max_usage(max_usage_in) {}
+
+    static size_t EntryUsage(const std::string& key, const std::string& value)
+    {
+        return key.size() + value.size() + ENTRY_OVERHEAD;
+    }
+
+    void Erase(std::unordered_map<std::string, Entries::iterator>::iterator it) EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        usage -= EntryUsage(it->second->first, it->second->second);
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    void Insert(std::string key, std::string value) EXCLUSIVE_LOCKS_REQUIRED(cs)
+    {
+        const size_t entry_usage = EntryUsage(key, value);
+        if (entry_usage > max_usage) return;
+        while (usage + entry_usage > max_usage) {
+            Erase(index.find(entries.back().first));
+        }
+        entries.emplace_front(std::move(key), std::move(value));
+        index.emplace(entries.front().first, entries.begin());
+        usage += entry_usage;
+    }
+};
+
+/** Keeps table caches consistent with the contents of a written batch. */
+class CDBWrapper::TableCacheUpdater : public leveldb::WriteBatch::Handler
+{
+    const CDBWrapper& m_db;
+
+public:
+    explicit TableCacheUpdater(const CDBWrapper& db) : m_db(db) {}
+
+    void Put(const leveldb::Slice& key, const leveldb::Slice& value) override
+    {
+        TableCache* cache = m_db.FindTableCache(key);
+        if (!cache) return;
+        LOCK(cache->cs);
+        ++cache->generation;
+        auto it = cache->index.find(key.ToString());
+        if (it != cache->index.end()) {
+            cache->usage -= TableCache::EntryUsage(it->second->first, it->second->second);
+            it->second->second.assign(value.data(), value.size());
+            cache->usage += TableCache::EntryUsage(it->second->first, it->second->second);
+        }
+    }
+
+    void Delete(const leveldb::Slice& key) override
+    {
+        TableCache* cache = m_db.FindTableCache(key);
+        if (!cache) return;
+        LOCK(cache->cs);
+        ++cache->generation;
+        auto it = cache->index.find(key.ToString());
+        if (it != cache->index.end()) cache->Erase(it);
+    }
+};
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -97,12 +216,14 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static leveldb::Options GetOptions(size_t nCacheSize, const DBProfile& profile)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    options.block_cache = leveldb::NewLRUCache(nCacheSize * profile.block_cache_percent / 100);
+    options.write_buffer_size = nCacheSize * profile.write_buffer_percent / 100; // up to two write buffers may be held in memory simultaneously
+    options.filter_policy = leveldb::NewBloomFilterPolicy(profile.bloom_bits);
+    options.block_size = profile.block_size;
+    options.max_file_size = profile.max_file_size;
     options.compression = leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -115,14 +236,16 @@ static leveldb::Options GetOptions(size_t nCacheSize)
 }
 
 CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
-    : m_name{path.stem().string()}
+    : m_name{path.stem().string()}, m_profile{GetDBProfile()}
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    m_table_readoptions = readoptions;
+    m_table_readoptions.fill_cache = false;
+    options = GetOptions(nCacheSize, m_profile);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -189,6 +312,10 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     }
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     dbwrapper_private::HandleError(status);
+    if (!m_table_caches.empty()) {
+        TableCacheUpdater updater(*this);
+        batch.batch.Iterate(&updater);
+    }
     if (log_memory) {
         double mem_after = DynamicMemoryUsage() / 1024.0 / 1024;
         LogPrint(BCLog::LEVELDB, "WriteBatch memory usage: db=%s, before=%.1fMiB, after=%.1fMiB\n",
@@ -206,6 +333,77 @@ size_t CDBWrapper::DynamicMemoryUsage() const {
     return stoul(memory);
 }
 
+size_t CDBWrapper::BlockCacheUsage() const
+{
+    return options.block_cache->TotalCharge();
+}
+
+void CDBWrapper::AddTableCache(std::string name, std::function<bool(const leveldb::Slice&)> match, size_t max_usage)
+{
+    LogPrintf("Using %.1f MiB of the %s database cache for %s entries\n", max_usage * (1.0 / 1024 / 1024), m_name, name);
+    m_table_caches.push_back(MakeUnique<TableCache>(std::move(name), std::move(match), max_usage));
+}
+
+std::vector<DBTableCacheStats> CDBWrapper::GetTableCacheStats() const
+{
+    std::vector<DBTableCacheStats> ret;
+    for (const auto& cache : m_table_caches) {
+        LOCK(cache->cs);
+        DBTableCacheStats stats;
+        stats.name = cache->name;
+        stats.entries = cache->entries.size();
+        stats.usage = cache->usage;
+        stats.max_usage = cache->max_usage;
+        stats.hits = cache->hits;
+        stats.misses = cache->misses;
+        ret.push_back(std::move(stats));
+    }
+    return ret;
+}
+
+CDBWrapper::TableCache* CDBWrapper::FindTableCache(const leveldb::Slice& key) const
+{
+    for (const auto& cache : m_table_caches) {
+        if (cache->match(key)) return cache.get();
+    }
+    return nullptr;
+}
+
+bool CDBWrapper::ReadRaw(const leveldb::Slice& key, std::string& value) const
+{
+    TableCache* cache = m_table_caches.empty() ? nullptr : FindTableCache(key);
+    uint64_t generation = 0;
+    if (cache) {
+        LOCK(cache->cs);
+        auto it = cache->index.find(key.ToString());
+        if (it != cache->index.end()) {
+            cache->entries.splice(cache->entries.begin(), cache->entries, it->second);
+            value = it->second->second;
+            ++cache->hits;
+            return true;
+        }
+        ++cache->misses;
+        generation = cache->generation;
+    }
+
+    leveldb::Status status = pdb->Get(cache ? m_table_readoptions : readoptions, key, &value);
+    if (!status.ok()) {
+        if (status.IsNotFound())
+            return false;
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        dbwrapper_private::HandleError(status);
+    }
+
+    if (cache) {
+        LOCK(cache->cs);
+        // Another thread may have cached the key meanwhile, or a write may have changed it.
+        if (cache->generation == generation && !cache->index.count(key.ToString())) {
+            cache->Insert(key.ToString(), value);
+        }
+    }
+    return true;
+}
+
 // Prefixed with null character to avoid collisions with other keys
 //
 // We must use a string constructor which specifies length so that we copy
@@ -15,9 +15,51 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+static const char* const DEFAULT_DB_PROFILE = "default";
+
+/**
+ * LevelDB tuning profile, selected with -dbprofile. Shares are percentages of
+ * the cache size a database is opened with.
+ */
+struct DBProfile
+{
+    const char* name;
+    int block_cache_percent;  //!< LevelDB block cache
+    int write_buffer_percent; //!< each of the (up to two) memtables
+    int table_cache_percent;  //!< value caches of separately cached tables, see CDBWrapper::AddTableCache
+    int bloom_bits;           //!< bloom filter bits per key
+    size_t block_size;        //!< uncompressed size of table blocks
+    size_t max_file_size;     //!< size of table files; larger files mean fewer, longer compactions
+};
+
+/** Find a profile by name. Returns nullptr for unknown names. */
+const DBProfile* FindDBProfile(const std::string& name);
+
+/** The profile selected with -dbprofile. Falls back to the default profile for unknown names. */
+const DBProfile& GetDBProfile();
+
+/** Comma-separated list of all profile names. */
+std::string ListDBProfiles();
+
+/** Usage of a separately cached table, see CDBWrapper::AddTableCache. */
+struct DBTableCacheStats
+{
+    std::string name;
+    size_t entries{0};
+    size_t usage{0};
+    size_t max_usage{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+};
+
 class dbwrapper_error : public std::runtime_error
 {
 public:
@@ -200,6 +242,23 @@ private:
     //! the name of this database
     std::string m_name;
 
+    //! the tuning profile the database was opened with
+    const DBProfile& m_profile;
+
+    struct TableCache;
+    class TableCacheUpdater;
+
+    //! separately cached tables, see AddTableCache
+    std::vector<std::unique_ptr<TableCache>> m_table_caches;
+
+    //! options used when reading keys of separately cached tables
+    leveldb::ReadOptions m_table_readoptions;
+
+    TableCache* FindTableCache(const leveldb::Slice& key) const;
+
+    //! Read the raw (still obfuscated) value of a key, going through the table caches.
+    bool ReadRaw(const leveldb::Slice& key, std::string& value) const;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -235,12 +294,8 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
-        if (!status.ok()) {
-            if (status.IsNotFound())
-                return false;
-            LogPrintf("LevelDB read failure: %s\n", status.ToString());
-            dbwrapper_private::HandleError(status);
+        if (!ReadRaw(slKey, strValue)) {
+            return false;
         }
         try {
             CDataStream ssValue(strValue.data(), strValue.data() + strValue.size(), SER_DISK, CLIENT_VERSION);
@@ -269,14 +324,7 @@ public:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
 
         std::string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
-        if (!status.ok()) {
-            if (status.IsNotFound())
-                return false;
-            LogPrintf("LevelDB read failure: %s\n", status.ToString());
-            dbwrapper_private::HandleError(status);
-        }
-        return true;
+        return ReadRaw(slKey, strValue);
     }
 
     template <typename K>
@@ -292,6 +340,23 @@ public:
     // Get an estimate of LevelDB memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    //! Bytes currently held by LevelDB's block cache.
+    size_t BlockCacheUsage() const;
+
+    const std::string& GetName() const { return m_name; }
+    const DBProfile& GetProfile() const { return m_profile; }
+
+    /**
+     * Cache the values of keys matched by `match` in a separate LRU cache of
+     * up to max_usage bytes. These keys are read without filling LevelDB's
+     * block cache, so lookups in a large table don't evict the blocks of
+     * other tables sharing the database. Must be called before the database
+     * is used from multiple threads.
+     */
+    void AddTableCache(std::string name, std::function<bool(const leveldb::Slice&)> match, size_t max_usage);
+
+    std::vector<DBTableCacheStats> GetTableCacheStats() const;
+
     CDBIterator *NewIterator()
     {
         return new CDBIterator(*this, pdb->NewIterator(iteroptions));
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <crypto/hmac_sha256.h>
 #include <httpserver.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <util/strencodings.h>
@@ -72,6 +73,58 @@ static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
 static std::map<std::string, std::set<std::string>> g_rpc_whitelist;
 static bool g_rpc_whitelist_default = false;
 
+/** Amount of streamed reply output that may wait to be sent before the RPC method is held up */
+static const size_t MAX_RPC_STREAM_PENDING = 4 * DEFAULT_JSON_CHUNK_SIZE;
+
+/** Streams the reply to a single JSON-RPC request as a chunked HTTP reply.
+ * The output is identical to JSONRPCReply(result, NullUniValue, id).
+ */
+class HTTPRPCReplyStream final : public JSONRPCReplyStream, public JSONStreamSink
+{
+public:
+    HTTPRPCReplyStream(HTTPRequest* req, const UniValue& id) : m_req(req), m_id(id) {}
+
+    JSONWriter& Begin() override
+    {
+        assert(!m_writer);
+        m_req->WriteHeader("Content-Type", "application/json");
+        m_req->StartChunkedReply(HTTP_OK);
+        m_writer = MakeUnique<JSONWriter>(*this);
+        m_writer->BeginObject();
+        m_writer->Key("result");
+        return *m_writer;
+    }
+
+    bool Started() const override { return m_writer != nullptr; }
+
+    void Write(std::string&& chunk) override { m_req->WriteReplyChunk(std::move(chunk)); }
+
+    void Drain() override { m_req->WaitReplyChunks(MAX_RPC_STREAM_PENDING); }
+
+    /** Complete the reply once the method has written its result. */
+    void End()
+    {
+        m_writer->KeyValue("error", NullUniValue);
+        m_writer->KeyValue("id", m_id);
+        m_writer->EndObject();
+        m_writer->Raw("\n");
+        m_writer->Flush();
+        m_req->EndChunkedReply();
+    }
+
+    /** Cut the reply short after an error, leaving the client with incomplete JSON. */
+    void Abort()
+    {
+        m_writer->Flush();
+        m_req->EndChunkedReply();
+    }
+
+private:
+    HTTPRequest* m_req;
+    const UniValue& m_id;
+    std::unique_ptr<JSONWriter> m_writer;
+};
+
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
     // Send error reply from json-rpc error object
@@ -180,6 +233,7 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
         return false;
     }
 
+    HTTPRPCReplyStream stream(req, jreq.id);
     try {
         // Parse request
         UniValue valRequest;
@@ -204,7 +258,12 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            jreq.stream = &stream;
             UniValue result = tableRPC.execute(jreq);
+            if (stream.Started()) {
+                stream.End();
+                return true;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -235,9 +294,19 @@ static bool HTTPReq_JSONRPC(const util::Ref& context, HTTPRequest* req)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (stream.Started()) {
+            LogPrintf("RPC method %s failed while streaming its reply: %s\n", jreq.strMethod, find_value(objError, "message").getValStr());
+            stream.Abort();
+            return false;
+        }
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (stream.Started()) {
+            LogPrintf("RPC method %s failed while streaming its reply: %s\n", jreq.strMethod, e.what());
+            stream.Abort();
+            return false;
+        }
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
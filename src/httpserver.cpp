@@ -14,6 +14,7 @@
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <util/threadnames.h>
+#include <util/time.h>
 #include <util/translation.h>
 
 #include <deque>
@@ -24,6 +25,11 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <event2/thread.h>
 #include <event2/buffer.h>
@@ -276,6 +282,21 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
     }
 }
 
+/** Re-enable reading from the socket once a reply has been sent. This is the
+ * second part of the libevent workaround in http_request_cb. */
+static void http_enable_read(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Callback to reject HTTP requests after shutdown. */
 static void http_reject_request_cb(struct evhttp_request* req, void*)
 {
@@ -515,9 +536,60 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 {
 }
 
+HTTPReplyFile::HTTPReplyFile(FILE* file) : m_file(file)
+{
+    assert(m_file);
+}
+
+HTTPReplyFile::~HTTPReplyFile()
+{
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    // Replies still holding parts of the segment keep it alive
+    if (m_segment) evbuffer_file_segment_free(m_segment);
+#endif
+    fclose(m_file);
+}
+
+bool HTTPRequest::AppendReplyFile(HTTPReplyFile& file, int64_t offset, int64_t length)
+{
+    assert(!replySent && req && !m_chunked);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    if (!file.m_segment) {
+        // Map the whole file once, so that all parts appended from it share a descriptor
+        int fd = -1;
+        long size = -1;
+        if (fseek(file.m_file, 0, SEEK_END) == 0 && (size = ftell(file.m_file)) >= 0) {
+            fd = dup(fileno(file.m_file));
+        }
+        if (fd >= 0) {
+            file.m_segment = evbuffer_file_segment_new(fd, 0, size, EVBUF_FS_CLOSE_ON_FREE);
+            if (!file.m_segment) close(fd);
+        }
+    }
+    if (file.m_segment && evbuffer_add_file_segment(evb, file.m_segment, offset, length) == 0) {
+        return true;
+    }
+#else
+    std::vector<unsigned char> data(length);
+    if (fseek(file.m_file, offset, SEEK_SET) == 0 && fread(data.data(), 1, data.size(), file.m_file) == data.size()) {
+        evbuffer_add(evb, data.data(), data.size());
+        return true;
+    }
+#endif
+    LogPrintf("%s: Failed to add %d bytes at %d of a file to the reply\n", __func__, length, offset);
+    evbuffer_drain(evb, evbuffer_get_length(evb));
+    return false;
+}
+
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && m_chunked) {
+        // A chunked reply cannot be turned into an error anymore
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        EndChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -581,17 +653,129 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     auto req_copy = req;
     HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+        http_enable_read(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** State of a chunked reply, shared between the worker and the http thread. */
+struct HTTPChunkedReply
+{
+    Mutex mutex;
+    std::condition_variable cond;
+    //! Bytes passed to WriteReplyChunk
+    uint64_t queued GUARDED_BY(mutex){0};
+    //! Bytes known to have been written to the socket
+    uint64_t sent GUARDED_BY(mutex){0};
+    //! Whether the client connection is gone
+    bool closed GUARDED_BY(mutex){false};
+    //! Bytes handed to libevent, only accessed from the http thread
+    uint64_t buffered{0};
+};
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/** Called by libevent once the connection's output buffer has been written out. */
+static void http_chunks_sent_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPChunkedReply* state = static_cast<HTTPChunkedReply*>(arg);
+    LOCK(state->mutex);
+    state->sent = state->buffered;
+    state->cond.notify_all();
+}
+#endif
+
+static void http_chunked_close_cb(struct evhttp_connection*, void* arg)
+{
+    HTTPChunkedReply* state = static_cast<HTTPChunkedReply*>(arg);
+    LOCK(state->mutex);
+    state->closed = true;
+    state->cond.notify_all();
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && req && !m_chunked);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    m_chunked = std::make_shared<HTTPChunkedReply>();
+    auto req_copy = req;
+    auto state = m_chunked;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state, nStatus]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            http_chunked_close_cb(nullptr, state.get());
+            return;
+        }
+        // The state outlives the connection's use of it: the callbacks are
+        // reset by EndChunkedReply, which holds a reference too.
+        evhttp_connection_set_closecb(conn, http_chunked_close_cb, state.get());
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyChunk(std::string&& chunk)
+{
+    assert(!replySent && req && m_chunked);
+    {
+        LOCK(m_chunked->mutex);
+        if (m_chunked->closed) return;
+        m_chunked->queued += chunk.size();
+    }
+    auto req_copy = req;
+    auto state = m_chunked;
+    auto data = std::make_shared<std::string>(std::move(chunk));
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state, data]{
+        if (!evhttp_request_get_connection(req_copy)) {
+            http_chunked_close_cb(nullptr, state.get());
+            return;
         }
+        struct evbuffer* evb = evbuffer_new();
+        assert(evb);
+        evbuffer_add(evb, data->data(), data->size());
+        state->buffered += data->size();
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        evhttp_send_reply_chunk_with_cb(req_copy, evb, http_chunks_sent_cb, state.get());
+#else
+        evhttp_send_reply_chunk(req_copy, evb);
+        http_chunks_sent_cb(nullptr, state.get());
+#endif
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WaitReplyChunks(size_t max_pending)
+{
+    assert(!replySent && req && m_chunked);
+    const std::chrono::seconds timeout{gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT)};
+    WAIT_LOCK(m_chunked->mutex, lock);
+    while (!m_chunked->closed && m_chunked->queued - m_chunked->sent > max_pending) {
+        const uint64_t sent = m_chunked->sent;
+        if (m_chunked->cond.wait_for(lock, timeout) == std::cv_status::timeout && m_chunked->sent == sent) {
+            // The client stopped reading; stop producing output for it
+            LogPrint(BCLog::HTTP, "Abandoning chunked reply after %d seconds without progress\n", count_seconds(timeout));
+            m_chunked->closed = true;
+        }
+    }
+    return !m_chunked->closed;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && req && m_chunked);
+    auto req_copy = req;
+    auto state = m_chunked;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, state]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) evhttp_connection_set_closecb(conn, nullptr, nullptr);
+        // Unlike evhttp_send_reply, this may free the request (and the
+        // connection) right away, so re-enable reading first.
+        http_enable_read(req_copy);
+        evhttp_send_reply_end(req_copy);
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -5,8 +5,11 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
-#include <string>
 #include <functional>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -14,8 +17,10 @@ static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
 struct evhttp_request;
 struct event_base;
+struct evbuffer_file_segment;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReply;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -50,6 +55,29 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** File whose contents can be appended to HTTP replies without being copied
+ * through user space, using sendfile() where the platform supports it.
+ */
+class HTTPReplyFile
+{
+private:
+    FILE* m_file;
+    struct evbuffer_file_segment* m_segment{nullptr};
+
+    friend class HTTPRequest;
+
+public:
+    /** Takes ownership of file, which must be open for reading. */
+    explicit HTTPReplyFile(FILE* file);
+    ~HTTPReplyFile();
+
+    HTTPReplyFile(const HTTPReplyFile&) = delete;
+    HTTPReplyFile& operator=(const HTTPReplyFile&) = delete;
+
+    /** The file, to read parts of it directly. */
+    FILE* Get() const { return m_file; }
+};
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -58,6 +86,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    std::shared_ptr<HTTPChunkedReply> m_chunked;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -104,6 +133,14 @@ public:
      */
     void WriteHeader(const std::string& hdr, const std::string& value);
 
+    /**
+     * Append length bytes of file, starting at offset, to the body of the
+     * reply, in front of the body passed to WriteReply. The file must not be
+     * modified in that range until the reply has been sent. On failure the
+     * body appended so far is discarded.
+     */
+    bool AppendReplyFile(HTTPReplyFile& file, int64_t offset, int64_t length);
+
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
@@ -113,6 +150,32 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply whose body is sent in chunks, for bodies that are
+     * produced incrementally. Headers must have been written before.
+     *
+     * @note Use WriteReplyChunk to send the body and EndChunkedReply to
+     * finish the reply, instead of WriteReply.
+     */
+    void StartChunkedReply(int nStatus);
+
+    /** Queue a chunk of the body of a chunked reply. Does not block. */
+    void WriteReplyChunk(std::string&& chunk);
+
+    /**
+     * Wait until at most max_pending bytes of the queued chunks have not
+     * been sent to the client yet. Returns false if the client has gone
+     * away, in which case further chunks are discarded.
+     */
+    bool WaitReplyChunks(size_t max_pending);
+
+    /**
+     * Finish a chunked reply.
+     *
+     * @note Same restrictions as WriteReply apply afterwards.
+     */
+    void EndChunkedReply();
 };
 
 /** Event handler closure.
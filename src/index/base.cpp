@@ -12,10 +12,16 @@
 #include <validation.h>
 #include <warnings.h>
 
+#include <condition_variable>
+#include <deque>
+
 constexpr char DB_BEST_BLOCK = 'B';
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30; // seconds
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+constexpr size_t SYNC_READ_AHEAD_PER_THREAD = 4; // blocks
+
+int g_index_sync_threads = 1;
 
 template <typename... Args>
 static void FatalError(const char* fmt, const Args&... args)
@@ -68,6 +74,104 @@ bool BaseIndex::Init()
     return true;
 }
 
+namespace {
+
+/** A block handed to the sync workers, to be written to the index once its predecessors are. */
+struct SyncJob {
+    const CBlockIndex* const pindex;
+    CBlock block;
+    bool read{false};
+    bool prepared{false};
+    bool done{false};
+
+    explicit SyncJob(const CBlockIndex* pindex_in) : pindex(pindex_in) {}
+};
+
+/**
+ * Pool of threads that read blocks from disk and run the index's context-free
+ * per-block work, so that the sync thread only has to do the ordered writes.
+ */
+class SyncWorkers
+{
+public:
+    using WorkFn = std::function<void(SyncJob&)>;
+
+    /** stopped is called once the threads have been joined, to drop the work of jobs not waited for. */
+    SyncWorkers(const std::string& name, int n_threads, WorkFn work, std::function<void()> stopped)
+        : m_work(std::move(work)), m_stopped(std::move(stopped))
+    {
+        for (int i = 0; i < n_threads; ++i) {
+            m_threads.emplace_back([this, thread_name = strprintf("%s.%d", name, i)] {
+                TraceThread(thread_name.c_str(), [this] { Loop(); });
+            });
+        }
+    }
+
+    ~SyncWorkers()
+    {
+        {
+            LOCK(m_mutex);
+            m_stop = true;
+        }
+        m_work_cv.notify_all();
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+        m_stopped();
+    }
+
+    void Push(std::shared_ptr<SyncJob> job)
+    {
+        {
+            LOCK(m_mutex);
+            m_queue.push_back(std::move(job));
+        }
+        m_work_cv.notify_one();
+    }
+
+    /** Block until a job previously passed to Push has been processed. */
+    void Wait(const SyncJob& job)
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_done_cv.wait(lock, [&] { return job.done; });
+    }
+
+private:
+    void Loop()
+    {
+        while (true) {
+            std::shared_ptr<SyncJob> job;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_work_cv.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+                if (m_stop) return;
+                job = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+
+            m_work(*job);
+
+            {
+                LOCK(m_mutex);
+                job->done = true;
+            }
+            m_done_cv.notify_all();
+        }
+    }
+
+    const WorkFn m_work;
+    const std::function<void()> m_stopped;
+    std::vector<std::thread> m_threads;
+
+    Mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    std::deque<std::shared_ptr<SyncJob>> m_queue GUARDED_BY(m_mutex);
+    bool m_stop GUARDED_BY(m_mutex){false};
+};
+
+} // namespace
+
 static const CBlockIndex* NextSyncBlock(const CBlockIndex* pindex_prev) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     AssertLockHeld(cs_main);
@@ -90,6 +194,15 @@ void BaseIndex::ThreadSync()
     if (!m_synced) {
         auto& consensus_params = Params().GetConsensus();
 
+        SyncWorkers workers(GetName(), g_index_sync_threads, [&](SyncJob& job) {
+            job.read = ReadBlockFromDisk(job.block, job.pindex, consensus_params);
+            job.prepared = job.read && PrepareBlock(job.block, job.pindex);
+        }, [this] { DiscardPreparedBlocks(); });
+        const size_t max_jobs = g_index_sync_threads * SYNC_READ_AHEAD_PER_THREAD;
+        std::deque<std::shared_ptr<SyncJob>> jobs;
+        // The last block handed to the workers, which is pindex if no jobs are outstanding.
+        const CBlockIndex* pindex_scheduled = pindex;
+
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
         while (true) {
@@ -104,22 +217,51 @@ void BaseIndex::ThreadSync()
 
             {
                 LOCK(cs_main);
-                const CBlockIndex* pindex_next = NextSyncBlock(pindex);
-                if (!pindex_next) {
-                    m_best_block_index = pindex;
-                    m_synced = true;
-                    // No need to handle errors in Commit. See rationale above.
-                    Commit();
-                    break;
+                // Read ahead for as long as the chain extends the last scheduled block. After a
+                // reorg, the outstanding jobs are written first and then the index is rewound.
+                while (jobs.size() < max_jobs) {
+                    const CBlockIndex* pindex_next = NextSyncBlock(pindex_scheduled);
+                    if (!pindex_next || pindex_next->pprev != pindex_scheduled) break;
+                    jobs.push_back(std::make_shared<SyncJob>(pindex_next));
+                    workers.Push(jobs.back());
+                    pindex_scheduled = pindex_next;
                 }
-                if (pindex_next->pprev != pindex && !Rewind(pindex, pindex_next->pprev)) {
-                    FatalError("%s: Failed to rewind index %s to a previous chain tip",
-                               __func__, GetName());
-                    return;
+
+                if (jobs.empty()) {
+                    const CBlockIndex* pindex_next = NextSyncBlock(pindex);
+                    if (!pindex_next) {
+                        m_best_block_index = pindex;
+                        m_synced = true;
+                        // No need to handle errors in Commit. See rationale above.
+                        Commit();
+                        break;
+                    }
+                    if (!Rewind(pindex, pindex_next->pprev)) {
+                        FatalError("%s: Failed to rewind index %s to a previous chain tip",
+                                   __func__, GetName());
+                        return;
+                    }
+                    pindex = pindex_scheduled = pindex_next->pprev;
+                    continue;
                 }
-                pindex = pindex_next;
             }
 
+            const std::shared_ptr<SyncJob> job = std::move(jobs.front());
+            jobs.pop_front();
+            workers.Wait(*job);
+
+            if (!job->read) {
+                FatalError("%s: Failed to read block %s from disk",
+                           __func__, job->pindex->GetBlockHash().ToString());
+                return;
+            }
+            if (!job->prepared || !WriteBlock(job->block, job->pindex)) {
+                FatalError("%s: Failed to write block %s to index database",
+                           __func__, job->pindex->GetBlockHash().ToString());
+                return;
+            }
+            pindex = job->pindex;
+
             int64_t current_time = GetTime();
             if (last_log_time + SYNC_LOG_INTERVAL < current_time) {
                 LogPrintf("Syncing %s with block chain from height %d\n",
@@ -133,18 +275,6 @@ void BaseIndex::ThreadSync()
                 // No need to handle errors in Commit. See rationale above.
                 Commit();
             }
-
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
-                FatalError("%s: Failed to read block %s from disk",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
-            if (!WriteBlock(block, pindex)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
-                return;
-            }
         }
     }
 
@@ -13,6 +13,14 @@
 
 class CBlockIndex;
 
+/** Maximum number of threads used to read and prepare blocks during an index's initial sync */
+static const int MAX_INDEX_SYNC_THREADS = 16;
+/** -indexsyncthreads default */
+static const int DEFAULT_INDEX_SYNC_THREADS = 2;
+
+/** Number of threads each index uses to read and prepare blocks while catching up with the chain. */
+extern int g_index_sync_threads;
+
 struct IndexSummary {
     std::string name;
     bool synced{false};
@@ -64,6 +72,10 @@ private:
     /// interrupted with m_interrupt. Once the index gets in sync, the m_synced
     /// flag is set and the BlockConnected ValidationInterface callback takes
     /// over and the sync thread exits.
+    ///
+    /// Blocks are read from disk and passed to PrepareBlock by a pool of
+    /// g_index_sync_threads worker threads ahead of the sync thread, which
+    /// then calls WriteBlock on them in chain order.
     void ThreadSync();
 
     /// Write the current index state (eg. chain block locator and subclass-specific items) to disk.
@@ -84,7 +96,17 @@ protected:
     /// Initialize internal state from the database and block index.
     virtual bool Init();
 
-    /// Write update index entries for a newly connected block.
+    /// Do any context-free work for a block ahead of WriteBlock being called on it. During the
+    /// initial sync this is called from worker threads, concurrently for several blocks and out of
+    /// chain order, so it must not depend on the index state of previous blocks.
+    virtual bool PrepareBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
+
+    /// Drop the results of PrepareBlock for blocks that were not written, when the initial sync
+    /// stops, is interrupted or fails.
+    virtual void DiscardPreparedBlocks() {}
+
+    /// Write update index entries for a newly connected block. Blocks are always written in chain
+    /// order, and WriteBlock may be called without a preceding PrepareBlock for the same block.
     virtual bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) { return true; }
 
     /// Virtual method called internally by Commit that can be overridden to atomically
@@ -5,6 +5,7 @@
 #include <map>
 
 #include <dbwrapper.h>
+#include <hash.h>
 #include <index/blockfilterindex.h>
 #include <util/system.h>
 #include <validation.h>
@@ -37,6 +38,8 @@ constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000; // 1 MiB
  *  is big enough for a 2,000,000 length block chain, which
  *  we should be enough until ~2047. */
 constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
+/** Maximum number of decoded filters kept for LookupFilterMatchAny. */
+constexpr size_t DECODED_FILTER_CACHE_MAX_SZ{256};
 
 namespace {
 
@@ -142,7 +145,7 @@ bool BlockFilterIndex::CommitInternal(CDBBatch& batch)
     return BaseIndex::CommitInternal(batch);
 }
 
-bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const
+bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const
 {
     CAutoFile filein(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
     if (filein.IsNull()) {
@@ -153,7 +156,12 @@ bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& f
     std::vector<unsigned char> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
-        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
+        // The filter was validated when it was written, so a matching hash is enough to skip
+        // decoding the whole filter again.
+        if (Hash(encoded_filter) != hash) {
+            return error("%s: Checksum mismatch in filter decode", __func__);
+        }
+        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter), /* skip_decode_check */ true);
     }
     catch (const std::exception& e) {
         return error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
@@ -208,16 +216,55 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter&
     return data_size;
 }
 
-bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+bool BlockFilterIndex::BuildFilter(const CBlock& block, const CBlockIndex* pindex, BlockFilter& filter) const
 {
     CBlockUndo block_undo;
-    uint256 prev_header;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
 
-    if (pindex->nHeight > 0) {
-        if (!UndoReadFromDisk(block_undo, pindex)) {
-            return false;
+    filter = BlockFilter(m_filter_type, block, block_undo);
+    return true;
+}
+
+bool BlockFilterIndex::PrepareBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    BlockFilter filter;
+    if (!BuildFilter(block, pindex, filter)) {
+        return false;
+    }
+
+    LOCK(m_cs_prepared_filters);
+    m_prepared_filters[pindex->GetBlockHash()] = std::move(filter);
+    return true;
+}
+
+void BlockFilterIndex::DiscardPreparedBlocks()
+{
+    LOCK(m_cs_prepared_filters);
+    m_prepared_filters.clear();
+}
+
+bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    BlockFilter filter;
+    bool prepared = false;
+    {
+        LOCK(m_cs_prepared_filters);
+        auto it = m_prepared_filters.find(pindex->GetBlockHash());
+        if (it != m_prepared_filters.end()) {
+            filter = std::move(it->second);
+            m_prepared_filters.erase(it);
+            prepared = true;
         }
+    }
+    if (!prepared && !BuildFilter(block, pindex, filter)) {
+        return false;
+    }
+
+    uint256 prev_header;
 
+    if (pindex->nHeight > 0) {
         std::pair<uint256, DBVal> read_out;
         if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
             return false;
@@ -232,8 +279,6 @@ bool BlockFilterIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex
         prev_header = read_out.second.header;
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
-
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) return false;
 
@@ -380,7 +425,41 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter&
         return false;
     }
 
-    return ReadFilterFromDisk(entry.pos, filter_out);
+    return ReadFilterFromDisk(entry.pos, entry.hash, filter_out);
+}
+
+bool BlockFilterIndex::LookupFilterMatchAny(const CBlockIndex* block_index, const GCSFilter::ElementSet& elements, bool& match)
+{
+    const uint256& block_hash = block_index->GetBlockHash();
+
+    std::shared_ptr<const DecodedFilter> decoded;
+    {
+        LOCK(m_cs_decoded_cache);
+        auto it = m_decoded_cache.find(block_hash);
+        if (it != m_decoded_cache.end()) decoded = it->second;
+    }
+
+    if (!decoded) {
+        BlockFilter filter;
+        if (!LookupFilter(block_index, filter)) {
+            return false;
+        }
+        std::vector<uint64_t> element_hashes = filter.GetFilter().DecodeElementHashes();
+        decoded = std::make_shared<const DecodedFilter>(DecodedFilter{std::move(filter), std::move(element_hashes)});
+
+        // A block's filter never changes, so entries stay valid across reorgs.
+        LOCK(m_cs_decoded_cache);
+        if (m_decoded_cache.emplace(block_hash, decoded).second) {
+            m_decoded_cache_order.push_back(block_hash);
+            if (m_decoded_cache_order.size() > DECODED_FILTER_CACHE_MAX_SZ) {
+                m_decoded_cache.erase(m_decoded_cache_order.front());
+                m_decoded_cache_order.pop_front();
+            }
+        }
+    }
+
+    match = decoded->filter.GetFilter().MatchAny(elements, decoded->element_hashes);
+    return true;
 }
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out)
@@ -424,7 +503,7 @@ bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* st
     filters_out.resize(entries.size());
     auto filter_pos_it = filters_out.begin();
     for (const auto& entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+        if (!ReadFilterFromDisk(entry.pos, entry.hash, *filter_pos_it)) {
             return false;
         }
         ++filter_pos_it;
@@ -10,6 +10,9 @@
 #include <flatfile.h>
 #include <index/base.h>
 
+#include <deque>
+#include <memory>
+
 /** Interval between compact filter checkpoints. See BIP 157. */
 static constexpr int CFCHECKPT_INTERVAL = 1000;
 
@@ -35,18 +38,41 @@ private:
     FlatFilePos m_next_filter_pos;
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
-    bool ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const;
+    bool ReadFilterFromDisk(const FlatFilePos& pos, const uint256& hash, BlockFilter& filter) const;
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
+    /** Read the block's undo data and build its filter. */
+    bool BuildFilter(const CBlock& block, const CBlockIndex* pindex, BlockFilter& filter) const;
+
+    Mutex m_cs_prepared_filters;
+    /** filters built by PrepareBlock during the initial sync, waiting to be written by WriteBlock. */
+    std::unordered_map<uint256, BlockFilter, FilterHeaderHasher> m_prepared_filters GUARDED_BY(m_cs_prepared_filters);
+
     Mutex m_cs_headers_cache;
     /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
     std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
+    struct DecodedFilter
+    {
+        BlockFilter filter;
+        std::vector<uint64_t> element_hashes;
+    };
+
+    Mutex m_cs_decoded_cache;
+    /** cache of block hash to decoded filter, to avoid reading and decoding filters of recently matched blocks again. */
+    std::unordered_map<uint256, std::shared_ptr<const DecodedFilter>, FilterHeaderHasher> m_decoded_cache GUARDED_BY(m_cs_decoded_cache);
+    /** block hashes in m_decoded_cache, oldest first. */
+    std::deque<uint256> m_decoded_cache_order GUARDED_BY(m_cs_decoded_cache);
+
 protected:
     bool Init() override;
 
     bool CommitInternal(CDBBatch& batch) override;
 
+    bool PrepareBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    void DiscardPreparedBlocks() override;
+
     bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
 
     bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
@@ -65,6 +91,13 @@ public:
     /** Get a single filter by block. */
     bool LookupFilter(const CBlockIndex* block_index, BlockFilter& filter_out) const;
 
+    /**
+     * Check whether a block's filter matches any of the given elements. Filters of the most
+     * recently matched blocks are kept decoded, so that repeated queries against the same blocks
+     * (e.g. several wallets scanning a new block) neither read nor decode the filter again.
+     */
+    bool LookupFilterMatchAny(const CBlockIndex* block_index, const GCSFilter::ElementSet& elements, bool& match);
+
     /** Get a single filter header by block. */
     bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out);
 
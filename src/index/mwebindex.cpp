@@ -0,0 +1,88 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/mwebindex.h>
+#include <util/system.h>
+
+constexpr char DB_MWEB_KERNEL = 'k';
+constexpr char DB_MWEB_OUTPUT = 'o';
+constexpr char DB_MWEB_SPENT = 's';
+
+std::unique_ptr<MWEBIndex> g_mwebindex;
+
+/** Access to the MWEB index database (indexes/mwebindex/) */
+class MWEBIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the location of the entry with the given prefix and ID. Returns false if the ID is
+    /// not indexed.
+    bool ReadPos(char prefix, const mw::Hash& id, MWEBIndexPos& pos) const;
+
+    /// Write all kernel, output and spent output positions of a block to the DB.
+    bool WriteBlock(const uint256& block_hash, const mw::Block& mweb_block);
+};
+
+MWEBIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "mwebindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool MWEBIndex::DB::ReadPos(char prefix, const mw::Hash& id, MWEBIndexPos& pos) const
+{
+    return Read(std::make_pair(prefix, id), pos);
+}
+
+bool MWEBIndex::DB::WriteBlock(const uint256& block_hash, const mw::Block& mweb_block)
+{
+    CDBBatch batch(*this);
+
+    const std::vector<Kernel>& kernels = mweb_block.GetKernels();
+    for (uint32_t i = 0; i < kernels.size(); i++) {
+        batch.Write(std::make_pair(DB_MWEB_KERNEL, kernels[i].GetKernelID()), MWEBIndexPos(block_hash, i));
+    }
+
+    const std::vector<Output>& outputs = mweb_block.GetOutputs();
+    for (uint32_t i = 0; i < outputs.size(); i++) {
+        batch.Write(std::make_pair(DB_MWEB_OUTPUT, outputs[i].GetOutputID()), MWEBIndexPos(block_hash, i));
+    }
+
+    const std::vector<Input>& inputs = mweb_block.GetInputs();
+    for (uint32_t i = 0; i < inputs.size(); i++) {
+        batch.Write(std::make_pair(DB_MWEB_SPENT, inputs[i].GetOutputID()), MWEBIndexPos(block_hash, i));
+    }
+
+    return WriteBatch(batch);
+}
+
+MWEBIndex::MWEBIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<MWEBIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+MWEBIndex::~MWEBIndex() {}
+
+bool MWEBIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Blocks before MWEB activation have nothing to index.
+    if (block.mweb_block.IsNull()) return true;
+
+    return m_db->WriteBlock(pindex->GetBlockHash(), *block.mweb_block.m_block);
+}
+
+BaseIndex::DB& MWEBIndex::GetDB() const { return *m_db; }
+
+bool MWEBIndex::FindKernel(const mw::Hash& kernel_id, MWEBIndexPos& pos) const
+{
+    return m_db->ReadPos(DB_MWEB_KERNEL, kernel_id, pos);
+}
+
+bool MWEBIndex::FindOutput(const mw::Hash& output_id, MWEBIndexPos& pos) const
+{
+    return m_db->ReadPos(DB_MWEB_OUTPUT, output_id, pos);
+}
+
+bool MWEBIndex::FindSpentOutput(const mw::Hash& output_id, MWEBIndexPos& pos) const
+{
+    return m_db->ReadPos(DB_MWEB_SPENT, output_id, pos);
+}
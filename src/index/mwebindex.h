@@ -0,0 +1,75 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_MWEBINDEX_H
+#define BITCOIN_INDEX_MWEBINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <mw/models/crypto/Hash.h>
+#include <serialize.h>
+#include <uint256.h>
+
+static const bool DEFAULT_MWEBINDEX = false;
+
+/** Location of an MWEB kernel, output or input within the block that contains it. */
+struct MWEBIndexPos
+{
+    uint256 block_hash;
+    uint32_t position{0}; // index into the block's kernels, outputs or inputs
+
+    MWEBIndexPos() = default;
+    MWEBIndexPos(const uint256& block_hash_in, uint32_t position_in)
+        : block_hash(block_hash_in), position(position_in) {}
+
+    SERIALIZE_METHODS(MWEBIndexPos, obj)
+    {
+        READWRITE(obj.block_hash, VARINT(obj.position));
+    }
+};
+
+/**
+ * MWEBIndex is used to look up MWEB kernels and outputs included in the blockchain by ID.
+ * The index is written to a LevelDB database and records the containing block and position
+ * of each kernel and output, as well as of each input spending an MWEB output.
+ *
+ * Entries are keyed by ID only, so after a reorg a lookup may return a block that is no
+ * longer part of the active chain. Callers are expected to check this.
+ */
+class MWEBIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "mwebindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit MWEBIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~MWEBIndex() override;
+
+    /// Look up the block and kernel position of a kernel, including kernels with peg-outs.
+    bool FindKernel(const mw::Hash& kernel_id, MWEBIndexPos& pos) const;
+
+    /// Look up the block and output position at which an MWEB output was created.
+    bool FindOutput(const mw::Hash& output_id, MWEBIndexPos& pos) const;
+
+    /// Look up the block and input position at which an MWEB output was spent.
+    bool FindSpentOutput(const mw::Hash& output_id, MWEBIndexPos& pos) const;
+};
+
+/// The global MWEB index. May be null.
+extern std::unique_ptr<MWEBIndex> g_mwebindex;
+
+#endif // BITCOIN_INDEX_MWEBINDEX_H
@@ -17,11 +17,14 @@
 #include <chainparams.h>
 #include <compat/sanity.h>
 #include <consensus/validation.h>
+#include <dbwrapper.h>
 #include <fs.h>
 #include <hash.h>
 #include <httprpc.h>
 #include <httpserver.h>
+#include <index/base.h>
 #include <index/blockfilterindex.h>
+#include <index/mwebindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <interfaces/node.h>
@@ -31,7 +34,9 @@
 #include <net_permissions.h>
 #include <net_processing.h>
 #include <netbase.h>
+#include <node/blocktemplate.h>
 #include <node/context.h>
+#include <node/txreconciliation.h>
 #include <node/ui_interface.h>
 #include <policy/feerate.h>
 #include <policy/fees.h>
@@ -39,6 +44,7 @@
 #include <policy/settings.h>
 #include <protocol.h>
 #include <rpc/blockchain.h>
+#include <rpc/executor.h>
 #include <rpc/register.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -213,6 +219,9 @@ void Interrupt(NodeContext& node)
     if (g_txindex) {
         g_txindex->Interrupt();
     }
+    if (g_mwebindex) {
+        g_mwebindex->Interrupt();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
 }
 
@@ -243,6 +252,8 @@ void Shutdown(NodeContext& node)
     // Because these depend on each-other, we make sure that neither can be
     // using the other before destroying them.
     if (node.peerman) UnregisterValidationInterface(node.peerman.get());
+    if (node.block_template_provider) UnregisterValidationInterface(node.block_template_provider.get());
+    if (node.block_template_updater) UnregisterValidationInterface(node.block_template_updater.get());
     // Follow the lock order requirements:
     // * CheckForStaleTipAndEvictPeers locks cs_main before indirectly calling GetExtraOutboundCount
     //   which locks cs_vNodes.
@@ -269,6 +280,8 @@ void Shutdown(NodeContext& node)
 
     // After the threads that potentially access these pointers have been stopped,
     // destruct and reset all to nullptr.
+    node.block_template_provider.reset();
+    node.block_template_updater.reset();
     node.peerman.reset();
     node.connman.reset();
     node.banman.reset();
@@ -308,6 +321,10 @@ void Shutdown(NodeContext& node)
         g_txindex->Stop();
         g_txindex.reset();
     }
+    if (g_mwebindex) {
+        g_mwebindex->Stop();
+        g_mwebindex.reset();
+    }
     ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
     DestroyAllBlockFilterIndexes();
 
@@ -448,6 +465,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbprofile=<name>", strprintf("LevelDB tuning profile for the block index, chain state and index databases (default: %s, values: %s). \"hdd\" reduces seeks on rotational disks, \"readheavy\" favours read caches over write buffers. Both reserve part of the chain state database cache for MWEB entries.", DEFAULT_DB_PROFILE, ListDBProfiles()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -480,6 +498,9 @@ void SetupServerArgs(NodeContext& node)
                  strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
                  " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
                  ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-indexsyncthreads=<n>", strprintf("Set the number of threads used per index to read and prepare blocks while it catches up with the block chain (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
+        1, MAX_INDEX_SYNC_THREADS, DEFAULT_INDEX_SYNC_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-mwebindex", strprintf("Maintain an index of MWEB kernels and outputs by ID, used by the getmwebkernel and getmweboutput rpc calls (default: %u)", DEFAULT_MWEBINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 
     argsman.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-asmap=<file>", strprintf("Specify asn mapping used for bucketing of the peers (default: %s). Relative paths will be prefixed by the net-specific datadir location.", DEFAULT_ASMAP_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -498,6 +519,7 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-maxsendbuffer=<n>", strprintf("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXSENDBUFFER), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-maxtimeadjustment", strprintf("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)", DEFAULT_MAX_TIME_ADJUSTMENT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-maxuploadtarget=<n>", strprintf("Tries to keep outbound traffic under the given target (in MiB per 24h). Limit does not apply to peers with 'download' permission. 0 = no limit (default: %d)", DEFAULT_MAX_UPLOAD_TARGET), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-msghandthreads=<n>", strprintf("Number of threads used to process P2P messages. Each peer is handled by one of them (1 to %d, default: %d)", MAX_MSGHAND_THREADS, DEFAULT_MSGHAND_THREADS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor onion services, set -noonion to disable (default: -proxy)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-onlynet=<net>", "Make outgoing connections only through network <net> (ipv4, ipv6 or onion). Incoming connections are not affected by this option. This option can be specified multiple times to allow multiple networks.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
@@ -506,7 +528,14 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-port=<port>", strprintf("Listen for connections on <port>. Nodes not using the default ports (default: %u, testnet: %u, signet: %u, regtest: %u) are unlikely to get incoming connections.", defaultChainParams->GetDefaultPort(), testnetChainParams->GetDefaultPort(), signetChainParams->GetDefaultPort(), regtestChainParams->GetDefaultPort()), ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-proxy=<ip:port>", "Connect through SOCKS5 proxy, set -noproxy to disable (default: disabled)", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-proxyrandomize", strprintf("Randomize credentials for every proxy connection. This enables Tor stream isolation (default: %u)", DEFAULT_PROXYRANDOMIZE), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+    argsman.AddArg("-sendzerocopy", strprintf("Send large payloads such as blocks without copying them into the kernel, where supported (Linux MSG_ZEROCOPY) (default: %u)", DEFAULT_SEND_ZEROCOPY), ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-seednode=<ip>", "Connect to a node to retrieve peer addresses, and disconnect. This option can be specified multiple times to connect to multiple nodes.", ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
+#ifdef USE_EPOLL
+    argsman.AddArg("-socketevents=<mode>", strprintf("Socket events backend used to wait for network activity, which must be one of: epoll, poll (default: %s)", DEFAULT_SOCKETEVENTS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
+#else
+    argsman.AddArg("-socketevents=<mode>", strprintf("Socket events backend used to wait for network activity, which must be: %s (default: %s)", DEFAULT_SOCKETEVENTS, DEFAULT_SOCKETEVENTS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
+#endif
+    argsman.AddArg("-txreconciliation", strprintf("Relay transactions to peers that support it by periodic set reconciliation instead of announcing each of them (default: %u)", DEFAULT_TXRECONCILIATION_ENABLE), ArgsManager::ALLOW_BOOL | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
     argsman.AddArg("-networkactive", "Enable all P2P network activity (default: 1). Can be changed by the setnetworkactive RPC command", ArgsManager::ALLOW_BOOL, OptionsCategory::CONNECTION);
     argsman.AddArg("-timeout=<n>", strprintf("Specify connection timeout in milliseconds (minimum: 1, default: %d)", DEFAULT_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY, OptionsCategory::CONNECTION);
     argsman.AddArg("-peertimeout=<n>", strprintf("Specify p2p connection timeout in seconds. This option determines the amount of time a peer may be inactive before the connection to it is dropped. (minimum: 1, default: %d)", DEFAULT_PEER_CONNECT_TIMEOUT), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::CONNECTION);
@@ -537,22 +566,38 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-zmqpubrawblock=<address>", "Enable publish raw block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtx=<address>", "Enable publish raw transaction in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequence=<address>", "Enable publish hash block and tx sequence in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubblocktemplate=<address>", "Enable publish binary block template in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawmwebblock=<address>", "Enable publish raw MWEB block in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubmwebkernel=<address>", "Enable publish raw MWEB kernel in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubmweboutput=<address>", "Enable publish raw MWEB output in <address>", ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashblockhwm=<n>", strprintf("Set publish hash block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubhashtxhwm=<n>", strprintf("Set publish hash transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawblockhwm=<n>", strprintf("Set publish raw block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubrawtxhwm=<n>", strprintf("Set publish raw transaction outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
     argsman.AddArg("-zmqpubsequencehwm=<n>", strprintf("Set publish hash sequence message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubblocktemplatehwm=<n>", strprintf("Set publish binary block template outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubrawmwebblockhwm=<n>", strprintf("Set publish raw MWEB block outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubmwebkernelhwm=<n>", strprintf("Set publish raw MWEB kernel outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
+    argsman.AddArg("-zmqpubmweboutputhwm=<n>", strprintf("Set publish raw MWEB output outbound message high water mark (default: %d)", CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM), ArgsManager::ALLOW_ANY, OptionsCategory::ZMQ);
 #else
     hidden_args.emplace_back("-zmqpubhashblock=<address>");
     hidden_args.emplace_back("-zmqpubhashtx=<address>");
     hidden_args.emplace_back("-zmqpubrawblock=<address>");
     hidden_args.emplace_back("-zmqpubrawtx=<address>");
     hidden_args.emplace_back("-zmqpubsequence=<n>");
+    hidden_args.emplace_back("-zmqpubblocktemplate=<address>");
+    hidden_args.emplace_back("-zmqpubrawmwebblock=<address>");
+    hidden_args.emplace_back("-zmqpubmwebkernel=<address>");
+    hidden_args.emplace_back("-zmqpubmweboutput=<address>");
     hidden_args.emplace_back("-zmqpubhashblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubhashtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawblockhwm=<n>");
     hidden_args.emplace_back("-zmqpubrawtxhwm=<n>");
     hidden_args.emplace_back("-zmqpubsequencehwm=<n>");
+    hidden_args.emplace_back("-zmqpubblocktemplatehwm=<n>");
+    hidden_args.emplace_back("-zmqpubrawmwebblockhwm=<n>");
+    hidden_args.emplace_back("-zmqpubmwebkernelhwm=<n>");
+    hidden_args.emplace_back("-zmqpubmweboutputhwm=<n>");
 #endif
 
     argsman.AddArg("-checkblocks=<n>", strprintf("How many blocks to check at startup (default: %u, 0 = all)", DEFAULT_CHECKBLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::DEBUG_TEST);
@@ -604,6 +649,7 @@ void SetupServerArgs(NodeContext& node)
 
 
     argsman.AddArg("-blockmaxweight=<n>", strprintf("Set maximum BIP141 block weight (default: %d)", DEFAULT_BLOCK_MAX_WEIGHT), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
+    argsman.AddArg("-blocktemplatefeedelta=<amt>", strprintf("Fee increase (in %s) that makes a new block template worth publishing to -zmqpubblocktemplate (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_TEMPLATE_FEE_DELTA)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), ArgsManager::ALLOW_ANY, OptionsCategory::BLOCK_CREATION);
     argsman.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::BLOCK_CREATION);
 
@@ -611,6 +657,8 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcauth=<userpw>", "Username and HMAC-SHA-256 hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcauth. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
+    argsman.AddArg("-rpcbatchlimit=<method>:<n>", "Execute at most <n> items calling <method> of JSON-RPC batch requests at the same time. This option can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg("-rpcbatchthreads=<n>", strprintf("Set the number of threads executing the items of a JSON-RPC batch request in parallel (1 = execute them in order, 0 = number of cores, maximum: %d, default: %d)", MAX_RPC_BATCH_THREADS, DEFAULT_RPC_BATCH_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost)", ArgsManager::ALLOW_ANY | ArgsManager::NETWORK_ONLY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
     argsman.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", ArgsManager::ALLOW_ANY | ArgsManager::SENSITIVE, OptionsCategory::RPC);
@@ -1039,6 +1087,10 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         return InitError(strprintf(_("Specified blocks directory \"%s\" does not exist."), args.GetArg("-blocksdir", "")));
     }
 
+    if (!FindDBProfile(args.GetArg("-dbprofile", DEFAULT_DB_PROFILE))) {
+        return InitError(strprintf(_("Unknown -dbprofile value %s."), args.GetArg("-dbprofile", "")));
+    }
+
     // parse and validate enabled filter types
     const bool fReindexChainState = args.GetBoolArg("-reindex-chainstate", false);
     const bool fPrune = args.GetArg("-prune", 0);
@@ -1079,6 +1131,8 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         if (!g_enabled_filter_types.empty()) {
             return InitError(_("Prune mode is incompatible with -blockfilterindex."));
         }
+        if (args.GetBoolArg("-mwebindex", DEFAULT_MWEBINDEX))
+            return InitError(_("Prune mode is incompatible with -mwebindex."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1389,7 +1443,27 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         for (int i = 0; i < script_threads; ++i) {
             threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
         }
+        // Header proof of work checks happen mostly during headers sync, before
+        // there are scripts to check, so they get the same number of threads.
+        g_parallel_header_checks = true;
+        for (int i = 0; i < script_threads; ++i) {
+            threadGroup.create_thread([i]() { return ThreadHeaderCheck(i); });
+        }
+        // Batches of transactions, such as a reloaded mempool, are checked
+        // before taking cs_main on threads of their own.
+        g_parallel_tx_prechecks = true;
+        for (int i = 0; i < script_threads; ++i) {
+            threadGroup.create_thread([i]() { return ThreadTxPreCheck(i); });
+        }
+    }
+
+    int index_sync_threads = args.GetArg("-indexsyncthreads", DEFAULT_INDEX_SYNC_THREADS);
+    if (index_sync_threads <= 0) {
+        // -indexsyncthreads=0 means autodetect (number of cores)
+        // -indexsyncthreads=-n means "leave n cores free"
+        index_sync_threads += GetNumCores();
     }
+    g_index_sync_threads = std::max(1, std::min(index_sync_threads, MAX_INDEX_SYNC_THREADS));
 
     assert(!node.scheduler);
     node.scheduler = MakeUnique<CScheduler>();
@@ -1462,6 +1536,16 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     node.peerman.reset(new PeerManager(chainparams, *node.connman, node.banman.get(), *node.scheduler, chainman, *node.mempool));
     RegisterValidationInterface(node.peerman.get());
 
+    node.block_template_updater = MakeUnique<BlockTemplateUpdater>(*node.mempool, chainparams);
+    RegisterValidationInterface(node.block_template_updater.get());
+
+    CAmount template_fee_delta = DEFAULT_BLOCK_TEMPLATE_FEE_DELTA;
+    if (args.IsArgSet("-blocktemplatefeedelta") && !ParseMoney(args.GetArg("-blocktemplatefeedelta", ""), template_fee_delta)) {
+        return InitError(AmountErrMsg("blocktemplatefeedelta", args.GetArg("-blocktemplatefeedelta", "")));
+    }
+    node.block_template_provider = MakeUnique<BlockTemplateProvider>(*node.block_template_updater, *node.mempool, *node.scheduler, template_fee_delta);
+    RegisterValidationInterface(node.block_template_provider.get());
+
     // sanitize comments per BIP-0014, format user agent and check total size
     std::vector<std::string> uacomments;
     for (const std::string& cmt : args.GetArgs("-uacomment")) {
@@ -1578,6 +1662,18 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
 
     if (g_zmq_notification_interface) {
         RegisterValidationInterface(g_zmq_notification_interface);
+
+        for (const CZMQAbstractNotifier* notifier : g_zmq_notification_interface->GetActiveNotifiers()) {
+            if (notifier->GetType() != "pubblocktemplate") continue;
+            // Publish from the scheduler thread, which sends all other ZMQ notifications
+            CScheduler& scheduler = *node.scheduler;
+            node.block_template_provider->AddListener([&scheduler](const BinaryBlockTemplate& blocktemplate) {
+                scheduler.schedule([blocktemplate] {
+                    if (g_zmq_notification_interface) g_zmq_notification_interface->NotifyBlockTemplate(blocktemplate);
+                }, std::chrono::system_clock::now());
+            });
+            break;
+        }
     }
 #endif
     uint64_t nMaxOutboundLimit = 0; //unlimited unless -maxuploadtarget is set
@@ -1607,12 +1703,14 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         filter_index_cache = max_cache / n_indexes;
         nTotalCache -= filter_index_cache * n_indexes;
     }
+    int64_t mweb_index_cache = std::min(nTotalCache / 8, args.GetBoolArg("-mwebindex", DEFAULT_MWEBINDEX) ? max_mweb_index_cache << 20 : 0);
+    nTotalCache -= mweb_index_cache;
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     int64_t nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     int64_t nMempoolSizeMax = args.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-    LogPrintf("Cache configuration:\n");
+    LogPrintf("Cache configuration (database profile %s):\n", GetDBProfile().name);
     LogPrintf("* Using %.1f MiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
         LogPrintf("* Using %.1f MiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
@@ -1621,6 +1719,9 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         LogPrintf("* Using %.1f MiB for %s block filter index database\n",
                   filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
     }
+    if (args.GetBoolArg("-mwebindex", DEFAULT_MWEBINDEX)) {
+        LogPrintf("* Using %.1f MiB for MWEB index database\n", mweb_index_cache * (1.0 / 1024 / 1024));
+    }
     LogPrintf("* Using %.1f MiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1f MiB for in-memory UTXO set (plus up to %.1f MiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1865,6 +1966,11 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         GetBlockFilterIndex(filter_type)->Start();
     }
 
+    if (args.GetBoolArg("-mwebindex", DEFAULT_MWEBINDEX)) {
+        g_mwebindex = MakeUnique<MWEBIndex>(mweb_index_cache, false, fReindex);
+        g_mwebindex->Start();
+    }
+
     // ********************************************************* Step 9: load wallet
     for (const auto& client : node.chain_clients) {
         if (!client->load()) {
@@ -1996,12 +2102,24 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     connOptions.m_msgproc = node.peerman.get();
     connOptions.nSendBufferMaxSize = 1000 * args.GetArg("-maxsendbuffer", DEFAULT_MAXSENDBUFFER);
     connOptions.nReceiveFloodSize = 1000 * args.GetArg("-maxreceivebuffer", DEFAULT_MAXRECEIVEBUFFER);
+    connOptions.m_num_msghand_threads = args.GetArg("-msghandthreads", DEFAULT_MSGHAND_THREADS);
     connOptions.m_added_nodes = args.GetArgs("-addnode");
 
     connOptions.nMaxOutboundTimeframe = nMaxOutboundTimeframe;
     connOptions.nMaxOutboundLimit = nMaxOutboundLimit;
     connOptions.m_peer_connect_timeout = peer_connect_timeout;
 
+    const std::string socket_events = args.GetArg("-socketevents", DEFAULT_SOCKETEVENTS);
+#ifdef USE_EPOLL
+    connOptions.m_use_epoll = socket_events == "epoll";
+    if (!connOptions.m_use_epoll && socket_events != "poll") {
+#else
+    if (socket_events != DEFAULT_SOCKETEVENTS) {
+#endif
+        return InitError(strprintf(_("Unknown -socketevents mode '%s'"), socket_events));
+    }
+    connOptions.m_send_zerocopy = args.GetBoolArg("-sendzerocopy", DEFAULT_SEND_ZEROCOPY);
+
     for (const std::string& bind_arg : args.GetArgs("-bind")) {
         CService bind_addr;
         const size_t index = bind_arg.rfind('=');
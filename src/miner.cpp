@@ -97,22 +97,18 @@ void BlockAssembler::resetBlock()
     // These counters do not include coinbase tx
     nBlockTx = 0;
     nFees = 0;
+    minPackageFeeRate = nullopt;
 }
 
 Optional<int64_t> BlockAssembler::m_last_block_num_txs{nullopt};
 Optional<int64_t> BlockAssembler::m_last_block_weight{nullopt};
 Optional<int64_t> BlockAssembler::m_last_block_mweb_weight{nullopt};
 
-std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
+void BlockAssembler::StartBlock(const CBlockIndex* pindexPrev)
 {
-    int64_t nTimeStart = GetTimeMicros();
-
     resetBlock();
 
     pblocktemplate.reset(new CBlockTemplate());
-
-    if(!pblocktemplate.get())
-        return nullptr;
     CBlock* const pblock = &pblocktemplate->block; // pointer for convenience
 
     // Add dummy coinbase tx as first transaction
@@ -120,9 +116,6 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     pblocktemplate->vTxFees.push_back(-1); // updated at end
     pblocktemplate->vTxSigOpsCost.push_back(-1); // updated at end
 
-    LOCK2(cs_main, m_mempool.cs);
-    CBlockIndex* pindexPrev = ::ChainActive().Tip();
-    assert(pindexPrev != nullptr);
     nHeight = pindexPrev->nHeight + 1;
 
     pblock->nVersion = ComputeBlockVersion(pindexPrev, chainparams.GetConsensus());
@@ -153,17 +146,16 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     if (fIncludeMWEB) {
         mweb_miner.NewBlock(nHeight);
     }
+}
 
-    int nPackagesSelected = 0;
-    int nDescendantsUpdated = 0;
-    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+void BlockAssembler::FinishBlock(CBlockTemplate& blocktemplate, const CScript& scriptPubKeyIn, const CBlockIndex* pindexPrev)
+{
+    CBlock* const pblock = &blocktemplate.block; // pointer for convenience
 
     if (fIncludeMWEB) {
-        mweb_miner.AddHogExTransaction(pindexPrev, pblock, pblocktemplate.get(), nFees);
+        mweb_miner.AddHogExTransaction(pindexPrev, pblock, &blocktemplate, nFees);
     }
 
-    int64_t nTime1 = GetTimeMicros();
-
     m_last_block_num_txs = nBlockTx;
     m_last_block_weight = nBlockWeight;
     m_last_block_mweb_weight = nBlockMWEBWeight;
@@ -177,8 +169,8 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     coinbaseTx.vout[0].nValue = nFees + GetBlockSubsidy(nHeight, chainparams.GetConsensus());
     coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
-    pblocktemplate->vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
-    pblocktemplate->vTxFees[0] = -nFees;
+    blocktemplate.vchCoinbaseCommitment = GenerateCoinbaseCommitment(*pblock, pindexPrev, chainparams.GetConsensus());
+    blocktemplate.vTxFees[0] = -nFees;
 
     LogPrintf("CreateNewBlock(): block weight: %u txs: %u fees: %ld sigops: %d MWEB weight: %u\n", GetBlockWeight(*pblock), nBlockTx, nFees, nBlockSigOpsCost, nBlockMWEBWeight);
 
@@ -187,10 +179,29 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     UpdateTime(pblock, chainparams.GetConsensus(), pindexPrev);
     pblock->nBits          = GetNextWorkRequired(pindexPrev, pblock, chainparams.GetConsensus());
     pblock->nNonce         = 0;
-    pblocktemplate->vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
+    blocktemplate.vTxSigOpsCost[0] = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
+}
+
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK2(cs_main, m_mempool.cs);
+    CBlockIndex* pindexPrev = ::ChainActive().Tip();
+    assert(pindexPrev != nullptr);
+
+    StartBlock(pindexPrev);
+
+    int nPackagesSelected = 0;
+    int nDescendantsUpdated = 0;
+    addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+
+    int64_t nTime1 = GetTimeMicros();
+
+    FinishBlock(*pblocktemplate, scriptPubKeyIn, pindexPrev);
 
     BlockValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+    if (!TestBlockValidity(state, chainparams, pblocktemplate->block, pindexPrev, false, false)) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, state.ToString()));
     }
     int64_t nTime2 = GetTimeMicros();
@@ -483,6 +494,10 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
         }
 
         ++nPackagesSelected;
+        const CFeeRate packageFeeRate(packageFees, packageSize, packageMWEBWeight);
+        if (!minPackageFeeRate || packageFeeRate < *minPackageFeeRate) {
+            minPackageFeeRate = packageFeeRate;
+        }
 
         if (!failed) {
             // Update transactions that depend on each of these
@@ -491,6 +506,219 @@ void BlockAssembler::addPackageTxs(int &nPackagesSelected, int &nDescendantsUpda
     }
 }
 
+BlockTemplateUpdater::BlockTemplateUpdater(const CTxMemPool& mempool, const CChainParams& params)
+    : m_mempool(mempool), m_assembler(mempool, params) {}
+
+BlockTemplateUpdater::BlockTemplateUpdater(const CTxMemPool& mempool, const CChainParams& params, const BlockAssembler::Options& options)
+    : m_mempool(mempool), m_assembler(mempool, params, options) {}
+
+void BlockTemplateUpdater::TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence)
+{
+    LOCK(m_pending_mutex);
+    // Changes from before the template was last brought up to date are in it already
+    if (m_missed || mempool_sequence < m_next_sequence) return;
+    if (m_added.size() + m_removed.size() >= MAX_PENDING_NOTIFICATIONS) {
+        // Nobody asked for a template in a while; assemble the next one from scratch.
+        m_missed = true;
+        m_added.clear();
+        m_removed.clear();
+        return;
+    }
+    m_added.push_back(tx->GetHash());
+    m_next_sequence = mempool_sequence + 1;
+}
+
+void BlockTemplateUpdater::TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence)
+{
+    LOCK(m_pending_mutex);
+    if (m_missed || mempool_sequence < m_next_sequence) return;
+    if (m_added.size() + m_removed.size() >= MAX_PENDING_NOTIFICATIONS) {
+        m_missed = true;
+        m_added.clear();
+        m_removed.clear();
+        return;
+    }
+    m_removed.insert(tx->GetHash());
+    m_next_sequence = mempool_sequence + 1;
+}
+
+void BlockTemplateUpdater::Rebuild(const CBlockIndex* pindexPrev)
+{
+    m_assembler.StartBlock(pindexPrev);
+
+    int nPackagesSelected = 0;
+    int nDescendantsUpdated = 0;
+    m_assembler.addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+
+    m_in_template.clear();
+    for (CTxMemPool::txiter it : m_assembler.inBlock) {
+        m_in_template.insert(it->GetTx().GetHash());
+    }
+    ++m_stats.full_rebuilds;
+}
+
+bool BlockTemplateUpdater::Update(const std::vector<uint256>& added)
+{
+    BlockAssembler& assembler = m_assembler;
+
+    // The packages the new transactions complete, which may include
+    // ancestors that weren't worth selecting on their own
+    struct Candidate {
+        CTxMemPool::txiter iter;
+        CTxMemPool::setEntries package;
+        CFeeRate feerate;
+    };
+    std::vector<Candidate> candidates;
+    for (const uint256& txid : added) {
+        const CTxMemPool::txiter it = m_mempool.mapTx.find(txid);
+        if (it == m_mempool.mapTx.end() || assembler.inBlock.count(it)) continue;
+
+        Candidate candidate{it, {}, {}};
+        uint64_t nNoLimit = std::numeric_limits<uint64_t>::max();
+        std::string dummy;
+        m_mempool.CalculateMemPoolAncestors(*it, candidate.package, nNoLimit, nNoLimit, nNoLimit, nNoLimit, dummy, false);
+        assembler.onlyUnconfirmed(candidate.package);
+        candidate.package.insert(it);
+        CAmount package_fees = 0;
+        uint64_t package_size = 0;
+        int64_t package_mweb_weight = 0;
+        for (CTxMemPool::txiter entry : candidate.package) {
+            package_fees += entry->GetModifiedFee();
+            package_size += entry->GetTxSize();
+            package_mweb_weight += entry->GetMWEBWeight();
+        }
+        candidate.feerate = CFeeRate(package_fees, package_size, package_mweb_weight);
+        candidates.push_back(std::move(candidate));
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.feerate > b.feerate;
+    });
+
+    const CTxMemPool::setEntries no_failed_txs;
+    std::vector<CTxMemPool::txiter> sortedEntries;
+    for (Candidate& candidate : candidates) {
+        // Earlier candidates may have selected part of this package already
+        assembler.onlyUnconfirmed(candidate.package);
+        if (!candidate.package.count(candidate.iter)) continue;
+
+        CAmount packageFees = 0;
+        uint64_t packageSize = 0;
+        int64_t packageSigOpsCost = 0;
+        int64_t packageMWEBWeight = 0;
+        for (CTxMemPool::txiter entry : candidate.package) {
+            packageFees += entry->GetModifiedFee();
+            packageSize += entry->GetTxSize();
+            packageSigOpsCost += entry->GetSigOpCost();
+            packageMWEBWeight += entry->GetMWEBWeight();
+        }
+        if (packageFees < assembler.blockMinFeeRate.GetTotalFee(packageSize, packageMWEBWeight)) continue;
+
+        const CFeeRate packageFeeRate(packageFees, packageSize, packageMWEBWeight);
+        if (!assembler.TestPackage(packageSize, packageSigOpsCost, packageMWEBWeight)) {
+            // The package might displace something that pays less, which
+            // only selecting the whole block again can tell.
+            if (assembler.minPackageFeeRate && *assembler.minPackageFeeRate < packageFeeRate) return false;
+            continue;
+        }
+        if (!assembler.TestPackageTransactions(candidate.package, no_failed_txs)) continue;
+
+        assembler.SortForBlock(candidate.package, sortedEntries);
+        for (CTxMemPool::txiter entry : sortedEntries) {
+            if (!assembler.AddToBlock(entry)) break;
+            m_in_template.insert(entry->GetTx().GetHash());
+        }
+        if (!assembler.minPackageFeeRate || packageFeeRate < *assembler.minPackageFeeRate) {
+            assembler.minPackageFeeRate = packageFeeRate;
+        }
+        ++m_stats.packages_appended;
+    }
+    ++m_stats.incremental_updates;
+    return true;
+}
+
+std::unique_ptr<CBlockTemplate> BlockTemplateUpdater::GetBlockTemplate(const CScript& scriptPubKeyIn)
+{
+    int64_t nTimeStart = GetTimeMicros();
+
+    LOCK(cs_main);
+    LOCK(m_template_mutex);
+    LOCK(m_mempool.cs);
+    CBlockIndex* pindexPrev = ::ChainActive().Tip();
+    assert(pindexPrev != nullptr);
+
+    const uint64_t mempool_sequence = m_mempool.GetSequence();
+    const unsigned int transactions_updated = m_mempool.GetTransactionsUpdated();
+    const int64_t now = GetTime();
+    const bool may_rebuild = pindexPrev != m_tip || now - m_last_rebuild_time >= MIN_REBUILD_INTERVAL;
+    std::vector<uint256> added;
+    bool rebuild = pindexPrev != m_tip || m_rebuild_due;
+    {
+        LOCK(m_pending_mutex);
+        // Every mempool addition and removal takes a sequence number and counts
+        // as a transaction update. If the notifications for all of them arrived,
+        // the pending changes are complete, and if the update counter moved by
+        // as much, nothing else (like a fee prioritisation) changed the mempool.
+        rebuild |= m_missed || m_next_sequence != mempool_sequence ||
+                   transactions_updated - m_transactions_updated != (unsigned int)(mempool_sequence - m_mempool_sequence);
+        for (const uint256& txid : m_removed) {
+            rebuild |= m_in_template.count(txid) > 0;
+        }
+        // A rebuild that is due too soon after the last one leaves the changes
+        // pending, and the last template is finished again.
+        if (!rebuild || may_rebuild) {
+            added.swap(m_added);
+            m_removed.clear();
+            m_missed = false;
+            // Notifications still on their way are covered by this update
+            m_next_sequence = mempool_sequence;
+        }
+    }
+    const bool deferred = rebuild && !may_rebuild;
+
+    if (!rebuild && !Update(added)) {
+        // Until a rebuild is allowed, the packages appended so far are kept
+        // and the ones that might displace others wait for it.
+        rebuild = may_rebuild;
+        m_rebuild_due = !may_rebuild;
+    }
+    if (rebuild && !deferred) {
+        // Clear the tip so the next request starts over, despite any failures from here on
+        m_tip = nullptr;
+        Rebuild(pindexPrev);
+        m_last_rebuild_time = now;
+        m_rebuild_due = false;
+    }
+    int64_t nTime1 = GetTimeMicros();
+
+    std::unique_ptr<CBlockTemplate> blocktemplate = MakeUnique<CBlockTemplate>(*m_assembler.pblocktemplate);
+    m_assembler.FinishBlock(*blocktemplate, scriptPubKeyIn, pindexPrev);
+
+    // Appended packages were all accepted to the mempool on top of this tip,
+    // so only check templates assembled from scratch.
+    if (rebuild && !deferred) {
+        BlockValidationState state;
+        if (!TestBlockValidity(state, m_assembler.chainparams, blocktemplate->block, pindexPrev, false, false)) {
+            throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, state.ToString()));
+        }
+    }
+    if (!deferred) {
+        m_tip = pindexPrev;
+        m_mempool_sequence = mempool_sequence;
+        m_transactions_updated = transactions_updated;
+    }
+    int64_t nTime2 = GetTimeMicros();
+
+    LogPrint(BCLog::BENCH, "GetBlockTemplate() %s: %.2fms, finish: %.2fms (%u full, %u incremental updates)\n", deferred ? "deferred rebuild" : rebuild ? "rebuild" : "update", 0.001 * (nTime1 - nTimeStart), 0.001 * (nTime2 - nTime1), m_stats.full_rebuilds, m_stats.incremental_updates);
+
+    return blocktemplate;
+}
+
+BlockTemplateUpdater::Stats BlockTemplateUpdater::GetStats() const
+{
+    LOCK(m_template_mutex);
+    return m_stats;
+}
+
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce)
 {
     // Update nExtraNonce
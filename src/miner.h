@@ -8,12 +8,16 @@
 
 #include <optional.h>
 #include <primitives/block.h>
+#include <sync.h>
 #include <txmempool.h>
 #include <validation.h>
+#include <validationinterface.h>
 #include <mweb/mweb_miner.h>
 
 #include <memory>
+#include <set>
 #include <stdint.h>
+#include <vector>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -131,6 +135,8 @@ struct update_for_parent_inclusion
 /** Generate a new block, without valid proof-of-work */
 class BlockAssembler
 {
+    friend class BlockTemplateUpdater;
+
 private:
     // The constructed block template
     std::unique_ptr<CBlockTemplate> pblocktemplate;
@@ -151,6 +157,8 @@ private:
     uint64_t nBlockMWEBWeight;
     CAmount nFees;
     CTxMemPool::setEntries inBlock;
+    // Lowest feerate of the packages selected so far
+    Optional<CFeeRate> minPackageFeeRate;
 
     // Chain context for the block
     int nHeight;
@@ -179,6 +187,10 @@ private:
     // utility functions
     /** Clear the block's state and prepare for assembling a new block */
     void resetBlock();
+    /** Reset the block and fill in the header fields and rules for a block on top of pindexPrev */
+    void StartBlock(const CBlockIndex* pindexPrev) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    /** Add the HogEx and coinbase transactions to the given copy of the block built so far, and finish its header */
+    void FinishBlock(CBlockTemplate& blocktemplate, const CScript& scriptPubKeyIn, const CBlockIndex* pindexPrev);
     /** Add a tx to the block */
     bool AddToBlock(CTxMemPool::txiter iter);
 
@@ -209,6 +221,85 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set& mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(m_mempool.cs);
 };
 
+/**
+ * Keeps a block template on the current tip up to date as transactions enter
+ * the mempool, instead of assembling a new one each time it is requested.
+ *
+ * Transactions added to the mempool are queued by the validation interface
+ * notifications, and on the next request the packages they complete are
+ * appended to the template in order of ancestor feerate, leaving the
+ * transactions already selected and the MWEB block builder as they are.
+ * Only the HogEx, the coinbase and the commitments are redone, so a refresh
+ * costs in proportion to what changed since the previous one.
+ *
+ * The template is assembled from scratch when the tip changes, when a
+ * transaction in it leaves the mempool, when fees are prioritised, when a new
+ * package doesn't fit and pays more than the least paying package included,
+ * or when the notifications haven't caught up with the mempool yet. Other than
+ * for a new tip, this happens at most once every MIN_REBUILD_INTERVAL seconds;
+ * in between, the last template is handed out again.
+ */
+class BlockTemplateUpdater final : public CValidationInterface
+{
+public:
+    struct Stats {
+        uint64_t full_rebuilds{0};
+        uint64_t incremental_updates{0};
+        uint64_t packages_appended{0};
+    };
+
+    /** Least number of seconds between two full rebuilds of the template on the same tip */
+    static constexpr int64_t MIN_REBUILD_INTERVAL = 5;
+
+    BlockTemplateUpdater(const CTxMemPool& mempool, const CChainParams& params);
+    BlockTemplateUpdater(const CTxMemPool& mempool, const CChainParams& params, const BlockAssembler::Options& options);
+
+    /** Return a template on the current tip with coinbase to scriptPubKeyIn, bringing it up to date first */
+    std::unique_ptr<CBlockTemplate> GetBlockTemplate(const CScript& scriptPubKeyIn) LOCKS_EXCLUDED(m_template_mutex, m_pending_mutex);
+
+    Stats GetStats() const LOCKS_EXCLUDED(m_template_mutex);
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& tx, uint64_t mempool_sequence) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason, uint64_t mempool_sequence) override;
+
+private:
+    /** Assemble the template from the whole mempool */
+    void Rebuild(const CBlockIndex* pindexPrev) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_template_mutex, m_mempool.cs);
+    /** Append the packages completed by the queued transactions. Returns false if the template must be rebuilt instead. */
+    bool Update(const std::vector<uint256>& added) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_template_mutex, m_mempool.cs);
+
+    const CTxMemPool& m_mempool;
+
+    mutable Mutex m_template_mutex;
+    BlockAssembler m_assembler GUARDED_BY(m_template_mutex);
+    //! Tip the template builds on, or nullptr if it must be rebuilt
+    const CBlockIndex* m_tip GUARDED_BY(m_template_mutex){nullptr};
+    //! Transactions selected into the template, including MWEB-only ones
+    std::set<uint256> m_in_template GUARDED_BY(m_template_mutex);
+    //! Mempool sequence and update counter when the template was last brought up to date
+    uint64_t m_mempool_sequence GUARDED_BY(m_template_mutex){0};
+    unsigned int m_transactions_updated GUARDED_BY(m_template_mutex){0};
+    //! Time of the last full rebuild
+    int64_t m_last_rebuild_time GUARDED_BY(m_template_mutex){0};
+    //! Whether an update skipped packages that need a rebuild to be considered
+    bool m_rebuild_due GUARDED_BY(m_template_mutex){false};
+    Stats m_stats GUARDED_BY(m_template_mutex);
+
+    /** Most notifications kept between requests before giving up on them and rebuilding instead */
+    static constexpr size_t MAX_PENDING_NOTIFICATIONS = 100000;
+
+    Mutex m_pending_mutex;
+    //! Transactions added to the mempool since the template was brought up to date, in order
+    std::vector<uint256> m_added GUARDED_BY(m_pending_mutex);
+    //! Transactions removed from the mempool since the template was brought up to date
+    std::set<uint256> m_removed GUARDED_BY(m_pending_mutex);
+    //! Sequence of the next mempool notification expected
+    uint64_t m_next_sequence GUARDED_BY(m_pending_mutex){0};
+    //! Whether notifications were dropped since the template was brought up to date
+    bool m_missed GUARDED_BY(m_pending_mutex){false};
+};
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -13,6 +13,7 @@ using namespace MWEB;
 void Miner::NewBlock(const uint64_t nHeight)
 {
     mweb_builder = std::make_shared<mw::BlockBuilder>(nHeight, ::ChainstateActive().CoinsTip().GetMWEBView());
+    mweb_block.reset();
     hogex_fees = 0;
     hogex_sigops = 0;
     mweb_amount_change = 0;
@@ -85,6 +86,7 @@ bool Miner::AddMWEBTransaction(CTxMemPool::txiter iter)
         return false;
     }
 
+    mweb_block.reset();
     hogex_inputs.insert(hogex_inputs.end(), vin.cbegin(), vin.cend());
     hogex_outputs.insert(hogex_outputs.end(), vout.cbegin(), vout.cend());
     mweb_amount_change += (CAmount(pegin_amount) - CAmount(pegout_amount + tx_fee));
@@ -133,20 +135,28 @@ void Miner::AddHogExTransaction(const CBlockIndex* pIndexPrev, CBlock* pblock, C
     CMutableTransaction hogExTransaction;
     hogExTransaction.m_hogEx = true;
 
-    CBlock prevBlock;
-    bool read_success = ReadBlockFromDisk(prevBlock, pIndexPrev, Params().GetConsensus());
-    assert(read_success);
+    if (pIndexPrev != prev_hogex_index) {
+        CBlock prevBlock;
+        bool read_success = ReadBlockFromDisk(prevBlock, pIndexPrev, Params().GetConsensus());
+        assert(read_success);
+
+        prev_hogex.reset();
+        if (prevBlock.vtx.size() >= 2 && prevBlock.vtx.back()->IsHogEx()) {
+            prev_hogex = prevBlock.vtx.back();
+        }
+        prev_hogex_index = pIndexPrev;
+    }
 
     CAmount previous_amount = 0;
 
     //
     // Add previous HogAddr as new HogEx input
     //
-    if (prevBlock.vtx.size() >= 2 && prevBlock.vtx.back()->IsHogEx()) {
-        assert(!prevBlock.vtx.back()->vout.empty());
-        previous_amount = prevBlock.vtx.back()->vout[0].nValue;
+    if (prev_hogex) {
+        assert(!prev_hogex->vout.empty());
+        previous_amount = prev_hogex->vout[0].nValue;
 
-        CTxIn prevHogExIn(prevBlock.vtx.back()->GetHash(), 0);
+        CTxIn prevHogExIn(prev_hogex->GetHash(), 0);
         hogExTransaction.vin.push_back(std::move(prevHogExIn));
     }
 
@@ -158,7 +168,9 @@ void Miner::AddHogExTransaction(const CBlockIndex* pIndexPrev, CBlock* pblock, C
     //
     // Add New HogAddr
     //
-    mw::Block::Ptr mweb_block = mweb_builder->BuildBlock();
+    if (!mweb_block) {
+        mweb_block = mweb_builder->BuildBlock();
+    }
 
     CTxOut hogAddr;
     hogAddr.scriptPubKey = CScript() << OP_8 << mweb_block->GetHash().vec();
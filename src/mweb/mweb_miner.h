@@ -20,11 +20,17 @@ private:
 
     // MWEB Attributes
     mw::BlockBuilder::Ptr mweb_builder;
+    mw::Block::Ptr mweb_block; // built from mweb_builder, reset when a transaction is added
     CAmount mweb_amount_change;
     CAmount hogex_fees;
     int64_t hogex_sigops;
     std::vector<CTxIn> hogex_inputs;
     std::vector<CTxOut> hogex_outputs;
+
+    // HogEx of the block the template builds on, so refreshing a template
+    // on the same tip doesn't read that block from disk again.
+    const CBlockIndex* prev_hogex_index{nullptr};
+    CTransactionRef prev_hogex;
 };
 
 } // namespace MWEB
\ No newline at end of file
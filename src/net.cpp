@@ -36,6 +36,18 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#ifdef USE_ZEROCOPY
+#include <linux/errqueue.h>
+#endif
+
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/upnpcommands.h>
@@ -120,6 +132,7 @@ RecursiveMutex cs_mapLocalHost;
 std::map<CNetAddr, LocalServiceInfo> mapLocalHost GUARDED_BY(cs_mapLocalHost);
 static bool vfLimited[NET_MAX] GUARDED_BY(cs_mapLocalHost) = {};
 std::string strSubVersion;
+RecvBufferPool g_recv_buffer_pool;
 
 void CConnman::AddAddrFetch(const std::string& strDest)
 {
@@ -691,6 +704,67 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+/** Index of the smallest size class holding buffers of at least size bytes */
+static size_t RecvBufferSizeClass(size_t size)
+{
+    size_t size_class = 0;
+    while ((MIN_POOLED_RECV_BUFFER_SIZE << size_class) < size) ++size_class;
+    return size_class;
+}
+
+CSerializeData RecvBufferPool::Get(size_t size)
+{
+    CSerializeData buffer;
+    if (size == 0) return buffer;
+    const size_t size_class = RecvBufferSizeClass(size);
+    if (size_class < NUM_SIZE_CLASSES) {
+        LOCK(m_mutex);
+        std::vector<CSerializeData>& free = m_free[size_class];
+        if (!free.empty()) {
+            buffer = std::move(free.back());
+            free.pop_back();
+            m_usage -= buffer.capacity();
+            ++m_reuses;
+            return buffer;
+        }
+        ++m_allocations;
+    } else {
+        WITH_LOCK(m_mutex, ++m_allocations);
+    }
+    buffer.reserve(std::max(size, MIN_POOLED_RECV_BUFFER_SIZE << size_class));
+    return buffer;
+}
+
+void RecvBufferPool::Put(CSerializeData&& buffer)
+{
+    const size_t capacity = buffer.capacity();
+    if (capacity < MIN_POOLED_RECV_BUFFER_SIZE || capacity > MAX_POOLED_RECV_BUFFER_SIZE) return;
+    // The largest class whose buffers this one can stand in for
+    size_t size_class = RecvBufferSizeClass(capacity);
+    if ((MIN_POOLED_RECV_BUFFER_SIZE << size_class) > capacity) --size_class;
+    buffer.clear();
+
+    LOCK(m_mutex);
+    std::vector<CSerializeData>& free = m_free[size_class];
+    if (free.size() >= MAX_POOLED_RECV_BUFFERS_PER_SIZE || m_usage + capacity > MAX_RECV_BUFFER_POOL_USAGE) return;
+    free.push_back(std::move(buffer));
+    m_usage += capacity;
+}
+
+RecvBufferPoolStats RecvBufferPool::GetStats() const
+{
+    RecvBufferPoolStats stats;
+    stats.bytes_received = m_bytes_received;
+    LOCK(m_mutex);
+    stats.allocations = m_allocations;
+    stats.reuses = m_reuses;
+    for (const std::vector<CSerializeData>& free : m_free) {
+        stats.free_buffers += free.size();
+    }
+    stats.usage = m_usage;
+    return stats;
+}
+
 int V1TransportDeserializer::readHeader(const char *pch, unsigned int nBytes)
 {
     // copy data to temporary parsing buffer
@@ -725,6 +799,12 @@ int V1TransportDeserializer::readHeader(const char *pch, unsigned int nBytes)
         return -1;
     }
 
+    // Receive the payload into a pooled buffer. Only allocate up to MAX_POOLED_RECV_BUFFER_SIZE ahead,
+    // readData() grows the buffer beyond that as the data arrives.
+    CSerializeData buffer = g_recv_buffer_pool.Get(std::min<size_t>(hdr.nMessageSize, MAX_POOLED_RECV_BUFFER_SIZE));
+    vRecv.SwapBuffer(buffer);
+    g_recv_buffer_pool.Put(std::move(buffer));
+
     // switch state to reading message data
     in_data = true;
 
@@ -738,7 +818,7 @@ int V1TransportDeserializer::readData(const char *pch, unsigned int nBytes)
 
     if (vRecv.size() < nDataPos + nCopy) {
         // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        vRecv.resize(std::min<size_t>(hdr.nMessageSize, nDataPos + nCopy + MAX_POOLED_RECV_BUFFER_SIZE));
     }
 
     hasher.Write({(const unsigned char*)pch, nCopy});
@@ -758,8 +838,9 @@ const uint256& V1TransportDeserializer::GetMessageHash() const
 
 Optional<CNetMessage> V1TransportDeserializer::GetMessage(const std::chrono::microseconds time, uint32_t& out_err_raw_size)
 {
-    // decompose a single CNetMessage from the TransportDeserializer
+    // decompose a single CNetMessage from the TransportDeserializer, handing it the payload buffer
     Optional<CNetMessage> msg(std::move(vRecv));
+    g_recv_buffer_pool.RecordBytesReceived(hdr.nMessageSize);
 
     // store command string, time, and sizes
     msg->m_command = hdr.GetCommand();
@@ -806,39 +887,104 @@ void V1TransportSerializer::prepareForTransport(CSerializedNetMsg& msg, std::vec
     CVectorWriter{SER_NETWORK, INIT_PROTO_VERSION, header, 0, hdr};
 }
 
+/**
+ * Send as much of the node's queued data as the socket accepts. Consecutive
+ * queued buffers (message headers and payloads) are gathered into a single
+ * sendmsg() call, so that many small messages don't cost a system call each.
+ * With -sendzerocopy, large payloads are sent on their own with MSG_ZEROCOPY
+ * and kept alive until the kernel reports that it has sent them.
+ */
 size_t CConnman::SocketSendData(CNode *pnode) const EXCLUSIVE_LOCKS_REQUIRED(pnode->cs_vSend)
 {
+#ifdef USE_ZEROCOPY
+    if (pnode->m_zerocopy) ReapZeroCopyCompletions(pnode);
+#endif
+
     auto it = pnode->vSendMsg.begin();
     size_t nSentSize = 0;
 
     while (it != pnode->vSendMsg.end()) {
-        const auto &data = *it;
-        assert(data.size() > pnode->nSendOffset);
+        assert(it->size() > pnode->nSendOffset);
         int nBytes = 0;
+        size_t nToSend = 0;
+        bool zerocopy = false;
         {
             LOCK(pnode->cs_hSocket);
             if (pnode->hSocket == INVALID_SOCKET)
                 break;
-            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(data.data()) + pnode->nSendOffset, data.size() - pnode->nSendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+#ifdef WIN32
+            nToSend = it->size() - pnode->nSendOffset;
+            nBytes = send(pnode->hSocket, reinterpret_cast<const char*>(it->data()) + pnode->nSendOffset, nToSend, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+            struct iovec iov[MAX_SEND_IOVECS];
+            size_t iov_count = 0;
+            for (auto buf_it = it; buf_it != pnode->vSendMsg.end() && iov_count < MAX_SEND_IOVECS; ++buf_it) {
+                const size_t offset = buf_it == it ? pnode->nSendOffset : 0;
+#ifdef USE_ZEROCOPY
+                if (pnode->m_zerocopy && !pnode->m_zerocopy_disabled && buf_it->size() - offset >= MIN_ZEROCOPY_SEND_SIZE) {
+                    // Large payloads are sent on their own, so that a completion covers exactly one buffer.
+                    if (iov_count > 0) break;
+                    zerocopy = true;
+                }
+#endif
+                iov[iov_count].iov_base = buf_it->data() + offset;
+                iov[iov_count].iov_len = buf_it->size() - offset;
+                nToSend += iov[iov_count].iov_len;
+                ++iov_count;
+                if (zerocopy) break;
+            }
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iov_count;
+            int flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+#ifdef USE_ZEROCOPY
+            if (zerocopy) flags |= MSG_ZEROCOPY;
+#endif
+            nBytes = sendmsg(pnode->hSocket, &msg, flags);
+#endif
         }
+        ++m_send_calls;
         if (nBytes > 0) {
             pnode->nLastSend = GetSystemTimeInSeconds();
             pnode->nSendBytes += nBytes;
-            pnode->nSendOffset += nBytes;
             nSentSize += nBytes;
-            if (pnode->nSendOffset == data.size()) {
+            if (zerocopy) {
+                m_zerocopy_bytes_sent += nBytes;
+                pnode->m_zerocopy_front = true;
+                ++pnode->m_zerocopy_next_seq;
+            }
+            // Advance over the buffers that were sent completely
+            size_t remaining = nBytes;
+            while (remaining > 0 && remaining >= it->size() - pnode->nSendOffset) {
+                remaining -= it->size() - pnode->nSendOffset;
                 pnode->nSendOffset = 0;
-                pnode->nSendSize -= data.size();
+                pnode->nSendSize -= it->size();
                 pnode->fPauseSend = pnode->nSendSize > nSendBufferMaxSize;
+                if (pnode->m_zerocopy_front) {
+                    // The kernel may still read from the buffer, keep it until the send completes.
+                    pnode->m_zerocopy_pending.emplace_back(pnode->m_zerocopy_next_seq - 1, std::move(*it));
+                    pnode->m_zerocopy_front = false;
+                }
                 it++;
-            } else {
-                // could not send full message; stop sending more
+            }
+            pnode->nSendOffset += remaining;
+            if ((size_t)nBytes < nToSend) {
+                // could not send all data; stop sending more
                 break;
             }
         } else {
             if (nBytes < 0) {
                 // error
                 int nErr = WSAGetLastError();
+#ifdef USE_ZEROCOPY
+                if (zerocopy && nErr == ENOBUFS) {
+                    // Out of memory for pinning the payload, send it by copying from now on. Completions
+                    // of earlier sends are still reaped, as their payloads are kept until then.
+                    LogPrint(BCLog::NET, "MSG_ZEROCOPY send failed for peer=%d, disabling it\n", pnode->GetId());
+                    pnode->m_zerocopy_disabled = true;
+                    continue;
+                }
+#endif
                 if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
                 {
                     LogPrintf("socket send error %s\n", NetworkErrorString(nErr));
@@ -858,6 +1004,44 @@ size_t CConnman::SocketSendData(CNode *pnode) const EXCLUSIVE_LOCKS_REQUIRED(pno
     return nSentSize;
 }
 
+#ifdef USE_ZEROCOPY
+void CConnman::ReapZeroCopyCompletions(CNode* pnode) const EXCLUSIVE_LOCKS_REQUIRED(pnode->cs_vSend)
+{
+    while (!pnode->m_zerocopy_pending.empty()) {
+        char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+        struct msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        {
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET) {
+                // The socket is closed, nothing references the payloads anymore.
+                pnode->m_zerocopy_pending.clear();
+                return;
+            }
+            if (recvmsg(pnode->hSocket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+        }
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+                !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) continue;
+            const struct sock_extended_err* err = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+            // Send calls ee_info through ee_data have completed. Completions are usually in order,
+            // but out of order ranges are kept until the ones before them complete.
+            pnode->m_zerocopy_completed_ranges[err->ee_info] = err->ee_data;
+        }
+        auto range = pnode->m_zerocopy_completed_ranges.begin();
+        while (range != pnode->m_zerocopy_completed_ranges.end() && range->first <= pnode->m_zerocopy_completed) {
+            pnode->m_zerocopy_completed = std::max(pnode->m_zerocopy_completed, range->second + 1);
+            range = pnode->m_zerocopy_completed_ranges.erase(range);
+        }
+    }
+    while (!pnode->m_zerocopy_pending.empty() && pnode->m_zerocopy_pending.front().first < pnode->m_zerocopy_completed) {
+        pnode->m_zerocopy_pending.pop_front();
+    }
+}
+#endif
+
 struct NodeEvictionCandidate
 {
     NodeId id;
@@ -1152,10 +1336,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 
     LogPrint(BCLog::NET, "connection from %s accepted\n", addr.ToString());
 
-    {
-        LOCK(cs_vNodes);
-        vNodes.push_back(pnode);
-    }
+    AddNode(pnode);
 
     // We received a new connection, harvest entropy from the time (and our peer count)
     RandAddEvent((uint32_t)id);
@@ -1220,6 +1401,11 @@ void CConnman::DisconnectNodes()
             {
                 // remove from vNodes
                 vNodes.erase(remove(vNodes.begin(), vNodes.end(), pnode), vNodes.end());
+#ifdef USE_EPOLL
+                // closing the socket below also removes it from the epoll set
+                m_epoll_nodes.erase(pnode->GetId());
+                m_epoll_readable.erase(pnode->GetId());
+#endif
 
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
@@ -1467,8 +1653,277 @@ void CConnman::SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_s
 }
 #endif
 
+void CConnman::AddNode(CNode* pnode)
+{
+#ifdef USE_ZEROCOPY
+    if (m_send_zerocopy) {
+        LOCK(pnode->cs_hSocket);
+        const int enable = 1;
+        if (pnode->hSocket != INVALID_SOCKET && setsockopt(pnode->hSocket, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0) {
+            pnode->m_zerocopy = true;
+        }
+    }
+#endif
+    LOCK(cs_vNodes);
+    vNodes.push_back(pnode);
+#ifdef USE_EPOLL
+    if (m_epoll_fd != -1) {
+        m_epoll_nodes.emplace(pnode->GetId(), pnode);
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET) return;
+        struct epoll_event event{};
+        event.events = EPOLLIN | EPOLLET;
+        event.data.u64 = pnode->GetId();
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+            LogPrintf("epoll_ctl failed to add socket for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(WSAGetLastError()));
+            pnode->fDisconnect = true;
+        }
+    }
+#endif
+}
+
+/**
+ * Read once from a node's socket and hand any completed messages to the
+ * message handler. Returns true if the read filled the whole buffer, in
+ * which case more data may still be pending on the socket.
+ */
+bool CConnman::SocketRecvData(CNode* pnode)
+{
+#ifdef USE_ZEROCOPY
+    // Send completions are reported on the socket's error queue, which also wakes the socket up for reading.
+    if (pnode->m_zerocopy) {
+        LOCK(pnode->cs_vSend);
+        ReapZeroCopyCompletions(pnode);
+    }
+#endif
+
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    int nBytes = 0;
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return false;
+        nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    }
+    if (nBytes > 0)
+    {
+        bool notify = false;
+        if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+            pnode->CloseSocketDisconnect();
+        RecordBytesRecv(nBytes);
+        if (notify) {
+            size_t nSizeAdded = 0;
+            auto it(pnode->vRecvMsg.begin());
+            for (; it != pnode->vRecvMsg.end(); ++it) {
+                // vRecvMsg contains only completed CNetMessage
+                // the single possible partially deserialized message are held by TransportDeserializer
+                nSizeAdded += it->m_raw_message_size;
+            }
+            {
+                LOCK(pnode->cs_vProcessMsg);
+                pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                pnode->nProcessQueueSize += nSizeAdded;
+                pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+            }
+            WakeMessageHandler(pnode->GetId());
+        }
+        return nBytes == (int)sizeof(pchBuf) && !pnode->fDisconnect;
+    }
+    else if (nBytes == 0)
+    {
+        // socket closed gracefully
+        if (!pnode->fDisconnect) {
+            LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
+        }
+        pnode->CloseSocketDisconnect();
+    }
+    else if (nBytes < 0)
+    {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr == WSAEINTR) return true;
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINPROGRESS)
+        {
+            if (!pnode->fDisconnect) {
+                LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
+            }
+            pnode->CloseSocketDisconnect();
+        }
+    }
+    return false;
+}
+
+#ifdef USE_EPOLL
+/** Tag set in the epoll event data of listening sockets, whose lower bits hold the index into vhListenSocket. */
+static constexpr uint64_t EPOLL_LISTEN_SOCKET_TAG = uint64_t{1} << 63;
+/** Maximum number of events returned by a single epoll_wait() call. */
+static constexpr int MAX_EPOLL_EVENTS = 1024;
+
+bool CConnman::InitEpoll()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd == -1) {
+        LogPrintf("epoll_create1 failed: %s\n", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+    for (size_t i = 0; i < vhListenSocket.size(); ++i) {
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = EPOLL_LISTEN_SOCKET_TAG | i;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, vhListenSocket[i].socket, &event) != 0) {
+            LogPrintf("epoll_ctl failed to add listening socket: %s\n", NetworkErrorString(WSAGetLastError()));
+            close(m_epoll_fd);
+            m_epoll_fd = -1;
+            return false;
+        }
+    }
+    return true;
+}
+
+void CConnman::UpdateSendInterest(CNode* pnode)
+{
+    const bool want_send = !pnode->vSendMsg.empty();
+    if (m_epoll_fd == -1 || want_send == pnode->m_epoll_send_interest) return;
+
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET) return;
+    struct epoll_event event{};
+    event.events = EPOLLIN | EPOLLET | (want_send ? uint32_t{EPOLLOUT} : 0u);
+    event.data.u64 = pnode->GetId();
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, pnode->hSocket, &event) == 0) {
+        pnode->m_epoll_send_interest = want_send;
+    }
+}
+
+void CConnman::EpollSocketHandler()
+{
+    // If a previous pass left data unread on a socket that can be read right
+    // away, only check for new events instead of waiting for them.
+    bool more_data = false;
+    if (!m_epoll_readable.empty()) {
+        LOCK(cs_vNodes);
+        for (const NodeId id : m_epoll_readable) {
+            auto it = m_epoll_nodes.find(id);
+            if (it == m_epoll_nodes.end() || it->second->fPauseRecv) continue;
+            LOCK(it->second->cs_vSend);
+            if (it->second->vSendMsg.empty()) {
+                more_data = true;
+                break;
+            }
+        }
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    int num_events = epoll_wait(m_epoll_fd, events, MAX_EPOLL_EVENTS, more_data ? 0 : SELECT_TIMEOUT_MILLISECONDS);
+
+    if (interruptNet) return;
+
+    if (num_events < 0) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINTR) {
+            LogPrintf("epoll_wait error %s\n", NetworkErrorString(nErr));
+            interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
+        }
+        return;
+    }
+
+    std::unordered_set<NodeId> send_set;
+    for (int i = 0; i < num_events; ++i) {
+        const uint64_t data = events[i].data.u64;
+        if (data & EPOLL_LISTEN_SOCKET_TAG) {
+            const size_t index = data & ~EPOLL_LISTEN_SOCKET_TAG;
+            if (index < vhListenSocket.size() && vhListenSocket[index].socket != INVALID_SOCKET) {
+                AcceptConnection(vhListenSocket[index]);
+            }
+            continue;
+        }
+        const NodeId id = data;
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) m_epoll_readable.insert(id);
+        if (events[i].events & EPOLLOUT) send_set.insert(id);
+    }
+
+    //
+    // Service the sockets that have events or unread data
+    //
+    std::vector<CNode*> vNodesCopy;
+    {
+        LOCK(cs_vNodes);
+        for (auto it = m_epoll_readable.begin(); it != m_epoll_readable.end();) {
+            auto node_it = m_epoll_nodes.find(*it);
+            if (node_it == m_epoll_nodes.end()) {
+                it = m_epoll_readable.erase(it);
+                continue;
+            }
+            vNodesCopy.push_back(node_it->second);
+            send_set.erase(*it);
+            ++it;
+        }
+        for (const NodeId id : send_set) {
+            auto node_it = m_epoll_nodes.find(id);
+            if (node_it != m_epoll_nodes.end()) vNodesCopy.push_back(node_it->second);
+        }
+        for (CNode* pnode : vNodesCopy)
+            pnode->AddRef();
+    }
+    for (CNode* pnode : vNodesCopy)
+    {
+        if (interruptNet)
+            break;
+
+        //
+        // Send
+        //
+        // As in the legacy handler, a node with queued data is drained before
+        // anything more is received from it. It stays in m_epoll_readable
+        // until it can be read.
+        bool send_pending;
+        {
+            LOCK(pnode->cs_vSend);
+            if (!pnode->vSendMsg.empty()) {
+                size_t nBytes = SocketSendData(pnode);
+                if (nBytes) {
+                    RecordBytesSent(nBytes);
+                }
+            }
+            UpdateSendInterest(pnode);
+            send_pending = !pnode->vSendMsg.empty();
+        }
+
+        //
+        // Receive
+        //
+        const NodeId id = pnode->GetId();
+        if (!send_pending && !pnode->fPauseRecv && m_epoll_readable.count(id)) {
+            if (!SocketRecvData(pnode)) {
+                // Drained until EAGAIN (or closed), so the next read is signalled by a new edge.
+                m_epoll_readable.erase(id);
+            }
+        }
+    }
+    {
+        LOCK(cs_vNodes);
+        const int64_t nTime = GetSystemTimeInSeconds();
+        if (!interruptNet && nTime >= m_epoll_next_inactivity_check) {
+            for (CNode* pnode : vNodes)
+                InactivityCheck(pnode);
+            m_epoll_next_inactivity_check = nTime + 1;
+        }
+        for (CNode* pnode : vNodesCopy)
+            pnode->Release();
+    }
+}
+#endif
+
 void CConnman::SocketHandler()
 {
+#ifdef USE_EPOLL
+    if (m_epoll_fd != -1) {
+        EpollSocketHandler();
+        return;
+    }
+#endif
+
     std::set<SOCKET> recv_set, send_set, error_set;
     SocketEvents(recv_set, send_set, error_set);
 
@@ -1516,58 +1971,7 @@ void CConnman::SocketHandler()
         }
         if (recvSet || errorSet)
         {
-            // typical socket buffer is 8K-64K
-            char pchBuf[0x10000];
-            int nBytes = 0;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-            }
-            if (nBytes > 0)
-            {
-                bool notify = false;
-                if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                    pnode->CloseSocketDisconnect();
-                RecordBytesRecv(nBytes);
-                if (notify) {
-                    size_t nSizeAdded = 0;
-                    auto it(pnode->vRecvMsg.begin());
-                    for (; it != pnode->vRecvMsg.end(); ++it) {
-                        // vRecvMsg contains only completed CNetMessage
-                        // the single possible partially deserialized message are held by TransportDeserializer
-                        nSizeAdded += it->m_raw_message_size;
-                    }
-                    {
-                        LOCK(pnode->cs_vProcessMsg);
-                        pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                        pnode->nProcessQueueSize += nSizeAdded;
-                        pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                    }
-                    WakeMessageHandler();
-                }
-            }
-            else if (nBytes == 0)
-            {
-                // socket closed gracefully
-                if (!pnode->fDisconnect) {
-                    LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
-                }
-                pnode->CloseSocketDisconnect();
-            }
-            else if (nBytes < 0)
-            {
-                // error
-                int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
-                    }
-                    pnode->CloseSocketDisconnect();
-                }
-            }
+            SocketRecvData(pnode);
         }
 
         //
@@ -1603,11 +2007,50 @@ void CConnman::ThreadSocketHandler()
 
 void CConnman::WakeMessageHandler()
 {
+    for (const auto& msghand : m_msghand_threads) {
+        {
+            LOCK(msghand->mutexMsgProc);
+            msghand->fMsgProcWake = true;
+        }
+        msghand->condMsgProc.notify_one();
+    }
+}
+
+void CConnman::WakeMessageHandler(NodeId id)
+{
+    const size_t index = GetMessageHandlerIndex(id);
+    if (index >= m_msghand_threads.size()) return;
+    MessageHandlerThread& msghand = *m_msghand_threads[index];
     {
-        LOCK(mutexMsgProc);
-        fMsgProcWake = true;
+        LOCK(msghand.mutexMsgProc);
+        msghand.fMsgProcWake = true;
     }
-    condMsgProc.notify_one();
+    msghand.condMsgProc.notify_one();
+}
+
+SendCallStats CConnman::GetSendCallStats()
+{
+    SendCallStats stats;
+    stats.calls = m_send_calls;
+    stats.bytes = WITH_LOCK(cs_totalBytesSent, return nTotalBytesSent);
+    stats.zerocopy_bytes = m_zerocopy_bytes_sent;
+    return stats;
+}
+
+std::vector<MessageHandlerStats> CConnman::GetMessageHandlerStats() const
+{
+    std::vector<MessageHandlerStats> stats(m_msghand_threads.size());
+    for (size_t i = 0; i < m_msghand_threads.size(); ++i) {
+        stats[i].thread_index = i;
+        stats[i].busy_time = m_msghand_threads[i]->busy_time;
+        stats[i].utilization = m_msghand_threads[i]->utilization;
+    }
+    LOCK(cs_vNodes);
+    for (const CNode* pnode : vNodes) {
+        const size_t index = GetMessageHandlerIndex(pnode->GetId());
+        if (index < stats.size()) ++stats[index].num_peers;
+    }
+    return stats;
 }
 
 
@@ -2242,26 +2685,31 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         grantOutbound->MoveTo(pnode->grantOutbound);
 
     m_msgproc->InitializeNode(pnode);
-    {
-        LOCK(cs_vNodes);
-        vNodes.push_back(pnode);
-    }
+    AddNode(pnode);
 }
 
-void CConnman::ThreadMessageHandler()
+/** Period over which the utilization of a message handler thread is measured */
+static constexpr int64_t MSGHAND_UTILIZATION_WINDOW_MICROS = 10 * 1000 * 1000;
+
+void CConnman::ThreadMessageHandler(size_t thread_index)
 {
+    MessageHandlerThread& msghand = *m_msghand_threads[thread_index];
+    msghand.window_start = GetTimeMicros();
+
     while (!flagInterruptMsgProc)
     {
         std::vector<CNode*> vNodesCopy;
         {
             LOCK(cs_vNodes);
-            vNodesCopy = vNodes;
-            for (CNode* pnode : vNodesCopy) {
+            for (CNode* pnode : vNodes) {
+                if (GetMessageHandlerIndex(pnode->GetId()) != thread_index) continue;
                 pnode->AddRef();
+                vNodesCopy.push_back(pnode);
             }
         }
 
         bool fMoreWork = false;
+        const int64_t busy_start = GetTimeMicros();
 
         for (CNode* pnode : vNodesCopy)
         {
@@ -2289,11 +2737,20 @@ void CConnman::ThreadMessageHandler()
                 pnode->Release();
         }
 
-        WAIT_LOCK(mutexMsgProc, lock);
+        const int64_t now = GetTimeMicros();
+        msghand.busy_time += now - busy_start;
+        msghand.window_busy_time += now - busy_start;
+        if (now - msghand.window_start >= MSGHAND_UTILIZATION_WINDOW_MICROS) {
+            msghand.utilization = double(msghand.window_busy_time) / (now - msghand.window_start);
+            msghand.window_start = now;
+            msghand.window_busy_time = 0;
+        }
+
+        WAIT_LOCK(msghand.mutexMsgProc, lock);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this]() EXCLUSIVE_LOCKS_REQUIRED(mutexMsgProc) { return fMsgProcWake; });
+            msghand.condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [&msghand]() EXCLUSIVE_LOCKS_REQUIRED(msghand.mutexMsgProc) { return msghand.fMsgProcWake; });
         }
-        fMsgProcWake = false;
+        msghand.fMsgProcWake = false;
     }
 }
 
@@ -2560,10 +3017,16 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     interruptNet.reset();
     flagInterruptMsgProc = false;
 
-    {
-        LOCK(mutexMsgProc);
-        fMsgProcWake = false;
+    m_msghand_threads.clear();
+    for (int i = 0; i < m_num_msghand_threads; ++i) {
+        m_msghand_threads.push_back(MakeUnique<MessageHandlerThread>());
+    }
+
+#ifdef USE_EPOLL
+    if (m_use_epoll && !InitEpoll()) {
+        LogPrintf("Failed to initialize epoll, falling back to poll() for socket events\n");
     }
+#endif
 
     // Send and receive from sockets, accept connections
     threadSocketHandler = std::thread(&TraceThread<std::function<void()> >, "net", std::function<void()>(std::bind(&CConnman::ThreadSocketHandler, this)));
@@ -2588,7 +3051,11 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         threadOpenConnections = std::thread(&TraceThread<std::function<void()> >, "opencon", std::function<void()>(std::bind(&CConnman::ThreadOpenConnections, this, connOptions.m_specified_outgoing)));
 
     // Process messages
-    threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
+    for (size_t i = 0; i < m_msghand_threads.size(); ++i) {
+        MessageHandlerThread& msghand = *m_msghand_threads[i];
+        msghand.name = i == 0 ? "msghand" : strprintf("msghand.%u", i);
+        msghand.thread = std::thread(&TraceThread<std::function<void()> >, msghand.name.c_str(), std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this, i)));
+    }
 
     // Dump network addresses
     scheduler.scheduleEvery([this] { DumpAddresses(); }, DUMP_PEERS_INTERVAL);
@@ -2613,11 +3080,12 @@ static CNetCleanup instance_of_cnetcleanup;
 
 void CConnman::Interrupt()
 {
-    {
-        LOCK(mutexMsgProc);
-        flagInterruptMsgProc = true;
+    flagInterruptMsgProc = true;
+    for (const auto& msghand : m_msghand_threads) {
+        // Synchronize with the thread so that the interruption can't be missed while it starts waiting
+        LOCK(msghand->mutexMsgProc);
+        msghand->condMsgProc.notify_all();
     }
-    condMsgProc.notify_all();
 
     interruptNet();
     InterruptSocks5(true);
@@ -2637,8 +3105,10 @@ void CConnman::Interrupt()
 
 void CConnman::StopThreads()
 {
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (const auto& msghand : m_msghand_threads) {
+        if (msghand->thread.joinable())
+            msghand->thread.join();
+    }
     if (threadOpenConnections.joinable())
         threadOpenConnections.join();
     if (threadOpenAddedConnections.joinable())
@@ -2684,6 +3154,14 @@ void CConnman::StopNodes()
     vNodes.clear();
     vNodesDisconnected.clear();
     vhListenSocket.clear();
+#ifdef USE_EPOLL
+    m_epoll_nodes.clear();
+    m_epoll_readable.clear();
+    if (m_epoll_fd != -1) {
+        close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+#endif
     semOutbound.reset();
     semAddnode.reset();
 }
@@ -2741,6 +3219,7 @@ std::vector<CAddress> CConnman::GetAddresses(CNode& requestor, size_t max_addres
         .Write(local_socket_bytes.data(), local_socket_bytes.size())
         .Finalize();
     const auto current_time = GetTime<std::chrono::microseconds>();
+    LOCK(m_addr_response_caches_mutex);
     auto r = m_addr_response_caches.emplace(cache_id, CachedAddrResponse{});
     CachedAddrResponse& cache_entry = r.first->second;
     if (cache_entry.m_cache_entry_expiration < current_time) { // If emplace() added new one it has expiration 0.
@@ -3067,6 +3546,10 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         // If write queue empty, attempt "optimistic write"
         if (optimisticSend == true)
             nBytesSent = SocketSendData(pnode);
+#ifdef USE_EPOLL
+        // Wait for the socket to become writable if anything is left over
+        UpdateSendInterest(pnode);
+#endif
     }
     if (nBytesSent)
         RecordBytesSent(nBytesSent);
@@ -25,11 +25,14 @@
 #include <threadinterrupt.h>
 #include <uint256.h>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
 #include <deque>
 #include <map>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <condition_variable>
 
@@ -88,6 +91,24 @@ static const int64_t DEFAULT_PEER_CONNECT_TIMEOUT = 60;
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
 static const size_t DEFAULT_MAXSENDBUFFER    = 1 * 1000;
+/** Default number of message handler threads */
+static const int DEFAULT_MSGHAND_THREADS = 2;
+/** Maximum number of message handler threads */
+static const int MAX_MSGHAND_THREADS = 16;
+/** Socket events backend used by the socket handler thread when -socketevents is not set */
+#if defined(USE_EPOLL)
+static const char* const DEFAULT_SOCKETEVENTS = "epoll";
+#elif defined(USE_POLL)
+static const char* const DEFAULT_SOCKETEVENTS = "poll";
+#else
+static const char* const DEFAULT_SOCKETEVENTS = "select";
+#endif
+/** Whether to send large payloads with MSG_ZEROCOPY by default */
+static const bool DEFAULT_SEND_ZEROCOPY = false;
+/** Maximum number of queued buffers passed to a single send call */
+static const size_t MAX_SEND_IOVECS = 64;
+/** Payloads at least this large are sent with MSG_ZEROCOPY when -sendzerocopy is set */
+static const size_t MIN_ZEROCOPY_SEND_SIZE = 64 * 1024;
 
 typedef int64_t NodeId;
 
@@ -102,6 +123,26 @@ struct AddedNodeInfo
 class CNodeStats;
 class CClientUIInterface;
 
+/** Statistics of a message handler thread */
+struct MessageHandlerStats
+{
+    size_t thread_index{0};
+    int num_peers{0};
+    /** Total time spent processing messages, in microseconds */
+    int64_t busy_time{0};
+    /** Fraction of time spent processing messages during the last utilization window */
+    double utilization{0};
+};
+
+/** Statistics of the send calls made on peer sockets */
+struct SendCallStats
+{
+    uint64_t calls{0};
+    uint64_t bytes{0};
+    //! Bytes sent with MSG_ZEROCOPY
+    uint64_t zerocopy_bytes{0};
+};
+
 struct CSerializedNetMsg
 {
     CSerializedNetMsg() = default;
@@ -221,6 +262,9 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         std::vector<bool> m_asmap;
+        bool m_use_epoll = false;
+        bool m_send_zerocopy = DEFAULT_SEND_ZEROCOPY;
+        int m_num_msghand_threads = 1;
     };
 
     void Init(const Options& connOptions) {
@@ -239,6 +283,9 @@ public:
         nSendBufferMaxSize = connOptions.nSendBufferMaxSize;
         nReceiveFloodSize = connOptions.nReceiveFloodSize;
         m_peer_connect_timeout = connOptions.m_peer_connect_timeout;
+        m_use_epoll = connOptions.m_use_epoll;
+        m_send_zerocopy = connOptions.m_send_zerocopy;
+        m_num_msghand_threads = std::max(1, std::min(connOptions.m_num_msghand_threads, MAX_MSGHAND_THREADS));
         {
             LOCK(cs_totalBytesSent);
             nMaxOutboundTimeframe = connOptions.nMaxOutboundTimeframe;
@@ -407,7 +454,14 @@ public:
 
     unsigned int GetReceiveFloodSize() const;
 
+    /** Wake all message handler threads. */
     void WakeMessageHandler();
+    /** Wake the message handler thread that processes messages from the given node. */
+    void WakeMessageHandler(NodeId id);
+
+    std::vector<MessageHandlerStats> GetMessageHandlerStats() const;
+
+    SendCallStats GetSendCallStats();
 
     /** Attempts to obfuscate tx time through exponentially distributed emitting.
         Works assuming that a single interval is used.
@@ -438,15 +492,27 @@ private:
     void AddAddrFetch(const std::string& strDest);
     void ProcessAddrFetch();
     void ThreadOpenConnections(std::vector<std::string> connect);
-    void ThreadMessageHandler();
+    void ThreadMessageHandler(size_t thread_index);
+    /** Peers are sharded over the message handler threads by id, so that each peer's messages are processed in order. */
+    size_t GetMessageHandlerIndex(NodeId id) const { return id % m_num_msghand_threads; }
     void AcceptConnection(const ListenSocket& hListenSocket);
     void DisconnectNodes();
     void NotifyNumConnectionsChanged();
     void InactivityCheck(CNode *pnode);
     bool GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
     void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
+    bool SocketRecvData(CNode* pnode);
     void SocketHandler();
     void ThreadSocketHandler();
+    /** Add a newly connected node to vNodes and register its socket with the events backend. */
+    void AddNode(CNode* pnode);
+#ifdef USE_EPOLL
+    /** Create the epoll instance and register the listening sockets. Returns false if epoll is not usable. */
+    bool InitEpoll();
+    void EpollSocketHandler();
+    /** Add or remove EPOLLOUT interest so that it matches whether the node has data queued to send. */
+    void UpdateSendInterest(CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(pnode->cs_vSend);
+#endif
     void ThreadDNSAddressSeed();
 
     uint64_t CalculateKeyedNetGroup(const CAddress& ad) const;
@@ -471,6 +537,10 @@ private:
     NodeId GetNewNodeId();
 
     size_t SocketSendData(CNode *pnode) const;
+#ifdef USE_ZEROCOPY
+    /** Release the payloads the kernel reports it is done sending with MSG_ZEROCOPY. */
+    void ReapZeroCopyCompletions(CNode* pnode) const EXCLUSIVE_LOCKS_REQUIRED(pnode->cs_vSend);
+#endif
     void DumpAddresses();
 
     // Network stats
@@ -500,6 +570,36 @@ private:
     // P2P timeout in seconds
     int64_t m_peer_connect_timeout;
 
+    // Use the epoll socket events backend (-socketevents=epoll)
+    bool m_use_epoll{false};
+
+    // Send large payloads with MSG_ZEROCOPY where supported (-sendzerocopy)
+    bool m_send_zerocopy{false};
+
+    // Number of send calls made, and bytes sent with MSG_ZEROCOPY
+    mutable std::atomic<uint64_t> m_send_calls{0};
+    mutable std::atomic<uint64_t> m_zerocopy_bytes_sent{0};
+
+#ifdef USE_EPOLL
+    /**
+     * epoll instance used by the socket handler thread, or -1 if the legacy
+     * poll()/select() path is in use. Sockets are registered once when the
+     * node is added, edge-triggered for reading. Write interest is only
+     * added while a node has data queued in vSendMsg.
+     */
+    int m_epoll_fd{-1};
+    /** Nodes registered with m_epoll_fd, by the id stored in their epoll event data. */
+    std::unordered_map<NodeId, CNode*> m_epoll_nodes GUARDED_BY(cs_vNodes);
+    /**
+     * Nodes that were reported readable and have not been read until EAGAIN yet,
+     * either because they are paused or because more data was pending. Only
+     * accessed by the socket handler thread.
+     */
+    std::unordered_set<NodeId> m_epoll_readable;
+    /** Time of the next inactivity check over all nodes. Only accessed by the socket handler thread. */
+    int64_t m_epoll_next_inactivity_check{0};
+#endif
+
     // Whitelisted ranges. Any node connecting from these is automatically
     // whitelisted (as well as those connecting to whitelisted binds).
     std::vector<NetWhitelistPermissions> vWhitelistedRange;
@@ -546,7 +646,8 @@ private:
      * resulting in at most ~196 KB. Every separate local socket may
      * add up to ~196 KB extra.
      */
-    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches;
+    std::map<uint64_t, CachedAddrResponse> m_addr_response_caches GUARDED_BY(m_addr_response_caches_mutex);
+    Mutex m_addr_response_caches_mutex;
 
     /**
      * Services this instance offers.
@@ -592,11 +693,24 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake GUARDED_BY(mutexMsgProc);
+    struct MessageHandlerThread {
+        std::string name;
+        std::thread thread;
+        /** flag for waking the message processor. */
+        bool fMsgProcWake GUARDED_BY(mutexMsgProc){false};
+        std::condition_variable condMsgProc;
+        Mutex mutexMsgProc;
+
+        // Utilization of the thread. The window is only accessed by the thread itself.
+        int64_t window_start{0};
+        int64_t window_busy_time{0};
+        std::atomic<int64_t> busy_time{0};
+        std::atomic<double> utilization{0};
+    };
 
-    std::condition_variable condMsgProc;
-    Mutex mutexMsgProc;
+    /** Number of message handler threads started by Start() (-msghandthreads) */
+    int m_num_msghand_threads{1};
+    std::vector<std::unique_ptr<MessageHandlerThread>> m_msghand_threads;
     std::atomic<bool> flagInterruptMsgProc{false};
 
     CThreadInterrupt interruptNet;
@@ -605,7 +719,6 @@ private:
     std::thread threadSocketHandler;
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
-    std::thread threadMessageHandler;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of m_max_outbound_full_relay
@@ -741,6 +854,65 @@ public:
 
 
 
+/** Smallest receive buffer kept for reuse */
+static constexpr size_t MIN_POOLED_RECV_BUFFER_SIZE = 512;
+/** Largest receive buffer kept for reuse, which is also how far ahead a message's buffer is allocated */
+static constexpr size_t MAX_POOLED_RECV_BUFFER_SIZE = 256 * 1024;
+/** Maximum number of free buffers of each size kept */
+static constexpr size_t MAX_POOLED_RECV_BUFFERS_PER_SIZE = 64;
+/** Maximum total capacity of the free buffers kept */
+static constexpr size_t MAX_RECV_BUFFER_POOL_USAGE = 8 * 1024 * 1024;
+
+struct RecvBufferPoolStats
+{
+    //! Buffers allocated because no free buffer of the right size was available
+    uint64_t allocations{0};
+    //! Buffers reused from the pool
+    uint64_t reuses{0};
+    //! Message payload bytes received into the buffers
+    uint64_t bytes_received{0};
+    //! Number and total capacity of the free buffers kept
+    size_t free_buffers{0};
+    size_t usage{0};
+};
+
+/**
+ * Pool of receive buffers shared by all peers. A message is received into a
+ * buffer from the pool, processed straight from that buffer, and the buffer is
+ * returned to the pool when the message is destroyed, so that relaying many
+ * small messages doesn't allocate and free a buffer for each of them.
+ *
+ * Free buffers are kept in power of two size classes, from
+ * MIN_POOLED_RECV_BUFFER_SIZE up to MAX_POOLED_RECV_BUFFER_SIZE.
+ */
+class RecvBufferPool
+{
+public:
+    /** Get an empty buffer with a capacity of at least size bytes. */
+    CSerializeData Get(size_t size);
+
+    /** Return a buffer to the pool. It is freed if the pool doesn't keep it. */
+    void Put(CSerializeData&& buffer);
+
+    /** Record a complete message payload received into a pooled buffer. */
+    void RecordBytesReceived(uint64_t bytes) { m_bytes_received += bytes; }
+
+    RecvBufferPoolStats GetStats() const;
+
+private:
+    static constexpr size_t NUM_SIZE_CLASSES = 10;
+    static_assert(MIN_POOLED_RECV_BUFFER_SIZE << (NUM_SIZE_CLASSES - 1) == MAX_POOLED_RECV_BUFFER_SIZE, "size classes must cover the pooled sizes");
+
+    mutable Mutex m_mutex;
+    std::array<std::vector<CSerializeData>, NUM_SIZE_CLASSES> m_free GUARDED_BY(m_mutex);
+    size_t m_usage GUARDED_BY(m_mutex){0};
+    uint64_t m_allocations GUARDED_BY(m_mutex){0};
+    uint64_t m_reuses GUARDED_BY(m_mutex){0};
+    std::atomic<uint64_t> m_bytes_received{0};
+};
+
+extern RecvBufferPool g_recv_buffer_pool;
+
 /** Transport protocol agnostic message container.
  * Ideally it should only contain receive time, payload,
  * command and size.
@@ -754,6 +926,16 @@ public:
     std::string m_command;
 
     CNetMessage(CDataStream&& recv_in) : m_recv(std::move(recv_in)) {}
+    CNetMessage(CNetMessage&&) = default;
+    CNetMessage& operator=(CNetMessage&&) = default;
+
+    /** Return the buffer of the message to g_recv_buffer_pool once it has been processed */
+    ~CNetMessage()
+    {
+        CSerializeData buffer;
+        m_recv.SwapBuffer(buffer);
+        g_recv_buffer_pool.Put(std::move(buffer));
+    }
 
     void SetVersion(int nVersionIn)
     {
@@ -867,6 +1049,21 @@ public:
     size_t nSendOffset{0}; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
     std::deque<std::vector<unsigned char>> vSendMsg GUARDED_BY(cs_vSend);
+    //! Whether SO_ZEROCOPY is enabled on the socket, so that large payloads can be sent with MSG_ZEROCOPY
+    std::atomic_bool m_zerocopy{false};
+    //! Whether new sends stopped using MSG_ZEROCOPY after the kernel failed to pin a payload
+    bool m_zerocopy_disabled GUARDED_BY(cs_vSend){false};
+    //! Whether the first vSendMsg entry was (partially) sent with MSG_ZEROCOPY
+    bool m_zerocopy_front GUARDED_BY(cs_vSend){false};
+    //! Payloads sent with MSG_ZEROCOPY that the kernel may still read from, with the
+    //! sequence number of the last send call that referenced them
+    std::deque<std::pair<uint32_t, std::vector<unsigned char>>> m_zerocopy_pending GUARDED_BY(cs_vSend);
+    //! Sequence number of the next send call with MSG_ZEROCOPY
+    uint32_t m_zerocopy_next_seq GUARDED_BY(cs_vSend){0};
+    //! All send calls before this sequence number have completed
+    uint32_t m_zerocopy_completed GUARDED_BY(cs_vSend){0};
+    //! Completed ranges of send calls after m_zerocopy_completed, first to last
+    std::map<uint32_t, uint32_t> m_zerocopy_completed_ranges GUARDED_BY(cs_vSend);
     RecursiveMutex cs_vSend;
     RecursiveMutex cs_hSocket;
     RecursiveMutex cs_vRecv;
@@ -918,6 +1115,8 @@ public:
     const uint64_t nKeyedNetGroup;
     std::atomic_bool fPauseRecv{false};
     std::atomic_bool fPauseSend{false};
+    // Whether the socket is registered for EPOLLOUT with the connman's epoll instance
+    bool m_epoll_send_interest GUARDED_BY(cs_vSend){false};
 
     bool IsOutboundOrBlockRelayConn() const {
         switch (m_conn_type) {
@@ -7,6 +7,7 @@
 
 #include <addrman.h>
 #include <banman.h>
+#include <blockdownload.h>
 #include <blockencodings.h>
 #include <blockfilter.h>
 #include <chainparams.h>
@@ -17,6 +18,7 @@
 #include <mw/mmr/Segment.h>
 #include <netbase.h>
 #include <netmessagemaker.h>
+#include <node/txreconciliation.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <primitives/block.h>
@@ -91,7 +93,8 @@ static constexpr auto OVERLOADED_PEER_TX_DELAY = std::chrono::seconds{2};
 static constexpr std::chrono::microseconds GETDATA_TX_INTERVAL{std::chrono::seconds{60}};
 /** Limit to avoid sending big packets. Not used in processing incoming GETDATA for compatibility */
 static const unsigned int MAX_GETDATA_SZ = 1000;
-/** Number of blocks that can be requested at any given time from a single peer. */
+/** Number of blocks that can be requested at any given time from a single peer when fetching announced
+ *  blocks directly. Other block downloads use the per-peer quota from BlockDownloadScheduler. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
 static const unsigned int BLOCK_STALLING_TIMEOUT = 2;
@@ -242,9 +245,16 @@ namespace {
         const CBlockIndex* pindex;                               //!< Optional.
         bool fValidatedHeaders;                                  //!< Whether this block has validated headers at the time of request.
         std::unique_ptr<PartiallyDownloadedBlock> partialBlock;  //!< Optional, used for CMPCTBLOCK downloads
+        std::chrono::microseconds m_requested_time;              //!< When the block was requested.
     };
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight GUARDED_BY(cs_main);
 
+    /** Per-peer block delivery measurements and in-flight quotas. */
+    BlockDownloadScheduler g_block_download GUARDED_BY(cs_main);
+
+    /** Reconciliation-based transaction relay, if enabled with -txreconciliation. */
+    std::unique_ptr<TxReconciliationTracker> g_txreconciliation;
+
     /** Stack of nodes which we have set to announce using compact blocks */
     std::list<NodeId> lNodesAnnouncingHeaderAndIDs GUARDED_BY(cs_main);
 
@@ -325,6 +335,8 @@ struct CNodeState {
     int64_t nDownloadingSince;
     int nBlocksInFlight;
     int nBlocksInFlightValidHeaders;
+    //! Don't request blocks from this peer before this time, after its blocks in flight were reassigned.
+    std::chrono::microseconds m_block_download_paused_until{0};
     //! Whether we consider this a preferred download peer.
     bool fPreferredDownload;
     //! Whether this peer wants invs or headers (when possible) for block announcements.
@@ -345,6 +357,8 @@ struct CNodeState {
     bool fWantsCmpctWitness;
     //! Whether this peer wants MWEB transactions in cmpctblocks/blocktxns
     bool fWantsCmpctMWEB;
+    //! Whether this peer wants MWEB kernel short IDs instead of full MWEB blocks in cmpctblocks
+    bool fWantsCmpctMWEBShortIDs;
     /**
      * If we've announced NODE_WITNESS to this peer: whether the peer sends witnesses in cmpctblocks/blocktxns,
      * otherwise: whether this peer sends non-witnesses in cmpctblocks/blocktxns.
@@ -353,7 +367,9 @@ struct CNodeState {
 
     int GetCmpctBlockVersion()
     {
-        if (fWantsCmpctMWEB) {
+        if (fWantsCmpctMWEBShortIDs) {
+            return 4;
+        } else if (fWantsCmpctMWEB) {
             return 3;
         } else if (fWantsCmpctWitness) {
             return 2;
@@ -437,6 +453,7 @@ struct CNodeState {
         fHaveMWEB = false;
         fWantsCmpctWitness = false;
         fWantsCmpctMWEB = false;
+        fWantsCmpctMWEBShortIDs = false;
         fSupportsDesiredCmpctVersion = false;
         m_chain_sync = { 0, nullptr, false, false };
         m_last_block_announcement = 0;
@@ -554,7 +571,8 @@ static void PushNodeVersion(CNode& pnode, CConnman& connman, int64_t nTime)
 
 // Returns a bool indicating whether we requested this block.
 // Also used if a block was /not/ received and timed out or started with another peer
-static bool MarkBlockAsReceived(const uint256& hash, Optional<NodeId> from_peer) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
+// block_size is the serialized size of a block received from from_peer, for measuring its delivery rate.
+static bool MarkBlockAsReceived(const uint256& hash, Optional<NodeId> from_peer, size_t block_size = 0) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
     std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> >::iterator itInFlight = mapBlocksInFlight.find(hash);
     if (itInFlight != mapBlocksInFlight.end()) {
         auto node_id = itInFlight->second.first;
@@ -565,6 +583,10 @@ static bool MarkBlockAsReceived(const uint256& hash, Optional<NodeId> from_peer)
 
         CNodeState *state = State(itInFlight->second.first);
         assert(state != nullptr);
+        if (from_peer && block_size > 0) {
+            g_block_download.BlockReceived(node_id, block_size, itInFlight->second.second->m_requested_time, GetTime<std::chrono::microseconds>());
+            state->m_block_download_paused_until = std::chrono::microseconds{0};
+        }
         state->nBlocksInFlightValidHeaders -= itInFlight->second.second->fValidatedHeaders;
         if (state->nBlocksInFlightValidHeaders == 0 && itInFlight->second.second->fValidatedHeaders) {
             // Last validated block on the queue was received.
@@ -605,7 +627,7 @@ static bool MarkBlockAsInFlight(CTxMemPool& mempool, NodeId nodeid, const uint25
         mweb_block = (*(*pit))->partialBlock->mweb_block;
     }
     std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(),
-            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool, mweb_block) : nullptr)});
+            {hash, pindex, pindex != nullptr, std::unique_ptr<PartiallyDownloadedBlock>(pit ? new PartiallyDownloadedBlock(&mempool, mweb_block) : nullptr), GetTime<std::chrono::microseconds>()});
     state->nBlocksInFlight++;
     state->nBlocksInFlightValidHeaders += it->fValidatedHeaders;
     if (state->nBlocksInFlight == 1) {
@@ -879,7 +901,7 @@ void PeerManager::ReattemptInitialBroadcast(CScheduler& scheduler) const
 
         if (tx != nullptr) {
             LOCK(cs_main);
-            RelayTransaction(txid, tx->GetWitnessHash(), m_connman);
+            RelayTransaction(txid, tx->GetWitnessHash(), m_connman, tx->IsMWEBOnly());
         } else {
             m_mempool.RemoveUnbroadcastTx(txid, true);
         }
@@ -919,6 +941,9 @@ void PeerManager::FinalizeNode(const CNode& node, bool& fUpdateConnectionTime) {
     }
     EraseOrphansFor(nodeid);
     m_txrequest.DisconnectedPeer(nodeid);
+    g_block_download.DisconnectedPeer(nodeid);
+    if (g_txreconciliation) g_txreconciliation->ForgetPeer(nodeid);
+    m_msg_stats.ForgetPeer(nodeid);
     nPreferredDownload -= state->fPreferredDownload;
     nPeersWithValidatedDownloads -= (state->nBlocksInFlightValidHeaders != 0);
     assert(nPeersWithValidatedDownloads >= 0);
@@ -937,6 +962,7 @@ void PeerManager::FinalizeNode(const CNode& node, bool& fUpdateConnectionTime) {
         assert(g_outbound_peers_with_protect_from_disconnect == 0);
         assert(g_wtxid_relay_peers == 0);
         assert(m_txrequest.Size() == 0);
+        assert(g_block_download.Size() == 0);
     }
     LogPrint(BCLog::NET, "Cleared nodestate for peer=%d\n", nodeid);
 }
@@ -953,6 +979,7 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
             if (queue.pindex)
                 stats.vHeightInFlight.push_back(queue.pindex->nHeight);
         }
+        g_block_download.GetStats(nodeid, stats.m_block_download);
     }
 
     PeerRef peer = GetPeerRef(nodeid);
@@ -1237,6 +1264,12 @@ PeerManager::PeerManager(const CChainParams& chainparams, CConnman& connman, Ban
     // same probability that we have in the reject filter).
     g_recent_confirmed_transactions.reset(new CRollingBloomFilter(48000, 0.000001));
 
+    if (gArgs.GetBoolArg("-txreconciliation", DEFAULT_TXRECONCILIATION_ENABLE)) {
+        g_txreconciliation = MakeUnique<TxReconciliationTracker>(TXRECONCILIATION_VERSION);
+    } else {
+        g_txreconciliation.reset();
+    }
+
     // Stale tip checking and peer eviction are on two different timers, but we
     // don't want them to get out of sync due to drift in the scheduler, so we
     // combine them in one function and schedule at the quicker (peer-eviction)
@@ -1373,6 +1406,7 @@ void PeerManager::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_
             bool fPeerWantsMWEB = State(pnode->GetId())->fWantsCmpctMWEB;
             int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
             nSendFlags |= fPeerWantsMWEB ? 0 : SERIALIZE_NO_MWEB;
+            nSendFlags |= state.fWantsCmpctMWEBShortIDs ? SERIALIZE_MWEB_SHORTIDS : 0;
 
             LogPrint(BCLog::NET, "%s sending header-and-ids %s to peer=%d\n", "PeerManager::NewPoWValidBlock",
                     hashBlock.ToString(), pnode->GetId());
@@ -1493,13 +1527,20 @@ bool static AlreadyHaveBlock(const uint256& block_hash) EXCLUSIVE_LOCKS_REQUIRED
     return LookupBlockIndex(block_hash) != nullptr;
 }
 
-void RelayTransaction(const uint256& txid, const uint256& wtxid, const CConnman& connman)
+void RelayTransaction(const uint256& txid, const uint256& wtxid, const CConnman& connman, bool mweb_only)
 {
-    connman.ForEachNode([&txid, &wtxid](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
+    connman.ForEachNode([&txid, &wtxid, mweb_only](CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(::cs_main) {
         AssertLockHeld(::cs_main);
 
         CNodeState* state = State(pnode->GetId());
         if (state == nullptr) return;
+        if (g_txreconciliation && pnode->m_tx_relay != nullptr && g_txreconciliation->IsPeerRegistered(pnode->GetId())) {
+            // Reconcile instead of announcing. MWEB-only transactions (identified by kernel ID)
+            // are of no use to peers without MWEB support, so they aren't reconciled with them.
+            if (mweb_only && !state->fHaveMWEB) return;
+            if (WITH_LOCK(pnode->m_tx_relay->cs_tx_inventory, return pnode->m_tx_relay->filterInventoryKnown.contains(wtxid))) return;
+            if (g_txreconciliation->AddToSet(pnode->GetId(), wtxid)) return;
+        }
         if (state->m_wtxid_relay) {
             pnode->PushTxInventory(wtxid);
         } else {
@@ -1582,7 +1623,7 @@ static void ActivateBestChainIfNeeded(const CChainParams& chainparams, const CIn
     }
 }
 
-void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, const CInv& inv, CConnman& connman)
+void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, const CInv& inv, CConnman& connman, RawBlockCache& raw_block_cache)
 {
     bool send = false;
     std::shared_ptr<const CBlock> a_recent_block;
@@ -1600,130 +1641,165 @@ void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, c
 
     ActivateBestChainIfNeeded(chainparams, inv);
 
-    LOCK(cs_main);
-    const CBlockIndex* pindex = LookupBlockIndex(inv.hash);
-    if (pindex) {
-        send = BlockRequestAllowed(pindex, consensusParams);
-        if (!send) {
-            LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom.GetId());
+    // cs_main is only held for the checks below, so that reading the block from
+    // disk does not block validation or other message handler threads.
+    const CBlockIndex* pindex{nullptr};
+    const CBlockIndex* tip{nullptr};
+    FlatFilePos block_pos{};
+    bool can_direct_fetch{false};
+    bool fPeerWantsWitness{false};
+    bool fPeerWantsMWEB{false};
+    bool fPeerWantsMWEBShortIDs{false};
+    {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(inv.hash);
+        if (pindex) {
+            send = BlockRequestAllowed(pindex, consensusParams);
+            if (!send) {
+                LogPrint(BCLog::NET, "%s: ignoring request from peer=%i for old block that isn't in the main chain\n", __func__, pfrom.GetId());
+            }
         }
-    }
-    const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
-    // disconnect node in case we have reached the outbound limit for serving historical blocks
-    if (send &&
-        connman.OutboundTargetReached(true) &&
-        (((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.IsMsgFilteredBlk()) &&
-        !pfrom.HasPermission(PF_DOWNLOAD) // nodes with the download permission may exceed target
-    ) {
-        LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom.GetId());
-
-        //disconnect node
-        pfrom.fDisconnect = true;
-        send = false;
-    }
-    // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
-    if (send && !pfrom.HasPermission(PF_NOBAN) && (
-            (((pfrom.GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom.GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (::ChainActive().Tip()->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
-       )) {
-        LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold from peer=%d\n", pfrom.GetId());
+        // disconnect node in case we have reached the outbound limit for serving historical blocks
+        if (send &&
+            connman.OutboundTargetReached(true) &&
+            (((pindexBestHeader != nullptr) && (pindexBestHeader->GetBlockTime() - pindex->GetBlockTime() > HISTORICAL_BLOCK_AGE)) || inv.IsMsgFilteredBlk()) &&
+            !pfrom.HasPermission(PF_DOWNLOAD) // nodes with the download permission may exceed target
+        ) {
+            LogPrint(BCLog::NET, "historical block serving limit reached, disconnect peer=%d\n", pfrom.GetId());
 
-        //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
-        pfrom.fDisconnect = true;
-        send = false;
+            //disconnect node
+            pfrom.fDisconnect = true;
+            send = false;
+        }
+        // Avoid leaking prune-height by never sending blocks below the NODE_NETWORK_LIMITED threshold
+        if (send && !pfrom.HasPermission(PF_NOBAN) && (
+                (((pfrom.GetLocalServices() & NODE_NETWORK_LIMITED) == NODE_NETWORK_LIMITED) && ((pfrom.GetLocalServices() & NODE_NETWORK) != NODE_NETWORK) && (::ChainActive().Tip()->nHeight - pindex->nHeight > (int)NODE_NETWORK_LIMITED_MIN_BLOCKS + 2 /* add two blocks buffer extension for possible races */) )
+           )) {
+            LogPrint(BCLog::NET, "Ignore block request below NODE_NETWORK_LIMITED threshold from peer=%d\n", pfrom.GetId());
+
+            //disconnect node and prevent it from stalling (would otherwise wait for the missing block)
+            pfrom.fDisconnect = true;
+            send = false;
+        }
+        // Pruned nodes may have deleted the block, so check whether
+        // it's available before trying to send.
+        if (!send || !(pindex->nStatus & BLOCK_HAVE_DATA)) return;
+
+        tip = ::ChainActive().Tip();
+        block_pos = pindex->GetBlockPos();
+        can_direct_fetch = CanDirectFetch(consensusParams);
+        const CNodeState* state = State(pfrom.GetId());
+        fPeerWantsWitness = state->fWantsCmpctWitness;
+        fPeerWantsMWEB = state->fWantsCmpctMWEB;
+        fPeerWantsMWEBShortIDs = state->fWantsCmpctMWEBShortIDs;
     }
-    // Pruned nodes may have deleted the block, so check whether
-    // it's available before trying to send.
-    if (send && (pindex->nStatus & BLOCK_HAVE_DATA))
-    {
-        std::shared_ptr<const CBlock> pblock;
-        if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
-            pblock = a_recent_block;
-        } else if (inv.IsMsgMWEBBlk()) {
-            // Fast-path: in this case it is possible to serve the block directly from disk,
-            // as the network format matches the format on disk
-            std::vector<uint8_t> block_data;
-            if (!ReadRawBlockFromDisk(block_data, pindex, chainparams.MessageStart())) {
-                assert(!"cannot load block from disk");
+
+    const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
+    std::shared_ptr<const CBlock> pblock;
+    if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
+        pblock = a_recent_block;
+    } else {
+        // Serve the block as stored on disk, which is the network format with
+        // witness and MWEB data, so that it's only deserialized when needed.
+        std::shared_ptr<const RawBlock> raw_block = raw_block_cache.Get(pindex->GetBlockHash(), block_pos, chainparams.MessageStart());
+        if (!raw_block) {
+            // The block may have been pruned after cs_main was released
+            LogPrint(BCLog::NET, "Cannot load block from disk, disconnect peer=%d\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        if (inv.IsMsgBlk() || inv.IsMsgWitnessBlk() || inv.IsMsgMWEBBlk()) {
+            CSerializedNetMsg msg;
+            msg.m_type = NetMsgType::BLOCK;
+            if (inv.IsMsgMWEBBlk()) {
+                msg.data = raw_block->data;
+            } else {
+                const int serialize_flags = inv.IsMsgBlk() ? SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB : SERIALIZE_NO_MWEB;
+                StripRawBlock(raw_block->data, raw_block->layout, serialize_flags, msg.data);
             }
-            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, MakeSpan(block_data)));
+            raw_block_cache.RecordBytesServed(msg.data.size());
+            connman.PushMessage(&pfrom, std::move(msg));
             // Don't set pblock as we've sent the block
         } else {
-            // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, pindex, consensusParams))
-                assert(!"cannot load block from disk");
+            try {
+                VectorReader(SER_DISK, CLIENT_VERSION, raw_block->data, 0) >> *pblockRead;
+            } catch (const std::exception& e) {
+                LogPrint(BCLog::NET, "Cannot deserialize block %s (%s), disconnect peer=%d\n", pindex->GetBlockHash().ToString(), e.what(), pfrom.GetId());
+                pfrom.fDisconnect = true;
+                return;
+            }
             pblock = pblockRead;
         }
-        if (pblock) {
-            if (inv.IsMsgBlk()) {
-                connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB, NetMsgType::BLOCK, *pblock));
-            } else if (inv.IsMsgWitnessBlk()) {
-                connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_NO_MWEB, NetMsgType::BLOCK, *pblock));
-            } else if (inv.IsMsgMWEBBlk()) {
-                connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
-            } else if (inv.IsMsgFilteredBlk()) {
-                bool sendMerkleBlock = false;
-                CMerkleBlock merkleBlock;
-                if (pfrom.m_tx_relay != nullptr) {
-                    LOCK(pfrom.m_tx_relay->cs_filter);
-                    if (pfrom.m_tx_relay->pfilter) {
-                        sendMerkleBlock = true;
-                        merkleBlock = CMerkleBlock(*pblock, *pfrom.m_tx_relay->pfilter);
-                    }
-                }
-                if (sendMerkleBlock) {
-                    connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
-                    // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
-                    // This avoids hurting performance by pointlessly requiring a round-trip
-                    // Note that there is currently no way for a node to request any single transactions we didn't send here -
-                    // they must either disconnect and retry or request the full block.
-                    // Thus, the protocol spec specified allows for us to provide duplicate txn here,
-                    // however we MUST always provide at least what the remote peer needs
-                    typedef std::pair<unsigned int, uint256> PairType;
-                    for (PairType& pair : merkleBlock.vMatchedTxn)
-                        connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB, NetMsgType::TX, *pblock->vtx[pair.first]));
+    }
+    if (pblock) {
+        if (inv.IsMsgBlk()) {
+            connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB, NetMsgType::BLOCK, *pblock));
+        } else if (inv.IsMsgWitnessBlk()) {
+            connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_NO_MWEB, NetMsgType::BLOCK, *pblock));
+        } else if (inv.IsMsgMWEBBlk()) {
+            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, *pblock));
+        } else if (inv.IsMsgFilteredBlk()) {
+            bool sendMerkleBlock = false;
+            CMerkleBlock merkleBlock;
+            if (pfrom.m_tx_relay != nullptr) {
+                LOCK(pfrom.m_tx_relay->cs_filter);
+                if (pfrom.m_tx_relay->pfilter) {
+                    sendMerkleBlock = true;
+                    merkleBlock = CMerkleBlock(*pblock, *pfrom.m_tx_relay->pfilter);
                 }
-                // else
-                    // no response
-            } else if (inv.IsMsgCmpctBlk()) {
-                // If a peer is asking for old blocks, we're almost guaranteed
-                // they won't have a useful mempool to match against a compact block,
-                // and we don't feel like constructing the object for them, so
-                // instead we respond with the full, non-compact block.
-                bool fPeerWantsWitness = State(pfrom.GetId())->fWantsCmpctWitness;
-                bool fPeerWantsMWEB = State(pfrom.GetId())->fWantsCmpctMWEB;
-                int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
-                nSendFlags |= fPeerWantsMWEB ? 0 : SERIALIZE_NO_MWEB;
-
-                if (CanDirectFetch(consensusParams) && pindex->nHeight >= ::ChainActive().Height() - MAX_CMPCTBLOCK_DEPTH) {
-                    if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && (fPeerWantsMWEB || !fMWEBPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
-                        connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
-                    } else {
-                        CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
-                        connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
-                    }
+            }
+            if (sendMerkleBlock) {
+                connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MERKLEBLOCK, merkleBlock));
+                // CMerkleBlock just contains hashes, so also push any transactions in the block the client did not see
+                // This avoids hurting performance by pointlessly requiring a round-trip
+                // Note that there is currently no way for a node to request any single transactions we didn't send here -
+                // they must either disconnect and retry or request the full block.
+                // Thus, the protocol spec specified allows for us to provide duplicate txn here,
+                // however we MUST always provide at least what the remote peer needs
+                typedef std::pair<unsigned int, uint256> PairType;
+                for (PairType& pair : merkleBlock.vMatchedTxn)
+                    connman.PushMessage(&pfrom, msgMaker.Make(SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB, NetMsgType::TX, *pblock->vtx[pair.first]));
+            }
+            // else
+                // no response
+        } else if (inv.IsMsgCmpctBlk()) {
+            // If a peer is asking for old blocks, we're almost guaranteed
+            // they won't have a useful mempool to match against a compact block,
+            // and we don't feel like constructing the object for them, so
+            // instead we respond with the full, non-compact block.
+            int nSendFlags = fPeerWantsWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
+            nSendFlags |= fPeerWantsMWEB ? 0 : SERIALIZE_NO_MWEB;
+
+            if (can_direct_fetch && pindex->nHeight >= tip->nHeight - MAX_CMPCTBLOCK_DEPTH) {
+                const int nCmpctSendFlags = nSendFlags | (fPeerWantsMWEBShortIDs ? SERIALIZE_MWEB_SHORTIDS : 0);
+                if ((fPeerWantsWitness || !fWitnessesPresentInARecentCompactBlock) && (fPeerWantsMWEB || !fMWEBPresentInARecentCompactBlock) && a_recent_compact_block && a_recent_compact_block->header.GetHash() == pindex->GetBlockHash()) {
+                    connman.PushMessage(&pfrom, msgMaker.Make(nCmpctSendFlags, NetMsgType::CMPCTBLOCK, *a_recent_compact_block));
                 } else {
-                    connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, *pblock));
-                }
-            } else if (inv.IsMsgMWEBHeader()) {
-                if (pblock->GetHogEx() != nullptr && !pblock->mweb_block.IsNull()) {
-                    CMerkleBlockWithMWEB merkle_block_with_mweb(*pblock);
-                    connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MWEBHEADER, merkle_block_with_mweb));
+                    CBlockHeaderAndShortTxIDs cmpctblock(*pblock, fPeerWantsWitness);
+                    connman.PushMessage(&pfrom, msgMaker.Make(nCmpctSendFlags, NetMsgType::CMPCTBLOCK, cmpctblock));
                 }
+            } else {
+                connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCK, *pblock));
+            }
+        } else if (inv.IsMsgMWEBHeader()) {
+            if (pblock->GetHogEx() != nullptr && !pblock->mweb_block.IsNull()) {
+                CMerkleBlockWithMWEB merkle_block_with_mweb(*pblock);
+                connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::MWEBHEADER, merkle_block_with_mweb));
             }
         }
+    }
 
-        // Trigger the peer node to send a getblocks request for the next batch of inventory
-        if (inv.hash == pfrom.hashContinue)
-        {
-            // Send immediately. This must send even if redundant,
-            // and we want it right after the last block so they don't
-            // wait for other stuff first.
-            std::vector<CInv> vInv;
-            vInv.push_back(CInv(MSG_BLOCK, ::ChainActive().Tip()->GetBlockHash()));
-            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::INV, vInv));
-            pfrom.hashContinue.SetNull();
-        }
+    // Trigger the peer node to send a getblocks request for the next batch of inventory
+    if (inv.hash == pfrom.hashContinue)
+    {
+        // Send immediately. This must send even if redundant,
+        // and we want it right after the last block so they don't
+        // wait for other stuff first.
+        std::vector<CInv> vInv;
+        vInv.push_back(CInv(MSG_BLOCK, tip->GetBlockHash()));
+        connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::INV, vInv));
+        pfrom.hashContinue.SetNull();
     }
 }
 
@@ -1959,7 +2035,7 @@ static CTransactionRef FindTxForGetData(const CTxMemPool& mempool, const CNode&
     return {};
 }
 
-void static ProcessGetData(CNode& pfrom, Peer& peer, const ChainstateManager& chainman, const CChainParams& chainparams, CConnman& connman, CTxMemPool& mempool, const std::atomic<bool>& interruptMsgProc) EXCLUSIVE_LOCKS_REQUIRED(!cs_main, peer.m_getdata_requests_mutex)
+void static ProcessGetData(CNode& pfrom, Peer& peer, const ChainstateManager& chainman, const CChainParams& chainparams, CConnman& connman, CTxMemPool& mempool, RawBlockCache& raw_block_cache, const std::atomic<bool>& interruptMsgProc) EXCLUSIVE_LOCKS_REQUIRED(!cs_main, peer.m_getdata_requests_mutex)
 {
     AssertLockNotHeld(cs_main);
 
@@ -1971,6 +2047,7 @@ void static ProcessGetData(CNode& pfrom, Peer& peer, const ChainstateManager& ch
     // Get last mempool request time
     const std::chrono::seconds mempool_req = pfrom.m_tx_relay != nullptr ? pfrom.m_tx_relay->m_last_mempool_req.load()
                                                                           : std::chrono::seconds::min();
+    const bool peer_has_mweb = WITH_LOCK(cs_main, return State(pfrom.GetId())->fHaveMWEB);
 
     // Process as many TX items from the front of the getdata queue as
     // possible, since they're common and it's efficient to batch process
@@ -1991,7 +2068,7 @@ void static ProcessGetData(CNode& pfrom, Peer& peer, const ChainstateManager& ch
         CTransactionRef tx = FindTxForGetData(mempool, pfrom, ToGenTxid(inv), mempool_req, now);
         if (tx) {
             // WTX and WITNESS_TX imply we serialize with witness
-            int nSendFlags = (inv.IsMsgTx() ? SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB : (State(pfrom.GetId())->fHaveMWEB ? 0 : SERIALIZE_NO_MWEB));
+            int nSendFlags = (inv.IsMsgTx() ? SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB : (peer_has_mweb ? 0 : SERIALIZE_NO_MWEB));
             connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::TX, *tx));
             mempool.RemoveUnbroadcastTx(tx->GetHash());
             // As we're going to send tx, make sure its unconfirmed parents are made requestable.
@@ -2026,7 +2103,7 @@ void static ProcessGetData(CNode& pfrom, Peer& peer, const ChainstateManager& ch
     if (it != peer.m_getdata_requests.end() && !pfrom.fPauseSend) {
         const CInv &inv = *it++;
         if (inv.IsGenBlkMsg()) {
-            ProcessGetBlockData(pfrom, chainparams, inv, connman);
+            ProcessGetBlockData(pfrom, chainparams, inv, connman, raw_block_cache);
         } else if (inv.IsMsgMWEBLeafset()) {
             ProcessGetMWEBLeafset(pfrom, chainman, chainparams, inv, connman);
         }
@@ -2076,10 +2153,15 @@ void PeerManager::SendBlockTransactions(CNode& pfrom, const CBlock& block, const
         }
         resp.txn[i] = block.vtx[req.indexes[i]];
     }
+    if (!FillMWEBBlockTransactions(m_mempool, block, req, resp)) {
+        Misbehaving(pfrom.GetId(), 100, "getblocktxn with out-of-bounds MWEB kernel indices");
+        return;
+    }
     LOCK(cs_main);
     const CNetMsgMaker msgMaker(pfrom.GetCommonVersion());
     int nSendFlags = State(pfrom.GetId())->fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
     nSendFlags |= State(pfrom.GetId())->fWantsCmpctMWEB ? 0 : SERIALIZE_NO_MWEB;
+    nSendFlags |= State(pfrom.GetId())->fWantsCmpctMWEBShortIDs ? SERIALIZE_MWEB_SHORTIDS : 0;
 
     m_connman.PushMessage(&pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCKTXN, resp));
 }
@@ -2294,7 +2376,7 @@ void PeerManager::ProcessOrphanTx(std::set<uint256>& orphan_work_set)
 
         if (AcceptToMemoryPool(m_mempool, state, porphanTx, &removed_txn, false /* bypass_limits */)) {
             LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
-            RelayTransaction(orphanHash, porphanTx->GetWitnessHash(), m_connman);
+            RelayTransaction(orphanHash, porphanTx->GetWitnessHash(), m_connman, porphanTx->IsMWEBOnly());
             for (unsigned int i = 0; i < porphanTx->vout.size(); i++) {
                 auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(orphanHash, i));
                 if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
@@ -2573,6 +2655,53 @@ static void ProcessGetCFCheckPt(CNode& peer, CDataStream& vRecv, const CChainPar
     connman.PushMessage(&peer, std::move(msg));
 }
 
+/**
+ * Messages that may be handled by multiple message handler threads at once.
+ * Apart from tx, they only serve data to the peer that sent them. Their
+ * handlers do not touch state of other peers, and take cs_main only as long as
+ * they need it (or, for getmwebutxos, throughout). The tx handler verifies the
+ * transaction concurrently, and takes m_msgproc_mutex itself to accept it.
+ */
+static bool IsConcurrentMessage(const std::string& msg_type)
+{
+    return msg_type == NetMsgType::TX ||
+           msg_type == NetMsgType::GETDATA ||
+           msg_type == NetMsgType::GETADDR ||
+           msg_type == NetMsgType::GETCFILTERS ||
+           msg_type == NetMsgType::GETCFHEADERS ||
+           msg_type == NetMsgType::GETCFCHECKPT ||
+           msg_type == NetMsgType::GETMWEBUTXOS;
+}
+
+void PeerManager::AnnounceReconciledTxs(CNode& peer, const std::vector<uint256>& wtxids)
+{
+    if (peer.m_tx_relay == nullptr || wtxids.empty()) return;
+    const CNetMsgMaker msgMaker(peer.GetCommonVersion());
+    CFeeRate filterrate;
+    {
+        LOCK(peer.m_tx_relay->cs_feeFilter);
+        filterrate = CFeeRate(peer.m_tx_relay->minFeeFilter);
+    }
+
+    LOCK(cs_main);
+    LOCK(peer.m_tx_relay->cs_tx_inventory);
+    std::vector<CInv> vInv;
+    for (const uint256& wtxid : wtxids) {
+        if (peer.m_tx_relay->filterInventoryKnown.contains(wtxid)) continue;
+        const auto txinfo = m_mempool.info(GenTxid(/* is_wtxid=*/true, wtxid));
+        if (!txinfo.tx || txinfo.fee < filterrate.GetTotalFee(txinfo.vsize, txinfo.mweb_weight)) continue;
+        // Allow the peer to request it like any announced transaction
+        State(peer.GetId())->m_recently_announced_invs.insert(wtxid);
+        peer.m_tx_relay->filterInventoryKnown.insert(wtxid);
+        vInv.emplace_back(MSG_WTX, wtxid);
+        if (vInv.size() == MAX_INV_SZ) {
+            m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+            vInv.clear();
+        }
+    }
+    if (!vInv.empty()) m_connman.PushMessage(&peer, msgMaker.Make(NetMsgType::INV, vInv));
+}
+
 void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDataStream& vRecv,
                                          const std::chrono::microseconds time_received,
                                          const std::atomic<bool>& interruptMsgProc)
@@ -2678,6 +2807,14 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDADDRV2));
         }
 
+        // Signal transaction reconciliation support to peers we relay transactions with.
+        // It requires wtxid relay, which is negotiated just before.
+        if (g_txreconciliation && greatest_common_version >= WTXID_RELAY_VERSION && g_relay_txes &&
+            pfrom.m_tx_relay != nullptr && fRelay) {
+            const uint64_t recon_salt = g_txreconciliation->PreRegisterPeer(pfrom.GetId());
+            m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::SENDTXRCNCL, TXRECONCILIATION_VERSION, recon_salt));
+        }
+
         m_connman.PushMessage(&pfrom, msg_maker.Make(NetMsgType::VERACK));
 
         pfrom.nServices = nServices;
@@ -2829,7 +2966,10 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             // We send this to non-NODE NETWORK peers as well, because
             // they may wish to request compact blocks from us
             bool fAnnounceUsingCMPCTBLOCK = false;
-            uint64_t nCMPCTBLOCKVersion = 3;
+            uint64_t nCMPCTBLOCKVersion = 4;
+            if (pfrom.GetLocalServices() & NODE_MWEB)
+                m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, fAnnounceUsingCMPCTBLOCK, nCMPCTBLOCKVersion));
+            nCMPCTBLOCKVersion = 3;
             if (pfrom.GetLocalServices() & NODE_MWEB)
                 m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, fAnnounceUsingCMPCTBLOCK, nCMPCTBLOCKVersion));
             nCMPCTBLOCKVersion = 2;
@@ -2872,6 +3012,38 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         return;
     }
 
+    // Transaction reconciliation is negotiated between VERSION and VERACK as well.
+    if (msg_type == NetMsgType::SENDTXRCNCL) {
+        if (!g_txreconciliation) {
+            LogPrint(BCLog::NET, "sendtxrcncl from peer=%d ignored, as our node does not have txreconciliation enabled\n", pfrom.GetId());
+            return;
+        }
+        if (pfrom.fSuccessfullyConnected) {
+            LogPrint(BCLog::NET, "sendtxrcncl received after verack from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        if (!WITH_LOCK(cs_main, return State(pfrom.GetId())->m_wtxid_relay)) {
+            // Short IDs are computed from wtxids, so reconciliation requires wtxid relay.
+            g_txreconciliation->ForgetPeer(pfrom.GetId());
+            return;
+        }
+
+        uint32_t peer_recon_version;
+        uint64_t remote_salt;
+        vRecv >> peer_recon_version >> remote_salt;
+        const ReconciliationRegisterResult result = g_txreconciliation->RegisterPeer(pfrom.GetId(), pfrom.IsInboundConn(), peer_recon_version, remote_salt);
+        if (result == ReconciliationRegisterResult::PROTOCOL_VIOLATION || result == ReconciliationRegisterResult::ALREADY_REGISTERED) {
+            LogPrint(BCLog::NET, "invalid sendtxrcncl from peer=%d; disconnecting\n", pfrom.GetId());
+            pfrom.fDisconnect = true;
+            return;
+        }
+        if (result == ReconciliationRegisterResult::SUCCESS) {
+            LogPrint(BCLog::NET, "Registered peer=%d for transaction reconciliation, we %s\n", pfrom.GetId(), pfrom.IsInboundConn() ? "respond" : "initiate");
+        }
+        return;
+    }
+
     if (!pfrom.fSuccessfullyConnected) {
         LogPrint(BCLog::NET, "Unsupported message \"%s\" prior to verack from peer=%d\n", SanitizeString(msg_type), pfrom.GetId());
         return;
@@ -2979,19 +3151,21 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         bool fAnnounceUsingCMPCTBLOCK = false;
         uint64_t nCMPCTBLOCKVersion = 0;
         vRecv >> fAnnounceUsingCMPCTBLOCK >> nCMPCTBLOCKVersion;
-        if (nCMPCTBLOCKVersion == 1 || ((pfrom.GetLocalServices() & NODE_WITNESS) && nCMPCTBLOCKVersion == 2) || ((pfrom.GetLocalServices() & NODE_MWEB) && nCMPCTBLOCKVersion == 3)) {
+        if (nCMPCTBLOCKVersion == 1 || ((pfrom.GetLocalServices() & NODE_WITNESS) && nCMPCTBLOCKVersion == 2) || ((pfrom.GetLocalServices() & NODE_MWEB) && (nCMPCTBLOCKVersion == 3 || nCMPCTBLOCKVersion == 4))) {
             LOCK(cs_main);
             // fProvidesHeaderAndIDs is used to "lock in" version of compact blocks we send (fWantsCmpctWitness)
             if (!State(pfrom.GetId())->fProvidesHeaderAndIDs) {
                 State(pfrom.GetId())->fProvidesHeaderAndIDs = true;
                 State(pfrom.GetId())->fWantsCmpctWitness = nCMPCTBLOCKVersion >= 2;
                 State(pfrom.GetId())->fWantsCmpctMWEB = nCMPCTBLOCKVersion >= 3;
+                State(pfrom.GetId())->fWantsCmpctMWEBShortIDs = nCMPCTBLOCKVersion >= 4;
             }
-            if (State(pfrom.GetId())->fWantsCmpctWitness == (nCMPCTBLOCKVersion >= 2) && State(pfrom.GetId())->fWantsCmpctMWEB == (nCMPCTBLOCKVersion >= 3))
+            if (State(pfrom.GetId())->fWantsCmpctWitness == (nCMPCTBLOCKVersion >= 2) && State(pfrom.GetId())->fWantsCmpctMWEB == (nCMPCTBLOCKVersion >= 3) &&
+                State(pfrom.GetId())->fWantsCmpctMWEBShortIDs == (nCMPCTBLOCKVersion >= 4))
                 State(pfrom.GetId())->fPreferHeaderAndIDs = fAnnounceUsingCMPCTBLOCK;
             if (!State(pfrom.GetId())->fSupportsDesiredCmpctVersion) {
                 if (pfrom.GetLocalServices() & NODE_MWEB)
-                    State(pfrom.GetId())->fSupportsDesiredCmpctVersion = (nCMPCTBLOCKVersion == 3); 
+                    State(pfrom.GetId())->fSupportsDesiredCmpctVersion = (nCMPCTBLOCKVersion >= 3);
                 else if (pfrom.GetLocalServices() & NODE_WITNESS)
                     State(pfrom.GetId())->fSupportsDesiredCmpctVersion = (nCMPCTBLOCKVersion == 2);
                 else
@@ -3055,6 +3229,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                 LogPrint(BCLog::NET, "got inv: %s  %s peer=%d\n", inv.ToString(), fAlreadyHave ? "have" : "new", pfrom.GetId());
 
                 pfrom.AddKnownTx(inv.hash);
+                if (g_txreconciliation) g_txreconciliation->TryRemovingFromSet(pfrom.GetId(), inv.hash);
                 if (fBlocksOnly) {
                     LogPrint(BCLog::NET, "transaction (%s) inv sent in violation of protocol, disconnecting peer=%d\n", inv.hash.ToString(), pfrom.GetId());
                     pfrom.fDisconnect = true;
@@ -3093,7 +3268,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         {
             LOCK(peer->m_getdata_requests_mutex);
             peer->m_getdata_requests.insert(peer->m_getdata_requests.end(), vInv.begin(), vInv.end());
-            ProcessGetData(pfrom, *peer, m_chainman, m_chainparams, m_connman, m_mempool, interruptMsgProc);
+            ProcessGetData(pfrom, *peer, m_chainman, m_chainparams, m_connman, m_mempool, m_raw_block_cache, interruptMsgProc);
         }
 
         return;
@@ -3168,6 +3343,10 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
     }
 
     if (msg_type == NetMsgType::GETBLOCKTXN) {
+        if (WITH_LOCK(cs_main, return State(pfrom.GetId())->fWantsCmpctMWEBShortIDs)) {
+            vRecv.SetVersion(vRecv.GetVersion() | SERIALIZE_MWEB_SHORTIDS);
+        }
+
         BlockTransactionsRequest req;
         vRecv >> req;
 
@@ -3304,12 +3483,23 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         const uint256& txid = ptx->GetHash();
         const uint256& wtxid = ptx->GetWitnessHash();
 
+        // Run the checks that don't need the locks first, so that message
+        // handler threads verify the transactions of their peers in parallel.
+        // Transactions we already have are left to the checks below.
+        TxValidationState precheck_state;
+        bool prechecked{false};
+        if (!WITH_LOCK(cs_main, return AlreadyHaveTx(GenTxid(/* is_wtxid=*/true, wtxid), m_mempool))) {
+            prechecked = PreCheckTransaction(m_mempool, ptx, precheck_state);
+        }
+
+        LOCK(m_msgproc_mutex);
         LOCK2(cs_main, g_cs_orphans);
 
         CNodeState* nodestate = State(pfrom.GetId());
 
         const uint256& hash = nodestate->m_wtxid_relay ? wtxid : txid;
         pfrom.AddKnownTx(hash);
+        if (g_txreconciliation) g_txreconciliation->TryRemovingFromSet(pfrom.GetId(), wtxid);
         if (nodestate->m_wtxid_relay && txid != wtxid) {
             // Insert txid into filterInventoryKnown, even for
             // wtxidrelay peers. This prevents re-adding of
@@ -3343,22 +3533,23 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                     LogPrintf("Not relaying non-mempool transaction %s from forcerelay peer=%d\n", tx.GetHash().ToString(), pfrom.GetId());
                 } else {
                     LogPrintf("Force relaying tx %s from peer=%d\n", tx.GetHash().ToString(), pfrom.GetId());
-                    RelayTransaction(tx.GetHash(), tx.GetWitnessHash(), m_connman);
+                    RelayTransaction(tx.GetHash(), tx.GetWitnessHash(), m_connman, tx.IsMWEBOnly());
                 }
             }
             return;
         }
 
-        TxValidationState state;
+        // A transaction that failed the checks above is rejected as if by AcceptToMemoryPool
+        TxValidationState state = precheck_state;
         std::list<CTransactionRef> lRemovedTxn;
 
-        if (AcceptToMemoryPool(m_mempool, state, ptx, &lRemovedTxn, false /* bypass_limits */)) {
+        if (state.IsValid() && AcceptToMemoryPool(m_mempool, state, ptx, &lRemovedTxn, false /* bypass_limits */, false /* test_accept */, nullptr /* fee_out */, prechecked)) {
             m_mempool.check(&::ChainstateActive().CoinsTip());
             // As this version of the transaction was acceptable, we can forget about any
             // requests for it.
             m_txrequest.ForgetTxHash(tx.GetHash());
             m_txrequest.ForgetTxHash(tx.GetWitnessHash());
-            RelayTransaction(tx.GetHash(), tx.GetWitnessHash(), m_connman);
+            RelayTransaction(tx.GetHash(), tx.GetWitnessHash(), m_connman, tx.IsMWEBOnly());
             for (unsigned int i = 0; i < tx.vout.size(); i++) {
                 auto it_by_prev = mapOrphanTransactionsByPrev.find(COutPoint(txid, i));
                 if (it_by_prev != mapOrphanTransactionsByPrev.end()) {
@@ -3517,6 +3708,9 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             if (!State(pfrom.GetId())->fWantsCmpctMWEB) {
                 vRecv.SetVersion(vRecv.GetVersion() | SERIALIZE_NO_MWEB);
             }
+            if (State(pfrom.GetId())->fWantsCmpctMWEBShortIDs) {
+                vRecv.SetVersion(vRecv.GetVersion() | SERIALIZE_MWEB_SHORTIDS);
+            }
         }
 
         CBlockHeaderAndShortTxIDs cmpctblock;
@@ -3647,15 +3841,21 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
                     if (!partialBlock.IsTxAvailable(i))
                         req.indexes.push_back(i);
                 }
-                if (req.indexes.empty()) {
+                for (size_t i = 0; i < partialBlock.MWEBKernelCount(); i++) {
+                    if (!partialBlock.IsMWEBKernelAvailable(i))
+                        req.mweb_indexes.push_back(i);
+                }
+                const int nBlockTxnFlags = nodestate->fWantsCmpctMWEBShortIDs ? SERIALIZE_MWEB_SHORTIDS : 0;
+                if (req.indexes.empty() && req.mweb_indexes.empty()) {
                     // Dirty hack to jump to BLOCKTXN code (TODO: move message handling into their own functions)
                     BlockTransactions txn;
                     txn.blockhash = cmpctblock.header.GetHash();
+                    blockTxnMsg.SetVersion(blockTxnMsg.GetVersion() | nBlockTxnFlags);
                     blockTxnMsg << txn;
                     fProcessBLOCKTXN = true;
                 } else {
                     req.blockhash = pindex->GetBlockHash();
-                    m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::GETBLOCKTXN, req));
+                    m_connman.PushMessage(&pfrom, msgMaker.Make(nBlockTxnFlags, NetMsgType::GETBLOCKTXN, req));
                 }
             } else {
                 // This block is either already in flight from a different
@@ -3747,6 +3947,10 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             return;
         }
 
+        if (WITH_LOCK(cs_main, return State(pfrom.GetId())->fWantsCmpctMWEBShortIDs)) {
+            vRecv.SetVersion(vRecv.GetVersion() | SERIALIZE_MWEB_SHORTIDS);
+        }
+
         BlockTransactions resp;
         vRecv >> resp;
 
@@ -3763,7 +3967,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             }
 
             PartiallyDownloadedBlock& partialBlock = *it->second.second->partialBlock;
-            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn);
+            ReadStatus status = partialBlock.FillBlock(*pblock, resp.txn, resp.mweb_txn, resp.mweb_block);
             if (status == READ_STATUS_INVALID) {
                 MarkBlockAsReceived(resp.blockhash, pfrom.GetId()); // Reset in-flight state in case Misbehaving does not result in a disconnect
                 Misbehaving(pfrom.GetId(), 100, "invalid compact block/non-matching block transactions");
@@ -3854,6 +4058,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             return;
         }
 
+        const size_t block_size = vRecv.size();
         std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
         vRecv >> *pblock;
 
@@ -3865,7 +4070,7 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
             LOCK(cs_main);
             // Also always process if we requested the block explicitly, as we may
             // need it even though it is not a candidate for a new best tip.
-            forceProcessing |= MarkBlockAsReceived(hash, pfrom.GetId());
+            forceProcessing |= MarkBlockAsReceived(hash, pfrom.GetId(), block_size);
             // mapBlockSource is only used for punishing peers and setting
             // which peers send us compact blocks, so the race between here and
             // cs_main in ProcessNewBlock is fine.
@@ -3901,13 +4106,16 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         }
         pfrom.fSentAddr = true;
 
-        pfrom.vAddrToSend.clear();
         std::vector<CAddress> vAddr;
         if (pfrom.HasPermission(PF_ADDR)) {
             vAddr = m_connman.GetAddresses(MAX_ADDR_TO_SEND, MAX_PCT_ADDR_TO_SEND);
         } else {
             vAddr = m_connman.GetAddresses(pfrom, MAX_ADDR_TO_SEND, MAX_PCT_ADDR_TO_SEND);
         }
+        // getaddr is handled concurrently, but address relay from other peers
+        // also pushes to vAddrToSend.
+        LOCK(m_msgproc_mutex);
+        pfrom.vAddrToSend.clear();
         FastRandomContext insecure_rand;
         for (const CAddress &addr : vAddr) {
             pfrom.PushAddress(addr, insecure_rand);
@@ -4082,6 +4290,51 @@ void PeerManager::ProcessMessage(CNode& pfrom, const std::string& msg_type, CDat
         return;
     }
 
+    if (msg_type == NetMsgType::REQRECON) {
+        if (!g_txreconciliation || !g_txreconciliation->IsPeerRegistered(pfrom.GetId())) return;
+        uint32_t peer_set_size;
+        vRecv >> peer_set_size;
+        ReconciliationSketch sketch;
+        if (!g_txreconciliation->HandleReconciliationRequest(pfrom.GetId(), peer_set_size, sketch)) {
+            Misbehaving(pfrom.GetId(), 100, "unexpected reqrecon");
+            return;
+        }
+        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::SKETCH, sketch));
+        return;
+    }
+
+    if (msg_type == NetMsgType::SKETCH) {
+        if (!g_txreconciliation || !g_txreconciliation->IsPeerRegistered(pfrom.GetId())) return;
+        ReconciliationSketch sketch;
+        vRecv >> sketch;
+        std::vector<uint256> txs_to_announce;
+        std::vector<uint32_t> txs_to_request;
+        bool success;
+        if (!g_txreconciliation->HandleSketch(pfrom.GetId(), sketch, txs_to_announce, txs_to_request, success)) {
+            Misbehaving(pfrom.GetId(), 100, "invalid sketch");
+            return;
+        }
+        LogPrint(BCLog::NET, "reconciliation with peer=%d %s: announcing %u, requesting %u\n", pfrom.GetId(),
+                 success ? "succeeded" : "failed", txs_to_announce.size(), txs_to_request.size());
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        m_connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::RECONCILDIFF, success, txs_to_request));
+        return;
+    }
+
+    if (msg_type == NetMsgType::RECONCILDIFF) {
+        if (!g_txreconciliation || !g_txreconciliation->IsPeerRegistered(pfrom.GetId())) return;
+        bool success;
+        std::vector<uint32_t> ask_short_ids;
+        vRecv >> success >> ask_short_ids;
+        std::vector<uint256> txs_to_announce;
+        if (!g_txreconciliation->HandleReconciliationDifference(pfrom.GetId(), success, ask_short_ids, txs_to_announce)) {
+            Misbehaving(pfrom.GetId(), 100, "unexpected reconcildiff");
+            return;
+        }
+        AnnounceReconciledTxs(pfrom, txs_to_announce);
+        return;
+    }
+
     if (msg_type == NetMsgType::FEEFILTER) {
         CAmount newFeeFilter = 0;
         vRecv >> newFeeFilter;
@@ -4190,11 +4443,12 @@ bool PeerManager::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgP
     {
         LOCK(peer->m_getdata_requests_mutex);
         if (!peer->m_getdata_requests.empty()) {
-            ProcessGetData(*pfrom, *peer, m_chainman, m_chainparams, m_connman, m_mempool, interruptMsgProc);
+            ProcessGetData(*pfrom, *peer, m_chainman, m_chainparams, m_connman, m_mempool, m_raw_block_cache, interruptMsgProc);
         }
     }
 
     {
+        LOCK(m_msgproc_mutex);
         LOCK2(cs_main, g_cs_orphans);
         if (!peer->m_orphan_work_set.empty()) {
             ProcessOrphanTx(peer->m_orphan_work_set);
@@ -4239,8 +4493,16 @@ bool PeerManager::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgP
     // Message size
     unsigned int nMessageSize = msg.m_message_size;
 
+    // Time the processing, and the part of it spent waiting for cs_main, by message type
+    LockWaitTracker cs_main_wait(&cs_main);
+    const auto processing_start = std::chrono::steady_clock::now();
     try {
-        ProcessMessage(*pfrom, msg_type, msg.m_recv, msg.m_time, interruptMsgProc);
+        if (IsConcurrentMessage(msg_type)) {
+            ProcessMessage(*pfrom, msg_type, msg.m_recv, msg.m_time, interruptMsgProc);
+        } else {
+            LOCK(m_msgproc_mutex);
+            ProcessMessage(*pfrom, msg_type, msg.m_recv, msg.m_time, interruptMsgProc);
+        }
         if (interruptMsgProc) return false;
         {
             LOCK(peer->m_getdata_requests_mutex);
@@ -4251,6 +4513,9 @@ bool PeerManager::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgP
     } catch (...) {
         LogPrint(BCLog::NET, "%s(%s, %u bytes): Unknown exception caught\n", __func__, SanitizeString(msg_type), nMessageSize);
     }
+    m_msg_stats.Record(pfrom->GetId(), msg_type, nMessageSize,
+                       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - processing_start),
+                       cs_main_wait.Waited());
 
     return fMoreWork;
 }
@@ -4411,6 +4676,7 @@ public:
 
 bool PeerManager::SendMessages(CNode* pto)
 {
+    LOCK(m_msgproc_mutex);
     const Consensus::Params& consensusParams = m_chainparams.GetConsensus();
 
     // We must call MaybeDiscourageAndDisconnect first, to ensure that we'll
@@ -4607,6 +4873,7 @@ bool PeerManager::SendMessages(CNode* pto)
 
                     int nSendFlags = state.fWantsCmpctWitness ? 0 : SERIALIZE_TRANSACTION_NO_WITNESS;
                     nSendFlags |= state.fWantsCmpctMWEB ? 0 : SERIALIZE_NO_MWEB;
+                    nSendFlags |= state.fWantsCmpctMWEBShortIDs ? SERIALIZE_MWEB_SHORTIDS : 0;
 
                     bool fGotBlockFromCache = false;
                     {
@@ -4858,6 +5125,33 @@ bool PeerManager::SendMessages(CNode* pto)
                 return true;
             }
         }
+        // During initial block download, reassign the blocks in flight from this peer that we are about to need,
+        // if the peer takes much longer to deliver them than its measured rate and round trip time predict.
+        // Unlike the stalling check above, this doesn't wait for the download window to fill up, and the peer
+        // isn't disconnected, but it won't be asked for more blocks for a while.
+        const int64_t min_ping_time = pto->nMinPingUsecTime;
+        if (min_ping_time != std::numeric_limits<int64_t>::max()) {
+            g_block_download.SetRoundTripTime(pto->GetId(), std::chrono::microseconds{min_ping_time});
+        }
+        if (state.vBlocksInFlight.size() > 0 && nPeersWithValidatedDownloads - (state.nBlocksInFlightValidHeaders > 0) > 0 &&
+            ::ChainstateActive().IsInitialBlockDownload() &&
+            current_time - std::chrono::microseconds{state.nDownloadingSince} > g_block_download.GetStallTimeout(pto->GetId())) {
+            const int reassign_height = ::ChainActive().Height() + MAX_BLOCKS_IN_TRANSIT_QUOTA;
+            std::vector<uint256> stalled;
+            for (const QueuedBlock& queued_block : state.vBlocksInFlight) {
+                if (queued_block.pindex && !queued_block.partialBlock && queued_block.pindex->nHeight <= reassign_height) {
+                    stalled.push_back(queued_block.hash);
+                }
+            }
+            if (!stalled.empty()) {
+                LogPrint(BCLog::NET, "Reassigning %u stalled blocks from peer=%d\n", stalled.size(), pto->GetId());
+                for (const uint256& hash : stalled) {
+                    MarkBlockAsReceived(hash, nullopt);
+                }
+                g_block_download.BlocksReassigned(pto->GetId(), stalled.size());
+                state.m_block_download_paused_until = current_time + g_block_download.GetStallTimeout(pto->GetId());
+            }
+        }
         // Check for headers sync timeouts
         if (state.fSyncStarted && state.nHeadersSyncTimeout < std::numeric_limits<int64_t>::max()) {
             // Detect whether this is a stalling initial-headers-sync peer
@@ -4899,10 +5193,12 @@ bool PeerManager::SendMessages(CNode* pto)
         // Message: getdata (blocks)
         //
         std::vector<CInv> vGetData;
-        if (!pto->fClient && ((fFetch && !pto->m_limited_node) || !::ChainstateActive().IsInitialBlockDownload()) && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
+        const int block_quota = g_block_download.GetQuota(pto->GetId());
+        if (!pto->fClient && ((fFetch && !pto->m_limited_node) || !::ChainstateActive().IsInitialBlockDownload()) &&
+            state.nBlocksInFlight < block_quota && current_time >= state.m_block_download_paused_until) {
             std::vector<const CBlockIndex*> vToDownload;
             NodeId staller = -1;
-            FindNextBlocksToDownload(pto->GetId(), MAX_BLOCKS_IN_TRANSIT_PER_PEER - state.nBlocksInFlight, vToDownload, staller, consensusParams);
+            FindNextBlocksToDownload(pto->GetId(), block_quota - state.nBlocksInFlight, vToDownload, staller, consensusParams);
             for (const CBlockIndex *pindex : vToDownload) {
                 uint32_t nFetchFlags = GetFetchFlags(*pto);
                 vGetData.push_back(CInv(MSG_BLOCK | nFetchFlags, pindex->GetBlockHash()));
@@ -4948,6 +5244,15 @@ bool PeerManager::SendMessages(CNode* pto)
         if (!vGetData.empty())
             m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::GETDATA, vGetData));
 
+        //
+        // Message: reqrecon
+        //
+        if (g_txreconciliation && pto->m_tx_relay != nullptr) {
+            if (const auto local_set_size = g_txreconciliation->InitiateReconciliationRequest(pto->GetId(), current_time)) {
+                m_connman.PushMessage(pto, msgMaker.Make(NetMsgType::REQRECON, *local_set_size));
+            }
+        }
+
         //
         // Message: feefilter
         //
@@ -6,8 +6,11 @@
 #ifndef BITCOIN_NET_PROCESSING_H
 #define BITCOIN_NET_PROCESSING_H
 
+#include <blockdownload.h>
 #include <consensus/params.h>
 #include <net.h>
+#include <node/netmsgstats.h>
+#include <node/rawblock.h>
 #include <sync.h>
 #include <txrequest.h>
 #include <validationinterface.h>
@@ -31,6 +34,8 @@ static const bool DEFAULT_PEERBLOOMFILTERS = false;
 static const bool DEFAULT_PEERBLOCKFILTERS = true;
 /** Threshold for marking a node to be discouraged, e.g. disconnected and added to the discouragement filter. */
 static const int DISCOURAGEMENT_THRESHOLD{100};
+/** Maximum memory usage of the cache of raw blocks served to peers */
+static const size_t MAX_RAW_BLOCK_CACHE_USAGE{32 << 20};
 
 class PeerManager final : public CValidationInterface, public NetEventsInterface {
 public:
@@ -94,6 +99,12 @@ public:
      */
     void Misbehaving(const NodeId pnode, const int howmuch, const std::string& message);
 
+    /** Statistics of the cache of raw blocks served to peers */
+    RawBlockCacheStats GetRawBlockCacheStats() const { return m_raw_block_cache.GetStats(); }
+
+    /** Size, processing time and cs_main wait statistics of the messages processed, by message type */
+    const NetMessageStats& GetMessageStats() const { return m_msg_stats; }
+
 private:
     /**
      * Potentially mark a node discouraged based on the contents of a BlockValidationState object
@@ -128,6 +139,11 @@ private:
 
     void SendBlockTransactions(CNode& pfrom, const CBlock& block, const BlockTransactionsRequest& req);
 
+    /** Announce the transactions a reconciliation found the peer to be missing, if
+     *  they are still in our mempool. These skip the trickle, as reconciliations are
+     *  delayed already. */
+    void AnnounceReconciledTxs(CNode& peer, const std::vector<uint256>& wtxids);
+
     /** Register with TxRequestTracker that an INV has been received from a
      *  peer. The announcement parameters are decided in PeerManager and then
      *  passed to TxRequestTracker. */
@@ -142,6 +158,20 @@ private:
     CTxMemPool& m_mempool;
     TxRequestTracker m_txrequest GUARDED_BY(::cs_main);
 
+    /**
+     * With multiple message handler threads, messages from different peers are
+     * processed concurrently. This mutex keeps handling of all other messages,
+     * orphan processing and SendMessages() serialized, as they update state
+     * shared between peers. Only messages in IsConcurrentMessage() run without it,
+     * or take it themselves.
+     */
+    Mutex m_msgproc_mutex;
+
+    /** Historical blocks recently served to peers, as stored on disk */
+    RawBlockCache m_raw_block_cache{MAX_RAW_BLOCK_CACHE_USAGE};
+
+    NetMessageStats m_msg_stats;
+
     int64_t m_stale_tip_check_time; //!< Next time to check for stale tip
 };
 
@@ -152,12 +182,13 @@ struct CNodeStateStats {
     std::vector<int> vHeightInFlight;
     uint64_t m_addr_processed = 0;
     uint64_t m_addr_rate_limited = 0;
+    BlockDownloadStats m_block_download;
 };
 
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 
-/** Relay transaction to every node */
-void RelayTransaction(const uint256& txid, const uint256& wtxid, const CConnman& connman) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+/** Relay transaction to every node. MWEB-only transactions aren't reconciled with peers without MWEB support. */
+void RelayTransaction(const uint256& txid, const uint256& wtxid, const CConnman& connman, bool mweb_only) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
 #endif // BITCOIN_NET_PROCESSING_H
@@ -0,0 +1,172 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blocktemplate.h>
+
+#include <chain.h>
+#include <hash.h>
+#include <logging.h>
+#include <miner.h>
+#include <scheduler.h>
+#include <script/script.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <cstring>
+
+std::vector<uint256> CoinbaseMerkleBranch(const CBlock& block)
+{
+    std::vector<uint256> branch;
+    std::vector<uint256> level;
+    level.reserve(block.vtx.size() + 1);
+    for (const CTransactionRef& tx : block.vtx) {
+        level.push_back(tx->GetHash());
+    }
+    // The first hash of each level depends on the coinbase and is never used;
+    // the second one is the sibling on the path from the coinbase to the root.
+    while (level.size() > 1) {
+        branch.push_back(level[1]);
+        if (level.size() & 1) level.push_back(level.back());
+        for (size_t i = 0; i < level.size() / 2; ++i) {
+            level[i] = Hash(level[2 * i], level[2 * i + 1]);
+        }
+        level.resize(level.size() / 2);
+    }
+    return branch;
+}
+
+BinaryBlockTemplate MakeBinaryBlockTemplate(const CBlockTemplate& blocktemplate, int height, uint64_t id)
+{
+    const CBlock& block = blocktemplate.block;
+    const CTransaction& coinbase = *block.vtx.at(0);
+
+    BinaryBlockTemplate result;
+    result.id = id;
+    result.version = block.nVersion;
+    result.prev_hash = block.hashPrevBlock;
+    result.time = block.nTime;
+    result.bits = block.nBits;
+    result.height = height;
+
+    // The first output pays the subsidy and fees to the miner, and the
+    // others carry the commitments every coinbase of the template needs.
+    const CScript prefix = CScript() << height;
+    result.coinbase_version = coinbase.nVersion;
+    result.coinbase_prefix.assign(prefix.begin(), prefix.end());
+    result.coinbase_sequence = coinbase.vin.at(0).nSequence;
+    result.coinbase_value = coinbase.vout.at(0).nValue;
+    result.coinbase_outputs.assign(coinbase.vout.begin() + 1, coinbase.vout.end());
+    result.coinbase_locktime = coinbase.nLockTime;
+
+    result.merkle_branch = CoinbaseMerkleBranch(block);
+
+    if (block.vtx.size() >= 2 && block.vtx.back()->IsHogEx()) {
+        result.hogex_hash = block.vtx.back()->GetHash();
+    }
+    if (!block.mweb_block.IsNull()) {
+        const mw::Hash mweb_hash = block.mweb_block.GetHash();
+        std::memcpy(result.mweb_hash.begin(), mweb_hash.data(), result.mweb_hash.size());
+    }
+    return result;
+}
+
+constexpr std::chrono::seconds BlockTemplateProvider::CHECK_INTERVAL;
+constexpr size_t BlockTemplateProvider::MAX_TEMPLATES;
+
+BlockTemplateProvider::BlockTemplateProvider(BlockTemplateUpdater& updater, const CTxMemPool& mempool, CScheduler& scheduler, CAmount fee_delta)
+    : m_updater(updater), m_mempool(mempool), m_fee_delta(fee_delta)
+{
+    scheduler.scheduleEvery([this] {
+        // Templates built during initial block download are stale right away
+        if (!HasListeners() || ::ChainstateActive().IsInitialBlockDownload()) return;
+        try {
+            LOCK(m_update_mutex);
+            Update();
+        } catch (const std::exception& e) {
+            LogPrintf("%s: failed to update the block template: %s\n", __func__, e.what());
+        }
+    }, CHECK_INTERVAL);
+}
+
+void BlockTemplateProvider::AddListener(Listener listener)
+{
+    LOCK(m_mutex);
+    m_listeners.push_back(std::move(listener));
+}
+
+bool BlockTemplateProvider::HasListeners() const
+{
+    LOCK(m_mutex);
+    return !m_listeners.empty();
+}
+
+std::shared_ptr<const BinaryBlockTemplate> BlockTemplateProvider::GetTemplate()
+{
+    LOCK(m_update_mutex);
+    return Update();
+}
+
+std::shared_ptr<const CBlockTemplate> BlockTemplateProvider::GetBlock(uint64_t id) const
+{
+    LOCK(m_mutex);
+    const auto it = m_blocks.find(id);
+    return it == m_blocks.end() ? nullptr : it->second;
+}
+
+void BlockTemplateProvider::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    if (fInitialDownload || !HasListeners()) return;
+    try {
+        LOCK(m_update_mutex);
+        Update();
+    } catch (const std::exception& e) {
+        LogPrintf("%s: failed to update the block template: %s\n", __func__, e.what());
+    }
+}
+
+std::shared_ptr<const BinaryBlockTemplate> BlockTemplateProvider::Update()
+{
+    // Nothing to do if the latest template is on the tip and the mempool didn't change
+    const unsigned int transactions_updated = m_mempool.GetTransactionsUpdated();
+    const uint256 tip_hash = WITH_LOCK(cs_main, return ::ChainActive().Tip()->GetBlockHash());
+    {
+        LOCK(m_mutex);
+        if (m_latest && m_latest->prev_hash == tip_hash && transactions_updated == m_transactions_updated) {
+            return m_latest;
+        }
+    }
+    m_transactions_updated = transactions_updated;
+
+    std::shared_ptr<const CBlockTemplate> blocktemplate = m_updater.GetBlockTemplate(CScript() << OP_TRUE);
+    const CBlock& block = blocktemplate->block;
+    const CAmount fees = -blocktemplate->vTxFees[0];
+    const int height = WITH_LOCK(cs_main, return LookupBlockIndex(block.hashPrevBlock)->nHeight + 1);
+
+    std::shared_ptr<const BinaryBlockTemplate> latest;
+    std::vector<Listener> listeners;
+    {
+        LOCK(m_mutex);
+        const bool new_tip = !m_latest || m_latest->prev_hash != block.hashPrevBlock;
+        // Templates with a little more in fees aren't worth having miners switch to.
+        if (!new_tip && fees < m_latest_fees + m_fee_delta) return m_latest;
+
+        // Solutions for earlier tips would be stale
+        if (new_tip) m_blocks.clear();
+        const uint64_t id = m_next_id++;
+        latest = std::make_shared<const BinaryBlockTemplate>(MakeBinaryBlockTemplate(*blocktemplate, height, id));
+        m_latest = latest;
+        m_latest_fees = fees;
+        m_blocks.emplace(id, std::move(blocktemplate));
+        while (m_blocks.size() > MAX_TEMPLATES) {
+            m_blocks.erase(m_blocks.begin());
+        }
+        listeners = m_listeners;
+    }
+    LogPrint(BCLog::BENCH, "BlockTemplateProvider: new template %u at height %d with %d fees\n", latest->id, height, fees);
+
+    for (const Listener& listener : listeners) {
+        listener(*latest);
+    }
+    return latest;
+}
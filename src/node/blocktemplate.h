@@ -0,0 +1,130 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKTEMPLATE_H
+#define BITCOIN_NODE_BLOCKTEMPLATE_H
+
+#include <amount.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class BlockTemplateUpdater;
+class CBlock;
+class CScheduler;
+class CTxMemPool;
+struct CBlockTemplate;
+
+/** Default for -blocktemplatefeedelta, the fee increase that makes a new template worth pushing */
+static const CAmount DEFAULT_BLOCK_TEMPLATE_FEE_DELTA = 10000;
+
+/**
+ * A block template without its transactions: what a miner needs to build the
+ * coinbase and hash headers, in a compact binary form. The coinbase fields
+ * follow the Stratum V2 NewTemplate message. The miner writes the coinbase
+ * with coinbase_prefix at the start of its scriptSig, an output of its own
+ * for coinbase_value and then coinbase_outputs. Its txid and merkle_branch
+ * give the merkle root.
+ *
+ * A solution is submitted with submittemplatesolution and the template id.
+ */
+struct BinaryBlockTemplate {
+    uint64_t id{0};
+
+    // Header fields
+    int32_t version{0};
+    uint256 prev_hash;
+    uint32_t time{0};
+    uint32_t bits{0};
+    int32_t height{0};
+
+    // Coinbase parts
+    int32_t coinbase_version{0};
+    std::vector<unsigned char> coinbase_prefix;
+    uint32_t coinbase_sequence{0};
+    CAmount coinbase_value{0};
+    std::vector<CTxOut> coinbase_outputs;
+    uint32_t coinbase_locktime{0};
+
+    //! Hashes to combine with the coinbase txid, from the bottom up, to get the merkle root
+    std::vector<uint256> merkle_branch;
+
+    //! The HogEx transaction and the hash of the MWEB block it commits to, or null before MWEB activation
+    uint256 hogex_hash;
+    uint256 mweb_hash;
+
+    SERIALIZE_METHODS(BinaryBlockTemplate, obj)
+    {
+        READWRITE(obj.id, obj.version, obj.prev_hash, obj.time, obj.bits, obj.height);
+        READWRITE(obj.coinbase_version, obj.coinbase_prefix, obj.coinbase_sequence, obj.coinbase_value, obj.coinbase_outputs, obj.coinbase_locktime);
+        READWRITE(obj.merkle_branch, obj.hogex_hash, obj.mweb_hash);
+    }
+};
+
+/** Merkle branch of the first transaction of the block, whose own hash doesn't matter */
+std::vector<uint256> CoinbaseMerkleBranch(const CBlock& block);
+
+/** Describe a template for a block at the given height */
+BinaryBlockTemplate MakeBinaryBlockTemplate(const CBlockTemplate& blocktemplate, int height, uint64_t id);
+
+/**
+ * Hands out block templates to miners that listen for new ones, rather than
+ * polling getblocktemplate. A new template is made as soon as the tip
+ * changes, and when the fees of the template have grown by at least the fee
+ * delta since the last one, checked every CHECK_INTERVAL. The latest
+ * MAX_TEMPLATES templates on the current tip are kept for solutions.
+ */
+class BlockTemplateProvider final : public CValidationInterface
+{
+public:
+    using Listener = std::function<void(const BinaryBlockTemplate&)>;
+
+    static constexpr std::chrono::seconds CHECK_INTERVAL{1};
+    /** Most templates kept for solutions */
+    static constexpr size_t MAX_TEMPLATES = 16;
+
+    BlockTemplateProvider(BlockTemplateUpdater& updater, const CTxMemPool& mempool, CScheduler& scheduler, CAmount fee_delta);
+
+    /** Call listener with every new template. Templates are only made while there are listeners. */
+    void AddListener(Listener listener) LOCKS_EXCLUDED(m_mutex);
+
+    /** Return the latest template, making a new one first if the tip or the fees changed */
+    std::shared_ptr<const BinaryBlockTemplate> GetTemplate() LOCKS_EXCLUDED(m_update_mutex, m_mutex);
+
+    /** The block of a template kept for solutions, or nullptr */
+    std::shared_ptr<const CBlockTemplate> GetBlock(uint64_t id) const LOCKS_EXCLUDED(m_mutex);
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+
+private:
+    std::shared_ptr<const BinaryBlockTemplate> Update() EXCLUSIVE_LOCKS_REQUIRED(m_update_mutex) LOCKS_EXCLUDED(m_mutex);
+    bool HasListeners() const LOCKS_EXCLUDED(m_mutex);
+
+    BlockTemplateUpdater& m_updater;
+    const CTxMemPool& m_mempool;
+    const CAmount m_fee_delta;
+
+    //! Serializes updates, so listeners see templates in order
+    Mutex m_update_mutex;
+    //! Mempool update counter when the latest template was made
+    unsigned int m_transactions_updated GUARDED_BY(m_update_mutex){0};
+
+    mutable Mutex m_mutex;
+    std::vector<Listener> m_listeners GUARDED_BY(m_mutex);
+    std::shared_ptr<const BinaryBlockTemplate> m_latest GUARDED_BY(m_mutex);
+    CAmount m_latest_fees GUARDED_BY(m_mutex){0};
+    std::map<uint64_t, std::shared_ptr<const CBlockTemplate>> m_blocks GUARDED_BY(m_mutex);
+    uint64_t m_next_id GUARDED_BY(m_mutex){1};
+};
+
+#endif // BITCOIN_NODE_BLOCKTEMPLATE_H
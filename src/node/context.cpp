@@ -6,8 +6,10 @@
 
 #include <banman.h>
 #include <interfaces/chain.h>
+#include <miner.h>
 #include <net.h>
 #include <net_processing.h>
+#include <node/blocktemplate.h>
 #include <scheduler.h>
 #include <txmempool.h>
 
@@ -12,6 +12,8 @@
 
 class ArgsManager;
 class BanMan;
+class BlockTemplateProvider;
+class BlockTemplateUpdater;
 class CConnman;
 class CScheduler;
 class CTxMemPool;
@@ -37,6 +39,8 @@ struct NodeContext {
     std::unique_ptr<CConnman> connman;
     std::unique_ptr<CTxMemPool> mempool;
     std::unique_ptr<PeerManager> peerman;
+    std::unique_ptr<BlockTemplateUpdater> block_template_updater;
+    std::unique_ptr<BlockTemplateProvider> block_template_provider;
     ChainstateManager* chainman{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
     std::unique_ptr<BanMan> banman;
     ArgsManager* args{nullptr}; // Currently a raw pointer because the memory is not managed by this struct
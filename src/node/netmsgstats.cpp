@@ -0,0 +1,78 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/netmsgstats.h>
+
+#include <protocol.h>
+
+#include <algorithm>
+#include <cmath>
+
+void Log2Histogram::Add(uint64_t value)
+{
+    size_t bucket = 0;
+    for (uint64_t v = value; v != 0 && bucket < NUM_BUCKETS - 1; v >>= 1) {
+        ++bucket;
+    }
+    ++m_buckets[bucket];
+    ++m_count;
+    m_sum += value;
+    m_max = std::max(m_max, value);
+}
+
+uint64_t Log2Histogram::Quantile(double fraction) const
+{
+    if (m_count == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * m_count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            // The largest value of the bucket, but never more than the largest value seen
+            return std::min(m_max, i == 0 ? 0 : (uint64_t{1} << i) - 1);
+        }
+    }
+    return m_max;
+}
+
+NetMessageStats::NetMessageStats()
+{
+    const std::vector<std::string>& types = getAllNetMessageTypes();
+    m_known_types.insert(types.begin(), types.end());
+    m_known_types.insert(NET_MESSAGE_COMMAND_OTHER);
+}
+
+void NetMessageStats::Record(NodeId peer_id, const std::string& msg_type, uint64_t size, std::chrono::microseconds processing_time, std::chrono::microseconds cs_main_wait)
+{
+    const std::string& type = m_known_types.count(msg_type) ? msg_type : NET_MESSAGE_COMMAND_OTHER;
+    const auto add = [&](NetMessageTypeStats& stats) {
+        stats.size.Add(size);
+        stats.processing_time.Add(std::max<int64_t>(0, processing_time.count()));
+        stats.cs_main_wait.Add(std::max<int64_t>(0, cs_main_wait.count()));
+    };
+
+    LOCK(m_mutex);
+    add(m_stats[type]);
+    add(m_peer_stats[peer_id][type]);
+}
+
+void NetMessageStats::ForgetPeer(NodeId peer_id)
+{
+    LOCK(m_mutex);
+    m_peer_stats.erase(peer_id);
+}
+
+NetMessageStatsMap NetMessageStats::GetStats() const
+{
+    LOCK(m_mutex);
+    return m_stats;
+}
+
+Optional<NetMessageStatsMap> NetMessageStats::GetPeerStats(NodeId peer_id) const
+{
+    LOCK(m_mutex);
+    const auto it = m_peer_stats.find(peer_id);
+    if (it == m_peer_stats.end()) return nullopt;
+    return it->second;
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_NETMSGSTATS_H
+#define BITCOIN_NODE_NETMSGSTATS_H
+
+#include <net.h>
+#include <optional.h>
+#include <sync.h>
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+
+/**
+ * Histogram of non-negative values with power of two buckets: bucket 0 counts
+ * zeros, and bucket i > 0 counts values in [2^(i-1), 2^i). The last bucket
+ * also counts all larger values.
+ */
+class Log2Histogram
+{
+public:
+    static constexpr size_t NUM_BUCKETS = 40;
+
+    void Add(uint64_t value);
+
+    uint64_t Count() const { return m_count; }
+    uint64_t Sum() const { return m_sum; }
+    uint64_t Max() const { return m_max; }
+    const std::array<uint64_t, NUM_BUCKETS>& Buckets() const { return m_buckets; }
+
+    /** Upper bound of the value below which the given fraction of the values lie, by bucket. */
+    uint64_t Quantile(double fraction) const;
+
+private:
+    std::array<uint64_t, NUM_BUCKETS> m_buckets{};
+    uint64_t m_count{0};
+    uint64_t m_sum{0};
+    uint64_t m_max{0};
+};
+
+/** Statistics of the messages of one type */
+struct NetMessageTypeStats
+{
+    //! Payload sizes in bytes
+    Log2Histogram size;
+    //! Time spent in ProcessMessage, in microseconds, including lock waits
+    Log2Histogram processing_time;
+    //! Time spent waiting for cs_main while processing, in microseconds
+    Log2Histogram cs_main_wait;
+};
+
+using NetMessageStatsMap = std::map<std::string, NetMessageTypeStats>;
+
+/**
+ * Statistics of the messages processed, by message type, globally and per
+ * connected peer. Message types we don't know are recorded as
+ * NET_MESSAGE_COMMAND_OTHER, so that peers can't grow the maps.
+ */
+class NetMessageStats
+{
+public:
+    NetMessageStats();
+
+    void Record(NodeId peer_id, const std::string& msg_type, uint64_t size, std::chrono::microseconds processing_time, std::chrono::microseconds cs_main_wait);
+
+    /** Forget the statistics of a disconnected peer. Its messages remain in the global statistics. */
+    void ForgetPeer(NodeId peer_id);
+
+    /** Statistics of all messages processed, of the message types seen so far */
+    NetMessageStatsMap GetStats() const;
+
+    /** Statistics of the messages processed from a connected peer */
+    Optional<NetMessageStatsMap> GetPeerStats(NodeId peer_id) const;
+
+private:
+    //! Message types we know, and NET_MESSAGE_COMMAND_OTHER
+    std::set<std::string> m_known_types;
+
+    mutable Mutex m_mutex;
+    NetMessageStatsMap m_stats GUARDED_BY(m_mutex);
+    std::map<NodeId, NetMessageStatsMap> m_peer_stats GUARDED_BY(m_mutex);
+};
+
+#endif // BITCOIN_NODE_NETMSGSTATS_H
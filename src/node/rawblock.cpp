@@ -0,0 +1,246 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/rawblock.h>
+
+#include <crypto/common.h>
+#include <hash.h>
+#include <mweb/mweb_models.h>
+#include <serialize.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+#include <version.h>
+
+#include <cmath>
+#include <cstring>
+
+/** Time constant of the moving average of bytes served per second */
+static constexpr double BYTES_SERVED_AVERAGE_SECONDS = 60.0;
+/** Approximate per-entry overhead of the list node, map entry and layout vector */
+static constexpr size_t RAW_BLOCK_ENTRY_OVERHEAD = 160;
+
+namespace {
+/** Stream over a serialized block that can skip data without copying it. */
+class RawBlockReader
+{
+    Span<const uint8_t> m_data;
+    size_t m_pos{0};
+
+public:
+    explicit RawBlockReader(Span<const uint8_t> data) : m_data(data) {}
+
+    int GetType() const { return SER_DISK; }
+    int GetVersion() const { return CLIENT_VERSION; }
+    uint32_t Pos() const { return m_pos; }
+
+    void ignore(size_t size)
+    {
+        if (size > m_data.size() - m_pos) {
+            throw std::ios_base::failure("RawBlockReader::ignore(): end of data");
+        }
+        m_pos += size;
+    }
+
+    void read(char* dst, size_t size)
+    {
+        if (size > m_data.size() - m_pos) {
+            throw std::ios_base::failure("RawBlockReader::read(): end of data");
+        }
+        memcpy(dst, m_data.data() + m_pos, size);
+        m_pos += size;
+    }
+
+    template <typename T>
+    RawBlockReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+};
+} // namespace
+
+bool ParseRawBlockLayout(Span<const uint8_t> block, RawBlockLayout& layout)
+{
+    layout.txs.clear();
+    if (block.size() > std::numeric_limits<uint32_t>::max()) return false;
+
+    try {
+        RawBlockReader reader(block);
+        reader.ignore(80); // header
+
+        const uint64_t num_txs = ReadCompactSize(reader);
+        layout.txs.reserve(num_txs);
+        for (uint64_t i = 0; i < num_txs; ++i) {
+            RawBlockLayout::Tx tx;
+            tx.begin = reader.Pos();
+            reader.ignore(4); // nVersion
+
+            uint64_t num_inputs = ReadCompactSize(reader);
+            if (num_inputs == 0) {
+                // Extended format: dummy empty vin followed by the flags
+                reader >> tx.flags;
+                // Only witness (1) and MWEB (8) data are defined
+                if (tx.flags == 0 || (tx.flags & ~9)) return false;
+                tx.io_begin = reader.Pos();
+                num_inputs = ReadCompactSize(reader);
+            } else {
+                tx.io_begin = tx.begin + 4;
+            }
+            for (uint64_t j = 0; j < num_inputs; ++j) {
+                reader.ignore(36); // prevout
+                reader.ignore(ReadCompactSize(reader)); // scriptSig
+                reader.ignore(4); // nSequence
+            }
+            const uint64_t num_outputs = ReadCompactSize(reader);
+            for (uint64_t j = 0; j < num_outputs; ++j) {
+                reader.ignore(8); // nValue
+                reader.ignore(ReadCompactSize(reader)); // scriptPubKey
+            }
+            tx.io_end = reader.Pos();
+
+            if (tx.flags & 1) {
+                for (uint64_t j = 0; j < num_inputs; ++j) {
+                    const uint64_t stack_size = ReadCompactSize(reader);
+                    for (uint64_t k = 0; k < stack_size; ++k) {
+                        reader.ignore(ReadCompactSize(reader));
+                    }
+                }
+            }
+            tx.witness_end = reader.Pos();
+
+            if (tx.flags & 8) {
+                MWEB::Tx mweb_tx;
+                reader >> mweb_tx;
+            }
+            tx.mweb_end = reader.Pos();
+
+            reader.ignore(4); // nLockTime
+            layout.txs.push_back(tx);
+        }
+        layout.txs_end = reader.Pos();
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void StripRawBlock(Span<const uint8_t> block, const RawBlockLayout& layout, int serialize_flags, std::vector<uint8_t>& out)
+{
+    const uint8_t keep_flags = ((serialize_flags & SERIALIZE_TRANSACTION_NO_WITNESS) ? 0 : 1) |
+                               ((serialize_flags & SERIALIZE_NO_MWEB) ? 0 : 8);
+    const auto append = [&](uint32_t begin, uint32_t end) {
+        out.insert(out.end(), block.begin() + begin, block.begin() + end);
+    };
+
+    out.clear();
+    out.reserve(block.size());
+    append(0, layout.txs.empty() ? layout.txs_end : layout.txs.front().begin);
+    for (const RawBlockLayout::Tx& tx : layout.txs) {
+        const uint8_t flags = tx.flags & keep_flags;
+        append(tx.begin, tx.begin + 4);
+        if (flags) {
+            out.push_back(0);
+            out.push_back(flags);
+        }
+        append(tx.io_begin, tx.io_end);
+        if (flags & 1) append(tx.io_end, tx.witness_end);
+        if (flags & 8) append(tx.witness_end, tx.mweb_end);
+        append(tx.mweb_end, tx.mweb_end + 4);
+    }
+    if (keep_flags & 8) {
+        append(layout.txs_end, block.size());
+    }
+}
+
+bool ReadRawBlockSize(FILE* file, const FlatFilePos& pos, const uint256& hash, const CMessageHeader::MessageStartChars& message_start, uint32_t& size)
+{
+    if (pos.nPos < 8 || fseek(file, pos.nPos - 8, SEEK_SET) != 0) {
+        return error("%s: Failed to seek to %s", __func__, pos.ToString());
+    }
+    // Message start, size and the block header
+    uint8_t buf[8 + 80];
+    if (fread(buf, 1, sizeof(buf), file) != sizeof(buf)) {
+        return error("%s: Failed to read %s", __func__, pos.ToString());
+    }
+    if (memcmp(buf, message_start, CMessageHeader::MESSAGE_START_SIZE)) {
+        return error("%s: Block magic mismatch for %s", __func__, pos.ToString());
+    }
+    size = ReadLE32(buf + 4);
+    if (size < 80 || size > MAX_SIZE) {
+        return error("%s: Invalid block size %u for %s", __func__, size, pos.ToString());
+    }
+    if (Hash(Span<const uint8_t>(buf + 8, 80)) != hash) {
+        return error("%s: Block at %s does not match %s", __func__, pos.ToString(), hash.ToString());
+    }
+    return true;
+}
+
+size_t RawBlockCache::EntryUsage(const RawBlock& block)
+{
+    return block.data.size() + block.layout.txs.size() * sizeof(RawBlockLayout::Tx) + RAW_BLOCK_ENTRY_OVERHEAD;
+}
+
+std::shared_ptr<const RawBlock> RawBlockCache::Get(const uint256& hash, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start)
+{
+    {
+        LOCK(m_mutex);
+        auto it = m_index.find(hash);
+        if (it != m_index.end()) {
+            ++m_hits;
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return it->second->second;
+        }
+        ++m_misses;
+    }
+
+    // Read the block without holding the lock, so that other blocks can be served meanwhile.
+    auto block = std::make_shared<RawBlock>();
+    if (!ReadRawBlockFromDisk(block->data, pos, message_start)) return nullptr;
+    if (block->data.size() < 80 || Hash(MakeSpan(block->data).first(80)) != hash) {
+        LogPrintf("%s: Block at %s does not match %s\n", __func__, pos.ToString(), hash.ToString());
+        return nullptr;
+    }
+    if (!ParseRawBlockLayout(block->data, block->layout)) {
+        LogPrintf("%s: Failed to parse block %s\n", __func__, hash.ToString());
+        return nullptr;
+    }
+
+    LOCK(m_mutex);
+    const size_t usage = EntryUsage(*block);
+    if (usage > m_max_usage || m_index.count(hash)) return block;
+    while (m_usage + usage > m_max_usage) {
+        m_usage -= EntryUsage(*m_entries.back().second);
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+    }
+    m_entries.emplace_front(hash, block);
+    m_index.emplace(hash, m_entries.begin());
+    m_usage += usage;
+    return block;
+}
+
+void RawBlockCache::RecordBytesServed(uint64_t bytes)
+{
+    const int64_t now = GetTimeMicros();
+    LOCK(m_mutex);
+    m_bytes_served += bytes;
+    m_bytes_per_second = m_bytes_per_second * std::exp(-(now - m_rate_time) * 1e-6 / BYTES_SERVED_AVERAGE_SECONDS) +
+                         bytes / BYTES_SERVED_AVERAGE_SECONDS;
+    m_rate_time = now;
+}
+
+RawBlockCacheStats RawBlockCache::GetStats() const
+{
+    const int64_t now = GetTimeMicros();
+    LOCK(m_mutex);
+    RawBlockCacheStats stats;
+    stats.usage = m_usage;
+    stats.num_blocks = m_entries.size();
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.bytes_served = m_bytes_served;
+    stats.bytes_per_second = m_bytes_per_second * std::exp(-(now - m_rate_time) * 1e-6 / BYTES_SERVED_AVERAGE_SECONDS);
+    return stats;
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_RAWBLOCK_H
+#define BITCOIN_NODE_RAWBLOCK_H
+
+#include <flatfile.h>
+#include <protocol.h>
+#include <span.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <list>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+
+/**
+ * Offsets of the optional parts of a fully serialized block (with witness and
+ * MWEB data), so that the serializations without them can be derived by
+ * copying byte ranges instead of deserializing and reserializing the block.
+ */
+struct RawBlockLayout
+{
+    struct Tx {
+        uint32_t begin{0};       //!< start of nVersion
+        uint32_t io_begin{0};    //!< start of vin, after the extended format marker and flags if present
+        uint32_t io_end{0};      //!< end of vout, start of the witnesses
+        uint32_t witness_end{0}; //!< end of the witnesses, start of the MWEB transaction
+        uint32_t mweb_end{0};    //!< end of the MWEB transaction, start of nLockTime
+        uint8_t flags{0};        //!< extended format flags, 0 if not extended
+    };
+
+    std::vector<Tx> txs;
+    //! End of the transactions, start of the MWEB block (if any)
+    uint32_t txs_end{0};
+};
+
+/** Parse the layout of a fully serialized block. Returns false if it can't be parsed. */
+bool ParseRawBlockLayout(Span<const uint8_t> block, RawBlockLayout& layout);
+
+/**
+ * Derive the serialization of a block with the given SERIALIZE_TRANSACTION_NO_WITNESS
+ * and SERIALIZE_NO_MWEB flags from its full serialization.
+ */
+void StripRawBlock(Span<const uint8_t> block, const RawBlockLayout& layout, int serialize_flags, std::vector<uint8_t>& out);
+
+/**
+ * Check the block stored in an open blk file at pos: the header in front of
+ * it must carry message_start, and the block must have the given hash. Sets
+ * size to the size of the block as stored, which is its full serialization.
+ */
+bool ReadRawBlockSize(FILE* file, const FlatFilePos& pos, const uint256& hash, const CMessageHeader::MessageStartChars& message_start, uint32_t& size);
+
+/** A block as stored in the blk files, with its layout */
+struct RawBlock
+{
+    std::vector<uint8_t> data;
+    RawBlockLayout layout;
+};
+
+struct RawBlockCacheStats
+{
+    size_t usage{0};
+    size_t num_blocks{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    //! Total bytes of blocks served to peers
+    uint64_t bytes_served{0};
+    //! Moving average of the bytes of blocks served per second
+    double bytes_per_second{0};
+};
+
+/**
+ * LRU cache of raw blocks recently served to peers. Peers syncing from us tend
+ * to request the same historical blocks around the same time, so keeping them
+ * avoids reading them from disk again, and the layout makes serving the
+ * stripped serializations cheap.
+ */
+class RawBlockCache
+{
+public:
+    explicit RawBlockCache(size_t max_usage) : m_max_usage(max_usage) {}
+
+    /**
+     * Get a block from the cache, or read it from disk at pos and add it. Returns
+     * nullptr if the block can't be read or doesn't match the given hash.
+     */
+    std::shared_ptr<const RawBlock> Get(const uint256& hash, const FlatFilePos& pos, const CMessageHeader::MessageStartChars& message_start);
+
+    /** Record a block of the given size sent to a peer. */
+    void RecordBytesServed(uint64_t bytes);
+
+    RawBlockCacheStats GetStats() const;
+
+private:
+    using Entries = std::list<std::pair<uint256, std::shared_ptr<const RawBlock>>>;
+
+    static size_t EntryUsage(const RawBlock& block);
+
+    const size_t m_max_usage;
+
+    mutable Mutex m_mutex;
+    //! most recently used first
+    Entries m_entries GUARDED_BY(m_mutex);
+    std::map<uint256, Entries::iterator> m_index GUARDED_BY(m_mutex);
+    size_t m_usage GUARDED_BY(m_mutex){0};
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+    uint64_t m_bytes_served GUARDED_BY(m_mutex){0};
+    double m_bytes_per_second GUARDED_BY(m_mutex){0};
+    int64_t m_rate_time GUARDED_BY(m_mutex){0};
+};
+
+#endif // BITCOIN_NODE_RAWBLOCK_H
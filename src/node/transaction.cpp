@@ -97,7 +97,7 @@ TransactionError BroadcastTransaction(NodeContext& node, const CTransactionRef t
         node.mempool->AddUnbroadcastTx(hashTx);
 
         LOCK(cs_main);
-        RelayTransaction(hashTx, tx->GetWitnessHash(), *node.connman);
+        RelayTransaction(hashTx, tx->GetWitnessHash(), *node.connman, tx->IsMWEBOnly());
     }
 
     return TransactionError::OK;
@@ -0,0 +1,279 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txreconciliation.h>
+
+#include <crypto/common.h>
+#include <crypto/siphash.h>
+#include <hash.h>
+#include <random.h>
+
+#include <cmath>
+
+/** Tag for the hash of both salts that keys the short IDs */
+static const std::string RECON_SALT_HASHER_TAG = "Tx Relay Salting";
+
+/** Hash of a short ID and a seed, used to place it in cells and to check cells */
+static uint32_t MixShortId(uint32_t short_id, uint32_t seed)
+{
+    uint64_t x = ((uint64_t{short_id} << 32) | seed) * 0x9e3779b97f4a7c15ULL;
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 32;
+    return (uint32_t)x;
+}
+
+ReconciliationSketch::ReconciliationSketch(size_t num_cells)
+    : m_cells((num_cells + NUM_HASHES - 1) / NUM_HASHES * NUM_HASHES)
+{
+}
+
+size_t ReconciliationSketch::CellsForDifference(size_t difference)
+{
+    // Small tables need proportionally more room to decode reliably.
+    return (size_t)std::ceil(difference * RECON_SKETCH_OVERHEAD) + 2 * NUM_HASHES;
+}
+
+size_t ReconciliationSketch::CellIndex(uint32_t short_id, size_t hash_index) const
+{
+    // Each hash function has its own partition of the cells, so that an element never lands twice in a cell.
+    const uint64_t partition_size = m_cells.size() / NUM_HASHES;
+    return hash_index * partition_size + ((MixShortId(short_id, hash_index) * partition_size) >> 32);
+}
+
+void ReconciliationSketch::Add(uint32_t short_id)
+{
+    if (m_cells.empty()) return;
+    const uint16_t hash = MixShortId(short_id, NUM_HASHES);
+    for (size_t i = 0; i < NUM_HASHES; ++i) {
+        Cell& cell = m_cells[CellIndex(short_id, i)];
+        ++cell.count;
+        cell.key_sum ^= short_id;
+        cell.hash_sum ^= hash;
+    }
+}
+
+void ReconciliationSketch::Subtract(const ReconciliationSketch& other)
+{
+    assert(other.m_cells.size() == m_cells.size());
+    for (size_t i = 0; i < m_cells.size(); ++i) {
+        m_cells[i].count -= other.m_cells[i].count;
+        m_cells[i].key_sum ^= other.m_cells[i].key_sum;
+        m_cells[i].hash_sum ^= other.m_cells[i].hash_sum;
+    }
+}
+
+bool ReconciliationSketch::Decode(std::vector<uint32_t>& only_ours, std::vector<uint32_t>& only_theirs) const
+{
+    only_ours.clear();
+    only_theirs.clear();
+    std::vector<Cell> cells = m_cells;
+    const auto is_pure = [](const Cell& cell) {
+        return (cell.count == 1 || cell.count == -1) && (uint16_t)MixShortId(cell.key_sum, NUM_HASHES) == cell.hash_sum;
+    };
+
+    // Repeatedly peel off the elements of cells that hold a single element.
+    std::vector<size_t> pure_cells;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (is_pure(cells[i])) pure_cells.push_back(i);
+    }
+    while (!pure_cells.empty()) {
+        const Cell cell = cells[pure_cells.back()];
+        pure_cells.pop_back();
+        if (!is_pure(cell)) continue;
+
+        (cell.count > 0 ? only_ours : only_theirs).push_back(cell.key_sum);
+        // A sketch can't hold more elements than cells, unless it was crafted not to decode.
+        if (only_ours.size() + only_theirs.size() > cells.size()) return false;
+
+        for (size_t i = 0; i < NUM_HASHES; ++i) {
+            const size_t index = CellIndex(cell.key_sum, i);
+            cells[index].count -= cell.count;
+            cells[index].key_sum ^= cell.key_sum;
+            cells[index].hash_sum ^= cell.hash_sum;
+            if (is_pure(cells[index])) pure_cells.push_back(index);
+        }
+    }
+    for (const Cell& cell : cells) {
+        if (!cell.IsEmpty()) return false;
+    }
+    return true;
+}
+
+uint32_t TxReconciliationTracker::PeerState::ShortId(const uint256& wtxid) const
+{
+    return (uint32_t)CSipHasher(k0, k1).Write(wtxid.begin(), wtxid.size()).Finalize();
+}
+
+TxReconciliationTracker::TxReconciliationTracker(uint32_t recon_version) : m_recon_version(recon_version) {}
+
+uint64_t TxReconciliationTracker::PreRegisterPeer(NodeId peer_id)
+{
+    const uint64_t local_salt{GetRand(std::numeric_limits<uint64_t>::max())};
+    LOCK(m_mutex);
+    m_pre_registered[peer_id] = local_salt;
+    return local_salt;
+}
+
+ReconciliationRegisterResult TxReconciliationTracker::RegisterPeer(NodeId peer_id, bool is_peer_inbound, uint32_t peer_recon_version, uint64_t remote_salt)
+{
+    LOCK(m_mutex);
+    if (m_peers.count(peer_id)) return ReconciliationRegisterResult::ALREADY_REGISTERED;
+    const auto it = m_pre_registered.find(peer_id);
+    if (it == m_pre_registered.end()) return ReconciliationRegisterResult::NOT_FOUND;
+    const uint64_t local_salt = it->second;
+    m_pre_registered.erase(it);
+
+    // The protocol is versioned by the lowest version both sides support; there is only version 1 so far.
+    if (std::min(peer_recon_version, m_recon_version) < 1) return ReconciliationRegisterResult::PROTOCOL_VIOLATION;
+
+    // Both sides derive the same keys by hashing the salts in ascending order.
+    const uint256 salt_hash = (TaggedHash(RECON_SALT_HASHER_TAG) << std::min(local_salt, remote_salt) << std::max(local_salt, remote_salt)).GetSHA256();
+    PeerState state;
+    state.we_initiate = !is_peer_inbound;
+    state.k0 = ReadLE64(salt_hash.begin());
+    state.k1 = ReadLE64(salt_hash.begin() + 8);
+    m_peers.emplace(peer_id, std::move(state));
+    return ReconciliationRegisterResult::SUCCESS;
+}
+
+void TxReconciliationTracker::ForgetPeer(NodeId peer_id)
+{
+    LOCK(m_mutex);
+    m_pre_registered.erase(peer_id);
+    m_peers.erase(peer_id);
+}
+
+bool TxReconciliationTracker::IsPeerRegistered(NodeId peer_id) const
+{
+    LOCK(m_mutex);
+    return m_peers.count(peer_id) > 0;
+}
+
+bool TxReconciliationTracker::AddToSet(NodeId peer_id, const uint256& wtxid)
+{
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it == m_peers.end() || it->second.local_set.size() >= MAX_RECON_SET_SIZE) return false;
+    it->second.local_set.insert(wtxid);
+    return true;
+}
+
+void TxReconciliationTracker::TryRemovingFromSet(NodeId peer_id, const uint256& wtxid)
+{
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it != m_peers.end()) it->second.local_set.erase(wtxid);
+}
+
+Optional<uint32_t> TxReconciliationTracker::InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it == m_peers.end()) return nullopt;
+    PeerState& state = it->second;
+    if (!state.we_initiate || state.awaiting_sketch || now < state.next_request) return nullopt;
+    state.awaiting_sketch = true;
+    state.next_request = now + RECON_REQUEST_INTERVAL;
+    return (uint32_t)state.local_set.size();
+}
+
+bool TxReconciliationTracker::HandleReconciliationRequest(NodeId peer_id, uint32_t peer_set_size, ReconciliationSketch& sketch)
+{
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it == m_peers.end()) return false;
+    PeerState& state = it->second;
+    if (state.we_initiate || state.awaiting_diff) return false;
+
+    state.snapshot.clear();
+    for (const uint256& wtxid : state.local_set) {
+        state.snapshot.emplace(state.ShortId(wtxid), wtxid);
+    }
+    state.local_set.clear();
+    state.awaiting_diff = true;
+
+    // Estimate the difference from the set sizes: at least their difference, plus a
+    // fraction of the smaller set for transactions only one side has seen.
+    const uint64_t local_size = state.snapshot.size();
+    const uint64_t difference = (local_size > peer_set_size ? local_size - peer_set_size : peer_set_size - local_size) +
+                                (uint64_t)(RECON_Q * std::min<uint64_t>(local_size, peer_set_size)) + 1;
+    const size_t num_cells = ReconciliationSketch::CellsForDifference(difference);
+    if (num_cells > MAX_SKETCH_CELLS ||
+        num_cells * sizeof(ReconciliationSketch::Cell) >= (local_size + peer_set_size) * RECON_INV_ENTRY_SIZE) {
+        // Announcing both sets would be as cheap; the empty sketch makes both sides do that.
+        sketch = ReconciliationSketch{};
+        return true;
+    }
+    sketch = ReconciliationSketch{num_cells};
+    for (const auto& entry : state.snapshot) {
+        sketch.Add(entry.first);
+    }
+    return true;
+}
+
+bool TxReconciliationTracker::HandleSketch(NodeId peer_id, const ReconciliationSketch& sketch, std::vector<uint256>& txs_to_announce, std::vector<uint32_t>& txs_to_request, bool& success)
+{
+    txs_to_announce.clear();
+    txs_to_request.clear();
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it == m_peers.end()) return false;
+    PeerState& state = it->second;
+    if (!state.we_initiate || !state.awaiting_sketch) return false;
+    if (sketch.Size() > MAX_SKETCH_CELLS || sketch.Size() % ReconciliationSketch::NUM_HASHES != 0) return false;
+    state.awaiting_sketch = false;
+
+    std::map<uint32_t, uint256> local_short_ids;
+    for (const uint256& wtxid : state.local_set) {
+        local_short_ids.emplace(state.ShortId(wtxid), wtxid);
+    }
+
+    success = false;
+    std::vector<uint32_t> only_ours;
+    if (sketch.Size() > 0) {
+        ReconciliationSketch difference{sketch.Size()};
+        for (const auto& entry : local_short_ids) {
+            difference.Add(entry.first);
+        }
+        difference.Subtract(sketch);
+        success = difference.Decode(only_ours, txs_to_request);
+    }
+
+    if (success) {
+        for (const uint32_t short_id : only_ours) {
+            const auto tx_it = local_short_ids.find(short_id);
+            if (tx_it != local_short_ids.end()) txs_to_announce.push_back(tx_it->second);
+        }
+    } else {
+        txs_to_request.clear();
+        txs_to_announce.assign(state.local_set.begin(), state.local_set.end());
+    }
+    state.local_set.clear();
+    return true;
+}
+
+bool TxReconciliationTracker::HandleReconciliationDifference(NodeId peer_id, bool success, const std::vector<uint32_t>& ask_short_ids, std::vector<uint256>& txs_to_announce)
+{
+    txs_to_announce.clear();
+    LOCK(m_mutex);
+    const auto it = m_peers.find(peer_id);
+    if (it == m_peers.end()) return false;
+    PeerState& state = it->second;
+    if (state.we_initiate || !state.awaiting_diff || ask_short_ids.size() > MAX_SKETCH_CELLS) return false;
+    state.awaiting_diff = false;
+
+    if (success) {
+        for (const uint32_t short_id : ask_short_ids) {
+            const auto tx_it = state.snapshot.find(short_id);
+            if (tx_it != state.snapshot.end()) txs_to_announce.push_back(tx_it->second);
+        }
+    } else {
+        for (const auto& entry : state.snapshot) {
+            txs_to_announce.push_back(entry.second);
+        }
+    }
+    state.snapshot.clear();
+    return true;
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_TXRECONCILIATION_H
+#define BITCOIN_NODE_TXRECONCILIATION_H
+
+#include <net.h>
+#include <optional.h>
+#include <serialize.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <vector>
+
+/** Whether transaction reconciliation is enabled by default */
+static constexpr bool DEFAULT_TXRECONCILIATION_ENABLE{false};
+/** Supported transaction reconciliation protocol version */
+static constexpr uint32_t TXRECONCILIATION_VERSION{1};
+/** Time between reconciliation requests to each peer we initiate reconciliations with */
+static constexpr std::chrono::microseconds RECON_REQUEST_INTERVAL{std::chrono::seconds{2}};
+/** Coefficient of the smaller set size in the estimate of the set difference (q in Erlay) */
+static constexpr double RECON_Q{0.25};
+/** Number of sketch cells per expected element of the set difference, so that decoding rarely fails */
+static constexpr double RECON_SKETCH_OVERHEAD{1.5};
+/** Maximum number of cells in a sketch, and of short IDs in a reconciliation difference */
+static constexpr size_t MAX_SKETCH_CELLS{3000};
+/** Maximum number of transactions in a reconciliation set. Transactions beyond it are announced by inv. */
+static constexpr size_t MAX_RECON_SET_SIZE{3000};
+/** Approximate size of announcing one transaction by inv, used to decide whether a sketch is worth sending */
+static constexpr size_t RECON_INV_ENTRY_SIZE{36};
+
+/**
+ * Invertible Bloom lookup table over 32-bit short transaction IDs. The
+ * difference of two sketches of the same size can be decoded into the
+ * elements of the symmetric difference of the two sets, as long as that
+ * difference is small enough for the number of cells.
+ */
+class ReconciliationSketch
+{
+public:
+    /** A cell is 8 bytes. A 16-bit checksum rarely lets a cell with several elements pass as pure,
+     *  which makes decoding fail rather than return wrong elements, as the cells don't peel to empty. */
+    struct Cell {
+        int16_t count{0};
+        uint16_t hash_sum{0};
+        uint32_t key_sum{0};
+
+        bool IsEmpty() const { return count == 0 && key_sum == 0 && hash_sum == 0; }
+        SERIALIZE_METHODS(Cell, obj) { READWRITE(obj.count, obj.key_sum, obj.hash_sum); }
+    };
+
+    /** Number of cells each element is added to */
+    static constexpr size_t NUM_HASHES = 3;
+
+    ReconciliationSketch() = default;
+    /** Create an empty sketch with num_cells cells, rounded up to a multiple of NUM_HASHES. */
+    explicit ReconciliationSketch(size_t num_cells);
+
+    /** Number of cells needed for a difference of the given size. */
+    static size_t CellsForDifference(size_t difference);
+
+    size_t Size() const { return m_cells.size(); }
+
+    void Add(uint32_t short_id);
+
+    /** Subtract a sketch of the same size, leaving the sketch of the symmetric difference. */
+    void Subtract(const ReconciliationSketch& other);
+
+    /**
+     * Decode a sketch obtained by subtracting theirs from ours into the short IDs
+     * only in ours and only in theirs. Returns false if it can't be fully decoded.
+     */
+    bool Decode(std::vector<uint32_t>& only_ours, std::vector<uint32_t>& only_theirs) const;
+
+    SERIALIZE_METHODS(ReconciliationSketch, obj) { READWRITE(obj.m_cells); }
+
+private:
+    size_t CellIndex(uint32_t short_id, size_t hash_index) const;
+
+    std::vector<Cell> m_cells;
+};
+
+enum class ReconciliationRegisterResult {
+    NOT_FOUND,
+    SUCCESS,
+    ALREADY_REGISTERED,
+    PROTOCOL_VIOLATION,
+};
+
+/**
+ * Set-reconciliation based transaction relay, after Erlay (BIP 330), with
+ * invertible Bloom lookup tables as sketches.
+ *
+ * Instead of announcing every transaction to a peer by inv, transactions are
+ * added to a reconciliation set kept for the peer. Periodically, the side that
+ * made the outbound connection (the initiator) sends REQRECON with the size of
+ * its set. The other side (the responder) answers with a SKETCH of its set and
+ * the initiator subtracts a sketch of its own set from it to find the
+ * difference: the transactions only it has are announced by inv, and the ones
+ * only the responder has are requested with RECONCILDIFF, which makes the
+ * responder announce them by inv. Transactions both sides already have are
+ * never announced. If the difference is too large to decode, both sides fall
+ * back to announcing their whole sets.
+ *
+ * Transactions are identified by 32-bit short IDs computed from their wtxid
+ * with a SipHash keyed by the salts both peers exchange in SENDTXRCNCL. For
+ * MWEB-only transactions the wtxid is the ID of their first kernel, so they are
+ * reconciled by kernel ID.
+ *
+ * The handshake is:
+ * 1. When we receive the peer's VERSION, PreRegisterPeer() generates our salt,
+ *    which we send in SENDTXRCNCL.
+ * 2. When we receive the peer's SENDTXRCNCL, RegisterPeer() completes the
+ *    registration with its salt.
+ */
+class TxReconciliationTracker
+{
+public:
+    explicit TxReconciliationTracker(uint32_t recon_version);
+
+    /** Generate our salt for the peer. Must be called before RegisterPeer(). */
+    uint64_t PreRegisterPeer(NodeId peer_id);
+
+    /** Register a peer that sent SENDTXRCNCL. Reconciliations are initiated by the side of the outbound connection. */
+    ReconciliationRegisterResult RegisterPeer(NodeId peer_id, bool is_peer_inbound, uint32_t peer_recon_version, uint64_t remote_salt);
+
+    /** Forget a peer, whether it was registered or not. */
+    void ForgetPeer(NodeId peer_id);
+
+    bool IsPeerRegistered(NodeId peer_id) const;
+
+    /**
+     * Add a transaction to reconcile with the peer. Returns false if the peer
+     * isn't registered or its set is full, in which case the transaction
+     * should be announced by inv instead.
+     */
+    bool AddToSet(NodeId peer_id, const uint256& wtxid);
+
+    /** Remove a transaction the peer announced to us from its set. */
+    void TryRemovingFromSet(NodeId peer_id, const uint256& wtxid);
+
+    /**
+     * If we initiate reconciliations with the peer and it is time for the next
+     * one, returns the size of our set to send in REQRECON.
+     */
+    Optional<uint32_t> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * Respond to a REQRECON from the peer. Takes a snapshot of our set and
+     * sketches it. An empty sketch means the sets differ too much to be worth
+     * reconciling. Returns false if the request is a protocol violation.
+     */
+    bool HandleReconciliationRequest(NodeId peer_id, uint32_t peer_set_size, ReconciliationSketch& sketch);
+
+    /**
+     * Finish a reconciliation we initiated with the peer's SKETCH. On success,
+     * returns the transactions to announce to the peer and the short IDs to
+     * request in RECONCILDIFF. Otherwise all of our set is to be announced.
+     * Returns false if the sketch is a protocol violation.
+     */
+    bool HandleSketch(NodeId peer_id, const ReconciliationSketch& sketch, std::vector<uint256>& txs_to_announce, std::vector<uint32_t>& txs_to_request, bool& success);
+
+    /**
+     * Handle the peer's RECONCILDIFF, returning the transactions of the snapshot
+     * to announce: the requested ones, or all of them if decoding failed.
+     * Returns false if the message is a protocol violation.
+     */
+    bool HandleReconciliationDifference(NodeId peer_id, bool success, const std::vector<uint32_t>& ask_short_ids, std::vector<uint256>& txs_to_announce);
+
+private:
+    struct PeerState {
+        //! Whether we send REQRECON to the peer (we are the initiator) or answer them
+        bool we_initiate;
+        //! SipHash keys for short IDs, derived from both salts
+        uint64_t k0, k1;
+        //! Transactions to reconcile with the peer
+        std::set<uint256> local_set;
+        //! Initiator: whether a REQRECON is outstanding, and when to send the next one
+        bool awaiting_sketch{false};
+        std::chrono::microseconds next_request{0};
+        //! Responder: the set as sketched in the last SKETCH, by short ID, until RECONCILDIFF arrives
+        std::map<uint32_t, uint256> snapshot;
+        bool awaiting_diff{false};
+
+        uint32_t ShortId(const uint256& wtxid) const;
+    };
+
+    const uint32_t m_recon_version;
+
+    mutable Mutex m_mutex;
+    //! Salts generated for peers that haven't sent SENDTXRCNCL yet
+    std::map<NodeId, uint64_t> m_pre_registered GUARDED_BY(m_mutex);
+    std::map<NodeId, PeerState> m_peers GUARDED_BY(m_mutex);
+};
+
+#endif // BITCOIN_NODE_TXRECONCILIATION_H
@@ -12,6 +12,13 @@
 
 static constexpr double INF_FEERATE = 1e99;
 
+/** Results of estimateSmartFee for every target, as of the last block */
+struct FeeEstimateSnapshot {
+    //! Indexed by target; targets that aren't tracked are left out
+    std::vector<std::pair<CFeeRate, FeeCalculation>> economical;
+    std::vector<std::pair<CFeeRate, FeeCalculation>> conservative;
+};
+
 std::string StringForFeeEstimateHorizon(FeeEstimateHorizon horizon) {
     static const std::map<FeeEstimateHorizon, std::string> horizon_strings = {
         {FeeEstimateHorizon::SHORT_HALFLIFE, "short"},
@@ -62,6 +69,15 @@ private:
 
     double decay;
 
+    // The moving averages above are only decayed as a whole, once every
+    // DECAY_EPOCH_LENGTH blocks. In between, they are kept divided by
+    // m_decay_scale, which is decay to the power of the number of blocks
+    // since the start of the epoch, and new data points are added divided by
+    // it as well.
+    static constexpr unsigned int DECAY_EPOCH_LENGTH = 1008;
+    unsigned int m_decay_epoch_blocks{0};
+    double m_decay_scale{1};
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -72,8 +88,15 @@ private:
     // transactions still unconfirmed after GetMaxConfirms for each bucket
     std::vector<int> oldUnconfTxs;
 
+    // While set by CacheUnconfirmed, the number of transactions in each
+    // bucket X that have been unconfirmed for at least Y blocks
+    std::vector<std::vector<int>> m_unconf_since; // m_unconf_since[Y][X]
+
     void resizeInMemoryCounters(size_t newbuckets);
 
+    /** Apply the decay of the current epoch to the moving averages, and start a new one */
+    void ApplyDecay();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -107,6 +130,12 @@ public:
         with the data gathered from the current block */
     void UpdateMovingAverages();
 
+    /** Count the unconfirmed transactions that EstimateMedianVal needs for
+     * every target at once, until ClearUnconfirmedCache. The unconfirmed
+     * transactions must not change in between. */
+    void CacheUnconfirmed(unsigned int nBlockHeight);
+    void ClearUnconfirmedCache() { m_unconf_since.clear(); }
+
     /**
      * Calculate a feerate estimate.  Find the lowest value bucket (or range of buckets
      * to make sure we have enough data points) whose transactions still have sufficient likelihood
@@ -115,10 +144,11 @@ public:
      * @param sufficientTxVal required average number of transactions per block in a bucket range
      * @param minSuccess the success probability we require
      * @param nBlockHeight the current block height
+     * @param log whether to log the calculation
      */
     double EstimateMedianVal(int confTarget, double sufficientTxVal,
                              double minSuccess, unsigned int nBlockHeight,
-                             EstimationResult *result = nullptr) const;
+                             EstimationResult *result = nullptr, bool log = true) const;
 
     /** Return the max number of confirms we're tracking */
     unsigned int GetMaxConfirms() const { return scale * confAvg.size(); }
@@ -179,30 +209,50 @@ void TxConfirmStats::Record(int blocksToConfirm, double feerate)
         return;
     int periodsToConfirm = (blocksToConfirm + scale - 1) / scale;
     unsigned int bucketindex = bucketMap.lower_bound(feerate)->second;
+    const double weight = 1 / m_decay_scale;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += weight;
     }
-    txCtAvg[bucketindex]++;
-    m_feerate_avg[bucketindex] += feerate;
+    txCtAvg[bucketindex] += weight;
+    m_feerate_avg[bucketindex] += feerate * weight;
 }
 
-void TxConfirmStats::UpdateMovingAverages()
+void TxConfirmStats::ApplyDecay()
 {
     assert(confAvg.size() == failAvg.size());
     for (unsigned int j = 0; j < buckets.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++) {
-            confAvg[i][j] *= decay;
-            failAvg[i][j] *= decay;
+            confAvg[i][j] *= m_decay_scale;
+            failAvg[i][j] *= m_decay_scale;
+        }
+        m_feerate_avg[j] *= m_decay_scale;
+        txCtAvg[j] *= m_decay_scale;
+    }
+    m_decay_epoch_blocks = 0;
+    m_decay_scale = 1;
+}
+
+void TxConfirmStats::UpdateMovingAverages()
+{
+    m_decay_scale *= decay;
+    if (++m_decay_epoch_blocks == DECAY_EPOCH_LENGTH) ApplyDecay();
+}
+
+void TxConfirmStats::CacheUnconfirmed(unsigned int nBlockHeight)
+{
+    const unsigned int bins = unconfTxs.size();
+    m_unconf_since.assign(GetMaxConfirms() + 1, oldUnconfTxs);
+    for (unsigned int confct = GetMaxConfirms(); confct-- > 0;) {
+        for (unsigned int j = 0; j < buckets.size(); j++) {
+            m_unconf_since[confct][j] = m_unconf_since[confct + 1][j] + unconfTxs[(nBlockHeight - confct) % bins][j];
         }
-        m_feerate_avg[j] *= decay;
-        txCtAvg[j] *= decay;
     }
 }
 
 // returns -1 on error conditions
 double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
                                          double successBreakPoint, unsigned int nBlockHeight,
-                                         EstimationResult *result) const
+                                         EstimationResult *result, bool log) const
 {
     // Counters for a bucket (or range of buckets)
     double nConf = 0; // Number of tx's confirmed within the confTarget
@@ -236,12 +286,16 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
-        for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
-            extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
-        extraNum += oldUnconfTxs[bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * m_decay_scale;
+        totalNum += txCtAvg[bucket] * m_decay_scale;
+        failNum += failAvg[periodTarget - 1][bucket] * m_decay_scale;
+        if (!m_unconf_since.empty()) {
+            extraNum += m_unconf_since[confTarget][bucket];
+        } else {
+            for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
+                extraNum += unconfTxs[(nBlockHeight - confct) % bins][bucket];
+            extraNum += oldUnconfTxs[bucket];
+        }
         // If we have enough transaction data points in this range of buckets,
         // we can test for success
         // (Only count the confirmed data points, so that each confirmation count
@@ -334,7 +388,7 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
         failed_within_target_perc = 100 * failBucket.withinTarget / (failBucket.totalConfirmed + failBucket.inMempool + failBucket.leftMempool);
     }
 
-    LogPrint(BCLog::ESTIMATEFEE, "FeeEst: %d > %.0f%% decay %.5f: feerate: %g from (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out) Fail: (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out)\n",
+    if (log) LogPrint(BCLog::ESTIMATEFEE, "FeeEst: %d > %.0f%% decay %.5f: feerate: %g from (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out) Fail: (%g - %g) %.2f%% %.1f/(%.1f %d mem %.1f out)\n",
              confTarget, 100.0 * successBreakPoint, decay,
              median, passBucket.start, passBucket.end,
              passed_within_target_perc,
@@ -355,12 +409,22 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
 
 void TxConfirmStats::Write(CAutoFile& fileout) const
 {
+    // Write the moving averages with the decay of the current epoch applied
+    const auto decayed = [this](std::vector<double> avg) {
+        for (double& val : avg) val *= m_decay_scale;
+        return avg;
+    };
+    std::vector<std::vector<double>> conf_avg;
+    std::vector<std::vector<double>> fail_avg;
+    for (const auto& avg : confAvg) conf_avg.push_back(decayed(avg));
+    for (const auto& avg : failAvg) fail_avg.push_back(decayed(avg));
+
     fileout << decay;
     fileout << scale;
-    fileout << m_feerate_avg;
-    fileout << txCtAvg;
-    fileout << confAvg;
-    fileout << failAvg;
+    fileout << decayed(m_feerate_avg);
+    fileout << decayed(txCtAvg);
+    fileout << conf_avg;
+    fileout << fail_avg;
 }
 
 void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -459,7 +523,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / m_decay_scale;
         }
     }
 }
@@ -619,6 +683,36 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
 
     trackedTxs = 0;
     untrackedTxs = 0;
+
+    // Rebuilt on the next estimateSmartFee, so blocks connected in a row
+    // (as in IBD) don't pay for it
+    std::atomic_store(&m_estimates, std::shared_ptr<const FeeEstimateSnapshot>());
+}
+
+std::shared_ptr<const FeeEstimateSnapshot> CBlockPolicyEstimator::updateEstimates() const
+{
+    int64_t start = GetTimeMicros();
+    feeStats->CacheUnconfirmed(nBestSeenHeight);
+    shortStats->CacheUnconfirmed(nBestSeenHeight);
+    longStats->CacheUnconfirmed(nBestSeenHeight);
+
+    auto estimates = std::make_shared<FeeEstimateSnapshot>();
+    const unsigned int max_target = longStats->GetMaxConfirms();
+    estimates->economical.resize(max_target + 1);
+    estimates->conservative.resize(max_target + 1);
+    for (unsigned int target = 1; target <= max_target; ++target) {
+        auto& economical = estimates->economical[target];
+        economical.first = computeSmartFee(target, &economical.second, /* conservative */ false, /* log */ false);
+        auto& conservative = estimates->conservative[target];
+        conservative.first = computeSmartFee(target, &conservative.second, /* conservative */ true, /* log */ false);
+    }
+
+    feeStats->ClearUnconfirmedCache();
+    shortStats->ClearUnconfirmedCache();
+    longStats->ClearUnconfirmedCache();
+    std::atomic_store(&m_estimates, std::shared_ptr<const FeeEstimateSnapshot>(estimates));
+    LogPrint(BCLog::ESTIMATEFEE, "Blockpolicy smart fee estimates for %u targets computed in %gs\n", max_target, (GetTimeMicros() - start) * 0.000001);
+    return estimates;
 }
 
 CFeeRate CBlockPolicyEstimator::estimateFee(int confTarget) const
@@ -715,32 +809,32 @@ unsigned int CBlockPolicyEstimator::MaxUsableEstimate() const
  * time horizon which tracks confirmations up to the desired target.  If
  * checkShorterHorizon is requested, also allow short time horizon estimates
  * for a lower target to reduce the given answer */
-double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result, bool log) const
 {
     double estimate = -1;
     if (confTarget >= 1 && confTarget <= longStats->GetMaxConfirms()) {
         // Find estimate from shortest time horizon possible
         if (confTarget <= shortStats->GetMaxConfirms()) { // short horizon
-            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result);
+            estimate = shortStats->EstimateMedianVal(confTarget, SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, result, log);
         }
         else if (confTarget <= feeStats->GetMaxConfirms()) { // medium horizon
-            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = feeStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result, log);
         }
         else { // long horizon
-            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result);
+            estimate = longStats->EstimateMedianVal(confTarget, SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, result, log);
         }
         if (checkShorterHorizon) {
             EstimationResult tempResult;
             // If a lower confTarget from a more recent horizon returns a lower answer use it.
             if (confTarget > feeStats->GetMaxConfirms()) {
-                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult);
+                double medMax = feeStats->EstimateMedianVal(feeStats->GetMaxConfirms(), SUFFICIENT_FEETXS, successThreshold, nBestSeenHeight, &tempResult, log);
                 if (medMax > 0 && (estimate == -1 || medMax < estimate)) {
                     estimate = medMax;
                     if (result) *result = tempResult;
                 }
             }
             if (confTarget > shortStats->GetMaxConfirms()) {
-                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult);
+                double shortMax = shortStats->EstimateMedianVal(shortStats->GetMaxConfirms(), SUFFICIENT_TXS_SHORT, successThreshold, nBestSeenHeight, &tempResult, log);
                 if (shortMax > 0 && (estimate == -1 || shortMax < estimate)) {
                     estimate = shortMax;
                     if (result) *result = tempResult;
@@ -754,15 +848,15 @@ double CBlockPolicyEstimator::estimateCombinedFee(unsigned int confTarget, doubl
 /** Ensure that for a conservative estimate, the DOUBLE_SUCCESS_PCT is also met
  * at 2 * target for any longer time horizons.
  */
-double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const
+double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result, bool log) const
 {
     double estimate = -1;
     EstimationResult tempResult;
     if (doubleTarget <= shortStats->GetMaxConfirms()) {
-        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result);
+        estimate = feeStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, result, log);
     }
     if (doubleTarget <= feeStats->GetMaxConfirms()) {
-        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult);
+        double longEstimate = longStats->EstimateMedianVal(doubleTarget, SUFFICIENT_FEETXS, DOUBLE_SUCCESS_PCT, nBestSeenHeight, &tempResult, log);
         if (longEstimate > estimate) {
             estimate = longEstimate;
             if (result) *result = tempResult;
@@ -777,11 +871,30 @@ double CBlockPolicyEstimator::estimateConservativeFee(unsigned int doubleTarget,
  * shortest time horizon which tracks the required target.  Conservative
  * estimates, however, required the 95% threshold at 2 * target be met for any
  * longer time horizons also.
+ *
+ * The estimates for every target are computed at once by the first call after
+ * a block, and served without taking m_cs_fee_estimator until the next one.
  */
 CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const
 {
+    std::shared_ptr<const FeeEstimateSnapshot> estimates = std::atomic_load(&m_estimates);
+    if (!estimates) {
+        LOCK(m_cs_fee_estimator);
+        estimates = std::atomic_load(&m_estimates);
+        if (!estimates) estimates = updateEstimates();
+    }
+    const auto& table = conservative ? estimates->conservative : estimates->economical;
+    if (confTarget > 0 && (unsigned int)confTarget < table.size()) {
+        if (feeCalc) *feeCalc = table[confTarget].second;
+        return table[confTarget].first;
+    }
+
     LOCK(m_cs_fee_estimator);
+    return computeSmartFee(confTarget, feeCalc, conservative, /* log */ true);
+}
 
+CFeeRate CBlockPolicyEstimator::computeSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool log) const
+{
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -817,13 +930,13 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
      * the purpose of conservative estimates is not to let short term
      * fluctuations lower our estimates by too much.
      */
-    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult);
+    double halfEst = estimateCombinedFee(confTarget/2, HALF_SUCCESS_PCT, true, &tempResult, log);
     if (feeCalc) {
         feeCalc->est = tempResult;
         feeCalc->reason = FeeReason::HALF_ESTIMATE;
     }
     median = halfEst;
-    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult);
+    double actualEst = estimateCombinedFee(confTarget, SUCCESS_PCT, true, &tempResult, log);
     if (actualEst > median) {
         median = actualEst;
         if (feeCalc) {
@@ -831,7 +944,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
             feeCalc->reason = FeeReason::FULL_ESTIMATE;
         }
     }
-    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult);
+    double doubleEst = estimateCombinedFee(2 * confTarget, DOUBLE_SUCCESS_PCT, !conservative, &tempResult, log);
     if (doubleEst > median) {
         median = doubleEst;
         if (feeCalc) {
@@ -841,7 +954,7 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
     }
 
     if (conservative || median == -1) {
-        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult);
+        double consEst =  estimateConservativeFee(2 * confTarget, &tempResult, log);
         if (consEst > median) {
             median = consEst;
             if (feeCalc) {
@@ -933,6 +1046,8 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+
+            std::atomic_store(&m_estimates, std::shared_ptr<const FeeEstimateSnapshot>());
         }
     }
     catch (const std::exception& e) {
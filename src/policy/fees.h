@@ -21,6 +21,7 @@ class CFeeRate;
 class CTxMemPoolEntry;
 class CTxMemPool;
 class TxConfirmStats;
+struct FeeEstimateSnapshot;
 
 /* Identifier for each of the 3 different TxConfirmStats which will track
  * history over different time horizons. */
@@ -193,7 +194,8 @@ public:
     /** Estimate feerate needed to get be included in a block within confTarget
      *  blocks. If no answer can be given at confTarget, return an estimate at
      *  the closest target where one can be given.  'conservative' estimates are
-     *  valid over longer time horizons also.
+     *  valid over longer time horizons also. The estimates are as of the first
+     *  call after the last block processed.
      */
     CFeeRate estimateSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative) const;
 
@@ -244,13 +246,21 @@ private:
     std::vector<double> buckets GUARDED_BY(m_cs_fee_estimator); // The upper-bound of the range for the bucket (inclusive)
     std::map<double, unsigned int> bucketMap GUARDED_BY(m_cs_fee_estimator); // Map of bucket upper-bound to index into all vectors by bucket
 
+    /** estimateSmartFee results since the last block, replaced as a whole with
+     * std::atomic_store; null until the first estimateSmartFee after a block */
+    mutable std::shared_ptr<const FeeEstimateSnapshot> m_estimates;
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry) EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
 
+    /** Recompute m_estimates, and return it */
+    std::shared_ptr<const FeeEstimateSnapshot> updateEstimates() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    /** estimateSmartFee from the current stats */
+    CFeeRate computeSmartFee(int confTarget, FeeCalculation *feeCalc, bool conservative, bool log) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
-    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result, bool log) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Helper for estimateSmartFee */
-    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
+    double estimateConservativeFee(unsigned int doubleTarget, EstimationResult *result, bool log) const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Number of blocks of data recorded while fee estimates have been running */
     unsigned int BlockSpan() const EXCLUSIVE_LOCKS_REQUIRED(m_cs_fee_estimator);
     /** Number of blocks of recorded fee estimate data represented in saved data file */
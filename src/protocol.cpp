@@ -50,6 +50,10 @@ const char *MWEBHEADER="mwebheader";
 const char *MWEBLEAFSET="mwebleafset";
 const char *GETMWEBUTXOS="getmwebutxos";
 const char *MWEBUTXOS="mwebutxos";
+const char *SENDTXRCNCL="sendtxrcncl";
+const char *REQRECON="reqrecon";
+const char *SKETCH="sketch";
+const char *RECONCILDIFF="reconcildiff";
 } // namespace NetMsgType
 
 /** All known message types. Keep this in the same order as the list of
@@ -94,6 +98,10 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::MWEBLEAFSET,
     NetMsgType::GETMWEBUTXOS,
     NetMsgType::MWEBUTXOS,
+    NetMsgType::SENDTXRCNCL,
+    NetMsgType::REQRECON,
+    NetMsgType::SKETCH,
+    NetMsgType::RECONCILDIFF,
 };
 const static std::vector<std::string> allNetMessageTypesVec(allNetMessageTypes, allNetMessageTypes+ARRAYLEN(allNetMessageTypes));
 
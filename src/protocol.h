@@ -286,6 +286,26 @@ extern const char* GETMWEBUTXOS;
  * @since protocol version 70017 as described by LIP-0006
  */
 extern const char* MWEBUTXOS;
+/**
+ * Indicates that a node supports transaction reconciliation, with the
+ * protocol version and a salt for short transaction IDs. Sent before verack.
+ */
+extern const char* SENDTXRCNCL;
+/**
+ * Requests a sketch of the peer's reconciliation set, and contains the size
+ * of the sender's set.
+ */
+extern const char* REQRECON;
+/**
+ * Contains a sketch of the sender's reconciliation set, in response to a
+ * reqrecon message.
+ */
+extern const char* SKETCH;
+/**
+ * Finishes a reconciliation: whether the sketch could be decoded, and the
+ * short IDs of the transactions the sender is missing.
+ */
+extern const char* RECONCILDIFF;
 }; // namespace NetMsgType
 
 /* Get a vector of all valid message types (see above) */
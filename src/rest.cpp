@@ -6,9 +6,12 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <hash.h>
 #include <httpserver.h>
+#include <index/mwebindex.h>
 #include <index/txindex.h>
 #include <node/context.h>
+#include <node/rawblock.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -18,6 +21,7 @@
 #include <sync.h>
 #include <txmempool.h>
 #include <util/check.h>
+#include <util/memory.h>
 #include <util/ref.h>
 #include <util/strencodings.h>
 #include <validation.h>
@@ -27,7 +31,15 @@
 
 #include <univalue.h>
 
+#include <algorithm>
+#include <map>
+#include <memory>
+
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+//! Maximum number of blocks returned by /rest/blocks/raw/
+static const long MAX_REST_RAW_BLOCKS = 1000;
+//! Size as stored of the blocks after which /rest/blocks/raw/ stops adding blocks to a reply
+static const uint64_t MAX_REST_RAW_BLOCKS_SIZE = 32 * 1024 * 1024;
 
 enum class RetFormat {
     UNDEF,
@@ -46,6 +58,15 @@ static const struct {
       {RetFormat::JSON, "json"},
 };
 
+/** Serializations offered by the raw block endpoints besides the full one, which is served as stored */
+static const struct {
+    const char* name;
+    int serialize_flags;
+} raw_block_variants[] = {
+      {"nomweb", SERIALIZE_NO_MWEB},
+      {"nowitness", SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB},
+};
+
 struct CCoin {
     uint32_t nHeight;
     CTxOut out;
@@ -302,6 +323,178 @@ static bool rest_block_notxdetails(const util::Ref& context, HTTPRequest* req, c
     return rest_block(req, strURIPart, false);
 }
 
+/** Whether the If-None-Match header of the request matches etag */
+static bool MatchesETag(HTTPRequest* req, const std::string& etag)
+{
+    const std::pair<bool, std::string> header = req->GetHeader("If-None-Match");
+    if (!header.first)
+        return false;
+    std::vector<std::string> tags;
+    boost::split(tags, header.second, boost::is_any_of(","));
+    for (std::string& tag : tags) {
+        boost::trim(tag);
+        if (tag == "*" || tag == etag || tag == "W/" + etag)
+            return true;
+    }
+    return false;
+}
+
+static bool rest_block_raw(HTTPRequest* req, const std::string& strURIPart, bool range)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+    const size_t num_params = range ? 2 : 1;
+    std::string variant;
+    int serialize_flags = 0;
+    if (path.size() == num_params + 1) {
+        variant = path[0];
+        path.erase(path.begin());
+        const auto it = std::find_if(std::begin(raw_block_variants), std::end(raw_block_variants), [&](const auto& v) { return variant == v.name; });
+        if (it == std::end(raw_block_variants))
+            return RESTERR(req, HTTP_BAD_REQUEST, "Unknown variant: " + SanitizeString(variant) + " (available: nomweb, nowitness)");
+        serialize_flags = it->serialize_flags;
+    } else if (path.size() != num_params) {
+        return RESTERR(req, HTTP_BAD_REQUEST, range ? "Invalid URI format. Use /rest/blocks/raw/[<variant>/]<count>/<hash>.<bin|hex>." :
+                                                      "Invalid URI format. Use /rest/block/raw/[<variant>/]<hash>.<bin|hex>.");
+    }
+
+    long count = 1;
+    if (range) {
+        count = strtol(path[0].c_str(), nullptr, 10);
+        if (count < 1 || count > MAX_REST_RAW_BLOCKS)
+            return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + SanitizeString(path[0]));
+    }
+
+    const std::string& hashStr = path.back();
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    // Only look up where the blocks are stored while holding cs_main
+    std::vector<std::pair<uint256, FlatFilePos>> positions;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(hash);
+        if (!pindex || (range && !::ChainActive().Contains(pindex)))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        if (IsBlockPruned(pindex))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
+        for (; pindex && (pindex->nStatus & BLOCK_HAVE_DATA) && positions.size() < (size_t)count; pindex = ::ChainActive().Next(pindex)) {
+            positions.emplace_back(pindex->GetBlockHash(), pindex->GetBlockPos());
+        }
+    }
+
+    // Check the blocks and find their sizes. A range ends early at the size
+    // limit, or at a block that can't be read, e.g. because it was pruned meanwhile.
+    struct Part {
+        HTTPReplyFile* file;
+        uint32_t offset;
+        uint32_t size;
+    };
+    std::map<int, std::unique_ptr<HTTPReplyFile>> files;
+    std::vector<Part> parts;
+    uint64_t total_size = 0;
+    CHashWriter tag_hasher(SER_GETHASH, 0);
+    for (const auto& position : positions) {
+        const FlatFilePos& pos = position.second;
+        std::unique_ptr<HTTPReplyFile>& file = files[pos.nFile];
+        if (!file) {
+            FILE* blk_file = OpenBlockFile(FlatFilePos(pos.nFile, 0), true);
+            if (!blk_file)
+                break;
+            file = MakeUnique<HTTPReplyFile>(blk_file);
+        }
+        uint32_t size;
+        if (!ReadRawBlockSize(file->Get(), pos, position.first, Params().MessageStart(), size))
+            break;
+        if (!parts.empty() && total_size + size > MAX_REST_RAW_BLOCKS_SIZE)
+            break;
+        total_size += size;
+        parts.push_back({file.get(), pos.nPos, size});
+        tag_hasher << position.first;
+    }
+    if (parts.empty())
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    // The contents of a block never change, so the tag only depends on which
+    // blocks are served and how. Which blocks follow a block in the active
+    // chain can change, so ranges have to be revalidated.
+    const std::string etag = strprintf("\"%s%s.%s\"", variant.empty() ? "" : variant + "-",
+                                       range ? tag_hasher.GetHash().GetHex() : hash.GetHex(), rf == RetFormat::BINARY ? "bin" : "hex");
+    const char* cache_control = range ? "no-cache" : "max-age=31536000, immutable";
+    if (MatchesETag(req, etag)) {
+        req->WriteHeader("ETag", etag);
+        req->WriteHeader("Cache-Control", cache_control);
+        req->WriteReply(HTTP_NOT_MODIFIED);
+        return true;
+    }
+
+    if (rf == RetFormat::BINARY && serialize_flags == 0) {
+        // Send the blocks straight from the blk files
+        for (const Part& part : parts) {
+            if (!req->AppendReplyFile(*part.file, part.offset, part.size))
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Failed to read block data");
+        }
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteHeader("ETag", etag);
+        req->WriteHeader("Cache-Control", cache_control);
+        req->WriteReply(HTTP_OK);
+        return true;
+    }
+
+    std::vector<uint8_t> data, block, stripped;
+    data.reserve(total_size);
+    for (const Part& part : parts) {
+        block.resize(part.size);
+        FILE* file = part.file->Get();
+        if (fseek(file, part.offset, SEEK_SET) != 0 || fread(block.data(), 1, block.size(), file) != block.size())
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Failed to read block data");
+        if (serialize_flags == 0) {
+            data.insert(data.end(), block.begin(), block.end());
+            continue;
+        }
+        RawBlockLayout layout;
+        if (!ParseRawBlockLayout(block, layout))
+            return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, "Failed to parse block data");
+        StripRawBlock(block, layout, serialize_flags, stripped);
+        data.insert(data.end(), stripped.begin(), stripped.end());
+    }
+
+    switch (rf) {
+    case RetFormat::BINARY: {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteHeader("ETag", etag);
+        req->WriteHeader("Cache-Control", cache_control);
+        req->WriteReply(HTTP_OK, std::string(data.begin(), data.end()));
+        return true;
+    }
+    default: {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteHeader("ETag", etag);
+        req->WriteHeader("Cache-Control", cache_control);
+        req->WriteReply(HTTP_OK, HexStr(data) + "\n");
+        return true;
+    }
+    }
+}
+
+static bool rest_block_raw_single(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block_raw(req, strURIPart, false);
+}
+
+static bool rest_block_raw_range(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block_raw(req, strURIPart, true);
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 RPCHelpMan getblockchaininfo();
 
@@ -666,12 +859,69 @@ static bool rest_blockhash_by_height(const util::Ref& context, HTTPRequest* req,
     }
 }
 
+static bool ParseMWEBHashStr(const std::string& str, mw::Hash& hash)
+{
+    if (str.size() != mw::Hash::size() * 2 || !IsHex(str)) return false;
+    hash = mw::Hash::FromHex(str);
+    return true;
+}
+
+static bool rest_mweb_lookup(HTTPRequest* req, const std::string& strURIPart, bool is_kernel)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    mw::Hash id;
+    if (!ParseMWEBHashStr(hashStr, id))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    if (!g_mwebindex)
+        return RESTERR(req, HTTP_NOT_FOUND, "MWEB index is not enabled");
+    g_mwebindex->BlockUntilSyncedToCurrentChain();
+
+    MWEBIndexPos pos;
+    if (!(is_kernel ? g_mwebindex->FindKernel(id, pos) : g_mwebindex->FindOutput(id, pos))) {
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+    }
+
+    switch (rf) {
+    case RetFormat::JSON: {
+        UniValue objPos = MWEBIndexPosToJSON(pos);
+        MWEBIndexPos spent_pos;
+        if (!is_kernel && g_mwebindex->FindSpentOutput(id, spent_pos)) {
+            objPos.pushKV("spent", MWEBIndexPosToJSON(spent_pos));
+        }
+        std::string strJSON = objPos.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: json)");
+    }
+    }
+}
+
+static bool rest_mweb_kernel(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_mweb_lookup(req, strURIPart, true);
+}
+
+static bool rest_mweb_output(const util::Ref& context, HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_mweb_lookup(req, strURIPart, false);
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(const util::Ref& context, HTTPRequest* req, const std::string& strReq);
 } uri_prefixes[] = {
       {"/rest/tx/", rest_tx},
       {"/rest/block/notxdetails/", rest_block_notxdetails},
+      {"/rest/block/raw/", rest_block_raw_single},
+      {"/rest/blocks/raw/", rest_block_raw_range},
       {"/rest/block/", rest_block_extended},
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
@@ -679,6 +929,8 @@ static const struct {
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
       {"/rest/blockhashbyheight/", rest_blockhash_by_height},
+      {"/rest/mwebkernel/", rest_mweb_kernel},
+      {"/rest/mweboutput/", rest_mweb_output},
 };
 
 void StartREST(const util::Ref& context)
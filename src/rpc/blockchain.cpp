@@ -14,6 +14,7 @@
 #include <core_io.h>
 #include <hash.h>
 #include <index/blockfilterindex.h>
+#include <index/mwebindex.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
@@ -21,6 +22,7 @@
 #include <policy/policy.h>
 #include <policy/rbf.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <script/descriptor.h>
@@ -172,6 +174,53 @@ UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex
     return result;
 }
 
+static UniValue MWEBInputToJSON(const Input& input)
+{
+    UniValue objInput(UniValue::VOBJ);
+    objInput.pushKV("output_id", input.GetOutputID().ToHex());
+    objInput.pushKV("commit", input.GetCommitment().ToHex());
+    objInput.pushKV("output_pubkey", input.GetOutputPubKey().ToHex());
+
+    if (!!input.GetInputPubKey()) {
+        objInput.pushKV("input_pubkey", input.GetInputPubKey()->ToHex());
+    }
+
+    if (!input.GetExtraData().empty()) {
+        objInput.pushKV("extra_data", HexStr(input.GetExtraData()));
+    }
+
+    objInput.pushKV("sig", input.GetSignature().ToHex());
+    return objInput;
+}
+
+static UniValue MWEBOutputToJSON(const Output& output)
+{
+    UniValue objOutput(UniValue::VOBJ);
+    objOutput.pushKV("output_id", output.GetOutputID().ToHex());
+    objOutput.pushKV("commit", output.GetCommitment().ToHex());
+    objOutput.pushKV("sender_pubkey", output.GetSenderPubKey().ToHex());
+    objOutput.pushKV("receiver_pubkey", output.GetReceiverPubKey().ToHex());
+    objOutput.pushKV("range_proof", HexStr(output.GetRangeProof()->Serialized()));
+    objOutput.pushKV("message", HexStr(output.GetOutputMessage().Serialized()));
+    return objOutput;
+}
+
+static UniValue MWEBKernelToJSON(const Kernel& kernel)
+{
+    UniValue objKernel(UniValue::VOBJ);
+    objKernel.pushKV("kernel_id", kernel.GetKernelID().ToHex());
+    objKernel.pushKV("features", kernel.GetFeatures());
+    objKernel.pushKV("commit", kernel.GetCommitment().ToHex());
+    objKernel.pushKV("fee", kernel.GetFee());
+    objKernel.pushKV("lock_height", kernel.GetLockHeight());
+    objKernel.pushKV("excess", kernel.GetExcess().ToHex());
+    objKernel.pushKV("signature", kernel.GetSignature().ToHex());
+    if (!kernel.GetExtraData().empty()) {
+        objKernel.pushKV("extra_data", HexStr(kernel.GetExtraData()));
+    }
+    return objKernel;
+}
+
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails)
 {
     // Serialize passed information without accessing chain state of the active chain!
@@ -228,21 +277,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
         UniValue inputs(UniValue::VARR);
         for (const auto& input : block.mweb_block.m_block->GetInputs()) {
             if (txDetails) {
-                UniValue objInput(UniValue::VOBJ);
-                objInput.pushKV("output_id", input.GetOutputID().ToHex());
-                objInput.pushKV("commit", input.GetCommitment().ToHex());
-                objInput.pushKV("output_pubkey", input.GetOutputPubKey().ToHex());
-
-                if (!!input.GetInputPubKey()) {
-                    objInput.pushKV("input_pubkey", input.GetInputPubKey()->ToHex());
-                }
-
-                if (!input.GetExtraData().empty()) {
-                    objInput.pushKV("extra_data", HexStr(input.GetExtraData()));
-                }
-
-                objInput.pushKV("sig", input.GetSignature().ToHex());
-                inputs.push_back(objInput);
+                inputs.push_back(MWEBInputToJSON(input));
             } else {
                 inputs.push_back(input.GetOutputID().ToHex());
             }
@@ -253,14 +288,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
         UniValue outputs(UniValue::VARR);
         for (const auto& output : block.mweb_block.m_block->GetOutputs()) {
             if (txDetails) {
-                UniValue objOutput(UniValue::VOBJ);
-                objOutput.pushKV("output_id", output.GetOutputID().ToHex());
-                objOutput.pushKV("commit", output.GetCommitment().ToHex());
-                objOutput.pushKV("sender_pubkey", output.GetSenderPubKey().ToHex());
-                objOutput.pushKV("receiver_pubkey", output.GetReceiverPubKey().ToHex());
-                objOutput.pushKV("range_proof", HexStr(output.GetRangeProof()->Serialized()));
-                objOutput.pushKV("message", HexStr(output.GetOutputMessage().Serialized()));
-                outputs.push_back(objOutput);
+                outputs.push_back(MWEBOutputToJSON(output));
             } else {
                 outputs.push_back(output.GetOutputID().ToHex());
             }
@@ -271,18 +299,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
         UniValue kernels(UniValue::VARR);
         for (const auto& kernel : block.mweb_block.m_block->GetKernels()) {
             if (txDetails) {
-                UniValue objKernel(UniValue::VOBJ);
-                objKernel.pushKV("kernel_id", kernel.GetKernelID().ToHex());
-                objKernel.pushKV("features", kernel.GetFeatures());
-                objKernel.pushKV("commit", kernel.GetCommitment().ToHex());
-                objKernel.pushKV("fee", kernel.GetFee());
-                objKernel.pushKV("lock_height", kernel.GetLockHeight());
-                objKernel.pushKV("excess", kernel.GetExcess().ToHex());
-                objKernel.pushKV("signature", kernel.GetSignature().ToHex());
-                if (!kernel.GetExtraData().empty()) {
-                    objKernel.pushKV("extra_data", HexStr(kernel.GetExtraData()));
-                }
-                kernels.push_back(objKernel);
+                kernels.push_back(MWEBKernelToJSON(kernel));
             } else {
                 kernels.push_back(kernel.GetCommitment().ToHex());
             }
@@ -299,6 +316,66 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIn
     return result;
 }
 
+void blockToJSON(JSONWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex)
+{
+    // Take the small fields from the summary, in the same order, and write
+    // the transactions and MWEB body elements one at a time.
+    const UniValue summary = blockToJSON(block, tip, blockindex, /* txDetails */ false);
+    const std::vector<std::string>& keys = summary.getKeys();
+    writer.BeginObject();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == "tx") {
+            writer.Key(keys[i]);
+            writer.BeginArray();
+            for (const auto& tx : block.vtx) {
+                UniValue objTx(UniValue::VOBJ);
+                TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
+                writer.Value(objTx);
+                writer.Drain();
+            }
+            writer.EndArray();
+        } else if (keys[i] == "mweb") {
+            const UniValue& mweb_block = summary[i];
+            const std::vector<std::string>& mweb_keys = mweb_block.getKeys();
+            writer.Key(keys[i]);
+            writer.BeginObject();
+            for (size_t j = 0; j < mweb_keys.size(); ++j) {
+                if (mweb_keys[j] == "inputs") {
+                    writer.Key(mweb_keys[j]);
+                    writer.BeginArray();
+                    for (const auto& input : block.mweb_block.m_block->GetInputs()) {
+                        writer.Value(MWEBInputToJSON(input));
+                        writer.Drain();
+                    }
+                    writer.EndArray();
+                } else if (mweb_keys[j] == "outputs") {
+                    writer.Key(mweb_keys[j]);
+                    writer.BeginArray();
+                    for (const auto& output : block.mweb_block.m_block->GetOutputs()) {
+                        writer.Value(MWEBOutputToJSON(output));
+                        writer.Drain();
+                    }
+                    writer.EndArray();
+                } else if (mweb_keys[j] == "kernels") {
+                    writer.Key(mweb_keys[j]);
+                    writer.BeginArray();
+                    for (const auto& kernel : block.mweb_block.m_block->GetKernels()) {
+                        writer.Value(MWEBKernelToJSON(kernel));
+                        writer.Drain();
+                    }
+                    writer.EndArray();
+                } else {
+                    writer.KeyValue(mweb_keys[j], mweb_block[j]);
+                }
+            }
+            writer.EndObject();
+        } else {
+            writer.KeyValue(keys[i], summary[i]);
+        }
+    }
+    writer.EndObject();
+}
+
 static RPCHelpMan getblockcount()
 {
     return RPCHelpMan{"getblockcount",
@@ -676,6 +753,38 @@ static void entryToJSON(const CTxMemPool& pool, UniValue& info, const CTxMemPool
     info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetHash()));
 }
 
+void MempoolToJSON(JSONWriter& writer, const CTxMemPool& pool)
+{
+    std::vector<uint256> txids;
+    {
+        LOCK(pool.cs);
+        txids.reserve(pool.mapTx.size());
+        for (const CTxMemPoolEntry& e : pool.mapTx) {
+            txids.push_back(e.GetTx().GetHash());
+        }
+    }
+
+    // Write the entries in batches and let the client catch up in between,
+    // without holding the mempool lock. Transactions that left the mempool
+    // in the meantime are skipped.
+    writer.BeginObject();
+    for (size_t begin = 0; begin < txids.size(); begin += MEMPOOL_JSON_BATCH_SIZE) {
+        const size_t end = std::min(begin + MEMPOOL_JSON_BATCH_SIZE, txids.size());
+        {
+            LOCK(pool.cs);
+            for (size_t i = begin; i < end; ++i) {
+                const auto it = pool.mapTx.find(txids[i]);
+                if (it == pool.mapTx.end()) continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(pool, info, *it);
+                writer.KeyValue(txids[i].ToString(), info);
+            }
+        }
+        writer.Drain();
+    }
+    writer.EndObject();
+}
+
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose, bool include_mempool_sequence)
 {
     if (verbose) {
@@ -762,7 +871,14 @@ static RPCHelpMan getrawmempool()
         include_mempool_sequence = request.params[1].get_bool();
     }
 
-    return MempoolToJSON(EnsureMemPool(request.context), fVerbose, include_mempool_sequence);
+    const CTxMemPool& mempool = EnsureMemPool(request.context);
+    if (fVerbose && !include_mempool_sequence) {
+        if (JSONWriter* writer = request.BeginStreamedResult()) {
+            MempoolToJSON(*writer, mempool);
+            return NullUniValue;
+        }
+    }
+    return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
 },
     };
 }
@@ -1145,6 +1261,12 @@ static RPCHelpMan getblock()
         return strHex;
     }
 
+    if (verbosity >= 2) {
+        if (JSONWriter* writer = request.BeginStreamedResult()) {
+            blockToJSON(*writer, block, tip, pblockindex);
+            return NullUniValue;
+        }
+    }
     return blockToJSON(block, tip, pblockindex, verbosity >= 2);
 },
     };
@@ -2536,6 +2658,126 @@ static RPCHelpMan getblockfilter()
     };
 }
 
+UniValue MWEBIndexPosToJSON(const MWEBIndexPos& pos)
+{
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("blockhash", pos.block_hash.GetHex());
+    result.pushKV("position", (uint64_t)pos.position);
+
+    LOCK(cs_main);
+    const CBlockIndex* pindex = LookupBlockIndex(pos.block_hash);
+    if (pindex) {
+        result.pushKV("height", pindex->nHeight);
+    }
+    result.pushKV("in_active_chain", pindex != nullptr && ::ChainActive().Contains(pindex));
+    return result;
+}
+
+static mw::Hash ParseMWEBHashV(const UniValue& v, const std::string& name)
+{
+    std::vector<unsigned char> bytes = ParseHexV(v, name);
+    if (bytes.size() != mw::Hash::size()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s must be of length %d (not %d)", name, mw::Hash::size() * 2, bytes.size() * 2));
+    }
+    return mw::Hash(std::move(bytes));
+}
+
+static MWEBIndex& EnsureMWEBIndex()
+{
+    if (!g_mwebindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "MWEB index is not enabled. Use -mwebindex to enable it.");
+    }
+    return *g_mwebindex;
+}
+
+static RPCHelpMan getmwebkernel()
+{
+    return RPCHelpMan{"getmwebkernel",
+                "\nLocate the block containing an MWEB kernel. Requires -mwebindex.\n",
+                {
+                    {"kernel_id", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The kernel ID"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "blockhash", "the hash of the block containing the kernel"},
+                        {RPCResult::Type::NUM, "position", "the index of the kernel within the block's MWEB kernels"},
+                        {RPCResult::Type::NUM, "height", /* optional */ true, "the height of the block, if it is known"},
+                        {RPCResult::Type::BOOL, "in_active_chain", "whether the block is part of the active chain"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getmwebkernel", "\"a60ef4ab5e25bd5c8c63a98d5e0bb2d1257b2e46bc2213c4860f6a8f58a7a4c5\"") +
+                    HelpExampleRpc("getmwebkernel", "\"a60ef4ab5e25bd5c8c63a98d5e0bb2d1257b2e46bc2213c4860f6a8f58a7a4c5\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const mw::Hash kernel_id = ParseMWEBHashV(request.params[0], "kernel_id");
+    MWEBIndex& index = EnsureMWEBIndex();
+    const bool index_ready = index.BlockUntilSyncedToCurrentChain();
+
+    MWEBIndexPos pos;
+    if (!index.FindKernel(kernel_id, pos)) {
+        if (!index_ready) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Kernel not found. MWEB index is still syncing.");
+        }
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Kernel not found");
+    }
+
+    return MWEBIndexPosToJSON(pos);
+},
+    };
+}
+
+static RPCHelpMan getmweboutput()
+{
+    return RPCHelpMan{"getmweboutput",
+                "\nLocate the blocks in which an MWEB output was created and, if applicable, spent. Requires -mwebindex.\n",
+                {
+                    {"output_id", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "The output ID"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::STR_HEX, "blockhash", "the hash of the block containing the output"},
+                        {RPCResult::Type::NUM, "position", "the index of the output within the block's MWEB outputs"},
+                        {RPCResult::Type::NUM, "height", /* optional */ true, "the height of the block, if it is known"},
+                        {RPCResult::Type::BOOL, "in_active_chain", "whether the block is part of the active chain"},
+                        {RPCResult::Type::OBJ, "spent", /* optional */ true, "the input spending the output, if any",
+                        {
+                            {RPCResult::Type::STR_HEX, "blockhash", "the hash of the block containing the spending input"},
+                            {RPCResult::Type::NUM, "position", "the index of the input within the block's MWEB inputs"},
+                            {RPCResult::Type::NUM, "height", /* optional */ true, "the height of the block, if it is known"},
+                            {RPCResult::Type::BOOL, "in_active_chain", "whether the block is part of the active chain"},
+                        }},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getmweboutput", "\"2d6d3ae8e1ab1a5b7b5f7c4f0c4a6f7c2ed0d6b2e8b15d1d2e4dcb1f6a9e0c31\"") +
+                    HelpExampleRpc("getmweboutput", "\"2d6d3ae8e1ab1a5b7b5f7c4f0c4a6f7c2ed0d6b2e8b15d1d2e4dcb1f6a9e0c31\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const mw::Hash output_id = ParseMWEBHashV(request.params[0], "output_id");
+    MWEBIndex& index = EnsureMWEBIndex();
+    const bool index_ready = index.BlockUntilSyncedToCurrentChain();
+
+    MWEBIndexPos pos;
+    if (!index.FindOutput(output_id, pos)) {
+        if (!index_ready) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Output not found. MWEB index is still syncing.");
+        }
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Output not found");
+    }
+
+    UniValue result = MWEBIndexPosToJSON(pos);
+    MWEBIndexPos spent_pos;
+    if (index.FindSpentOutput(output_id, spent_pos)) {
+        result.pushKV("spent", MWEBIndexPosToJSON(spent_pos));
+    }
+    return result;
+},
+    };
+}
+
 /**
  * Serialize the UTXO set to a file for loading elsewhere.
  *
@@ -2674,6 +2916,8 @@ static const CRPCCommand commands[] =
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
     { "blockchain",         "scantxoutset",           &scantxoutset,           {"action", "scanobjects"} },
     { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
+    { "blockchain",         "getmwebkernel",          &getmwebkernel,          {"kernel_id"} },
+    { "blockchain",         "getmweboutput",          &getmweboutput,          {"output_id"} },
 
     /* Not shown in help */
     { "hidden",             "invalidateblock",        &invalidateblock,        {"blockhash"} },
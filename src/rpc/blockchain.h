@@ -18,7 +18,9 @@ class CBlockIndex;
 class CConnman;
 class CTxMemPool;
 class ChainstateManager;
+class JSONWriter;
 class UniValue;
+struct MWEBIndexPos;
 struct NodeContext;
 namespace util {
 class Ref;
@@ -26,6 +28,9 @@ class Ref;
 
 static constexpr int NUM_GETBLOCKSTATS_PERCENTILES = 5;
 
+/** Number of mempool entries written per lock acquisition when streaming the mempool */
+static constexpr size_t MEMPOOL_JSON_BATCH_SIZE = 1000;
+
 /**
  * Get the difficulty of the net wrt to the given block index.
  *
@@ -40,15 +45,27 @@ void RPCNotifyBlockChange(const CBlockIndex*);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex, bool txDetails = false) LOCKS_EXCLUDED(cs_main);
 
+/** Verbose block description with transaction details, written to a JSONWriter.
+ * The output is identical to blockToJSON(block, tip, blockindex, true). */
+void blockToJSON(JSONWriter& writer, const CBlock& block, const CBlockIndex* tip, const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main);
+
 /** Mempool information to JSON */
 UniValue MempoolInfoToJSON(const CTxMemPool& pool);
 
 /** Mempool to JSON */
 UniValue MempoolToJSON(const CTxMemPool& pool, bool verbose = false, bool include_mempool_sequence = false);
 
+/** Verbose mempool, written to a JSONWriter. Equal to MempoolToJSON(pool, true)
+ * if the mempool does not change meanwhile, as the mempool lock is released
+ * between batches of entries. Must be called without locks held. */
+void MempoolToJSON(JSONWriter& writer, const CTxMemPool& pool);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* tip, const CBlockIndex* blockindex) LOCKS_EXCLUDED(cs_main);
 
+/** MWEB index entry to JSON */
+UniValue MWEBIndexPosToJSON(const MWEBIndexPos& pos) LOCKS_EXCLUDED(cs_main);
+
 /** Used by getblockstats to get feerates at different percentiles by weight  */
 void CalculatePercentilesByWeight(CAmount result[NUM_GETBLOCKSTATS_PERCENTILES], std::vector<std::pair<CAmount, int64_t>>& scores, int64_t total_weight);
 
@@ -66,6 +66,10 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listtransactions", 3, "include_watchonly" },
     { "walletpassphrase", 1, "timeout" },
     { "getblocktemplate", 0, "template_request" },
+    { "submittemplatesolution", 0, "template_id" },
+    { "submittemplatesolution", 1, "version" },
+    { "submittemplatesolution", 2, "time" },
+    { "submittemplatesolution", 3, "nonce" },
     { "listsinceblock", 1, "target_confirmations" },
     { "listsinceblock", 2, "include_watchonly" },
     { "listsinceblock", 3, "include_removed" },
@@ -186,6 +190,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "loadwallet", 1, "load_on_startup"},
     { "unloadwallet", 1, "load_on_startup"},
     { "getnodeaddresses", 0, "count"},
+    { "getnetmsgstats", 0, "peer_id"},
     { "addpeeraddress", 1, "port"},
     { "stop", 0, "wait" },
 };
@@ -0,0 +1,204 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/executor.h>
+
+#include <tinyformat.h>
+#include <util/memory.h>
+#include <util/threadnames.h>
+
+#include <algorithm>
+#include <atomic>
+
+constexpr std::chrono::seconds RPCBatchExecutor::DEFAULT_IDLE_TIMEOUT;
+
+struct RPCBatchExecutor::Batch
+{
+    //! A contiguous run of task indexes, taken from the front by its owner and from the back by thieves
+    struct Range
+    {
+        Mutex mutex;
+        size_t begin GUARDED_BY(mutex){0};
+        size_t end GUARDED_BY(mutex){0};
+    };
+
+    std::vector<Task>& tasks;
+    const size_t num_ranges;
+    std::unique_ptr<Range[]> ranges;
+    //! Next range to hand out to a worker; range 0 belongs to the submitting thread
+    std::atomic<size_t> next_range{1};
+    std::atomic<size_t> remaining;
+
+    Mutex done_mutex;
+    std::condition_variable done_cond;
+
+    Batch(std::vector<Task>& tasks_in, size_t num_ranges_in)
+        : tasks(tasks_in), num_ranges(num_ranges_in), ranges(new Range[num_ranges_in]), remaining(tasks_in.size())
+    {
+        for (size_t r = 0; r < num_ranges; ++r) {
+            LOCK(ranges[r].mutex);
+            ranges[r].begin = tasks.size() * r / num_ranges;
+            ranges[r].end = tasks.size() * (r + 1) / num_ranges;
+        }
+    }
+
+    bool PopFront(size_t r, size_t& index)
+    {
+        LOCK(ranges[r].mutex);
+        if (ranges[r].begin == ranges[r].end) return false;
+        index = ranges[r].begin++;
+        return true;
+    }
+
+    bool PopBack(size_t r, size_t& index)
+    {
+        LOCK(ranges[r].mutex);
+        if (ranges[r].begin == ranges[r].end) return false;
+        index = --ranges[r].end;
+        return true;
+    }
+
+    void Execute(size_t index)
+    {
+        tasks[index]();
+        if (--remaining == 0) {
+            LOCK(done_mutex);
+            done_cond.notify_all();
+        }
+    }
+
+    /** Drain range r, then steal from the other ranges until no work is left. */
+    void Work(size_t r)
+    {
+        size_t index;
+        if (r < num_ranges) {
+            while (PopFront(r, index)) Execute(index);
+        }
+        for (size_t k = 1; k <= num_ranges; ++k) {
+            const size_t victim = (r + k) % num_ranges;
+            while (PopBack(victim, index)) Execute(index);
+        }
+    }
+};
+
+RPCBatchExecutor::RPCBatchExecutor(int max_threads, std::chrono::milliseconds idle_timeout)
+    : m_max_workers(std::max(0, std::min(max_threads, MAX_RPC_BATCH_THREADS) - 1)), m_idle_timeout(idle_timeout)
+{
+}
+
+RPCBatchExecutor::~RPCBatchExecutor()
+{
+    Stop();
+}
+
+void RPCBatchExecutor::Run(std::vector<Task>& tasks)
+{
+    const size_t num_ranges = std::min<size_t>(tasks.size(), m_max_workers + 1);
+    bool parallel = num_ranges > 1;
+    std::shared_ptr<Batch> batch;
+    if (parallel) {
+        batch = std::make_shared<Batch>(tasks, num_ranges);
+        LOCK(m_mutex);
+        parallel = m_running;
+        if (parallel) {
+            JoinRetired();
+            m_batches.push_back(batch);
+            // Start workers for the ranges that the idle ones cannot cover
+            int wanted = int(num_ranges) - 1 - m_idle;
+            while (wanted-- > 0 && m_workers < m_max_workers) {
+                m_threads.emplace_back(&RPCBatchExecutor::Worker, this, m_next_worker_num++);
+                ++m_workers;
+            }
+            m_cond.notify_all();
+        }
+    }
+    if (!parallel) {
+        for (Task& task : tasks) task();
+        return;
+    }
+
+    batch->Work(0);
+    {
+        WAIT_LOCK(batch->done_mutex, lock);
+        batch->done_cond.wait(lock, [&] { return batch->remaining == 0; });
+    }
+    LOCK(m_mutex);
+    auto it = std::find(m_batches.begin(), m_batches.end(), batch);
+    if (it != m_batches.end()) m_batches.erase(it);
+}
+
+void RPCBatchExecutor::Worker(int worker_num)
+{
+    util::ThreadRename(strprintf("rpcbatch.%i", worker_num));
+    while (true) {
+        std::shared_ptr<Batch> batch;
+        size_t range;
+        {
+            WAIT_LOCK(m_mutex, lock);
+            ++m_idle;
+            while (m_running && m_batches.empty()) {
+                if (m_cond.wait_for(lock, m_idle_timeout) == std::cv_status::timeout && m_running && m_batches.empty()) {
+                    --m_idle;
+                    --m_workers;
+                    m_retired.push_back(std::this_thread::get_id());
+                    return;
+                }
+            }
+            --m_idle;
+            if (!m_running) {
+                --m_workers;
+                return;
+            }
+            batch = m_batches.front();
+            range = batch->next_range++;
+            // Once every range is claimed, later workers move on to the next batch
+            if (range + 1 >= batch->num_ranges) m_batches.pop_front();
+        }
+        batch->Work(range);
+    }
+}
+
+void RPCBatchExecutor::JoinRetired()
+{
+    for (const std::thread::id& id : m_retired) {
+        auto it = std::find_if(m_threads.begin(), m_threads.end(), [&](const std::thread& thread) { return thread.get_id() == id; });
+        if (it != m_threads.end()) {
+            it->join();
+            m_threads.erase(it);
+        }
+    }
+    m_retired.clear();
+}
+
+void RPCBatchExecutor::SetMethodLimit(const std::string& method, int limit)
+{
+    m_method_limits[method] = MakeUnique<CSemaphore>(std::max(limit, 1));
+}
+
+CSemaphore* RPCBatchExecutor::GetMethodLimit(const std::string& method) const
+{
+    auto it = m_method_limits.find(method);
+    return it == m_method_limits.end() ? nullptr : it->second.get();
+}
+
+int RPCBatchExecutor::WorkerCount() const
+{
+    LOCK(m_mutex);
+    return m_workers;
+}
+
+void RPCBatchExecutor::Stop()
+{
+    std::list<std::thread> threads;
+    {
+        LOCK(m_mutex);
+        m_running = false;
+        m_retired.clear();
+        threads.swap(m_threads);
+    }
+    m_cond.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_EXECUTOR_H
+#define BITCOIN_RPC_EXECUTOR_H
+
+#include <sync.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Default for -rpcbatchthreads, 0 = number of cores */
+static const int DEFAULT_RPC_BATCH_THREADS = 0;
+/** Maximum number of threads executing the items of one batch request */
+static const int MAX_RPC_BATCH_THREADS = 64;
+
+/**
+ * Executes the items of JSON-RPC batch requests in parallel.
+ *
+ * Each batch is split into one contiguous range of items per participating
+ * thread. A thread takes items from the front of its own range and, once that
+ * is exhausted, steals items from the back of the other ranges, so that a few
+ * slow calls do not hold up the rest of the batch. The thread submitting the
+ * batch always participates, which guarantees progress even when every worker
+ * is busy with other batches.
+ *
+ * Workers are started on demand, up to the configured maximum, and exit again
+ * after being idle for a while, so the pool follows the batch load.
+ */
+class RPCBatchExecutor
+{
+public:
+    /** A batch item. Tasks must not throw. */
+    using Task = std::function<void()>;
+
+    static constexpr std::chrono::seconds DEFAULT_IDLE_TIMEOUT{30};
+
+    /**
+     * @param[in] max_threads   Maximum number of threads executing one batch,
+     *                          including the submitting thread.
+     * @param[in] idle_timeout  How long a worker waits for work before exiting.
+     */
+    explicit RPCBatchExecutor(int max_threads, std::chrono::milliseconds idle_timeout = DEFAULT_IDLE_TIMEOUT);
+    ~RPCBatchExecutor();
+
+    RPCBatchExecutor(const RPCBatchExecutor&) = delete;
+    RPCBatchExecutor& operator=(const RPCBatchExecutor&) = delete;
+
+    /** Run all tasks and return once every one of them has finished. */
+    void Run(std::vector<Task>& tasks);
+
+    /** Allow at most limit items calling method to run at the same time. Must be called before Run. */
+    void SetMethodLimit(const std::string& method, int limit);
+
+    /** Return the semaphore limiting the concurrency of method, or nullptr if it is not limited. */
+    CSemaphore* GetMethodLimit(const std::string& method) const;
+
+    /** Number of worker threads currently running. */
+    int WorkerCount() const;
+
+    /** Stop and join all workers. Batches submitted afterwards run on the calling thread. */
+    void Stop();
+
+private:
+    struct Batch;
+
+    void Worker(int worker_num);
+    void JoinRetired() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+    const int m_max_workers;
+    const std::chrono::milliseconds m_idle_timeout;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cond;
+    //! Batches that still have a range that no thread has claimed yet
+    std::deque<std::shared_ptr<Batch>> m_batches GUARDED_BY(m_mutex);
+    std::list<std::thread> m_threads GUARDED_BY(m_mutex);
+    //! Workers that timed out and are about to exit, joined lazily
+    std::vector<std::thread::id> m_retired GUARDED_BY(m_mutex);
+    int m_workers GUARDED_BY(m_mutex){0};
+    int m_idle GUARDED_BY(m_mutex){0};
+    int m_next_worker_num GUARDED_BY(m_mutex){0};
+    bool m_running GUARDED_BY(m_mutex){true};
+
+    std::map<std::string, std::unique_ptr<CSemaphore>> m_method_limits;
+};
+
+#endif // BITCOIN_RPC_EXECUTOR_H
@@ -0,0 +1,103 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonwriter.h>
+
+#include <univalue.h>
+
+#include <cassert>
+
+JSONWriter::JSONWriter(JSONStreamSink& sink, size_t chunk_size)
+    : m_sink(sink), m_chunk_size(chunk_size)
+{
+    m_buffer.reserve(m_chunk_size);
+}
+
+JSONWriter::~JSONWriter()
+{
+    Flush();
+}
+
+void JSONWriter::BeginValue()
+{
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    if (!m_has_members.empty()) {
+        if (m_has_members.back()) m_buffer += ',';
+        m_has_members.back() = true;
+    }
+}
+
+void JSONWriter::BeginObject()
+{
+    BeginValue();
+    m_buffer += '{';
+    m_has_members.push_back(false);
+}
+
+void JSONWriter::EndObject()
+{
+    assert(!m_has_members.empty() && !m_after_key);
+    m_has_members.pop_back();
+    m_buffer += '}';
+    MaybeFlush();
+}
+
+void JSONWriter::BeginArray()
+{
+    BeginValue();
+    m_buffer += '[';
+    m_has_members.push_back(false);
+}
+
+void JSONWriter::EndArray()
+{
+    assert(!m_has_members.empty() && !m_after_key);
+    m_has_members.pop_back();
+    m_buffer += ']';
+    MaybeFlush();
+}
+
+void JSONWriter::Key(const std::string& key)
+{
+    assert(!m_has_members.empty() && !m_after_key);
+    BeginValue();
+    m_buffer += UniValue(key).write();
+    m_buffer += ':';
+    m_after_key = true;
+}
+
+void JSONWriter::Value(const UniValue& value)
+{
+    BeginValue();
+    m_buffer += value.write();
+    MaybeFlush();
+}
+
+void JSONWriter::Raw(const std::string& text)
+{
+    assert(m_has_members.empty());
+    m_buffer += text;
+}
+
+void JSONWriter::MaybeFlush()
+{
+    if (m_buffer.size() >= m_chunk_size) Flush();
+}
+
+void JSONWriter::Flush()
+{
+    if (m_buffer.empty()) return;
+    std::string chunk;
+    chunk.reserve(m_chunk_size);
+    chunk.swap(m_buffer);
+    m_sink.Write(std::move(chunk));
+}
+
+void JSONWriter::Drain()
+{
+    m_sink.Drain();
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONWRITER_H
+#define BITCOIN_RPC_JSONWRITER_H
+
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Size at which JSONWriter passes its buffered output on to the sink */
+static const size_t DEFAULT_JSON_CHUNK_SIZE = 64 * 1024;
+
+/** Consumer of the output of a JSONWriter. */
+class JSONStreamSink
+{
+public:
+    virtual ~JSONStreamSink() {}
+
+    /** Take a chunk of output. Must not block, as the writer may be called with locks held. */
+    virtual void Write(std::string&& chunk) = 0;
+
+    /** Wait until most of the output taken so far has been consumed. Only called without locks held. */
+    virtual void Drain() {}
+};
+
+/** Sink that appends all output to a string. */
+class JSONStringSink final : public JSONStreamSink
+{
+public:
+    std::string str;
+
+    void Write(std::string&& chunk) override { str += chunk; }
+};
+
+/**
+ * Writes JSON incrementally, producing the same output as UniValue::write()
+ * without indentation. Large results can be emitted one element at a time
+ * instead of being built as a single UniValue tree first; small values are
+ * still passed in as UniValues.
+ *
+ * Output is buffered and passed on to the sink in chunks of about chunk_size
+ * bytes. Callers are expected to call Drain() regularly at points where they
+ * hold no locks, which lets the sink bound the memory used by output that
+ * has not been consumed yet.
+ */
+class JSONWriter
+{
+public:
+    explicit JSONWriter(JSONStreamSink& sink, size_t chunk_size = DEFAULT_JSON_CHUNK_SIZE);
+    ~JSONWriter();
+
+    JSONWriter(const JSONWriter&) = delete;
+    JSONWriter& operator=(const JSONWriter&) = delete;
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write the key of the next object member. Must be followed by a value. */
+    void Key(const std::string& key);
+    /** Write a complete value. */
+    void Value(const UniValue& value);
+    void KeyValue(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+
+    /** Append raw text after the end of the top-level value. */
+    void Raw(const std::string& text);
+
+    /** Pass all buffered output on to the sink. */
+    void Flush();
+    /** Wait for the sink to consume the output passed on so far. Do not call with locks held. */
+    void Drain();
+
+private:
+    void BeginValue();
+    void MaybeFlush();
+
+    JSONStreamSink& m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    //! For each open object or array, whether a member has been written to it yet
+    std::vector<bool> m_has_members;
+    bool m_after_key{false};
+};
+
+#endif // BITCOIN_RPC_JSONWRITER_H
@@ -7,12 +7,14 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <consensus/consensus.h>
+#include <consensus/merkle.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <key_io.h>
 #include <miner.h>
 #include <net.h>
+#include <node/blocktemplate.h>
 #include <node/context.h>
 #include <policy/fees.h>
 #include <pow.h>
@@ -24,6 +26,7 @@
 #include <script/script.h>
 #include <script/signingprovider.h>
 #include <shutdown.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <univalue.h>
 #include <util/fees.h>
@@ -737,8 +740,11 @@ static RPCHelpMan getblocktemplate()
     static CBlockIndex* pindexPrev;
     static int64_t nStart;
     static std::unique_ptr<CBlockTemplate> pblocktemplate;
+    // Keeping the template up to date is cheap when the node maintains it, and
+    // it throttles full rebuilds itself, so only throttle refreshes when the
+    // template has to be assembled from scratch.
     if (pindexPrev != ::ChainActive().Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
+        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && (node.block_template_updater || GetTime() - nStart > 5)))
     {
         // Clear pindexPrev so future calls make a new block, despite any failures from here on
         pindexPrev = nullptr;
@@ -750,7 +756,11 @@ static RPCHelpMan getblocktemplate()
 
         // Create new block
         CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(mempool, Params()).CreateNewBlock(scriptDummy);
+        if (node.block_template_updater) {
+            pblocktemplate = node.block_template_updater->GetBlockTemplate(scriptDummy);
+        } else {
+            pblocktemplate = BlockAssembler(mempool, Params()).CreateNewBlock(scriptDummy);
+        }
         if (!pblocktemplate)
             throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
 
@@ -935,33 +945,9 @@ protected:
     }
 };
 
-static RPCHelpMan submitblock()
+static UniValue SubmitBlock(const JSONRPCRequest& request, const std::shared_ptr<CBlock>& blockptr)
 {
-    // We allow 2 arguments for compliance with BIP22. Argument 2 is ignored.
-    return RPCHelpMan{"submitblock",
-                "\nAttempts to submit new block to network.\n"
-                "See https://en.bitcoin.it/wiki/BIP_0022 for full specification.\n",
-                {
-                    {"hexdata", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded block data to submit"},
-                    {"dummy", RPCArg::Type::STR, /* default */ "ignored", "dummy value, for compatibility with BIP22. This value is ignored."},
-                },
-                RPCResult{RPCResult::Type::NONE, "", "Returns JSON Null when valid, a string according to BIP22 otherwise"},
-                RPCExamples{
-                    HelpExampleCli("submitblock", "\"mydata\"")
-            + HelpExampleRpc("submitblock", "\"mydata\"")
-                },
-        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
-{
-    std::shared_ptr<CBlock> blockptr = std::make_shared<CBlock>();
     CBlock& block = *blockptr;
-    if (!DecodeHexBlk(block, request.params[0].get_str())) {
-        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block decode failed");
-    }
-
-    if (block.vtx.empty() || !block.vtx[0]->IsCoinBase()) {
-        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block does not start with a coinbase");
-    }
-
     uint256 hash = block.GetHash();
     {
         LOCK(cs_main);
@@ -996,6 +982,124 @@ static RPCHelpMan submitblock()
         return "inconclusive";
     }
     return BIP22ValidationResult(sc->state);
+}
+
+static RPCHelpMan submitblock()
+{
+    // We allow 2 arguments for compliance with BIP22. Argument 2 is ignored.
+    return RPCHelpMan{"submitblock",
+                "\nAttempts to submit new block to network.\n"
+                "See https://en.bitcoin.it/wiki/BIP_0022 for full specification.\n",
+                {
+                    {"hexdata", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded block data to submit"},
+                    {"dummy", RPCArg::Type::STR, /* default */ "ignored", "dummy value, for compatibility with BIP22. This value is ignored."},
+                },
+                RPCResult{RPCResult::Type::NONE, "", "Returns JSON Null when valid, a string according to BIP22 otherwise"},
+                RPCExamples{
+                    HelpExampleCli("submitblock", "\"mydata\"")
+            + HelpExampleRpc("submitblock", "\"mydata\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    std::shared_ptr<CBlock> blockptr = std::make_shared<CBlock>();
+    CBlock& block = *blockptr;
+    if (!DecodeHexBlk(block, request.params[0].get_str())) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block decode failed");
+    }
+
+    if (block.vtx.empty() || !block.vtx[0]->IsCoinBase()) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Block does not start with a coinbase");
+    }
+
+    return SubmitBlock(request, blockptr);
+},
+    };
+}
+
+static BlockTemplateProvider& EnsureBlockTemplateProvider(const util::Ref& context)
+{
+    NodeContext& node = EnsureNodeContext(context);
+    if (!node.block_template_provider) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block template provider not found");
+    }
+    return *node.block_template_provider;
+}
+
+static RPCHelpMan getbinaryblocktemplate()
+{
+    return RPCHelpMan{"getbinaryblocktemplate",
+                "\nReturns the latest block template in the compact binary form that -zmqpubblocktemplate publishes.\n"
+                "It has the header fields, the parts of the coinbase, the merkle branch of the coinbase and the HogEx\n"
+                "and MWEB block hashes, but not the transactions. Solve it with submittemplatesolution.\n",
+                {},
+                RPCResult{RPCResult::Type::STR_HEX, "", "the serialized template"},
+                RPCExamples{
+                    HelpExampleCli("getbinaryblocktemplate", "")
+            + HelpExampleRpc("getbinaryblocktemplate", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    BlockTemplateProvider& provider = EnsureBlockTemplateProvider(request.context);
+    if (!Params().IsTestChain() && ::ChainstateActive().IsInitialBlockDownload()) {
+        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, PACKAGE_NAME " is in initial sync and waiting for blocks...");
+    }
+
+    const std::shared_ptr<const BinaryBlockTemplate> blocktemplate = provider.GetTemplate();
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << *blocktemplate;
+    return HexStr(ss);
+},
+    };
+}
+
+static RPCHelpMan submittemplatesolution()
+{
+    return RPCHelpMan{"submittemplatesolution",
+                "\nSubmit a block made from a template of getbinaryblocktemplate or -zmqpubblocktemplate,\n"
+                "with the given header fields and coinbase transaction.\n",
+                {
+                    {"template_id", RPCArg::Type::NUM, RPCArg::Optional::NO, "the id of the template"},
+                    {"version", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block version"},
+                    {"time", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block time"},
+                    {"nonce", RPCArg::Type::NUM, RPCArg::Optional::NO, "the block nonce"},
+                    {"coinbase", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the hex-encoded coinbase transaction"},
+                },
+                RPCResult{RPCResult::Type::NONE, "", "Returns JSON Null when valid, a string according to BIP22 otherwise"},
+                RPCExamples{
+                    HelpExampleCli("submittemplatesolution", "3 536870912 1610000000 12345 \"mycoinbase\"")
+            + HelpExampleRpc("submittemplatesolution", "3, 536870912, 1610000000, 12345, \"mycoinbase\"")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    const auto get_uint32 = [&](size_t index, const std::string& name) {
+        const int64_t value = request.params[index].get_int64();
+        if (value < 0 || value > std::numeric_limits<uint32_t>::max()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid parameter, %s out of range", name));
+        }
+        return static_cast<uint32_t>(value);
+    };
+    const uint32_t time = get_uint32(2, "time");
+    const uint32_t nonce = get_uint32(3, "nonce");
+
+    BlockTemplateProvider& provider = EnsureBlockTemplateProvider(request.context);
+    const std::shared_ptr<const CBlockTemplate> blocktemplate = provider.GetBlock(request.params[0].get_int64());
+    if (!blocktemplate) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown or expired template");
+    }
+
+    CMutableTransaction coinbase;
+    if (!DecodeHexTx(coinbase, request.params[4].get_str(), true, true) || !CTransaction(coinbase).IsCoinBase()) {
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Coinbase decode failed");
+    }
+
+    std::shared_ptr<CBlock> blockptr = std::make_shared<CBlock>(blocktemplate->block);
+    blockptr->vtx[0] = MakeTransactionRef(std::move(coinbase));
+    blockptr->nVersion = request.params[1].get_int();
+    blockptr->nTime = time;
+    blockptr->nNonce = nonce;
+    blockptr->hashMerkleRoot = BlockMerkleRoot(*blockptr);
+
+    return SubmitBlock(request, blockptr);
 },
     };
 }
@@ -1235,6 +1339,8 @@ static const CRPCCommand commands[] =
     { "mining",             "getblocktemplate",       &getblocktemplate,       {"template_request"} },
     { "mining",             "submitblock",            &submitblock,            {"hexdata","dummy"} },
     { "mining",             "submitheader",           &submitheader,           {"hexdata"} },
+    { "mining",             "getbinaryblocktemplate", &getbinaryblocktemplate, {} },
+    { "mining",             "submittemplatesolution", &submittemplatesolution, {"template_id","version","time","nonce","coinbase"} },
 
 
     { "generating",         "generatetoaddress",      &generatetoaddress,      {"nblocks","address","maxtries"} },
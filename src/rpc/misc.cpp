@@ -3,8 +3,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <dbwrapper.h>
 #include <httpserver.h>
 #include <index/blockfilterindex.h>
+#include <index/mwebindex.h>
 #include <index/txindex.h>
 #include <interfaces/chain.h>
 #include <key_io.h>
@@ -15,11 +17,13 @@
 #include <rpc/util.h>
 #include <scheduler.h>
 #include <script/descriptor.h>
+#include <txdb.h>
 #include <util/check.h>
 #include <util/message.h> // For MessageSign(), MessageVerify()
 #include <util/ref.h>
 #include <util/strencodings.h>
 #include <util/system.h>
+#include <validation.h>
 
 #include <stdint.h>
 #include <tuple>
@@ -443,6 +447,46 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCDBInfo(const CDBWrapper& db)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("profile", db.GetProfile().name);
+    obj.pushKV("memory_usage", uint64_t(db.DynamicMemoryUsage()));
+    obj.pushKV("block_cache_usage", uint64_t(db.BlockCacheUsage()));
+    UniValue tables(UniValue::VOBJ);
+    for (const DBTableCacheStats& stats : db.GetTableCacheStats()) {
+        UniValue table(UniValue::VOBJ);
+        table.pushKV("entries", uint64_t(stats.entries));
+        table.pushKV("usage", uint64_t(stats.usage));
+        table.pushKV("max_usage", uint64_t(stats.max_usage));
+        table.pushKV("hits", stats.hits);
+        table.pushKV("misses", stats.misses);
+        tables.pushKV(stats.name, table);
+    }
+    obj.pushKV("table_caches", tables);
+    return obj;
+}
+
+static std::vector<RPCResult> RPCDBInfoDoc()
+{
+    return {
+        {RPCResult::Type::STR, "profile", "LevelDB tuning profile (see -dbprofile)"},
+        {RPCResult::Type::NUM, "memory_usage", "Approximate number of bytes used by LevelDB"},
+        {RPCResult::Type::NUM, "block_cache_usage", "Number of bytes held by the LevelDB block cache"},
+        {RPCResult::Type::OBJ_DYN, "table_caches", "Tables cached separately from the block cache, by name",
+        {
+            {RPCResult::Type::OBJ, "name", "",
+            {
+                {RPCResult::Type::NUM, "entries", "Number of cached entries"},
+                {RPCResult::Type::NUM, "usage", "Approximate number of bytes used"},
+                {RPCResult::Type::NUM, "max_usage", "Maximum number of bytes used"},
+                {RPCResult::Type::NUM, "hits", "Number of lookups served from the cache"},
+                {RPCResult::Type::NUM, "misses", "Number of lookups that read the database"},
+            }},
+        }},
+    };
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -487,6 +531,11 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "leveldb", "Information about LevelDB databases",
+                            {
+                                {RPCResult::Type::OBJ, "blockindex", "The block index database", RPCDBInfoDoc()},
+                                {RPCResult::Type::OBJ, "chainstate", "The chain state database", RPCDBInfoDoc()},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -503,6 +552,15 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        UniValue leveldb(UniValue::VOBJ);
+        {
+            LOCK(cs_main);
+            if (pblocktree) leveldb.pushKV("blockindex", RPCDBInfo(*pblocktree));
+            if (::ChainstateActive().CanFlushToDisk()) {
+                leveldb.pushKV("chainstate", RPCDBInfo(*::ChainstateActive().CoinsDB().GetDB()));
+            }
+        }
+        obj.pushKV("leveldb", leveldb);
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -690,6 +748,10 @@ static RPCHelpMan getindexinfo()
         result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
     });
 
+    if (g_mwebindex) {
+        result.pushKVs(SummaryToJSON(g_mwebindex->GetSummary(), index_name));
+    }
+
     return result;
 },
     };
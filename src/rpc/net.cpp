@@ -139,6 +139,10 @@ static RPCHelpMan getpeerinfo()
                             {
                                 {RPCResult::Type::NUM, "n", "The heights of blocks we're currently asking from this peer"},
                             }},
+                            {RPCResult::Type::NUM, "inflight_quota", "The number of blocks we may have in flight from this peer, based on its measured delivery rate"},
+                            {RPCResult::Type::NUM, "block_download_rate", "The measured rate at which this peer delivers requested blocks, in bytes per second (0 if not measured yet)"},
+                            {RPCResult::Type::NUM, "blocks_received", "The number of requested blocks received from this peer"},
+                            {RPCResult::Type::NUM, "blocks_reassigned", "The number of blocks requested from other peers because this peer stalled"},
                             {RPCResult::Type::NUM, "addr_processed", "The total number of addresses processed, excluding those dropped due to rate limiting"},
                             {RPCResult::Type::NUM, "addr_rate_limited", "The total number of addresses dropped due to rate limiting"},
                             {RPCResult::Type::BOOL, "whitelisted", /* optional */ true, "Whether the peer is whitelisted with default permissions\n"
@@ -238,6 +242,10 @@ static RPCHelpMan getpeerinfo()
                 heights.push_back(height);
             }
             obj.pushKV("inflight", heights);
+            obj.pushKV("inflight_quota", statestats.m_block_download.quota);
+            obj.pushKV("block_download_rate", statestats.m_block_download.bytes_per_second);
+            obj.pushKV("blocks_received", statestats.m_block_download.blocks_received);
+            obj.pushKV("blocks_reassigned", statestats.m_block_download.blocks_reassigned);
             obj.pushKV("addr_processed", statestats.m_addr_processed);
             obj.pushKV("addr_rate_limited", statestats.m_addr_rate_limited);
         }
@@ -527,6 +535,29 @@ static RPCHelpMan getnettotals()
                            {RPCResult::Type::NUM, "bytes_left_in_cycle", "Bytes left in current time cycle"},
                            {RPCResult::Type::NUM, "time_left_in_cycle", "Seconds left in current time cycle"},
                         }},
+                       {RPCResult::Type::OBJ, "sendcalls", "System calls made to send data to peers",
+                       {
+                           {RPCResult::Type::NUM, "calls", "Number of send calls"},
+                           {RPCResult::Type::NUM, "bytes_per_call", "Average number of bytes sent per call"},
+                           {RPCResult::Type::NUM, "zerocopy_bytes", "Bytes sent without copying them into the kernel (-sendzerocopy)"},
+                        }},
+                       {RPCResult::Type::OBJ, "recvbuffers", "Pooled buffers that received messages are read into",
+                       {
+                           {RPCResult::Type::NUM, "allocations", "Number of buffers allocated"},
+                           {RPCResult::Type::NUM, "reuses", "Number of buffers reused from the pool"},
+                           {RPCResult::Type::NUM, "bytes_received", "Total bytes of message payloads received"},
+                           {RPCResult::Type::NUM, "free_buffers", "Number of free buffers in the pool"},
+                           {RPCResult::Type::NUM, "usage", "Total capacity of the free buffers in bytes"},
+                        }},
+                       {RPCResult::Type::OBJ, "blockserving", /* optional */ true, "Historical blocks served to peers from disk",
+                       {
+                           {RPCResult::Type::NUM, "bytes_served", "Total bytes of blocks served"},
+                           {RPCResult::Type::NUM, "bytes_per_second", "Bytes of blocks served per second, averaged over the last minute"},
+                           {RPCResult::Type::NUM, "cache_blocks", "Number of raw blocks in the cache"},
+                           {RPCResult::Type::NUM, "cache_usage", "Memory usage of the raw block cache in bytes"},
+                           {RPCResult::Type::NUM, "cache_hits", "Number of blocks served from the cache"},
+                           {RPCResult::Type::NUM, "cache_misses", "Number of blocks read from disk"},
+                        }},
                     }
                 },
                 RPCExamples{
@@ -552,11 +583,130 @@ static RPCHelpMan getnettotals()
     outboundLimit.pushKV("bytes_left_in_cycle", node.connman->GetOutboundTargetBytesLeft());
     outboundLimit.pushKV("time_left_in_cycle", node.connman->GetMaxOutboundTimeLeftInCycle());
     obj.pushKV("uploadtarget", outboundLimit);
+
+    const SendCallStats send_stats = node.connman->GetSendCallStats();
+    UniValue send_calls(UniValue::VOBJ);
+    send_calls.pushKV("calls", send_stats.calls);
+    send_calls.pushKV("bytes_per_call", send_stats.calls ? (double)send_stats.bytes / send_stats.calls : 0.0);
+    send_calls.pushKV("zerocopy_bytes", send_stats.zerocopy_bytes);
+    obj.pushKV("sendcalls", send_calls);
+
+    const RecvBufferPoolStats recv_buffer_stats = g_recv_buffer_pool.GetStats();
+    UniValue recv_buffers(UniValue::VOBJ);
+    recv_buffers.pushKV("allocations", recv_buffer_stats.allocations);
+    recv_buffers.pushKV("reuses", recv_buffer_stats.reuses);
+    recv_buffers.pushKV("bytes_received", recv_buffer_stats.bytes_received);
+    recv_buffers.pushKV("free_buffers", (uint64_t)recv_buffer_stats.free_buffers);
+    recv_buffers.pushKV("usage", (uint64_t)recv_buffer_stats.usage);
+    obj.pushKV("recvbuffers", recv_buffers);
+
+    if (node.peerman) {
+        const RawBlockCacheStats stats = node.peerman->GetRawBlockCacheStats();
+        UniValue block_serving(UniValue::VOBJ);
+        block_serving.pushKV("bytes_served", stats.bytes_served);
+        block_serving.pushKV("bytes_per_second", stats.bytes_per_second);
+        block_serving.pushKV("cache_blocks", (uint64_t)stats.num_blocks);
+        block_serving.pushKV("cache_usage", (uint64_t)stats.usage);
+        block_serving.pushKV("cache_hits", stats.hits);
+        block_serving.pushKV("cache_misses", stats.misses);
+        obj.pushKV("blockserving", block_serving);
+    }
     return obj;
 },
     };
 }
 
+static std::vector<RPCResult> HistogramDoc(const std::string& unit)
+{
+    return {
+        {RPCResult::Type::NUM, "total", "Sum of the values, in " + unit},
+        {RPCResult::Type::NUM, "max", "Largest value, in " + unit},
+        {RPCResult::Type::NUM, "p50", "Median, rounded up to the end of its bucket"},
+        {RPCResult::Type::NUM, "p99", "99th percentile, rounded up to the end of its bucket"},
+        {RPCResult::Type::ARR, "buckets", "Number of values in each bucket: 0, then [2^(i-1), 2^i) for bucket i. Trailing empty buckets are omitted.",
+        {
+            {RPCResult::Type::NUM, "", "Number of values"},
+        }},
+    };
+}
+
+static UniValue HistogramToJSON(const Log2Histogram& histogram)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("total", histogram.Sum());
+    obj.pushKV("max", histogram.Max());
+    obj.pushKV("p50", histogram.Quantile(0.5));
+    obj.pushKV("p99", histogram.Quantile(0.99));
+    const auto& buckets = histogram.Buckets();
+    size_t num_buckets = buckets.size();
+    while (num_buckets > 0 && buckets[num_buckets - 1] == 0) --num_buckets;
+    UniValue buckets_arr(UniValue::VARR);
+    for (size_t i = 0; i < num_buckets; ++i) {
+        buckets_arr.push_back(buckets[i]);
+    }
+    obj.pushKV("buckets", buckets_arr);
+    return obj;
+}
+
+static RPCHelpMan getnetmsgstats()
+{
+    return RPCHelpMan{"getnetmsgstats",
+                "\nReturns statistics of the P2P messages processed, by message type: their sizes, the time spent\n"
+                "processing them and the part of it spent waiting for cs_main.\n"
+                "Messages of unknown types are listed under '" + NET_MESSAGE_COMMAND_OTHER + "'.\n",
+                {
+                    {"peer_id", RPCArg::Type::NUM, /* default */ "all peers", "Only return the messages received from this connected peer (see getpeerinfo for peer IDs)"},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ_DYN, "", "Message types that were processed at least once",
+                    {
+                        {RPCResult::Type::OBJ, "msg", "",
+                        {
+                            {RPCResult::Type::NUM, "count", "Number of messages processed"},
+                            {RPCResult::Type::OBJ, "size", "Payload sizes in bytes", HistogramDoc("bytes")},
+                            {RPCResult::Type::OBJ, "processing_time", "Time spent processing in microseconds, including lock waits", HistogramDoc("microseconds")},
+                            {RPCResult::Type::OBJ, "cs_main_wait", "Time spent waiting for cs_main while processing, in microseconds", HistogramDoc("microseconds")},
+                        }},
+                    }
+                },
+                RPCExamples{
+                    HelpExampleCli("getnetmsgstats", "")
+            + HelpExampleCli("getnetmsgstats", "1")
+            + HelpExampleRpc("getnetmsgstats", "")
+                },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    NodeContext& node = EnsureNodeContext(request.context);
+    if (!node.connman || !node.peerman)
+        throw JSONRPCError(RPC_CLIENT_P2P_DISABLED, "Error: Peer-to-peer functionality missing or disabled");
+
+    NetMessageStatsMap stats;
+    if (request.params[0].isNull()) {
+        stats = node.peerman->GetMessageStats().GetStats();
+    } else {
+        const NodeId peer_id = request.params[0].get_int64();
+        if (!node.connman->ForNode(peer_id, [](CNode*) { return true; })) {
+            throw JSONRPCError(RPC_CLIENT_NODE_NOT_CONNECTED, "Node not found in connected nodes");
+        }
+        // A peer whose messages haven't been processed yet has no statistics
+        stats = node.peerman->GetMessageStats().GetPeerStats(peer_id).value_or(NetMessageStatsMap{});
+    }
+
+    UniValue result(UniValue::VOBJ);
+    for (const auto& entry : stats) {
+        const NetMessageTypeStats& type_stats = entry.second;
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("count", type_stats.size.Count());
+        obj.pushKV("size", HistogramToJSON(type_stats.size));
+        obj.pushKV("processing_time", HistogramToJSON(type_stats.processing_time));
+        obj.pushKV("cs_main_wait", HistogramToJSON(type_stats.cs_main_wait));
+        result.pushKV(entry.first, obj);
+    }
+    return result;
+},
+    };
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -598,6 +748,16 @@ static RPCHelpMan getnetworkinfo()
                         {RPCResult::Type::NUM, "connections_in", "the number of inbound connections"},
                         {RPCResult::Type::NUM, "connections_out", "the number of outbound connections"},
                         {RPCResult::Type::BOOL, "networkactive", "whether p2p networking is enabled"},
+                        {RPCResult::Type::ARR, "messagehandlers", "information per message handler thread",
+                        {
+                            {RPCResult::Type::OBJ, "", "",
+                            {
+                                {RPCResult::Type::NUM, "thread", "index of the thread"},
+                                {RPCResult::Type::NUM, "peers", "the number of peers whose messages are processed by this thread"},
+                                {RPCResult::Type::NUM, "busytime", "the total time spent processing messages, in seconds"},
+                                {RPCResult::Type::NUM, "utilization", "the fraction of time spent processing messages over the last 10 seconds"},
+                            }},
+                        }},
                         {RPCResult::Type::ARR, "networks", "information per network",
                         {
                             {RPCResult::Type::OBJ, "", "",
@@ -647,6 +807,16 @@ static RPCHelpMan getnetworkinfo()
         obj.pushKV("connections", (int)node.connman->GetNodeCount(CConnman::CONNECTIONS_ALL));
         obj.pushKV("connections_in", (int)node.connman->GetNodeCount(CConnman::CONNECTIONS_IN));
         obj.pushKV("connections_out", (int)node.connman->GetNodeCount(CConnman::CONNECTIONS_OUT));
+        UniValue msghand_threads(UniValue::VARR);
+        for (const MessageHandlerStats& stats : node.connman->GetMessageHandlerStats()) {
+            UniValue thread(UniValue::VOBJ);
+            thread.pushKV("thread", (uint64_t)stats.thread_index);
+            thread.pushKV("peers", stats.num_peers);
+            thread.pushKV("busytime", stats.busy_time * 1e-6);
+            thread.pushKV("utilization", stats.utilization);
+            msghand_threads.push_back(thread);
+        }
+        obj.pushKV("messagehandlers", msghand_threads);
     }
     obj.pushKV("networks",      GetNetworksInfo());
     obj.pushKV("relayfee",      ValueFromAmount(::minRelayTxFee.GetFeePerK()));
@@ -963,6 +1133,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         {"address", "nodeid"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       {"node"} },
     { "network",            "getnettotals",           &getnettotals,           {} },
+    { "network",            "getnetmsgstats",         &getnetmsgstats,         {"peer_id"} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         {} },
     { "network",            "setban",                 &setban,                 {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             {} },
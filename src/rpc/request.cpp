@@ -182,3 +182,9 @@ void JSONRPCRequest::parse(const UniValue& valRequest)
     else
         throw JSONRPCError(RPC_INVALID_REQUEST, "Params must be an array or object");
 }
+
+JSONWriter* JSONRPCRequest::BeginStreamedResult() const
+{
+    if (!stream) return nullptr;
+    return &stream->Begin();
+}
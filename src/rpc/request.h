@@ -14,6 +14,8 @@ namespace util {
 class Ref;
 } // namespace util
 
+class JSONWriter;
+
 UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params, const UniValue& id);
 UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id);
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id);
@@ -28,6 +30,17 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue& in);
 
+/** Reply that a method can stream its result into instead of returning it. */
+class JSONRPCReplyStream
+{
+public:
+    virtual ~JSONRPCReplyStream() {}
+    /** Send the start of the reply and return a writer positioned at the result value. */
+    virtual JSONWriter& Begin() = 0;
+    /** Whether Begin() has been called. */
+    virtual bool Started() const = 0;
+};
+
 class JSONRPCRequest
 {
 public:
@@ -39,19 +52,30 @@ public:
     std::string authUser;
     std::string peerAddr;
     const util::Ref& context;
+    //! Set by servers that can stream the reply to this request, see BeginStreamedResult()
+    JSONRPCReplyStream* stream;
 
-    JSONRPCRequest(const util::Ref& context) : id(NullUniValue), params(NullUniValue), fHelp(false), context(context) {}
+    JSONRPCRequest(const util::Ref& context) : id(NullUniValue), params(NullUniValue), fHelp(false), context(context), stream(nullptr) {}
 
     //! Initializes request information from another request object and the
     //! given context. The implementation should be updated if any members are
     //! added or removed above.
     JSONRPCRequest(const JSONRPCRequest& other, const util::Ref& context)
         : id(other.id), strMethod(other.strMethod), params(other.params), fHelp(other.fHelp), URI(other.URI),
-          authUser(other.authUser), peerAddr(other.peerAddr), context(context)
+          authUser(other.authUser), peerAddr(other.peerAddr), context(context), stream(other.stream)
     {
     }
 
     void parse(const UniValue& valRequest);
+
+    /**
+     * Start streaming the result of this request, if the server supports it.
+     * Returns nullptr if the result has to be returned as a UniValue instead.
+     * Otherwise the method must write exactly one value to the returned
+     * writer and return NullUniValue. As errors can no longer be reported
+     * once the reply has started, call this only after all checks passed.
+     */
+    JSONWriter* BeginStreamedResult() const;
 };
 
 #endif // BITCOIN_RPC_REQUEST_H
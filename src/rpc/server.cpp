@@ -5,6 +5,7 @@
 
 #include <rpc/server.h>
 
+#include <rpc/executor.h>
 #include <rpc/util.h>
 #include <shutdown.h>
 #include <sync.h>
@@ -30,6 +31,8 @@ static RPCTimerInterface* timerInterface = nullptr;
 static Mutex g_deadline_timers_mutex;
 static std::map<std::string, std::unique_ptr<RPCTimerBase> > deadlineTimers GUARDED_BY(g_deadline_timers_mutex);
 static bool ExecuteCommand(const CRPCCommand& command, const JSONRPCRequest& request, UniValue& result, bool last_handler);
+/* Executor for the items of batch requests, replaced with std::atomic_store */
+static std::shared_ptr<RPCBatchExecutor> g_rpc_batch_executor;
 
 struct RPCCommandExecutionInfo
 {
@@ -284,6 +287,20 @@ bool CRPCTable::removeCommand(const std::string& name, const CRPCCommand* pcmd)
 void StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    int batch_threads = gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS);
+    if (batch_threads <= 0) batch_threads = GetNumCores();
+    auto executor = std::make_shared<RPCBatchExecutor>(batch_threads);
+    for (const std::string& limit : gArgs.GetArgs("-rpcbatchlimit")) {
+        const size_t pos = limit.rfind(':');
+        int n;
+        if (pos == std::string::npos || !ParseInt32(limit.substr(pos + 1), &n) || n < 1) {
+            LogPrintf("Ignoring invalid -rpcbatchlimit=%s\n", limit);
+            continue;
+        }
+        executor->SetMethodLimit(limit.substr(0, pos), n);
+    }
+    LogPrint(BCLog::RPC, "Executing batch requests on up to %d threads\n", std::min(batch_threads, MAX_RPC_BATCH_THREADS));
+    std::atomic_store(&g_rpc_batch_executor, executor);
     g_rpc_running = true;
     g_rpcSignals.Started();
 }
@@ -306,6 +323,9 @@ void StopRPC()
     assert(!g_rpc_running);
     std::call_once(g_rpc_stop_flag, []() {
         LogPrint(BCLog::RPC, "Stopping RPC\n");
+        // Batches still running on HTTP workers keep their reference and
+        // the executor is joined when the last one finishes.
+        std::atomic_store(&g_rpc_batch_executor, std::shared_ptr<RPCBatchExecutor>());
         WITH_LOCK(g_deadline_timers_mutex, deadlineTimers.clear());
         DeleteAuthCookie();
         g_rpcSignals.Stopped();
@@ -373,15 +393,44 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, RPCBatchExecutor* executor)
 {
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    if (!executor) {
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+
+        return ret.write() + "\n";
+    }
+
+    // Items may complete in any order; each writes its own slot so the
+    // replies are assembled in request order.
+    std::vector<UniValue> replies(vReq.size());
+    std::vector<RPCBatchExecutor::Task> tasks;
+    tasks.reserve(vReq.size());
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        tasks.emplace_back([&jreq, &vReq, &replies, executor, reqIdx] {
+            const UniValue& method = find_value(vReq[reqIdx], "method");
+            CSemaphore* limit = method.isStr() ? executor->GetMethodLimit(method.get_str()) : nullptr;
+            CSemaphoreGrant grant;
+            if (limit) CSemaphoreGrant(*limit).MoveTo(grant);
+            replies[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+        });
+    }
+    executor->Run(tasks);
+
+    for (const UniValue& reply : replies)
+        ret.push_back(reply);
 
     return ret.write() + "\n";
 }
 
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+{
+    std::shared_ptr<RPCBatchExecutor> executor = std::atomic_load(&g_rpc_batch_executor);
+    return JSONRPCExecBatch(jreq, vReq, executor.get());
+}
+
 /**
  * Process named arguments into a vector of positional arguments, based on the
  * passed-in specification for the RPC call's arguments.
@@ -20,6 +20,7 @@
 static const unsigned int DEFAULT_RPC_SERIALIZE_VERSION = 2;
 
 class CRPCCommand;
+class RPCBatchExecutor;
 
 namespace RPCServer
 {
@@ -180,7 +181,12 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
+/** Execute the items of a batch request on the executor started by StartRPC
+ * and return the replies in request order. */
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+/** Execute the items of a batch request on executor, or sequentially on the
+ * calling thread if executor is nullptr. */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, RPCBatchExecutor* executor);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
@@ -0,0 +1,155 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <spendindex.h>
+
+#include <crypto/siphash.h>
+#include <memusage.h>
+#include <random.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static uint256 OutputIdToUint256(const mw::Hash& output_id)
+{
+    uint256 hash;
+    std::memcpy(hash.begin(), output_id.data(), sizeof(hash));
+    return hash;
+}
+
+SpendIndex::SpendIndex() : m_k0(GetRand(std::numeric_limits<uint64_t>::max())), m_k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+size_t SpendIndex::Home(const uint256& hash, uint32_t n, bool mweb) const
+{
+    // MWEB output IDs have no index; give them one outpoints spent in the mempool never have.
+    return SipHashUint256Extra(m_k0, m_k1, hash, mweb ? std::numeric_limits<uint32_t>::max() : n) & (m_slots.size() - 1);
+}
+
+const SpendIndex::Slot* SpendIndex::FindSlot(const uint256& hash, uint32_t n, bool mweb) const
+{
+    if (m_size == 0) return nullptr;
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = Home(hash, n, mweb);; i = (i + 1) & mask) {
+        const Slot& slot = m_slots[i];
+        if (!slot.tx) return nullptr;
+        if (slot.n == n && slot.mweb == mweb && slot.hash == hash) return &slot;
+    }
+}
+
+const CTransaction* SpendIndex::Find(const uint256& hash, uint32_t n, bool mweb) const
+{
+    const Slot* slot = FindSlot(hash, n, mweb);
+    return slot ? slot->tx : nullptr;
+}
+
+const CTransaction* SpendIndex::Get(const mw::Hash& output_id) const
+{
+    return Find(OutputIdToUint256(output_id), 0, true);
+}
+
+const CTransaction* SpendIndex::Get(const OutputIndex& index) const
+{
+    if (const mw::Hash* output_id = boost::get<mw::Hash>(&index)) return Get(*output_id);
+    return Get(boost::get<COutPoint>(index));
+}
+
+const CTransaction* SpendIndex::Get(const CTxInput& input) const
+{
+    return input.IsMWEB() ? Get(input.ToMWEB()) : Get(input.GetTxIn().prevout);
+}
+
+bool SpendIndex::Insert(const uint256& hash, uint32_t n, bool mweb, const CTransaction* tx)
+{
+    assert(tx != nullptr);
+    // Keep the load factor at most 3/4, so that probe sequences stay short.
+    if ((m_size + 1) * 4 > m_slots.size() * 3) {
+        Rehash(std::max(MIN_SLOTS, m_slots.size() * 2));
+    }
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = Home(hash, n, mweb);; i = (i + 1) & mask) {
+        Slot& slot = m_slots[i];
+        if (!slot.tx) {
+            slot.hash = hash;
+            slot.n = n;
+            slot.mweb = mweb;
+            slot.tx = tx;
+            ++m_size;
+            return true;
+        }
+        if (slot.n == n && slot.mweb == mweb && slot.hash == hash) return false;
+    }
+}
+
+bool SpendIndex::Insert(const mw::Hash& output_id, const CTransaction* tx)
+{
+    return Insert(OutputIdToUint256(output_id), 0, true, tx);
+}
+
+bool SpendIndex::Insert(const CTxInput& input, const CTransaction* tx)
+{
+    return input.IsMWEB() ? Insert(input.ToMWEB(), tx) : Insert(input.GetTxIn().prevout, tx);
+}
+
+bool SpendIndex::Erase(const uint256& hash, uint32_t n, bool mweb)
+{
+    const Slot* found = FindSlot(hash, n, mweb);
+    if (!found) return false;
+
+    // Shift back the slots after the hole that would no longer be reachable from their home slot.
+    const size_t mask = m_slots.size() - 1;
+    size_t hole = found - m_slots.data();
+    for (size_t i = (hole + 1) & mask; m_slots[i].tx; i = (i + 1) & mask) {
+        const size_t home = Home(m_slots[i].hash, m_slots[i].n, m_slots[i].mweb);
+        // The slot can move to the hole if its home is not cyclically in (hole, i].
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole] = Slot{};
+    --m_size;
+
+    // Give memory back as the mempool shrinks, e.g. after a large block. The
+    // table is reported in full by DynamicMemoryUsage(), so it must not stay
+    // large while the mempool is trimmed.
+    if (m_slots.size() > MIN_SLOTS && m_size * 4 < m_slots.size()) {
+        Rehash(m_slots.size() / 2);
+    }
+    return true;
+}
+
+bool SpendIndex::Erase(const mw::Hash& output_id)
+{
+    return Erase(OutputIdToUint256(output_id), 0, true);
+}
+
+bool SpendIndex::Erase(const CTxInput& input)
+{
+    return input.IsMWEB() ? Erase(input.ToMWEB()) : Erase(input.GetTxIn().prevout);
+}
+
+void SpendIndex::Rehash(size_t num_slots)
+{
+    std::vector<Slot> old_slots(num_slots);
+    old_slots.swap(m_slots);
+    const size_t mask = m_slots.size() - 1;
+    for (const Slot& slot : old_slots) {
+        if (!slot.tx) continue;
+        size_t i = Home(slot.hash, slot.n, slot.mweb);
+        while (m_slots[i].tx) i = (i + 1) & mask;
+        m_slots[i] = slot;
+    }
+}
+
+void SpendIndex::Clear()
+{
+    std::vector<Slot>().swap(m_slots);
+    m_size = 0;
+}
+
+size_t SpendIndex::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(m_slots);
+}
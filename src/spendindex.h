@@ -0,0 +1,88 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SPENDINDEX_H
+#define BITCOIN_SPENDINDEX_H
+
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <vector>
+
+/**
+ * Hash map from outputs, either outpoints or MWEB output IDs, to mempool
+ * transactions, as the mempool keeps both for the outputs its transactions
+ * spend and for the MWEB outputs they create. The mempool also uses it to map
+ * MWEB kernel IDs to the transactions that have them.
+ *
+ * Both kinds of keys are stored as a 256-bit hash with a 32-bit index, so
+ * lookups don't go through the OutputIndex variant. The slots live in one
+ * array with open addressing and linear probing, and are placed by a salted
+ * SipHash so that peers can't make lookups slow by crafting colliding keys.
+ * Removal shifts the following slots back instead of leaving tombstones.
+ */
+class SpendIndex
+{
+public:
+    SpendIndex();
+
+    /** The transaction mapped to the output, or nullptr */
+    const CTransaction* Get(const COutPoint& outpoint) const { return Find(outpoint.hash, outpoint.n, false); }
+    const CTransaction* Get(const mw::Hash& output_id) const;
+    const CTransaction* Get(const OutputIndex& index) const;
+    const CTransaction* Get(const CTxInput& input) const;
+
+    bool Contains(const OutputIndex& index) const { return Get(index) != nullptr; }
+
+    /** Map the output to the transaction, unless it is mapped already. Returns whether it was inserted. */
+    bool Insert(const COutPoint& outpoint, const CTransaction* tx) { return Insert(outpoint.hash, outpoint.n, false, tx); }
+    bool Insert(const mw::Hash& output_id, const CTransaction* tx);
+    bool Insert(const CTxInput& input, const CTransaction* tx);
+
+    /** Remove the output. Returns whether it was mapped. */
+    bool Erase(const COutPoint& outpoint) { return Erase(outpoint.hash, outpoint.n, false); }
+    bool Erase(const mw::Hash& output_id);
+    bool Erase(const CTxInput& input);
+
+    void Clear();
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+    size_t DynamicMemoryUsage() const;
+
+    /** Call fn with every transaction mapped to, once per output. */
+    template <typename Fn>
+    void ForEachTx(Fn fn) const
+    {
+        for (const Slot& slot : m_slots) {
+            if (slot.tx) fn(slot.tx);
+        }
+    }
+
+private:
+    struct Slot {
+        uint256 hash;
+        uint32_t n{0};
+        //! Whether hash is an MWEB output ID rather than the txid of an outpoint
+        bool mweb{false};
+        //! nullptr if the slot is empty
+        const CTransaction* tx{nullptr};
+    };
+
+    /** Smallest number of slots allocated */
+    static constexpr size_t MIN_SLOTS = 4;
+
+    size_t Home(const uint256& hash, uint32_t n, bool mweb) const;
+    const Slot* FindSlot(const uint256& hash, uint32_t n, bool mweb) const;
+    const CTransaction* Find(const uint256& hash, uint32_t n, bool mweb) const;
+    bool Insert(const uint256& hash, uint32_t n, bool mweb, const CTransaction* tx);
+    bool Erase(const uint256& hash, uint32_t n, bool mweb);
+    void Rehash(size_t num_slots);
+
+    const uint64_t m_k0, m_k1;
+    //! Power of two number of slots, or none before the first insertion
+    std::vector<Slot> m_slots;
+    size_t m_size{0};
+};
+
+#endif // BITCOIN_SPENDINDEX_H
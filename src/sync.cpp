@@ -32,6 +32,33 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+#ifdef HAVE_THREAD_LOCAL
+//! Innermost lock wait tracker of the current thread
+static thread_local LockWaitTracker* g_lock_wait_tracker{nullptr};
+
+LockWaitTracker::LockWaitTracker(const void* mutex) : m_mutex(mutex), m_prev(g_lock_wait_tracker)
+{
+    g_lock_wait_tracker = this;
+}
+
+LockWaitTracker::~LockWaitTracker()
+{
+    g_lock_wait_tracker = m_prev;
+}
+
+void LockWaitTracker::RecordWait(const void* mutex, std::chrono::steady_clock::duration wait)
+{
+    for (LockWaitTracker* tracker = g_lock_wait_tracker; tracker != nullptr; tracker = tracker->m_prev) {
+        if (tracker->m_mutex == mutex) tracker->m_waited += wait;
+    }
+}
+#else
+// Without thread_local storage, waits are not tracked.
+LockWaitTracker::LockWaitTracker(const void* mutex) : m_mutex(mutex), m_prev(nullptr) {}
+LockWaitTracker::~LockWaitTracker() {}
+void LockWaitTracker::RecordWait(const void* mutex, std::chrono::steady_clock::duration wait) {}
+#endif
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -9,6 +9,7 @@
 #include <threadsafety.h>
 #include <util/macros.h>
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <string>
@@ -128,6 +129,32 @@ typedef AnnotatedMixin<std::mutex> Mutex;
 void PrintLockContention(const char* pszName, const char* pszFile, int nLine);
 #endif
 
+/**
+ * Measures how long the current thread waits for a mutex while the tracker is
+ * in scope, e.g. to tell how much of the time spent on some work went to
+ * waiting for cs_main. Only contended locks taken through UniqueLock (LOCK,
+ * LOCK2, WAIT_LOCK) are counted. Trackers can be nested.
+ */
+class LockWaitTracker
+{
+public:
+    explicit LockWaitTracker(const void* mutex);
+    ~LockWaitTracker();
+
+    LockWaitTracker(const LockWaitTracker&) = delete;
+    LockWaitTracker& operator=(const LockWaitTracker&) = delete;
+
+    std::chrono::microseconds Waited() const { return std::chrono::duration_cast<std::chrono::microseconds>(m_waited); }
+
+    /** Add a wait of the current thread for a mutex to the trackers of that mutex on the thread. */
+    static void RecordWait(const void* mutex, std::chrono::steady_clock::duration wait);
+
+private:
+    const void* const m_mutex;
+    LockWaitTracker* const m_prev;
+    std::chrono::steady_clock::duration m_waited{0};
+};
+
 /** Wrapper around std::unique_lock style lock for Mutex. */
 template <typename Mutex, typename Base = typename Mutex::UniqueLock>
 class SCOPED_LOCKABLE UniqueLock : public Base
@@ -136,14 +163,14 @@ private:
     void Enter(const char* pszName, const char* pszFile, int nLine)
     {
         EnterCritical(pszName, pszFile, nLine, (void*)(Base::mutex()));
-#ifdef DEBUG_LOCKCONTENTION
         if (!Base::try_lock()) {
+#ifdef DEBUG_LOCKCONTENTION
             PrintLockContention(pszName, pszFile, nLine);
 #endif
+            const auto wait_start = std::chrono::steady_clock::now();
             Base::lock();
-#ifdef DEBUG_LOCKCONTENTION
+            LockWaitTracker::RecordWait(Base::mutex(), std::chrono::steady_clock::now() - wait_start);
         }
-#endif
     }
 
     bool TryEnter(const char* pszName, const char* pszFile, int nLine)
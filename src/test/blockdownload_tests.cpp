@@ -0,0 +1,188 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockdownload.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <deque>
+#include <set>
+
+BOOST_FIXTURE_TEST_SUITE(blockdownload_tests, BasicTestingSetup)
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr std::chrono::microseconds NEVER{std::numeric_limits<int64_t>::max()};
+
+/** A peer serving the blocks requested from it one at a time, at a fixed bandwidth. */
+struct SimPeer {
+    NodeId id;
+    double bandwidth; // bytes per second
+    std::chrono::microseconds rtt;
+    //! Stop delivering blocks at this time.
+    std::chrono::microseconds stall_time{NEVER};
+
+    struct Request {
+        int block;
+        std::chrono::microseconds requested;
+        std::chrono::microseconds delivery;
+    };
+    std::deque<Request> queue;
+    std::chrono::microseconds free_at{0};
+    //! When the block at the front of the queue became the front.
+    std::chrono::microseconds downloading_since{0};
+    std::chrono::microseconds paused_until{0};
+};
+
+/** Download num_blocks blocks of block_size bytes from the given peers, in order of height, the way
+ *  SendMessages() schedules them. Returns the time it took to download all blocks. */
+std::chrono::microseconds Simulate(BlockDownloadScheduler& scheduler, std::vector<SimPeer>& peers, int num_blocks, size_t block_size)
+{
+    std::set<int> to_request;
+    for (int i = 0; i < num_blocks; ++i) to_request.insert(i);
+    std::set<int> received;
+
+    std::chrono::microseconds now{0};
+    while ((int)received.size() < num_blocks) {
+        BOOST_REQUIRE(now < 3600s);
+        for (SimPeer& peer : peers) {
+            scheduler.SetRoundTripTime(peer.id, peer.rtt);
+
+            // Deliveries
+            while (!peer.queue.empty() && peer.queue.front().delivery <= now) {
+                const SimPeer::Request& request = peer.queue.front();
+                scheduler.BlockReceived(peer.id, block_size, request.requested, request.delivery);
+                received.insert(request.block);
+                peer.downloading_since = request.delivery;
+                peer.paused_until = 0us;
+                peer.queue.pop_front();
+            }
+
+            // Reassign stalled blocks
+            if (!peer.queue.empty() && now - peer.downloading_since > scheduler.GetStallTimeout(peer.id)) {
+                for (const SimPeer::Request& request : peer.queue) {
+                    to_request.insert(request.block);
+                }
+                scheduler.BlocksReassigned(peer.id, peer.queue.size());
+                peer.queue.clear();
+                peer.paused_until = now + scheduler.GetStallTimeout(peer.id);
+            }
+
+            // Requests
+            while (now >= peer.paused_until && (int)peer.queue.size() < scheduler.GetQuota(peer.id) && !to_request.empty()) {
+                const int block = *to_request.begin();
+                to_request.erase(to_request.begin());
+                // The request takes half a round trip to arrive, and the block another half to come back.
+                const std::chrono::microseconds start = std::max(now + peer.rtt / 2, peer.free_at);
+                peer.free_at = start + std::chrono::microseconds{(int64_t)(block_size / peer.bandwidth * 1e6)};
+                const std::chrono::microseconds delivery = peer.free_at >= peer.stall_time ? NEVER : peer.free_at + peer.rtt / 2;
+                if (peer.queue.empty()) peer.downloading_since = now;
+                peer.queue.push_back({block, now, delivery});
+            }
+        }
+        now += 10ms;
+    }
+    return now;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(blockdownload_defaults)
+{
+    BlockDownloadScheduler scheduler;
+    BlockDownloadStats stats;
+    BOOST_CHECK_EQUAL(scheduler.GetQuota(0), DEFAULT_BLOCKS_IN_TRANSIT_QUOTA);
+    BOOST_CHECK(scheduler.GetStallTimeout(0) == DEFAULT_BLOCK_STALL_TIMEOUT);
+    BOOST_CHECK(!scheduler.GetStats(0, stats));
+
+    // 100 kB blocks delivered back to back every 100ms, with a 150ms round trip time
+    scheduler.SetRoundTripTime(0, 150ms);
+    std::chrono::microseconds now{0};
+    for (int i = 0; i < 10; ++i) {
+        scheduler.BlockReceived(0, 100000, 0us, now += 100ms);
+    }
+    BOOST_REQUIRE(scheduler.GetStats(0, stats));
+    BOOST_CHECK_CLOSE(stats.bytes_per_second, 1000000, 0.01);
+    BOOST_CHECK_EQUAL(stats.blocks_received, 10U);
+    // Enough blocks to cover the round trip time plus the buffer time
+    BOOST_CHECK_EQUAL(stats.quota, 12);
+    // Delivery is expected within 250ms, but the stall timeout is bounded
+    BOOST_CHECK(scheduler.GetStallTimeout(0) == MIN_BLOCK_STALL_TIMEOUT);
+
+    // Reassigning blocks halves the estimated rate
+    scheduler.BlocksReassigned(0, 3);
+    BOOST_REQUIRE(scheduler.GetStats(0, stats));
+    BOOST_CHECK_CLOSE(stats.bytes_per_second, 500000, 0.01);
+    BOOST_CHECK_EQUAL(stats.quota, 6);
+    BOOST_CHECK_EQUAL(stats.blocks_reassigned, 3U);
+
+    // The quota and stall timeout are bounded
+    scheduler.BlockReceived(1, 1000000, 0us, 60s);
+    BOOST_CHECK_EQUAL(scheduler.GetQuota(1), MIN_BLOCKS_IN_TRANSIT_QUOTA);
+    BOOST_CHECK(scheduler.GetStallTimeout(1) == DEFAULT_BLOCK_STALL_TIMEOUT);
+    scheduler.BlockReceived(2, 1000, 0us, 1ms);
+    BOOST_CHECK_EQUAL(scheduler.GetQuota(2), MAX_BLOCKS_IN_TRANSIT_QUOTA);
+
+    BOOST_CHECK_EQUAL(scheduler.Size(), 3U);
+    scheduler.DisconnectedPeer(0);
+    scheduler.DisconnectedPeer(1);
+    scheduler.DisconnectedPeer(2);
+    BOOST_CHECK_EQUAL(scheduler.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(blockdownload_simulate_rates)
+{
+    // One fast and one slow peer downloading 1 MB blocks
+    BlockDownloadScheduler scheduler;
+    std::vector<SimPeer> peers{
+        {0, 20e6, 50ms},
+        {1, 250e3, 300ms},
+    };
+    const std::chrono::microseconds duration = Simulate(scheduler, peers, 2000, 1000000);
+
+    BlockDownloadStats fast, slow;
+    BOOST_REQUIRE(scheduler.GetStats(0, fast));
+    BOOST_REQUIRE(scheduler.GetStats(1, slow));
+
+    // The measured rates match the bandwidth of the peers
+    BOOST_CHECK_CLOSE(fast.bytes_per_second, 20e6, 10);
+    BOOST_CHECK_CLOSE(slow.bytes_per_second, 250e3, 10);
+
+    // The fast peer gets enough blocks in flight to cover its round trip time plus a second,
+    // the slow peer only the minimum.
+    BOOST_CHECK(fast.quota >= 20);
+    BOOST_CHECK_EQUAL(slow.quota, MIN_BLOCKS_IN_TRANSIT_QUOTA);
+    BOOST_CHECK(fast.blocks_received > 50 * slow.blocks_received);
+    BOOST_CHECK_EQUAL(fast.blocks_reassigned + slow.blocks_reassigned, 0U);
+
+    // The download runs at close to the combined bandwidth of the peers
+    BOOST_CHECK(duration < 2000 * 1000000 / 20e6 * 1.2 * 1s);
+}
+
+BOOST_AUTO_TEST_CASE(blockdownload_simulate_stall)
+{
+    // One of three peers stops delivering blocks after 10 seconds
+    BlockDownloadScheduler scheduler;
+    std::vector<SimPeer> peers{
+        {0, 5e6, 100ms},
+        {1, 5e6, 100ms, 10s},
+        {2, 5e6, 100ms},
+    };
+    const std::chrono::microseconds duration = Simulate(scheduler, peers, 500, 1000000);
+
+    BlockDownloadStats stalled;
+    BOOST_REQUIRE(scheduler.GetStats(1, stalled));
+    BOOST_CHECK(stalled.blocks_reassigned > 0);
+    BOOST_CHECK_EQUAL(stalled.quota, MIN_BLOCKS_IN_TRANSIT_QUOTA);
+
+    // The stalled blocks are fetched from the other peers within seconds, instead of
+    // waiting for the download window to fill up or the block download timeout.
+    const auto ideal = 10s + (500 * 1000000 - 10 * 3 * 5e6) / (2 * 5e6) * 1s;
+    BOOST_CHECK(duration < ideal + 5s);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
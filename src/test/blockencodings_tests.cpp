@@ -5,10 +5,13 @@
 #include <blockencodings.h>
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <mw/consensus/Aggregation.h>
+#include <mw/consensus/Params.h>
 #include <pow.h>
 #include <streams.h>
 
 #include <test/util/setup_common.h>
+#include <test_framework/models/Tx.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -72,7 +75,7 @@ BOOST_AUTO_TEST_CASE(SimpleRoundTripTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK( partialBlock.IsTxAvailable(0));
         BOOST_CHECK(!partialBlock.IsTxAvailable(1));
@@ -115,6 +118,9 @@ public:
     uint64_t nonce;
     std::vector<uint64_t> shorttxids;
     std::vector<PrefilledTransaction> prefilledtxn;
+    MWEB::Block mweb_block;
+    mw::Header::CPtr mweb_header;
+    std::vector<uint64_t> mweb_shortids;
 
     explicit TestHeaderAndShortIDs(const CBlockHeaderAndShortTxIDs& orig) {
         CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
@@ -132,7 +138,15 @@ public:
         return base.GetShortID(txhash);
     }
 
-    SERIALIZE_METHODS(TestHeaderAndShortIDs, obj) { READWRITE(obj.header, obj.nonce, Using<VectorFormatter<CustomUintFormatter<CBlockHeaderAndShortTxIDs::SHORTTXIDS_LENGTH>>>(obj.shorttxids), obj.prefilledtxn); }
+    SERIALIZE_METHODS(TestHeaderAndShortIDs, obj)
+    {
+        READWRITE(obj.header, obj.nonce, Using<VectorFormatter<CustomUintFormatter<CBlockHeaderAndShortTxIDs::SHORTTXIDS_LENGTH>>>(obj.shorttxids), obj.prefilledtxn);
+        if (s.GetVersion() & SERIALIZE_MWEB_SHORTIDS) {
+            READWRITE(WrapOptionalPtr(obj.mweb_header), Using<VectorFormatter<CustomUintFormatter<CBlockHeaderAndShortTxIDs::SHORTTXIDS_LENGTH>>>(obj.mweb_shortids));
+        } else {
+            READWRITE(obj.mweb_block);
+        }
+    }
 };
 
 BOOST_AUTO_TEST_CASE(NonCoinbasePreforwardRTTest)
@@ -162,7 +176,7 @@ BOOST_AUTO_TEST_CASE(NonCoinbasePreforwardRTTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK(!partialBlock.IsTxAvailable(0));
         BOOST_CHECK( partialBlock.IsTxAvailable(1));
@@ -232,7 +246,7 @@ BOOST_AUTO_TEST_CASE(SufficientPreforwardRTTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK( partialBlock.IsTxAvailable(0));
         BOOST_CHECK( partialBlock.IsTxAvailable(1));
@@ -287,7 +301,7 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
         CBlockHeaderAndShortTxIDs shortIDs2;
         stream >> shortIDs2;
 
-        PartiallyDownloadedBlock partialBlock(&pool);
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
         BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
         BOOST_CHECK(partialBlock.IsTxAvailable(0));
 
@@ -300,6 +314,129 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(MWEBKernelShortIDsCountTest)
+{
+    CTxMemPool pool;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig.resize(10);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].nValue = 42;
+
+    CBlock block;
+    block.vtx.resize(1);
+    block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+    block.nVersion = 1;
+    block.hashPrevBlock = InsecureRand256();
+    block.nBits = 0x1e0ffff0;
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+
+    // Announce the block with an MWEB header and the given number of kernel short IDs, as
+    // received from a peer that asked for MWEB short IDs
+    auto make_cmpctblock = [&](size_t num_kernels) {
+        TestHeaderAndShortIDs test_ids(block);
+        test_ids.mweb_header = std::make_shared<mw::Header>(1, mw::Hash{}, mw::Hash{}, mw::Hash{}, BlindingFactor{}, BlindingFactor{}, 0, num_kernels);
+        for (size_t i = 0; i < num_kernels; i++) {
+            test_ids.mweb_shortids.push_back(i);
+        }
+
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION | SERIALIZE_MWEB_SHORTIDS);
+        stream << test_ids;
+        CBlockHeaderAndShortTxIDs cmpctblock;
+        stream >> cmpctblock;
+        BOOST_CHECK_EQUAL(cmpctblock.MWEBKernelCount(), num_kernels);
+        return cmpctblock;
+    };
+
+    // Kernel positions beyond 16 bits are kept apart
+    {
+        const size_t num_kernels = 0x10000 + 10;
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
+        BOOST_CHECK(partialBlock.InitData(make_cmpctblock(num_kernels), extra_txn) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(partialBlock.MWEBKernelCount(), num_kernels);
+        BOOST_CHECK(!partialBlock.IsMWEBKernelAvailable(num_kernels - 1));
+    }
+
+    // More kernels than an MWEB block can hold
+    {
+        PartiallyDownloadedBlock partialBlock(&pool, MWEB::Block());
+        BOOST_CHECK(partialBlock.InitData(make_cmpctblock(mw::MAX_BLOCK_WEIGHT / mw::BASE_KERNEL_WEIGHT + 1), extra_txn) == READ_STATUS_INVALID);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(FillMWEBBlockTransactionsTest)
+{
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    std::vector<CTransactionRef> txs;
+    for (CAmount amount : {1000, 2000}) {
+        CMutableTransaction mtx;
+        mtx.mweb_tx = MWEB::Tx(test::Tx::CreatePegIn(amount).GetTransaction());
+        txs.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+
+    CBlock block(BuildBlockTestCase());
+    const mw::Transaction::CPtr body = Aggregation::Aggregate({txs[0]->mweb_tx.m_transaction, txs[1]->mweb_tx.m_transaction});
+    const auto header = std::make_shared<mw::Header>(1, mw::Hash{}, mw::Hash{}, mw::Hash{}, body->GetKernelOffset(), body->GetStealthOffset(), 2, 2);
+    block.mweb_block = MWEB::Block(std::make_shared<mw::Block>(header, body->GetBody()));
+
+    // Position of the kernel of each transaction within the MWEB block
+    std::vector<uint32_t> positions;
+    const std::vector<Kernel>& kernels = block.mweb_block.m_block->GetKernels();
+    for (const CTransactionRef& tx : txs) {
+        const mw::Hash kernel_id = *tx->mweb_tx.GetKernelIDs().begin();
+        const auto it = std::find_if(kernels.begin(), kernels.end(), [&](const Kernel& kernel) { return kernel.GetKernelID() == kernel_id; });
+        BOOST_REQUIRE(it != kernels.end());
+        positions.push_back(it - kernels.begin());
+    }
+
+    LOCK2(cs_main, pool.cs);
+    pool.addUnchecked(entry.FromTx(txs[0]));
+    BOOST_CHECK(pool.mapTxKernels_MWEB.Get(*txs[0]->mweb_tx.GetKernelIDs().begin()) == txs[0].get());
+
+    BlockTransactionsRequest req;
+    req.blockhash = block.GetHash();
+
+    // A kernel of a mempool transaction is sent as that transaction
+    {
+        req.mweb_indexes = {positions[0]};
+        BlockTransactions resp(req);
+        BOOST_CHECK(FillMWEBBlockTransactions(pool, block, req, resp));
+        BOOST_REQUIRE_EQUAL(resp.mweb_txn.size(), 1U);
+        BOOST_CHECK(resp.mweb_txn[0]->GetHash() == txs[0]->mweb_tx.m_transaction->GetHash());
+        BOOST_CHECK(resp.mweb_block.IsNull());
+    }
+
+    // If any kernel can't be found, the whole MWEB block is sent instead
+    {
+        req.mweb_indexes = {std::min(positions[0], positions[1]), std::max(positions[0], positions[1])};
+        BlockTransactions resp(req);
+        BOOST_CHECK(FillMWEBBlockTransactions(pool, block, req, resp));
+        BOOST_CHECK(resp.mweb_txn.empty());
+        BOOST_CHECK(!resp.mweb_block.IsNull());
+    }
+
+    // Once mined, the transaction is found among the recently removed ones
+    {
+        pool.removeRecursive(*txs[0], MemPoolRemovalReason::BLOCK);
+        BOOST_CHECK(pool.mapTxKernels_MWEB.Get(*txs[0]->mweb_tx.GetKernelIDs().begin()) == nullptr);
+        req.mweb_indexes = {positions[0]};
+        BlockTransactions resp(req);
+        BOOST_CHECK(FillMWEBBlockTransactions(pool, block, req, resp));
+        BOOST_REQUIRE_EQUAL(resp.mweb_txn.size(), 1U);
+        BOOST_CHECK(resp.mweb_txn[0]->GetHash() == txs[0]->mweb_tx.m_transaction->GetHash());
+    }
+
+    // Kernel positions out of bounds
+    {
+        req.mweb_indexes = {2};
+        BlockTransactions resp(req);
+        BOOST_CHECK(!FillMWEBBlockTransactions(pool, block, req, resp));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
@@ -51,6 +51,14 @@ static bool CheckFilterLookups(BlockFilterIndex& filter_index, const CBlockIndex
     BOOST_CHECK_EQUAL(filters[0].GetHash(), expected_filter.GetHash());
     BOOST_CHECK_EQUAL(filter_hashes[0], expected_filter.GetHash());
 
+    // Match twice so the second lookup is served from the decoded filter cache.
+    GCSFilter::ElementSet elements{GCSFilter::Element(32, 0x01)};
+    for (int i = 0; i < 2; ++i) {
+        bool match;
+        BOOST_CHECK(filter_index.LookupFilterMatchAny(block_index, elements, match));
+        BOOST_CHECK_EQUAL(match, expected_filter.GetFilter().MatchAny(elements));
+    }
+
     filters.clear();
     filter_hashes.clear();
     last_header = filter_header;
@@ -266,6 +274,38 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_parallel_sync, BuildChainTestingSetup)
+{
+    // Sync with several worker threads reading and building filters out of order. The filter
+    // header chain must come out the same as with a sequential sync.
+    const int saved_sync_threads = g_index_sync_threads;
+    g_index_sync_threads = 4;
+
+    BlockFilterIndex filter_index(BlockFilterType::BASIC, 1 << 20, true);
+    filter_index.Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+
+    {
+        LOCK(cs_main);
+        uint256 last_header;
+        for (const CBlockIndex* block_index = ::ChainActive().Genesis();
+             block_index != nullptr;
+             block_index = ::ChainActive().Next(block_index)) {
+            CheckFilterLookups(filter_index, block_index, last_header);
+        }
+    }
+
+    filter_index.Stop();
+    SyncWithValidationInterfaceQueue();
+    g_index_sync_threads = saved_sync_threads;
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
@@ -10,6 +10,7 @@
 #include <serialize.h>
 #include <streams.h>
 #include <univalue.h>
+#include <util/golombrice.h>
 #include <util/strencodings.h>
 
 #include <boost/test/unit_test.hpp>
@@ -39,6 +40,83 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(golombrice_word_codec)
+{
+    for (uint8_t P : {0, 1, 19, 20, 57, 63}) {
+        std::vector<uint64_t> values;
+        for (int i = 0; i < 200; ++i) {
+            // Keep quotients small enough to not blow up the encoding, but cover multi-word runs.
+            values.push_back(InsecureRandBits(std::min(P + (i % 8), 64)));
+        }
+
+        std::vector<unsigned char> expected, encoded;
+        {
+            CVectorWriter stream(SER_NETWORK, 0, expected, 0);
+            BitStreamWriter<CVectorWriter> bitwriter(stream);
+            for (uint64_t value : values) GolombRiceEncode(bitwriter, P, value);
+            bitwriter.Flush();
+        }
+        GolombRiceWriter writer(encoded);
+        for (uint64_t value : values) writer.Encode(P, value);
+        writer.Flush();
+        BOOST_CHECK(encoded == expected);
+
+        GolombRiceReader reader(encoded);
+        for (uint64_t value : values) BOOST_CHECK_EQUAL(reader.Decode(P), value);
+        BOOST_CHECK_EQUAL(reader.GetUnreadBytes(), 0U);
+        BOOST_CHECK_THROW(reader.Decode(P), std::ios_base::failure);
+    }
+
+    // A long run of ones spanning several buffer refills.
+    std::vector<unsigned char> encoded;
+    GolombRiceWriter writer(encoded);
+    writer.Encode(2, 1000);
+    writer.Encode(2, 3);
+    writer.Flush();
+    GolombRiceReader reader(encoded);
+    BOOST_CHECK_EQUAL(reader.Decode(2), 1000U);
+    BOOST_CHECK_EQUAL(reader.Decode(2), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_decoded_match)
+{
+    GCSFilter::ElementSet included_elements, excluded_elements;
+    for (int i = 0; i < 100; ++i) {
+        GCSFilter::Element element1(32);
+        element1[0] = i;
+        included_elements.insert(std::move(element1));
+
+        GCSFilter::Element element2(32);
+        element2[1] = i;
+        excluded_elements.insert(std::move(element2));
+    }
+
+    GCSFilter filter({0, 0, 10, 1 << 10}, included_elements);
+    const std::vector<uint64_t> hashes = filter.DecodeElementHashes();
+    BOOST_CHECK_EQUAL(hashes.size(), filter.GetN());
+    BOOST_CHECK(std::is_sorted(hashes.begin(), hashes.end()));
+
+    BOOST_CHECK_EQUAL(filter.MatchAny(excluded_elements, hashes), filter.MatchAny(excluded_elements));
+    for (const auto& element : included_elements) {
+        auto insertion = excluded_elements.insert(element);
+        BOOST_CHECK(filter.MatchAny(excluded_elements, hashes));
+        excluded_elements.erase(insertion.first);
+    }
+
+    // Reconstructing from the encoding, with or without the decode check, yields the same filter.
+    GCSFilter checked(filter.GetParams(), filter.GetEncoded());
+    GCSFilter unchecked(filter.GetParams(), filter.GetEncoded(), /* skip_decode_check */ true);
+    BOOST_CHECK(checked.DecodeElementHashes() == hashes);
+    BOOST_CHECK(unchecked.DecodeElementHashes() == hashes);
+
+    // Excess or missing data is still rejected by the decode check.
+    std::vector<unsigned char> encoded = filter.GetEncoded();
+    encoded.push_back(0);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), encoded), std::ios_base::failure);
+    encoded.resize(encoded.size() - 2);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), encoded), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor)
 {
     GCSFilter filter;
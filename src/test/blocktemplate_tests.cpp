@@ -0,0 +1,229 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <hash.h>
+#include <key.h>
+#include <miner.h>
+#include <node/blocktemplate.h>
+#include <pow.h>
+#include <scheduler.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+#include <validationinterface.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+
+BOOST_FIXTURE_TEST_SUITE(blocktemplate_tests, TestChain100Setup)
+
+namespace {
+
+std::set<uint256> TemplateTxids(const CBlockTemplate& blocktemplate)
+{
+    std::set<uint256> txids;
+    for (const CTransactionRef& tx : blocktemplate.block.vtx) {
+        if (!tx->IsCoinBase() && !tx->IsHogEx()) txids.insert(tx->GetHash());
+    }
+    return txids;
+}
+
+// Spend output n of prev_tx, which pays to the P2PK script of key, into two outputs paying the given fee
+CTransactionRef Spend(CTxMemPool& mempool, const CKey& key, const CTransactionRef& prev_tx, uint32_t n, CAmount fee)
+{
+    const CScript p2pk_scriptPubKey = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction tx;
+    tx.nVersion = 1;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(prev_tx->GetHash(), n);
+    tx.vout.resize(2);
+    tx.vout[0].nValue = (prev_tx->vout[n].nValue - fee) / 2;
+    tx.vout[0].scriptPubKey = p2pk_scriptPubKey;
+    tx.vout[1].nValue = prev_tx->vout[n].nValue - fee - tx.vout[0].nValue;
+    tx.vout[1].scriptPubKey = p2pk_scriptPubKey;
+
+    std::vector<unsigned char> vchSig;
+    const uint256 hash = SignatureHash(p2pk_scriptPubKey, tx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig << vchSig;
+
+    const CTransactionRef ptx = MakeTransactionRef(tx);
+    LOCK(cs_main);
+    TxValidationState state;
+    BOOST_CHECK(AcceptToMemoryPool(mempool, state, ptx, nullptr /* plTxnReplaced */, true /* bypass_limits */));
+    return ptx;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(incremental_updates)
+{
+    const CScript p2pk_scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CTxMemPool& mempool = *m_node.mempool;
+
+    BlockTemplateUpdater updater(mempool, Params());
+    RegisterValidationInterface(&updater);
+    int64_t now = GetTime();
+    SetMockTime(now);
+
+    auto blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK(TemplateTxids(*blocktemplate).empty());
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 1U);
+
+    // A new transaction and then its child are appended to the template
+    const CTransactionRef parent = Spend(mempool, coinbaseKey, m_coinbase_txns[0], 0, 10000);
+    SyncWithValidationInterfaceQueue();
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK(TemplateTxids(*blocktemplate) == std::set<uint256>{parent->GetHash()});
+
+    const CTransactionRef child = Spend(mempool, coinbaseKey, parent, 0, 20000);
+    const CTransactionRef other = Spend(mempool, coinbaseKey, parent, 1, 5000);
+    SyncWithValidationInterfaceQueue();
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 1U);
+    BOOST_CHECK_EQUAL(updater.GetStats().incremental_updates, 2U);
+    BOOST_CHECK_EQUAL(updater.GetStats().packages_appended, 3U);
+    BOOST_CHECK(TemplateTxids(*blocktemplate) == (std::set<uint256>{parent->GetHash(), child->GetHash(), other->GetHash()}));
+    BOOST_CHECK(blocktemplate->block.vtx[1] == parent);
+    BOOST_CHECK(blocktemplate->block.vtx[2] == child);
+    BOOST_CHECK_EQUAL(blocktemplate->vTxFees[0], -35000);
+
+    // The updated template holds the same transactions as one assembled from scratch, and is valid
+    const auto fresh = BlockAssembler(mempool, Params()).CreateNewBlock(p2pk_scriptPubKey);
+    BOOST_CHECK(TemplateTxids(*blocktemplate) == TemplateTxids(*fresh));
+    {
+        LOCK(cs_main);
+        BlockValidationState state;
+        BOOST_CHECK(TestBlockValidity(state, Params(), blocktemplate->block, ::ChainActive().Tip(), false, false));
+    }
+
+    // Without changes, the template is only finished again
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 1U);
+    BOOST_CHECK_EQUAL(updater.GetStats().incremental_updates, 3U);
+
+    // Prioritising a transaction changes the mempool without a notification,
+    // which is only picked up once a rebuild is allowed again
+    mempool.PrioritiseTransaction(other->GetHash(), 1000);
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 1U);
+    now += BlockTemplateUpdater::MIN_REBUILD_INTERVAL;
+    SetMockTime(now);
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 2U);
+    BOOST_CHECK_EQUAL(TemplateTxids(*blocktemplate).size(), 3U);
+
+    // Removing a transaction in the template starts over, too
+    WITH_LOCK(mempool.cs, mempool.removeRecursive(*child, MemPoolRemovalReason::REPLACED));
+    SyncWithValidationInterfaceQueue();
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 2U);
+    BOOST_CHECK_EQUAL(TemplateTxids(*blocktemplate).size(), 3U);
+    now += BlockTemplateUpdater::MIN_REBUILD_INTERVAL;
+    SetMockTime(now);
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 3U);
+    BOOST_CHECK(TemplateTxids(*blocktemplate) == (std::set<uint256>{parent->GetHash(), other->GetHash()}));
+
+    // A new tip, on which the template now builds, is picked up right away
+    CreateAndProcessBlock({}, p2pk_scriptPubKey);
+    blocktemplate = updater.GetBlockTemplate(p2pk_scriptPubKey);
+    BOOST_CHECK_EQUAL(updater.GetStats().full_rebuilds, 4U);
+    BOOST_CHECK(blocktemplate->block.hashPrevBlock == WITH_LOCK(cs_main, return ::ChainActive().Tip()->GetBlockHash()));
+
+    SetMockTime(0);
+    UnregisterValidationInterface(&updater);
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(binary_templates)
+{
+    const CScript p2pk_scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CTxMemPool& mempool = *m_node.mempool;
+
+    BlockTemplateUpdater updater(mempool, Params());
+    RegisterValidationInterface(&updater);
+    // Templates are made on request here, rather than by the periodic check
+    CScheduler scheduler;
+    BlockTemplateProvider provider(updater, mempool, scheduler, 10000);
+    std::vector<uint64_t> published;
+    provider.AddListener([&](const BinaryBlockTemplate& blocktemplate) { published.push_back(blocktemplate.id); });
+
+    const CTransactionRef parent = Spend(mempool, coinbaseKey, m_coinbase_txns[0], 0, 10000);
+    SyncWithValidationInterfaceQueue();
+    auto blocktemplate = provider.GetTemplate();
+    BOOST_CHECK_EQUAL(blocktemplate->id, 1U);
+    BOOST_CHECK_EQUAL(blocktemplate->height, WITH_LOCK(cs_main, return ::ChainActive().Height()) + 1);
+    BOOST_CHECK(blocktemplate->hogex_hash.IsNull());
+    BOOST_CHECK(provider.GetTemplate() == blocktemplate);
+
+    // The template survives serialization
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << *blocktemplate;
+    BinaryBlockTemplate decoded;
+    ss >> decoded;
+    BOOST_CHECK(decoded.prev_hash == blocktemplate->prev_hash);
+    BOOST_CHECK(decoded.coinbase_outputs == blocktemplate->coinbase_outputs);
+    BOOST_CHECK(decoded.merkle_branch == blocktemplate->merkle_branch);
+
+    // A small fee increase doesn't make a new template, a large one does
+    const CTransactionRef small = Spend(mempool, coinbaseKey, parent, 0, 5000);
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(provider.GetTemplate()->id, 1U);
+    Spend(mempool, coinbaseKey, parent, 1, 20000);
+    SyncWithValidationInterfaceQueue();
+    blocktemplate = provider.GetTemplate();
+    BOOST_CHECK_EQUAL(blocktemplate->id, 2U);
+    BOOST_CHECK(published == (std::vector<uint64_t>{1, 2}));
+    BOOST_CHECK(provider.GetBlock(1) != nullptr);
+    BOOST_CHECK(provider.GetBlock(3) == nullptr);
+
+    // A miner builds its own coinbase from the template, and gets the merkle root from the branch
+    CMutableTransaction coinbase;
+    coinbase.nVersion = blocktemplate->coinbase_version;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript(blocktemplate->coinbase_prefix.begin(), blocktemplate->coinbase_prefix.end()) << OP_0;
+    coinbase.vin[0].nSequence = blocktemplate->coinbase_sequence;
+    coinbase.vout.emplace_back(blocktemplate->coinbase_value, p2pk_scriptPubKey);
+    coinbase.vout.insert(coinbase.vout.end(), blocktemplate->coinbase_outputs.begin(), blocktemplate->coinbase_outputs.end());
+    coinbase.nLockTime = blocktemplate->coinbase_locktime;
+    uint256 merkle_root = coinbase.GetHash();
+    for (const uint256& hash : blocktemplate->merkle_branch) {
+        merkle_root = Hash(merkle_root, hash);
+    }
+
+    auto block = std::make_shared<CBlock>(provider.GetBlock(blocktemplate->id)->block);
+    // The witness commitment needs the reserved value
+    coinbase.vin[0].scriptWitness = block->vtx[0]->vin[0].scriptWitness;
+    block->vtx[0] = MakeTransactionRef(coinbase);
+    BOOST_CHECK(BlockMerkleRoot(*block) == merkle_root);
+    BOOST_CHECK_EQUAL(block->vtx.size(), 4U);
+    BOOST_CHECK(std::find(block->vtx.begin(), block->vtx.end(), small) != block->vtx.end());
+
+    block->hashMerkleRoot = merkle_root;
+    while (!CheckProofOfWork(block->GetPoWHash(), block->nBits, Params().GetConsensus())) ++block->nNonce;
+    BOOST_CHECK(Assert(m_node.chainman)->ProcessNewBlock(Params(), block, true, nullptr));
+    BOOST_CHECK(WITH_LOCK(cs_main, return ::ChainActive().Tip()->GetBlockHash()) == block->GetHash());
+
+    // Solutions for the old tip are gone with the next template
+    SyncWithValidationInterfaceQueue();
+    blocktemplate = provider.GetTemplate();
+    BOOST_CHECK_EQUAL(blocktemplate->id, 3U);
+    BOOST_CHECK(blocktemplate->prev_hash == block->GetHash());
+    BOOST_CHECK(provider.GetBlock(2) == nullptr);
+
+    UnregisterValidationInterface(&updater);
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -159,6 +159,79 @@ BOOST_AUTO_TEST_CASE(dbwrapper_batch)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_table_cache)
+{
+    // Perform tests both obfuscated and non-obfuscated.
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = GetDataDir() / (obfuscate ? "dbwrapper_table_cache_obfuscate_true" : "dbwrapper_table_cache_obfuscate_false");
+        CDBWrapper dbw(ph, (1 << 20), true, false, obfuscate);
+        dbw.AddTableCache("t", [](const leveldb::Slice& key) { return key.size() > 0 && key[0] == 't'; }, 1 << 10);
+
+        std::vector<std::pair<char, uint256>> keys;
+        for (int i = 0; i < 20; ++i) keys.emplace_back('t', uint256(std::vector<unsigned char>(32, i)));
+        const char other_key = 'o';
+
+        uint256 in = InsecureRand256();
+        uint256 res;
+        BOOST_CHECK(dbw.Write(keys[0], in));
+        BOOST_CHECK(dbw.Write(other_key, in));
+
+        // The first read misses, the second is served from the cache.
+        BOOST_CHECK(dbw.Read(keys[0], res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+        BOOST_CHECK(dbw.Read(keys[0], res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+        BOOST_CHECK(dbw.Read(other_key, res));
+
+        std::vector<DBTableCacheStats> stats = dbw.GetTableCacheStats();
+        BOOST_REQUIRE_EQUAL(stats.size(), 1U);
+        BOOST_CHECK_EQUAL(stats[0].name, "t");
+        BOOST_CHECK_EQUAL(stats[0].entries, 1U);
+        BOOST_CHECK_EQUAL(stats[0].hits, 1U);
+        BOOST_CHECK_EQUAL(stats[0].misses, 1U);
+
+        // Writes and erases of cached keys are reflected in later reads.
+        uint256 in2 = InsecureRand256();
+        BOOST_CHECK(dbw.Write(keys[0], in2));
+        BOOST_CHECK(dbw.Read(keys[0], res));
+        BOOST_CHECK_EQUAL(res.ToString(), in2.ToString());
+        BOOST_CHECK(dbw.Erase(keys[0]));
+        BOOST_CHECK(!dbw.Read(keys[0], res));
+        BOOST_CHECK(!dbw.Exists(keys[0]));
+
+        // The cache stays within its size limit.
+        for (const auto& key : keys) {
+            BOOST_CHECK(dbw.Write(key, in));
+            BOOST_CHECK(dbw.Read(key, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+        }
+        stats = dbw.GetTableCacheStats();
+        BOOST_CHECK(stats[0].usage <= stats[0].max_usage);
+        BOOST_CHECK(stats[0].entries < keys.size());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    BOOST_CHECK(FindDBProfile(DEFAULT_DB_PROFILE) != nullptr);
+    BOOST_CHECK(FindDBProfile("hdd") != nullptr);
+    BOOST_CHECK(FindDBProfile("unknown") == nullptr);
+    BOOST_CHECK_EQUAL(std::string(GetDBProfile().name), DEFAULT_DB_PROFILE);
+
+    // The default profile splits the cache as before profiles existed
+    const DBProfile& def = GetDBProfile();
+    BOOST_CHECK_EQUAL(def.block_cache_percent, 50);
+    BOOST_CHECK_EQUAL(def.write_buffer_percent, 25);
+    BOOST_CHECK_EQUAL(def.table_cache_percent, 0);
+
+    for (const char* name : {"hdd", "readheavy"}) {
+        const DBProfile* profile = FindDBProfile(name);
+        BOOST_REQUIRE(profile);
+        BOOST_CHECK(ListDBProfiles().find(name) != std::string::npos);
+        BOOST_CHECK(profile->block_cache_percent + 2 * profile->write_buffer_percent <= 100);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
     // Perform tests both obfuscated and non-obfuscated.
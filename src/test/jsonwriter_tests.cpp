@@ -0,0 +1,195 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <consensus/merkle.h>
+#include <mw/consensus/Aggregation.h>
+#include <primitives/block.h>
+#include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <test_framework/models/Tx.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+/** Sink that records every chunk and drain call */
+class RecordingSink final : public JSONStreamSink
+{
+public:
+    std::string str;
+    size_t chunks{0};
+    size_t drains{0};
+
+    void Write(std::string&& chunk) override
+    {
+        str += chunk;
+        ++chunks;
+    }
+    void Drain() override { ++drains; }
+};
+
+/** Write value with JSONWriter calls, descending into objects and arrays */
+void WriteValue(JSONWriter& writer, const UniValue& value)
+{
+    if (value.isObject()) {
+        writer.BeginObject();
+        for (size_t i = 0; i < value.size(); ++i) {
+            writer.Key(value.getKeys()[i]);
+            WriteValue(writer, value[i]);
+        }
+        writer.EndObject();
+    } else if (value.isArray()) {
+        writer.BeginArray();
+        for (size_t i = 0; i < value.size(); ++i) {
+            WriteValue(writer, value[i]);
+        }
+        writer.EndArray();
+    } else {
+        writer.Value(value);
+    }
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(jsonwriter_tests, TestingSetup)
+
+BOOST_AUTO_TEST_CASE(jsonwriter_matches_univalue)
+{
+    UniValue value;
+    BOOST_REQUIRE(value.read("{\"a\":1,\"b\":[],\"c\":{},\"d\":[1,\"x\",null,true,false,{\"e\":[[]]}],"
+                             "\"esc\\\"aped\\n\":\"\\u0001\\\\\\t\",\"f\":-0.5,\"g\":{\"h\":{\"i\":[{},[]]}}}"));
+    for (size_t chunk_size : {1, 7, 4096}) {
+        RecordingSink sink;
+        {
+            JSONWriter writer(sink, chunk_size);
+            WriteValue(writer, value);
+            writer.Raw("\n");
+        }
+        BOOST_CHECK_EQUAL(sink.str, value.write() + "\n");
+        if (chunk_size == 1) BOOST_CHECK(sink.chunks > 1);
+    }
+
+    // Scalars and empty containers at the top level
+    for (const char* json : {"[]", "{}", "null", "\"str\"", "42"}) {
+        UniValue v;
+        BOOST_REQUIRE(v.read(json));
+        JSONStringSink sink;
+        {
+            JSONWriter writer(sink);
+            WriteValue(writer, v);
+        }
+        BOOST_CHECK_EQUAL(sink.str, v.write());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(jsonwriter_block)
+{
+    const CBlock block = getBlock13b8a();
+    const uint256 hash = block.GetHash();
+    CBlockIndex blockindex;
+    blockindex.phashBlock = &hash;
+    blockindex.nBits = block.nBits;
+
+    RecordingSink sink;
+    {
+        JSONWriter writer(sink, 256);
+        blockToJSON(writer, block, &blockindex, &blockindex);
+    }
+    BOOST_CHECK_EQUAL(sink.str, blockToJSON(block, &blockindex, &blockindex, /* txDetails */ true).write());
+    BOOST_CHECK_EQUAL(sink.drains, block.vtx.size());
+    BOOST_CHECK(sink.chunks > 1);
+}
+
+BOOST_AUTO_TEST_CASE(jsonwriter_mweb_block)
+{
+    CBlock block = getBlock13b8a();
+    block.vtx.resize(2);
+
+    // A peg-in, and a peg-out spending an MWEB output
+    const test::Tx pegin = test::Tx::CreatePegIn(1000);
+    const test::Tx pegout = test::Tx::CreatePegOut(test::Tx::CreatePegIn(5000).GetOutputs().front(), 100);
+    CMutableTransaction pegin_tx;
+    pegin_tx.vin.emplace_back(COutPoint(block.vtx[1]->GetHash(), 0));
+    pegin_tx.vout.emplace_back(1000, GetScriptForPegin(pegin.GetKernels().front().GetKernelID()));
+    pegin_tx.mweb_tx = MWEB::Tx(pegin.GetTransaction());
+    block.vtx.push_back(MakeTransactionRef(pegin_tx));
+    CMutableTransaction pegout_tx;
+    pegout_tx.mweb_tx = MWEB::Tx(pegout.GetTransaction());
+    block.vtx.push_back(MakeTransactionRef(pegout_tx));
+    CMutableTransaction hogex;
+    hogex.vin.emplace_back(COutPoint(pegin_tx.GetHash(), 0));
+    hogex.vout.emplace_back(1000, CScript() << OP_TRUE);
+    hogex.m_hogEx = true;
+    block.vtx.push_back(MakeTransactionRef(hogex));
+
+    const mw::Transaction::CPtr body = Aggregation::Aggregate({pegin.GetTransaction(), pegout.GetTransaction()});
+    const auto header = std::make_shared<mw::Header>(1, mw::Hash::ValueOf(1), mw::Hash::ValueOf(2), mw::Hash::ValueOf(3),
+        body->GetKernelOffset(), body->GetStealthOffset(), 2, 2);
+    block.mweb_block = MWEB::Block(std::make_shared<mw::Block>(header, body->GetBody()));
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    const mw::Block& mweb_block = *block.mweb_block.m_block;
+    BOOST_REQUIRE_EQUAL(mweb_block.GetInputs().size(), 1U);
+    BOOST_REQUIRE_EQUAL(mweb_block.GetOutputs().size(), 1U);
+    BOOST_REQUIRE_EQUAL(mweb_block.GetKernels().size(), 2U);
+
+    const uint256 hash = block.GetHash();
+    CBlockIndex blockindex;
+    blockindex.phashBlock = &hash;
+    blockindex.nBits = block.nBits;
+    blockindex.mweb_header = header;
+    blockindex.mweb_amount = 1000;
+
+    RecordingSink sink;
+    {
+        JSONWriter writer(sink, 256);
+        blockToJSON(writer, block, &blockindex, &blockindex);
+    }
+    const UniValue expected = blockToJSON(block, &blockindex, &blockindex, /* txDetails */ true);
+    BOOST_CHECK(expected.exists("mweb"));
+    BOOST_CHECK_EQUAL(sink.str, expected.write());
+    // One drain per transaction and per MWEB input, output and kernel
+    BOOST_CHECK_EQUAL(sink.drains, block.vtx.size() + mweb_block.GetInputs().size() + mweb_block.GetOutputs().size() + mweb_block.GetKernels().size());
+}
+
+BOOST_AUTO_TEST_CASE(jsonwriter_mempool)
+{
+    CTxMemPool& pool = *m_node.mempool;
+    TestMemPoolEntryHelper entry;
+    {
+        LOCK2(cs_main, pool.cs);
+        CMutableTransaction parent;
+        parent.vin.resize(1);
+        parent.vin[0].scriptSig = CScript() << OP_11;
+        parent.vout.resize(3);
+        for (int i = 0; i < 3; ++i) {
+            parent.vout[i].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+            parent.vout[i].nValue = 33000LL;
+        }
+        pool.addUnchecked(entry.Fee(10000LL).FromTx(parent));
+        for (int i = 0; i < 3; ++i) {
+            CMutableTransaction child;
+            child.vin.resize(1);
+            child.vin[0].prevout = COutPoint(parent.GetHash(), i);
+            child.vout.resize(1);
+            child.vout[0].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+            child.vout[0].nValue = 11000LL;
+            pool.addUnchecked(entry.Fee(1000LL * (i + 1)).FromTx(child));
+        }
+    }
+
+    JSONStringSink sink;
+    {
+        JSONWriter writer(sink);
+        MempoolToJSON(writer, pool);
+    }
+    BOOST_CHECK_EQUAL(sink.str, MempoolToJSON(pool, /* verbose */ true).write());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
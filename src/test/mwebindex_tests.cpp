@@ -0,0 +1,205 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <index/mwebindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <mw/crypto/Hasher.h>
+#include <mw/crypto/SecretKeys.h>
+#include <test_framework/TxBuilder.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(mwebindex_tests)
+
+static void WaitForSync(MWEBIndex& mwebindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!mwebindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(mwebindex_initial_sync, TestChain100Setup)
+{
+    MWEBIndex mwebindex(1 << 20, true);
+
+    // BlockUntilSyncedToCurrentChain should return false before mwebindex is started.
+    BOOST_CHECK(!mwebindex.BlockUntilSyncedToCurrentChain());
+
+    mwebindex.Start();
+
+    // Allow the index to catch up with the block index.
+    WaitForSync(mwebindex);
+
+    // Blocks without MWEB data are indexed without producing any entries.
+    IndexSummary summary = mwebindex.GetSummary();
+    BOOST_CHECK(summary.synced);
+    BOOST_CHECK_EQUAL(summary.best_block_height, ::ChainActive().Height());
+
+    MWEBIndexPos pos;
+    const mw::Hash unknown_id = mw::Hash::ValueOf(1);
+    BOOST_CHECK(!mwebindex.FindKernel(unknown_id, pos));
+    BOOST_CHECK(!mwebindex.FindOutput(unknown_id, pos));
+    BOOST_CHECK(!mwebindex.FindSpentOutput(unknown_id, pos));
+
+    // New blocks connected after the initial sync keep the index in sync.
+    CScript coinbase_script_pub_key = GetScriptForDestination(PKHash(coinbaseKey.GetPubKey()));
+    std::vector<CMutableTransaction> no_txns;
+    CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+    BOOST_CHECK(mwebindex.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(mwebindex.GetSummary().best_block_height, ::ChainActive().Height());
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    mwebindex.Stop();
+
+    // Let scheduler events finish running to avoid accessing any memory related to mwebindex after it is destructed
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_FIXTURE_TEST_CASE(mwebindex_mweb_data, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    const CScript p2pk_scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Mine a block on the mempool, which includes the HogEx once MWEB is active
+    const auto mine = [&]() {
+        auto block = std::make_shared<CBlock>(BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(p2pk_scriptPubKey)->block);
+        block->hashMerkleRoot = BlockMerkleRoot(*block);
+        while (!CheckProofOfWork(block->GetPoWHash(), block->nBits, chainparams.GetConsensus())) ++block->nNonce;
+        BOOST_REQUIRE(Assert(m_node.chainman)->ProcessNewBlock(chainparams, block, true, nullptr));
+        return block;
+    };
+    const auto accept = [&](const CMutableTransaction& mtx) {
+        LOCK(cs_main);
+        TxValidationState state;
+        const bool accepted = AcceptToMemoryPool(*m_node.mempool, state, MakeTransactionRef(mtx), nullptr /* plTxnReplaced */, true /* bypass_limits */);
+        BOOST_REQUIRE_MESSAGE(accepted, state.ToString());
+    };
+    // Peg the output of a coinbase transaction, less a fee, into an MWEB output to the receiver
+    const auto peg_in = [&](const CTransactionRef& coinbase, const StealthAddress& receiver) {
+        const CAmount amount = coinbase->vout[0].nValue - 10000;
+        const test::Tx pegin = test::TxBuilder()
+            .AddPeginKernel(amount)
+            .AddOutput(amount, SecretKey::Random(), receiver)
+            .Build();
+        CMutableTransaction mtx;
+        mtx.nVersion = 2;
+        mtx.vin.emplace_back(COutPoint(coinbase->GetHash(), 0));
+        mtx.vout.emplace_back(amount, GetScriptForPegin(pegin.GetKernels().front().GetKernelID()));
+        mtx.mweb_tx = MWEB::Tx(pegin.GetTransaction());
+
+        std::vector<unsigned char> sig;
+        const uint256 hash = SignatureHash(p2pk_scriptPubKey, mtx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+        sig.push_back((unsigned char)SIGHASH_ALL);
+        mtx.vin[0].scriptSig << sig;
+        accept(mtx);
+        return pegin;
+    };
+
+    while (!IsMWEBEnabled(WITH_LOCK(cs_main, return ::ChainActive().Tip()), chainparams.GetConsensus())) {
+        mine();
+    }
+
+    // Two outputs are pegged in, and one of them is pegged out again in the next block.
+    // It is sent to a stealth address whose keys are known here, so it can be spent.
+    const SecretKey scan_secret = SecretKey::Random();
+    const SecretKey spend_secret = SecretKey::Random();
+    const PublicKey spend_pubkey = PublicKey::From(spend_secret);
+    const test::Tx pegin_spent = peg_in(m_coinbase_txns[0], StealthAddress(spend_pubkey.Mul(scan_secret), spend_pubkey));
+    const test::Tx pegin_unspent = peg_in(m_coinbase_txns[1], StealthAddress::Random());
+    const std::shared_ptr<CBlock> pegin_block = mine();
+    BOOST_REQUIRE(!pegin_block->mweb_block.IsNull());
+    BOOST_REQUIRE_EQUAL(pegin_block->mweb_block.m_block->GetOutputs().size(), 2U);
+
+    // The output key is derived as the wallet does, c.f. mw::Keychain
+    const test::TxOutput& spent_output = pegin_spent.GetOutputs().front();
+    const SecretKey shared_secret = Hashed(EHashTag::DERIVE, spent_output.GetOutput().Ke().Mul(scan_secret));
+    const SecretKey output_key = SecretKeys::From(spend_secret).Mul(Hashed(EHashTag::OUT_KEY, shared_secret)).Total();
+    const CAmount pegout_fee = 100000;
+    const test::Tx pegout = test::TxBuilder()
+        .AddInput(spent_output.GetAmount(), output_key, spent_output.GetBlind(), spent_output.GetOutputID())
+        .AddPegoutKernel(spent_output.GetAmount() - pegout_fee, pegout_fee, true)
+        .Build();
+    CMutableTransaction pegout_tx;
+    pegout_tx.nVersion = 2;
+    pegout_tx.mweb_tx = MWEB::Tx(pegout.GetTransaction());
+    accept(pegout_tx);
+    const std::shared_ptr<CBlock> pegout_block = mine();
+    BOOST_REQUIRE(!pegout_block->mweb_block.IsNull());
+    BOOST_REQUIRE_EQUAL(pegout_block->mweb_block.m_block->GetInputs().size(), 1U);
+    mine();
+
+    // The index catches up with the chain, MWEB blocks included
+    MWEBIndex mwebindex(1 << 20, true);
+    mwebindex.Start();
+    WaitForSync(mwebindex);
+
+    const auto block_height = [](const uint256& block_hash) {
+        LOCK(cs_main);
+        const CBlockIndex* pindex = LookupBlockIndex(block_hash);
+        BOOST_REQUIRE(pindex);
+        return pindex->nHeight;
+    };
+    const int pegin_height = block_height(pegin_block->GetHash());
+    const int pegout_height = block_height(pegout_block->GetHash());
+    BOOST_CHECK_EQUAL(pegout_height, pegin_height + 1);
+
+    // A kernel
+    MWEBIndexPos pos;
+    const mw::Hash pegout_kernel_id = pegout.GetKernels().front().GetKernelID();
+    BOOST_REQUIRE(mwebindex.FindKernel(pegout_kernel_id, pos));
+    BOOST_CHECK(pos.block_hash == pegout_block->GetHash());
+    BOOST_CHECK_EQUAL(block_height(pos.block_hash), pegout_height);
+    BOOST_CHECK(pegout_block->mweb_block.m_block->GetKernels().at(pos.position).GetKernelID() == pegout_kernel_id);
+
+    // An unspent output
+    const mw::Hash& unspent_id = pegin_unspent.GetOutputs().front().GetOutputID();
+    BOOST_REQUIRE(mwebindex.FindOutput(unspent_id, pos));
+    BOOST_CHECK(pos.block_hash == pegin_block->GetHash());
+    BOOST_CHECK_EQUAL(block_height(pos.block_hash), pegin_height);
+    BOOST_CHECK(pegin_block->mweb_block.m_block->GetOutputs().at(pos.position).GetOutputID() == unspent_id);
+    BOOST_CHECK(!mwebindex.FindSpentOutput(unspent_id, pos));
+
+    // A spent output, which is found both where it was created and where it was spent
+    const mw::Hash& spent_id = spent_output.GetOutputID();
+    BOOST_REQUIRE(mwebindex.FindOutput(spent_id, pos));
+    BOOST_CHECK(pos.block_hash == pegin_block->GetHash());
+    BOOST_CHECK_EQUAL(block_height(pos.block_hash), pegin_height);
+    BOOST_CHECK(pegin_block->mweb_block.m_block->GetOutputs().at(pos.position).GetOutputID() == spent_id);
+    BOOST_REQUIRE(mwebindex.FindSpentOutput(spent_id, pos));
+    BOOST_CHECK(pos.block_hash == pegout_block->GetHash());
+    BOOST_CHECK_EQUAL(block_height(pos.block_hash), pegout_height);
+    BOOST_CHECK(pegout_block->mweb_block.m_block->GetInputs().at(pos.position).GetOutputID() == spent_id);
+
+    mwebindex.Stop();
+    SyncWithValidationInterfaceQueue();
+}
+
+BOOST_AUTO_TEST_CASE(mwebindex_pos_serialization)
+{
+    const MWEBIndexPos pos(uint256S("0x1234"), 300);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << pos;
+
+    MWEBIndexPos pos_read;
+    ss >> pos_read;
+    BOOST_CHECK(pos_read.block_hash == pos.block_hash);
+    BOOST_CHECK_EQUAL(pos_read.position, pos.position);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
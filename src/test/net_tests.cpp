@@ -9,6 +9,7 @@
 #include <cstdint>
 #include <net.h>
 #include <netbase.h>
+#include <netmessagemaker.h>
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
@@ -769,4 +770,66 @@ BOOST_AUTO_TEST_CASE(PoissonNextSend)
     g_mock_deterministic_tests = false;
 }
 
+BOOST_AUTO_TEST_CASE(recv_buffer_pool)
+{
+    RecvBufferPool pool;
+
+    CSerializeData buffer = pool.Get(100);
+    BOOST_CHECK(buffer.empty());
+    BOOST_CHECK_EQUAL(buffer.capacity(), MIN_POOLED_RECV_BUFFER_SIZE);
+    const char* data = buffer.data();
+    buffer.resize(100);
+    pool.Put(std::move(buffer));
+    RecvBufferPoolStats stats = pool.GetStats();
+    BOOST_CHECK_EQUAL(stats.allocations, 1U);
+    BOOST_CHECK_EQUAL(stats.free_buffers, 1U);
+    BOOST_CHECK_EQUAL(stats.usage, MIN_POOLED_RECV_BUFFER_SIZE);
+
+    // A buffer of the same size class is reused, emptied
+    buffer = pool.Get(MIN_POOLED_RECV_BUFFER_SIZE);
+    BOOST_CHECK(buffer.empty());
+    BOOST_CHECK(buffer.data() == data);
+    stats = pool.GetStats();
+    BOOST_CHECK_EQUAL(stats.reuses, 1U);
+    BOOST_CHECK_EQUAL(stats.free_buffers, 0U);
+    BOOST_CHECK_EQUAL(stats.usage, 0U);
+
+    // Larger sizes get a buffer of their own class
+    pool.Put(std::move(buffer));
+    CSerializeData large = pool.Get(MIN_POOLED_RECV_BUFFER_SIZE + 1);
+    BOOST_CHECK_EQUAL(large.capacity(), 2 * MIN_POOLED_RECV_BUFFER_SIZE);
+    BOOST_CHECK_EQUAL(pool.GetStats().allocations, 2U);
+
+    // Buffers outside of the pooled sizes are not kept
+    CSerializeData huge = pool.Get(MAX_POOLED_RECV_BUFFER_SIZE + 1);
+    BOOST_CHECK(huge.capacity() > MAX_POOLED_RECV_BUFFER_SIZE);
+    pool.Put(std::move(huge));
+    pool.Put(CSerializeData(10));
+    BOOST_CHECK_EQUAL(pool.GetStats().free_buffers, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(recv_buffer_reuse)
+{
+    // Messages received one after another are read into the same buffer
+    V1TransportDeserializer deserializer{Params(), 0, SER_NETWORK, INIT_PROTO_VERSION};
+    const std::vector<unsigned char> payload(1000, 0x42);
+    CSerializedNetMsg msg = CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::PING, payload);
+    std::vector<unsigned char> header;
+    V1TransportSerializer().prepareForTransport(msg, header);
+
+    const char* prev_data = nullptr;
+    for (int i = 0; i < 3; ++i) {
+        deserializer.Read((const char*)header.data(), header.size());
+        deserializer.Read((const char*)msg.data.data(), msg.data.size());
+        BOOST_REQUIRE(deserializer.Complete());
+        uint32_t out_err_raw_size{0};
+        Optional<CNetMessage> result = deserializer.GetMessage(GetTime<std::chrono::microseconds>(), out_err_raw_size);
+        BOOST_REQUIRE(result);
+        BOOST_CHECK_EQUAL(result->m_command, NetMsgType::PING);
+        BOOST_CHECK(std::equal(payload.begin(), payload.end(), result->m_recv.begin() + 3));
+        if (prev_data) BOOST_CHECK(result->m_recv.data() == prev_data);
+        prev_data = result->m_recv.data();
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
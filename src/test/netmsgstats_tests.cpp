@@ -0,0 +1,111 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/netmsgstats.h>
+#include <protocol.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+
+BOOST_FIXTURE_TEST_SUITE(netmsgstats_tests, BasicTestingSetup)
+
+using namespace std::chrono_literals;
+
+BOOST_AUTO_TEST_CASE(log2_histogram)
+{
+    Log2Histogram histogram;
+    BOOST_CHECK_EQUAL(histogram.Quantile(0.5), 0U);
+
+    for (const uint64_t value : {0, 1, 2, 3, 4, 100, 1000}) {
+        histogram.Add(value);
+    }
+    BOOST_CHECK_EQUAL(histogram.Count(), 7U);
+    BOOST_CHECK_EQUAL(histogram.Sum(), 1110U);
+    BOOST_CHECK_EQUAL(histogram.Max(), 1000U);
+    const auto& buckets = histogram.Buckets();
+    BOOST_CHECK_EQUAL(buckets[0], 1U);  // 0
+    BOOST_CHECK_EQUAL(buckets[1], 1U);  // 1
+    BOOST_CHECK_EQUAL(buckets[2], 2U);  // 2, 3
+    BOOST_CHECK_EQUAL(buckets[3], 1U);  // 4
+    BOOST_CHECK_EQUAL(buckets[7], 1U);  // 100
+    BOOST_CHECK_EQUAL(buckets[10], 1U); // 1000
+
+    // Quantiles are rounded up to the end of their bucket, but not past the largest value
+    BOOST_CHECK_EQUAL(histogram.Quantile(0.5), 3U);
+    BOOST_CHECK_EQUAL(histogram.Quantile(0.99), 1000U);
+
+    // Values too large for the buckets go into the last one
+    histogram.Add(std::numeric_limits<uint64_t>::max());
+    BOOST_CHECK_EQUAL(buckets[Log2Histogram::NUM_BUCKETS - 1], 1U);
+}
+
+BOOST_AUTO_TEST_CASE(record_by_type)
+{
+    NetMessageStats stats;
+    stats.Record(0, NetMsgType::TX, 250, 100us, 0us);
+    stats.Record(0, NetMsgType::TX, 300, 200us, 50us);
+    stats.Record(1, NetMsgType::GETMWEBUTXOS, 40, 1000us, 0us);
+    stats.Record(1, "madeup", 10, 1us, 0us);
+
+    const NetMessageStatsMap global = stats.GetStats();
+    BOOST_CHECK_EQUAL(global.size(), 3U);
+    BOOST_CHECK_EQUAL(global.at(NetMsgType::TX).size.Count(), 2U);
+    BOOST_CHECK_EQUAL(global.at(NetMsgType::TX).size.Sum(), 550U);
+    BOOST_CHECK_EQUAL(global.at(NetMsgType::TX).processing_time.Sum(), 300U);
+    BOOST_CHECK_EQUAL(global.at(NetMsgType::TX).cs_main_wait.Sum(), 50U);
+    BOOST_CHECK_EQUAL(global.at(NetMsgType::GETMWEBUTXOS).processing_time.Max(), 1000U);
+    // Unknown message types don't get their own entry
+    BOOST_CHECK_EQUAL(global.count("madeup"), 0U);
+    BOOST_CHECK_EQUAL(global.at(NET_MESSAGE_COMMAND_OTHER).size.Count(), 1U);
+
+    const auto peer_stats = stats.GetPeerStats(1);
+    BOOST_REQUIRE(peer_stats);
+    BOOST_CHECK_EQUAL(peer_stats->size(), 2U);
+    BOOST_CHECK_EQUAL(peer_stats->count(NetMsgType::TX), 0U);
+
+    // Forgetting a peer keeps its messages in the global statistics
+    stats.ForgetPeer(1);
+    BOOST_CHECK(!stats.GetPeerStats(1));
+    BOOST_CHECK(stats.GetPeerStats(0));
+    BOOST_CHECK_EQUAL(stats.GetStats().size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(lock_wait_tracker)
+{
+    Mutex mutex, other_mutex;
+    LockWaitTracker tracker(&mutex);
+    {
+        LOCK(mutex);
+        LOCK(other_mutex);
+    }
+    // Uncontended locks don't wait
+    BOOST_CHECK_EQUAL(tracker.Waited().count(), 0);
+
+    std::atomic<bool> locked{false};
+    std::thread holder([&] {
+        LOCK(mutex);
+        locked = true;
+        UninterruptibleSleep(50ms);
+    });
+    while (!locked) std::this_thread::yield();
+    {
+        LockWaitTracker inner(&mutex);
+        LOCK(mutex);
+        BOOST_CHECK(inner.Waited() > 0us);
+    }
+    holder.join();
+    BOOST_CHECK(tracker.Waited() > 0us);
+
+    // Only the thread's own waits are counted
+    const auto waited = tracker.Waited();
+    std::thread other([&] { LOCK(mutex); });
+    other.join();
+    BOOST_CHECK(tracker.Waited() == waited);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,10 +2,14 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
+#include <fs.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/system.h>
 #include <util/time.h>
 
 #include <test/util/setup_common.h>
@@ -178,6 +182,76 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // Smart fee estimates survive a round trip through the estimates file
+    const auto smart_estimates = [](const CBlockPolicyEstimator& estimator) {
+        std::vector<CFeeRate> estimates;
+        for (int i = 1; i <= 48; i++) {
+            FeeCalculation feeCalc;
+            estimates.push_back(estimator.estimateSmartFee(i, &feeCalc, false));
+            BOOST_CHECK_EQUAL(feeCalc.desiredTarget, i);
+            estimates.push_back(estimator.estimateSmartFee(i, &feeCalc, true));
+        }
+        return estimates;
+    };
+    const std::vector<CFeeRate> smartFeeEst = smart_estimates(feeEst);
+    BOOST_CHECK(smartFeeEst[2] > CFeeRate(0));
+    {
+        CAutoFile file(fsbridge::fopen(GetDataDir() / "fee_estimates.dat", "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(feeEst.Write(file));
+    }
+    CBlockPolicyEstimator feeEstRead;
+    {
+        CAutoFile file(fsbridge::fopen(GetDataDir() / "fee_estimates.dat", "rb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(feeEstRead.Read(file));
+    }
+    BOOST_CHECK(smart_estimates(feeEstRead) == smartFeeEst);
+
+    // Smart fee estimates only take transactions waiting in the mempool into
+    // account once a block comes in
+    for (int j = 0; j < 10; j++) {
+        for (int k = 0; k < 4; k++) {
+            tx.vin[0].prevout.n = 10000*blocknum+100*j+k;
+            mpool.addUnchecked(entry.Fee(feeV[j]).Time(GetTime()).Height(blocknum).FromTx(tx));
+        }
+    }
+    BOOST_CHECK(smart_estimates(feeEst) == smartFeeEst);
+}
+
+BOOST_AUTO_TEST_CASE(LazyDecay)
+{
+    CBlockPolicyEstimator feeEst;
+    CTxMemPool mpool(&feeEst);
+    LOCK2(cs_main, mpool.cs);
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 0LL;
+
+    // Confirm one transaction in each block, for longer than the 1008 blocks
+    // after which the decay is applied to the stored averages, and check the
+    // long horizon count against decaying it on every block
+    double expected = 0;
+    unsigned int checked = 0;
+    for (int blocknum = 0; blocknum < 1100;) {
+        tx.vin[0].prevout.n = blocknum;
+        mpool.addUnchecked(entry.Fee(10000).Time(GetTime()).Height(blocknum).FromTx(tx));
+        CBlock block;
+        block.vtx.push_back(mpool.get(tx.GetHash()));
+        mpool.removeForBlock(block, ++blocknum, nullptr);
+
+        EstimationResult result;
+        feeEst.estimateRawFee(1, 0.95, FeeEstimateHorizon::LONG_HALFLIFE, &result);
+        expected = expected * result.decay + 1;
+        // Only filled in once there are enough data points
+        if (result.pass.totalConfirmed == 0) continue;
+        BOOST_CHECK_CLOSE(result.pass.totalConfirmed, expected, 1e-6);
+        BOOST_CHECK_CLOSE(result.pass.withinTarget, expected, 1e-6);
+        ++checked;
+    }
+    BOOST_CHECK(checked > 900);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
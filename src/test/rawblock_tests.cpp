@@ -0,0 +1,180 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <node/rawblock.h>
+#include <primitives/block.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+#include <version.h>
+
+#include <test_framework/models/Tx.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(rawblock_tests, BasicTestingSetup)
+
+static CMutableTransaction MakeTx(uint32_t n, bool witness)
+{
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(InsecureRand256(), n);
+    tx.vin[0].scriptSig = CScript() << n;
+    if (witness) {
+        tx.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(72, n));
+        tx.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(33, n));
+    }
+    tx.vout.resize(1);
+    tx.vout[0].nValue = n * COIN;
+    tx.vout[0].scriptPubKey = CScript() << OP_TRUE;
+    tx.nLockTime = n;
+    return tx;
+}
+
+static CBlock MakeBlock()
+{
+    CBlock block;
+    block.nVersion = 0x20000000;
+    block.nTime = 1234;
+    block.nBits = 0x207fffff;
+
+    // Legacy coinbase
+    block.vtx.push_back(MakeTransactionRef(MakeTx(0, false)));
+    // Witness transaction
+    block.vtx.push_back(MakeTransactionRef(MakeTx(1, true)));
+
+    // Pure MWEB transaction
+    CMutableTransaction mweb_tx;
+    mweb_tx.mweb_tx = MWEB::Tx(test::Tx::CreatePegIn(1000).GetTransaction());
+    block.vtx.push_back(MakeTransactionRef(mweb_tx));
+
+    // Transaction with both witness and MWEB data
+    CMutableTransaction witness_mweb_tx = MakeTx(2, true);
+    witness_mweb_tx.mweb_tx = MWEB::Tx(test::Tx::CreatePegIn(2000).GetTransaction());
+    block.vtx.push_back(MakeTransactionRef(witness_mweb_tx));
+
+    // HogEx, serialized with the MWEB flag but without an MWEB transaction
+    CMutableTransaction hogex = MakeTx(3, false);
+    hogex.m_hogEx = true;
+    block.vtx.push_back(MakeTransactionRef(hogex));
+
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    return block;
+}
+
+static std::vector<uint8_t> SerializeBlock(const CBlock& block, int serialize_flags)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION | serialize_flags);
+    stream << block;
+    return std::vector<uint8_t>(stream.begin(), stream.end());
+}
+
+BOOST_AUTO_TEST_CASE(rawblock_strip)
+{
+    const CBlock block = MakeBlock();
+    const std::vector<uint8_t> raw = SerializeBlock(block, 0);
+
+    RawBlockLayout layout;
+    BOOST_REQUIRE(ParseRawBlockLayout(raw, layout));
+    BOOST_REQUIRE_EQUAL(layout.txs.size(), block.vtx.size());
+    BOOST_CHECK_EQUAL(layout.txs[0].flags, 0);
+    BOOST_CHECK_EQUAL(layout.txs[1].flags, 1);
+    BOOST_CHECK_EQUAL(layout.txs[2].flags, 8);
+    BOOST_CHECK_EQUAL(layout.txs[3].flags, 9);
+    BOOST_CHECK_EQUAL(layout.txs[4].flags, 8);
+
+    for (const int serialize_flags : {0, SERIALIZE_TRANSACTION_NO_WITNESS, SERIALIZE_NO_MWEB, SERIALIZE_TRANSACTION_NO_WITNESS | SERIALIZE_NO_MWEB}) {
+        std::vector<uint8_t> stripped;
+        StripRawBlock(raw, layout, serialize_flags, stripped);
+        BOOST_CHECK(stripped == SerializeBlock(block, serialize_flags));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rawblock_parse_invalid)
+{
+    const std::vector<uint8_t> raw = SerializeBlock(MakeBlock(), 0);
+    RawBlockLayout layout;
+
+    // Truncated blocks
+    BOOST_CHECK(!ParseRawBlockLayout(MakeSpan(raw).first(79), layout));
+    BOOST_CHECK(!ParseRawBlockLayout(MakeSpan(raw).first(raw.size() / 2), layout));
+
+    // Unknown transaction flags
+    std::vector<uint8_t> bad_flags = raw;
+    BOOST_REQUIRE(ParseRawBlockLayout(raw, layout));
+    bad_flags[layout.txs[1].begin + 5] = 3;
+    BOOST_CHECK(!ParseRawBlockLayout(bad_flags, layout));
+}
+
+BOOST_FIXTURE_TEST_CASE(rawblock_cache, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    uint256 hash;
+    FlatFilePos pos;
+    {
+        LOCK(cs_main);
+        hash = ::ChainActive()[10]->GetBlockHash();
+        pos = ::ChainActive()[10]->GetBlockPos();
+    }
+
+    RawBlockCache cache(1 << 20);
+    std::shared_ptr<const RawBlock> raw_block = cache.Get(hash, pos, chainparams.MessageStart());
+    BOOST_REQUIRE(raw_block);
+    BOOST_CHECK(cache.Get(hash, pos, chainparams.MessageStart()) == raw_block);
+
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pos, chainparams.GetConsensus()));
+    BOOST_CHECK(raw_block->data == SerializeBlock(block, 0));
+
+    // A block that doesn't match the requested hash is not returned
+    BOOST_CHECK(!cache.Get(InsecureRand256(), pos, chainparams.MessageStart()));
+
+    RawBlockCacheStats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.num_blocks, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK(stats.usage >= raw_block->data.size());
+
+    cache.RecordBytesServed(raw_block->data.size());
+    stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.bytes_served, raw_block->data.size());
+    BOOST_CHECK(stats.bytes_per_second > 0);
+
+    // Blocks larger than the cache are served without being cached
+    RawBlockCache small_cache(1);
+    BOOST_CHECK(small_cache.Get(hash, pos, chainparams.MessageStart()));
+    BOOST_CHECK_EQUAL(small_cache.GetStats().num_blocks, 0U);
+}
+
+BOOST_FIXTURE_TEST_CASE(rawblock_read_size, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    uint256 hash;
+    FlatFilePos pos;
+    {
+        LOCK(cs_main);
+        hash = ::ChainActive()[10]->GetBlockHash();
+        pos = ::ChainActive()[10]->GetBlockPos();
+    }
+
+    CAutoFile file(OpenBlockFile(FlatFilePos(pos.nFile, 0), true), SER_DISK, CLIENT_VERSION);
+    BOOST_REQUIRE(!file.IsNull());
+    uint32_t size{0};
+    BOOST_REQUIRE(ReadRawBlockSize(file.Get(), pos, hash, chainparams.MessageStart(), size));
+
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pos, chainparams.GetConsensus()));
+    BOOST_CHECK_EQUAL(size, SerializeBlock(block, 0).size());
+
+    // The block must match the hash and the message start
+    BOOST_CHECK(!ReadRawBlockSize(file.Get(), pos, InsecureRand256(), chainparams.MessageStart(), size));
+    const CMessageHeader::MessageStartChars other_start{0x01, 0x02, 0x03, 0x04};
+    BOOST_CHECK(!ReadRawBlockSize(file.Get(), pos, hash, other_start, size));
+    // A position that isn't the start of a block
+    BOOST_CHECK(!ReadRawBlockSize(file.Get(), FlatFilePos(pos.nFile, pos.nPos + 1), hash, chainparams.MessageStart(), size));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
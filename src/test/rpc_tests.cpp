@@ -3,12 +3,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/client.h>
+#include <rpc/executor.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 
+#include <chainparams.h>
 #include <core_io.h>
 #include <interfaces/chain.h>
+#include <miner.h>
+#include <node/blocktemplate.h>
 #include <node/context.h>
+#include <scheduler.h>
 #include <test/util/setup_common.h>
 #include <util/ref.h>
 #include <util/time.h>
@@ -20,6 +25,8 @@
 
 #include <rpc/blockchain.h>
 
+#include <atomic>
+
 class RPCTestingSetup : public TestingSetup
 {
 public:
@@ -421,4 +428,89 @@ BOOST_AUTO_TEST_CASE(rpc_getblockstats_calculate_percentiles_by_weight)
     }
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch_executor)
+{
+    util::Ref context{m_node};
+    JSONRPCRequest jreq(context);
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+
+    // Items run concurrently, replies keep the request order
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < 100; ++i) {
+        UniValue params(UniValue::VARR);
+        params.push_back(i);
+        batch.push_back(JSONRPCRequestObj(i % 10 == 9 ? "nosuchmethod" : "echo", params, i));
+    }
+    batch.push_back("not an object");
+
+    RPCBatchExecutor executor(4, std::chrono::milliseconds{10});
+    const std::string sequential = JSONRPCExecBatch(jreq, batch, nullptr);
+    BOOST_CHECK_EQUAL(JSONRPCExecBatch(jreq, batch, &executor), sequential);
+    BOOST_CHECK(executor.WorkerCount() <= 3);
+
+    UniValue replies;
+    BOOST_CHECK(replies.read(sequential));
+    BOOST_CHECK_EQUAL(replies.size(), 101U);
+    BOOST_CHECK_EQUAL(find_value(replies[42], "id").get_int(), 42);
+    BOOST_CHECK_EQUAL(find_value(replies[42], "result")[0].get_int(), 42);
+    BOOST_CHECK_EQUAL(find_value(find_value(replies[49], "error"), "code").get_int(), RPC_METHOD_NOT_FOUND);
+    BOOST_CHECK(!find_value(replies[100], "error").isNull());
+
+    // Idle workers exit
+    for (int i = 0; i < 1000 && executor.WorkerCount() > 0; ++i) {
+        UninterruptibleSleep(std::chrono::milliseconds{10});
+    }
+    BOOST_CHECK_EQUAL(executor.WorkerCount(), 0);
+
+    // Per-method limits bound the number of items of a method running at once
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    CRPCCommand command("hidden", "batchtest", [&](const JSONRPCRequest&, UniValue& result, bool) {
+        const int now = ++running;
+        int prev = max_running;
+        while (now > prev && !max_running.compare_exchange_weak(prev, now)) {}
+        UninterruptibleSleep(std::chrono::milliseconds{2});
+        --running;
+        result = NullUniValue;
+        return true;
+    }, {}, 0);
+    tableRPC.appendCommand("batchtest", &command);
+    executor.SetMethodLimit("batchtest", 2);
+
+    UniValue limited(UniValue::VARR);
+    for (int i = 0; i < 20; ++i) {
+        limited.push_back(JSONRPCRequestObj("batchtest", UniValue(UniValue::VARR), i));
+    }
+    JSONRPCExecBatch(jreq, limited, &executor);
+    BOOST_CHECK(max_running >= 1);
+    BOOST_CHECK(max_running <= 2);
+    tableRPC.removeCommand("batchtest", &command);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_submittemplatesolution)
+{
+    m_node.block_template_updater = MakeUnique<BlockTemplateUpdater>(*m_node.mempool, Params());
+    CScheduler scheduler;
+    m_node.block_template_provider = MakeUnique<BlockTemplateProvider>(*m_node.block_template_updater, *m_node.mempool, scheduler, 10000);
+    const uint64_t id = m_node.block_template_provider->GetTemplate()->id;
+    const std::string coinbase = EncodeHexTx(*m_node.block_template_provider->GetBlock(id)->block.vtx[0]);
+    const auto submit = [&](const std::string& time, const std::string& nonce) {
+        return CallRPC(strprintf("submittemplatesolution %d 536870912 %s %s %s", id, time, nonce, coinbase));
+    };
+
+    // Header fields that don't fit in 32 bits are rejected rather than truncated
+    BOOST_CHECK_EXCEPTION(submit("4294967296", "0"), std::runtime_error, HasReason("time out of range"));
+    BOOST_CHECK_EXCEPTION(submit("-1", "0"), std::runtime_error, HasReason("time out of range"));
+    BOOST_CHECK_EXCEPTION(submit("0", "4294967296"), std::runtime_error, HasReason("nonce out of range"));
+    BOOST_CHECK_EXCEPTION(submit("0", "-1"), std::runtime_error, HasReason("nonce out of range"));
+
+    // The largest values are accepted, and the block is then rejected by validation
+    UniValue result;
+    BOOST_CHECK_NO_THROW(result = submit("4294967295", "4294967295"));
+    BOOST_CHECK(result.isStr());
+
+    m_node.block_template_provider.reset();
+    m_node.block_template_updater.reset();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
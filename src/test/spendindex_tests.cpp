@@ -0,0 +1,109 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <spendindex.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+BOOST_FIXTURE_TEST_SUITE(spendindex_tests, BasicTestingSetup)
+
+namespace {
+
+mw::Hash RandomOutputId()
+{
+    const uint256 hash = InsecureRand256();
+    return mw::Hash{std::vector<uint8_t>(hash.begin(), hash.end())};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(outpoints_and_output_ids)
+{
+    SpendIndex index;
+    BOOST_CHECK(index.Empty());
+    BOOST_CHECK_EQUAL(index.DynamicMemoryUsage(), 0U);
+
+    const CTransaction tx_a{CMutableTransaction{}}, tx_b{CMutableTransaction{}};
+    const COutPoint outpoint{InsecureRand256(), 0};
+    // An MWEB output ID with the same bytes as the txid of the outpoint is a different key
+    const mw::Hash output_id{std::vector<uint8_t>(outpoint.hash.begin(), outpoint.hash.end())};
+
+    BOOST_CHECK(index.Insert(outpoint, &tx_a));
+    BOOST_CHECK(!index.Insert(outpoint, &tx_b));
+    BOOST_CHECK(index.Get(outpoint) == &tx_a);
+    BOOST_CHECK(index.Get(COutPoint{outpoint.hash, 1}) == nullptr);
+    BOOST_CHECK(index.Get(output_id) == nullptr);
+
+    BOOST_CHECK(index.Insert(CTxInput{output_id}, &tx_b));
+    BOOST_CHECK(index.Get(output_id) == &tx_b);
+    BOOST_CHECK(index.Get(OutputIndex{output_id}) == &tx_b);
+    BOOST_CHECK(index.Get(CTxInput{CTxIn{outpoint}}) == &tx_a);
+    BOOST_CHECK(index.Contains(OutputIndex{outpoint}));
+    BOOST_CHECK_EQUAL(index.Size(), 2U);
+    BOOST_CHECK(index.DynamicMemoryUsage() > 0);
+
+    BOOST_CHECK(index.Erase(outpoint));
+    BOOST_CHECK(!index.Erase(outpoint));
+    BOOST_CHECK(index.Get(outpoint) == nullptr);
+    BOOST_CHECK(index.Get(output_id) == &tx_b);
+
+    index.Clear();
+    BOOST_CHECK(index.Empty());
+    BOOST_CHECK(index.Get(output_id) == nullptr);
+    BOOST_CHECK_EQUAL(index.DynamicMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(matches_map)
+{
+    // Random insertions and removals, which move slots around on growth, shrinking and removal
+    SpendIndex index;
+    std::map<OutputIndex, const CTransaction*> expected;
+    std::vector<OutputIndex> keys;
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < 10; ++i) txs.push_back(MakeTransactionRef());
+
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            const CTransaction* tx = txs[InsecureRandRange(txs.size())].get();
+            if (InsecureRandBool()) {
+                const COutPoint outpoint{InsecureRand256(), (uint32_t)InsecureRandRange(4)};
+                BOOST_CHECK(index.Insert(outpoint, tx));
+                keys.emplace_back(outpoint);
+            } else {
+                const mw::Hash output_id = RandomOutputId();
+                BOOST_CHECK(index.Insert(output_id, tx));
+                keys.emplace_back(output_id);
+            }
+            expected.emplace(keys.back(), tx);
+        }
+        // Remove most of the keys, so that the table shrinks
+        Shuffle(keys.begin(), keys.end(), g_insecure_rand_ctx);
+        while (keys.size() > 100) {
+            const OutputIndex& key = keys.back();
+            if (const mw::Hash* output_id = boost::get<mw::Hash>(&key)) {
+                BOOST_CHECK(index.Erase(*output_id));
+            } else {
+                BOOST_CHECK(index.Erase(boost::get<COutPoint>(key)));
+            }
+            expected.erase(key);
+            keys.pop_back();
+        }
+
+        BOOST_CHECK_EQUAL(index.Size(), expected.size());
+        // The usage covers the whole table, which is at most 3/4 full
+        BOOST_CHECK(index.DynamicMemoryUsage() >= index.Size() * 4 / 3 * sizeof(uint256));
+        for (const auto& entry : expected) {
+            BOOST_CHECK(index.Get(entry.first) == entry.second);
+        }
+        size_t num_txs = 0;
+        index.ForEachTx([&](const CTransaction*) { ++num_txs; });
+        BOOST_CHECK_EQUAL(num_txs, expected.size());
+    }
+    BOOST_CHECK(index.Get(RandomOutputId()) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
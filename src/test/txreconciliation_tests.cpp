@@ -0,0 +1,191 @@
+// Copyright (c) 2021 The Litecoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txreconciliation.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
+
+namespace {
+
+using namespace std::chrono_literals;
+
+/** Register two trackers with each other, the first one as the initiator (outbound side). */
+void RegisterPair(TxReconciliationTracker& initiator, TxReconciliationTracker& responder)
+{
+    const uint64_t initiator_salt = initiator.PreRegisterPeer(1);
+    const uint64_t responder_salt = responder.PreRegisterPeer(0);
+    BOOST_REQUIRE(initiator.RegisterPeer(1, /* is_peer_inbound */ false, TXRECONCILIATION_VERSION, responder_salt) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_REQUIRE(responder.RegisterPeer(0, /* is_peer_inbound */ true, TXRECONCILIATION_VERSION, initiator_salt) == ReconciliationRegisterResult::SUCCESS);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(sketch_decode)
+{
+    ReconciliationSketch ours{ReconciliationSketch::CellsForDifference(20)};
+    ReconciliationSketch theirs{ReconciliationSketch::CellsForDifference(20)};
+    BOOST_CHECK_EQUAL(ours.Size() % ReconciliationSketch::NUM_HASHES, 0U);
+
+    // 1000 common elements, 12 only in ours and 8 only in theirs. Decoding fails with a small
+    // probability, so the elements come from a deterministic context.
+    FastRandomContext rng(/* fDeterministic */ true);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const uint32_t id = rng.rand32();
+        ours.Add(id);
+        theirs.Add(id);
+    }
+    std::vector<uint32_t> expected_ours, expected_theirs;
+    for (int i = 0; i < 12; ++i) {
+        expected_ours.push_back(rng.rand32());
+        ours.Add(expected_ours.back());
+    }
+    for (int i = 0; i < 8; ++i) {
+        expected_theirs.push_back(rng.rand32());
+        theirs.Add(expected_theirs.back());
+    }
+
+    ours.Subtract(theirs);
+    std::vector<uint32_t> only_ours, only_theirs;
+    BOOST_REQUIRE(ours.Decode(only_ours, only_theirs));
+    std::sort(only_ours.begin(), only_ours.end());
+    std::sort(only_theirs.begin(), only_theirs.end());
+    std::sort(expected_ours.begin(), expected_ours.end());
+    std::sort(expected_theirs.begin(), expected_theirs.end());
+    BOOST_CHECK(only_ours == expected_ours);
+    BOOST_CHECK(only_theirs == expected_theirs);
+
+    // A difference much larger than the sketch can't be decoded
+    ReconciliationSketch small{ReconciliationSketch::CellsForDifference(5)};
+    for (int i = 0; i < 100; ++i) {
+        small.Add(InsecureRand32());
+    }
+    BOOST_CHECK(!small.Decode(only_ours, only_theirs));
+
+    // Serialization round trip
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << theirs;
+    ReconciliationSketch deserialized;
+    stream >> deserialized;
+    BOOST_CHECK_EQUAL(deserialized.Size(), theirs.Size());
+}
+
+BOOST_AUTO_TEST_CASE(register_peer)
+{
+    TxReconciliationTracker tracker(TXRECONCILIATION_VERSION);
+
+    // Peers must be pre-registered, and only registered once
+    BOOST_CHECK(tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION, 1) == ReconciliationRegisterResult::NOT_FOUND);
+    tracker.PreRegisterPeer(0);
+    BOOST_CHECK(tracker.RegisterPeer(0, true, 0, 1) == ReconciliationRegisterResult::PROTOCOL_VIOLATION);
+    BOOST_CHECK(!tracker.IsPeerRegistered(0));
+    tracker.PreRegisterPeer(0);
+    BOOST_CHECK(tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION + 1, 1) == ReconciliationRegisterResult::SUCCESS);
+    BOOST_CHECK(tracker.IsPeerRegistered(0));
+    BOOST_CHECK(tracker.RegisterPeer(0, true, TXRECONCILIATION_VERSION, 1) == ReconciliationRegisterResult::ALREADY_REGISTERED);
+
+    // Inbound peers initiate reconciliations, so we never request them
+    BOOST_CHECK(!tracker.InitiateReconciliationRequest(0, 1h));
+
+    BOOST_CHECK(tracker.AddToSet(0, InsecureRand256()));
+    BOOST_CHECK(!tracker.AddToSet(1, InsecureRand256()));
+    tracker.ForgetPeer(0);
+    BOOST_CHECK(!tracker.IsPeerRegistered(0));
+    BOOST_CHECK(!tracker.AddToSet(0, InsecureRand256()));
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_sets)
+{
+    TxReconciliationTracker initiator(TXRECONCILIATION_VERSION), responder(TXRECONCILIATION_VERSION);
+    RegisterPair(initiator, responder);
+
+    // Both sides got 200 transactions from elsewhere, each side 5 the other one didn't.
+    std::set<uint256> initiator_only, responder_only;
+    for (int i = 0; i < 200; ++i) {
+        const uint256 wtxid = InsecureRand256();
+        BOOST_CHECK(initiator.AddToSet(1, wtxid));
+        BOOST_CHECK(responder.AddToSet(0, wtxid));
+    }
+    for (int i = 0; i < 5; ++i) {
+        initiator_only.insert(InsecureRand256());
+        responder_only.insert(InsecureRand256());
+    }
+    for (const uint256& wtxid : initiator_only) BOOST_CHECK(initiator.AddToSet(1, wtxid));
+    for (const uint256& wtxid : responder_only) BOOST_CHECK(responder.AddToSet(0, wtxid));
+
+    // A transaction the peer announced to us doesn't need to be reconciled
+    const uint256 announced = InsecureRand256();
+    BOOST_CHECK(responder.AddToSet(0, announced));
+    responder.TryRemovingFromSet(0, announced);
+
+    const auto set_size = initiator.InitiateReconciliationRequest(1, 1s);
+    BOOST_REQUIRE(set_size);
+    BOOST_CHECK_EQUAL(*set_size, 205U);
+    // Only one reconciliation at a time
+    BOOST_CHECK(!initiator.InitiateReconciliationRequest(1, 1h));
+
+    ReconciliationSketch sketch;
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(0, *set_size, sketch));
+    BOOST_CHECK(sketch.Size() > 0);
+    // The sketch is much smaller than announcing the sets
+    BOOST_CHECK(sketch.Size() * sizeof(ReconciliationSketch::Cell) < 205 * RECON_INV_ENTRY_SIZE / 2);
+
+    std::vector<uint256> initiator_announce, responder_announce;
+    std::vector<uint32_t> to_request;
+    bool success;
+    BOOST_REQUIRE(initiator.HandleSketch(1, sketch, initiator_announce, to_request, success));
+    BOOST_REQUIRE(success);
+    BOOST_CHECK(std::set<uint256>(initiator_announce.begin(), initiator_announce.end()) == initiator_only);
+    BOOST_CHECK_EQUAL(to_request.size(), 5U);
+
+    BOOST_REQUIRE(responder.HandleReconciliationDifference(0, success, to_request, responder_announce));
+    BOOST_CHECK(std::set<uint256>(responder_announce.begin(), responder_announce.end()) == responder_only);
+
+    // Messages out of turn are protocol violations
+    BOOST_CHECK(!responder.HandleReconciliationDifference(0, success, to_request, responder_announce));
+    BOOST_CHECK(!initiator.HandleSketch(1, sketch, initiator_announce, to_request, success));
+    BOOST_CHECK(!initiator.HandleReconciliationRequest(1, 0, sketch));
+
+    // The next reconciliation waits for the request interval
+    BOOST_CHECK(!initiator.InitiateReconciliationRequest(1, 1s + RECON_REQUEST_INTERVAL - 1us));
+    BOOST_CHECK(initiator.InitiateReconciliationRequest(1, 1s + RECON_REQUEST_INTERVAL));
+}
+
+BOOST_AUTO_TEST_CASE(reconcile_fallback)
+{
+    TxReconciliationTracker initiator(TXRECONCILIATION_VERSION), responder(TXRECONCILIATION_VERSION);
+    RegisterPair(initiator, responder);
+
+    // Disjoint sets: the difference is much larger than estimated and can't be decoded
+    for (int i = 0; i < 20; ++i) {
+        initiator.AddToSet(1, InsecureRand256());
+        responder.AddToSet(0, InsecureRand256());
+    }
+    const auto set_size = initiator.InitiateReconciliationRequest(1, 1s);
+    BOOST_REQUIRE(set_size);
+    ReconciliationSketch sketch;
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(0, *set_size, sketch));
+
+    std::vector<uint256> initiator_announce, responder_announce;
+    std::vector<uint32_t> to_request;
+    bool success;
+    BOOST_REQUIRE(initiator.HandleSketch(1, sketch, initiator_announce, to_request, success));
+    BOOST_CHECK(!success);
+    BOOST_CHECK_EQUAL(initiator_announce.size(), 20U);
+    BOOST_CHECK(to_request.empty());
+    BOOST_REQUIRE(responder.HandleReconciliationDifference(0, success, to_request, responder_announce));
+    BOOST_CHECK_EQUAL(responder_announce.size(), 20U);
+
+    // A sketch is not sent when announcing both sets would be as cheap
+    initiator.AddToSet(1, InsecureRand256());
+    BOOST_REQUIRE(initiator.InitiateReconciliationRequest(1, 1h));
+    BOOST_REQUIRE(responder.HandleReconciliationRequest(0, 1, sketch));
+    BOOST_CHECK_EQUAL(sketch.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,17 +2,46 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
 #include <consensus/validation.h>
+#include <fs.h>
+#include <key.h>
 #include <primitives/transaction.h>
+#include <script/interpreter.h>
 #include <script/script.h>
+#include <streams.h>
 #include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <util/time.h>
 #include <validation.h>
 
+#include <test_framework/models/Tx.h>
+
 #include <boost/test/unit_test.hpp>
 
 
 BOOST_AUTO_TEST_SUITE(txvalidation_tests)
 
+/** Spend the first output of a coinbase transaction, paying to the same key */
+static CMutableTransaction SpendCoinbase(const CTransactionRef& coinbase, const CKey& key, CAmount fee)
+{
+    const CScript scriptPubKey = CScript() << ToByteVector(key.GetPubKey()) << OP_CHECKSIG;
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbase->GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbase->vout[0].nValue - fee;
+    spend.vout[0].scriptPubKey = scriptPubKey;
+    std::vector<unsigned char> vchSig;
+    const uint256 hash = SignatureHash(scriptPubKey, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+    return spend;
+}
+
 /**
  * Ensure that the mempool won't accept coinbase transactions.
  */
@@ -51,4 +80,112 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_reject_coinbase, TestChain100Setup)
     BOOST_CHECK(state.GetResult() == TxValidationResult::TX_CONSENSUS);
 }
 
+/**
+ * Ensure that the checks done before taking cs_main reject what they should, and
+ * leave the rest to AcceptToMemoryPool.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_precheck, TestChain100Setup)
+{
+    const CMutableTransaction spend = SpendCoinbase(m_coinbase_txns[0], coinbaseKey, 10000);
+
+    // Script failures are left for AcceptToMemoryPool to report
+    CMutableTransaction bad_sig = spend;
+    bad_sig.vout[0].nValue -= 1;
+
+    CMutableTransaction duplicate_inputs = spend;
+    duplicate_inputs.vin.push_back(spend.vin[0]);
+
+    // Policy failures are left for AcceptToMemoryPool to report as well, and
+    // the scripts of such transactions aren't verified beforehand
+    CMutableTransaction no_fee = spend;
+    no_fee.vout[0].nValue = m_coinbase_txns[0]->vout[0].nValue;
+
+    CMutableTransaction mweb;
+    mweb.mweb_tx = MWEB::Tx(test::Tx::CreatePegIn(1000).GetTransaction());
+
+    const std::vector<CTransactionRef> txs{MakeTransactionRef(spend), MakeTransactionRef(bad_sig), MakeTransactionRef(duplicate_inputs), MakeTransactionRef(mweb), MakeTransactionRef(no_fee)};
+    const std::vector<TxValidationState> states = PreCheckTransactions(*m_node.mempool, txs);
+    BOOST_CHECK_EQUAL(states.size(), 5U);
+    BOOST_CHECK(states[0].IsValid());
+    BOOST_CHECK(states[1].IsValid());
+    BOOST_CHECK_EQUAL(states[2].GetRejectReason(), "bad-txns-inputs-duplicate");
+    BOOST_CHECK_EQUAL(states[3].GetRejectReason(), "mweb-before-activation");
+    BOOST_CHECK(states[4].IsValid());
+
+    LOCK(cs_main);
+    TxValidationState state;
+    BOOST_CHECK(!AcceptToMemoryPool(*m_node.mempool, state, txs[1], nullptr /* plTxnReplaced */, true /* bypass_limits */, false /* test_accept */, nullptr /* fee_out */, true /* prechecked */));
+    BOOST_CHECK(state.GetResult() == TxValidationResult::TX_CONSENSUS);
+    state = TxValidationState{};
+    BOOST_CHECK(!AcceptToMemoryPool(*m_node.mempool, state, txs[4], nullptr /* plTxnReplaced */, false /* bypass_limits */, false /* test_accept */, nullptr /* fee_out */, true /* prechecked */));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "min relay fee not met");
+    state = TxValidationState{};
+    BOOST_CHECK(AcceptToMemoryPool(*m_node.mempool, state, txs[0], nullptr /* plTxnReplaced */, true /* bypass_limits */, false /* test_accept */, nullptr /* fee_out */, true /* prechecked */));
+    BOOST_CHECK(m_node.mempool->exists(txs[0]->GetHash()));
+}
+
+/**
+ * Ensure that the mempool is reloaded from a dump, with the fee deltas, also
+ * of expired transactions, and from a dump in the format from before chunks.
+ */
+BOOST_FIXTURE_TEST_CASE(tx_mempool_persist, TestChain100Setup)
+{
+    CTxMemPool& pool = *m_node.mempool;
+    const CTransactionRef parent = MakeTransactionRef(SpendCoinbase(m_coinbase_txns[0], coinbaseKey, 10000));
+    const CTransactionRef child = MakeTransactionRef(SpendCoinbase(parent, coinbaseKey, 10000));
+    {
+        LOCK(cs_main);
+        for (const CTransactionRef& tx : {parent, child}) {
+            TxValidationState state;
+            BOOST_CHECK(AcceptToMemoryPool(pool, state, tx, nullptr /* plTxnReplaced */, true /* bypass_limits */));
+        }
+    }
+    pool.PrioritiseTransaction(child->GetHash(), 1000);
+
+    const auto check_loaded = [&] {
+        LOCK(pool.cs);
+        BOOST_CHECK_EQUAL(pool.size(), 2U);
+        BOOST_CHECK(pool.exists(parent->GetHash()));
+        const auto it = pool.mapTx.find(child->GetHash());
+        BOOST_REQUIRE(it != pool.mapTx.end());
+        BOOST_CHECK_EQUAL(it->GetModifiedFee(), 10000 + 1000);
+    };
+    const auto clear = [&] {
+        LOCK(pool.cs);
+        pool.clear();
+        pool.ClearPrioritisation(child->GetHash());
+        BOOST_CHECK_EQUAL(pool.size(), 0U);
+    };
+
+    BOOST_CHECK(DumpMempool(pool));
+    clear();
+    BOOST_CHECK(LoadMempool(pool));
+    check_loaded();
+
+    // Expired transactions aren't loaded, but their fee deltas are
+    BOOST_CHECK(DumpMempool(pool));
+    clear();
+    SetMockTime(GetTime() + DEFAULT_MEMPOOL_EXPIRY * 60 * 60 + 1);
+    BOOST_CHECK(LoadMempool(pool));
+    SetMockTime(0);
+    {
+        LOCK(pool.cs);
+        BOOST_CHECK_EQUAL(pool.size(), 0U);
+        CAmount delta{0};
+        pool.ApplyDelta(child->GetHash(), delta);
+        BOOST_CHECK_EQUAL(delta, 1000);
+    }
+
+    {
+        CAutoFile file(fsbridge::fopen(GetDataDir() / "mempool.dat", "wb"), SER_DISK, CLIENT_VERSION);
+        file << uint64_t{1} << uint64_t{2};
+        file << parent << int64_t{GetTime()} << int64_t{0};
+        file << child << int64_t{GetTime()} << int64_t{1000};
+        file << std::map<uint256, CAmount>{} << std::set<uint256>{};
+    }
+    clear();
+    BOOST_CHECK(LoadMempool(pool));
+    check_loaded();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -27,6 +27,17 @@ void ConnmanTestMsg::NodeReceiveMsgBytes(CNode& node, const char* pch, unsigned
     }
 }
 
+void ConnmanTestMsg::InitSocketEvents(const Options& options)
+{
+    Init(options);
+#ifdef USE_EPOLL
+    if (m_use_epoll) {
+        const bool epoll_ok = InitEpoll();
+        assert(epoll_ok);
+    }
+#endif
+}
+
 bool ConnmanTestMsg::ReceiveMsgFrom(CNode& node, CSerializedNetMsg& ser_msg) const
 {
     std::vector<unsigned char> ser_msg_header;
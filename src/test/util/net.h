@@ -21,8 +21,18 @@ struct ConnmanTestMsg : public CConnman {
             delete node;
         }
         vNodes.clear();
+#ifdef USE_EPOLL
+        m_epoll_nodes.clear();
+        m_epoll_readable.clear();
+#endif
     }
 
+    /** Apply the options and set up the socket events backend they select, as Start() does. */
+    void InitSocketEvents(const Options& options);
+    /** Add a node with a connected socket, to be serviced by SocketHandlerOnce(). */
+    void AddSocketTestNode(CNode& node) { AddNode(&node); }
+    void SocketHandlerOnce() { SocketHandler(); }
+
     void ProcessMessagesOnce(CNode& node) { m_msgproc->ProcessMessages(&node, flagInterruptMsgProc); }
 
     void NodeReceiveMsgBytes(CNode& node, const char* pch, unsigned int nBytes, bool& complete) const;
@@ -160,12 +160,22 @@ TestingSetup::TestingSetup(const std::string& chainName, const std::vector<const
         throw std::runtime_error(strprintf("ActivateBestChain failed. (%s)", state.ToString()));
     }
 
-    // Start script-checking threads. Set g_parallel_script_checks to true so they are used.
+    // Start script-checking, header-checking and transaction pre-checking threads. Set
+    // g_parallel_script_checks, g_parallel_header_checks and g_parallel_tx_prechecks to
+    // true so they are used.
     constexpr int script_check_threads = 2;
     for (int i = 0; i < script_check_threads; ++i) {
         threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
     }
     g_parallel_script_checks = true;
+    for (int i = 0; i < script_check_threads; ++i) {
+        threadGroup.create_thread([i]() { return ThreadHeaderCheck(i); });
+    }
+    g_parallel_header_checks = true;
+    for (int i = 0; i < script_check_threads; ++i) {
+        threadGroup.create_thread([i]() { return ThreadTxPreCheck(i); });
+    }
+    g_parallel_tx_prechecks = true;
 
     m_node.banman = MakeUnique<BanMan>(GetDataDir() / "banlist.dat", nullptr, DEFAULT_MISBEHAVING_BANTIME);
     m_node.connman = MakeUnique<CConnman>(0x1337, 0x1337); // Deterministic randomness for tests.
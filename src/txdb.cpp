@@ -41,8 +41,32 @@ struct CoinEntry {
 
 }
 
+/**
+ * Whether a chainstate key belongs to one of the MWEB tables: UTXOs ('U'), MMR
+ * info ('M') and output MMR leaves ('O'). libmw stores its entries under
+ * serialized strings of the table prefix followed by the item key.
+ */
+static bool IsMWEBKey(const leveldb::Slice& key)
+{
+    return key.size() >= 2 && static_cast<unsigned char>(key[0]) == key.size() - 1 &&
+           (key[1] == 'U' || key[1] == 'M' || key[1] == 'O');
+}
+
+/**
+ * Open the chainstate database. Unless the profile reserves no cache for them,
+ * the MWEB tables get a cache of their own so that MWEB lookups don't evict
+ * blocks holding transparent coins.
+ */
+static std::unique_ptr<CDBWrapper> OpenCoinsDB(const fs::path& ldb_path, size_t cache_size, bool memory, bool wipe)
+{
+    const size_t mweb_cache_size = cache_size * GetDBProfile().table_cache_percent / 100;
+    auto db = MakeUnique<CDBWrapper>(ldb_path, cache_size - mweb_cache_size, memory, wipe, /*obfuscate*/ true);
+    if (mweb_cache_size > 0) db->AddTableCache("mweb", IsMWEBKey, mweb_cache_size);
+    return db;
+}
+
 CCoinsViewDB::CCoinsViewDB(fs::path ldb_path, size_t nCacheSize, bool fMemory, bool fWipe) :
-    m_db(MakeUnique<CDBWrapper>(ldb_path, nCacheSize, fMemory, fWipe, true)),
+    m_db(OpenCoinsDB(ldb_path, nCacheSize, fMemory, fWipe)),
     m_ldb_path(ldb_path),
     m_is_memory(fMemory) { }
 
@@ -51,8 +75,7 @@ void CCoinsViewDB::ResizeCache(size_t new_cache_size)
     // Have to do a reset first to get the original `m_db` state to release its
     // filesystem lock.
     m_db.reset();
-    m_db = MakeUnique<CDBWrapper>(
-        m_ldb_path, new_cache_size, m_is_memory, /*fWipe*/ false, /*obfuscate*/ true);
+    m_db = OpenCoinsDB(m_ldb_path, new_cache_size, m_is_memory, /*fWipe*/ false);
     GetMWEBView()->SetDatabase(std::make_shared<MWEB::DBWrapper>(GetDB()));
 }
 
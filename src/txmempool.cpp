@@ -138,9 +138,9 @@ void CTxMemPool::UpdateTransactionsFromBlock(const std::vector<uint256> &vHashes
         {
             const auto epoch = GetFreshEpoch();
 	        for (const CTxOutput& output : it->GetTx().GetOutputs()) {
-	            auto iter = mapNextTx.find(output.GetIndex());
-                if (iter != mapNextTx.end()) {
-                    const uint256& childHash = iter->second->GetHash();
+	            const CTransaction* child = mapNextTx.Get(output.GetIndex());
+                if (child) {
+                    const uint256& childHash = child->GetHash();
                     txiter childIter = mapTx.find(childHash);
                     assert(childIter != mapTx.end());
                     // We can skip updating entries we've encountered before or that
@@ -360,7 +360,7 @@ CTxMemPool::CTxMemPool(CBlockPolicyEstimator* estimator)
 bool CTxMemPool::isSpent(const OutputIndex& outpoint) const
 {
     LOCK(cs);
-    return mapNextTx.count(outpoint);
+    return mapNextTx.Contains(outpoint);
 }
 
 unsigned int CTxMemPool::GetTransactionsUpdated() const
@@ -397,21 +397,24 @@ void CTxMemPool::addUnchecked(const CTxMemPoolEntry &entry, setEntries &setAnces
     const CTransaction& tx = newit->GetTx();
     std::set<uint256> setParentTransactions;
     for (const CTxInput& input : tx.GetInputs()) {
-        mapNextTx.insert(std::make_pair(input.GetIndex(), &tx));
+        mapNextTx.Insert(input, &tx);
 
         if (input.IsMWEB()) {
-            auto parentIter = mapTxOutputs_MWEB.find(input.ToMWEB());
-            if (parentIter != mapTxOutputs_MWEB.end()) {
-                setParentTransactions.insert(parentIter->second->GetHash());
+            const CTransaction* parent = mapTxOutputs_MWEB.Get(input.ToMWEB());
+            if (parent) {
+                setParentTransactions.insert(parent->GetHash());
             }
         } else {
             setParentTransactions.insert(input.GetTxIn().prevout.hash);
         }
     }
 
-    // MWEB: Add transaction to mapTxOutputs_MWEB for each output
+    // MWEB: Add transaction to mapTxOutputs_MWEB for each output, and to mapTxKernels_MWEB for each kernel
     for (const mw::Hash& output_id : tx.mweb_tx.GetOutputIDs()) {
-        mapTxOutputs_MWEB.insert(std::make_pair(output_id, &tx));
+        mapTxOutputs_MWEB.Insert(output_id, &tx);
+    }
+    for (const mw::Hash& kernel_id : tx.mweb_tx.GetKernelIDs()) {
+        mapTxKernels_MWEB.Insert(kernel_id, &tx);
     }
 
     // Don't bother worrying about child transactions of this one.
@@ -454,11 +457,14 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 
     const uint256 hash = ptx->GetHash();
     for (const CTxInput& txin : ptx->GetInputs())
-        mapNextTx.erase(txin.GetIndex());
+        mapNextTx.Erase(txin);
 
-    // MWEB: Remove transaction from mapTxOutputs_MWEB for each output
+    // MWEB: Remove transaction from mapTxOutputs_MWEB for each output, and from mapTxKernels_MWEB for each kernel
     for (const mw::Hash& output_id : ptx->mweb_tx.GetOutputIDs()) {
-        mapTxOutputs_MWEB.erase(output_id);
+        mapTxOutputs_MWEB.Erase(output_id);
+    }
+    for (const mw::Hash& kernel_id : ptx->mweb_tx.GetKernelIDs()) {
+        if (mapTxKernels_MWEB.Get(kernel_id) == ptx.get()) mapTxKernels_MWEB.Erase(kernel_id);
     }
 
     // MWEB: When removing MWEB transactions from the mempool after a block is connected,
@@ -532,10 +538,10 @@ void CTxMemPool::removeRecursive(const CTransaction &origTx, MemPoolRemovalReaso
         // happen during chain re-orgs if origTx isn't re-accepted into
         // the mempool for any reason.
         for (const CTxOutput& output : origTx.GetOutputs()) {
-            auto it = mapNextTx.find(output.GetIndex());
-            if (it == mapNextTx.end())
+            const CTransaction* spending_tx = mapNextTx.Get(output.GetIndex());
+            if (!spending_tx)
                 continue;
-            txiter nextit = mapTx.find(it->second->GetHash());
+            txiter nextit = mapTx.find(spending_tx->GetHash());
             assert(nextit != mapTx.end());
             txToRemove.insert(nextit);
         }
@@ -597,9 +603,9 @@ void CTxMemPool::removeConflicts(const CTransaction &tx)
     // Remove transactions which depend on inputs of tx, recursively
     AssertLockHeld(cs);
     for (const CTxInput& input : tx.GetInputs()) {
-        auto it = mapNextTx.find(input.GetIndex());
-        if (it != mapNextTx.end()) {
-            const CTransaction &txConflict = *it->second;
+        const CTransaction* conflict = mapNextTx.Get(input);
+        if (conflict) {
+            const CTransaction &txConflict = *conflict;
             if (txConflict != tx)
             {
                 ClearPrioritisation(txConflict.GetHash());
@@ -670,8 +676,9 @@ void CTxMemPool::removeForBlock(const CBlock& block, unsigned int nBlockHeight,
 void CTxMemPool::_clear()
 {
     mapTx.clear();
-    mapNextTx.clear();
-    mapTxOutputs_MWEB.clear();
+    mapNextTx.Clear();
+    mapTxOutputs_MWEB.Clear();
+    mapTxKernels_MWEB.Clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
@@ -704,7 +711,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
     if (GetRand(std::numeric_limits<uint32_t>::max()) >= nCheckFrequency)
         return;
 
-    LogPrint(BCLog::MEMPOOL, "Checking mempool with %u transactions and %u inputs\n", (unsigned int)mapTx.size(), (unsigned int)mapNextTx.size());
+    LogPrint(BCLog::MEMPOOL, "Checking mempool with %u transactions and %u inputs\n", (unsigned int)mapTx.size(), (unsigned int)mapNextTx.Size());
 
     uint64_t checkTotal = 0;
     uint64_t innerUsage = 0;
@@ -734,10 +741,7 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
                 assert(pcoins->HaveCoin(input.GetIndex()));
             }
             // Check whether its inputs are marked in mapNextTx.
-            auto it3 = mapNextTx.find(input.GetIndex());
-            assert(it3 != mapNextTx.end());
-            assert(it3->first == input.GetIndex());
-            assert(it3->second == &tx);
+            assert(mapNextTx.Get(input) == &tx);
             i++;
         }
         auto comp = [](const CTxMemPoolEntry& a, const CTxMemPoolEntry& b) -> bool {
@@ -770,9 +774,9 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
         CTxMemPoolEntry::Children setChildrenCheck;
         uint64_t child_sizes = 0;
         for (const CTxOutput& output : it->GetTx().GetOutputs()) {
-            auto iter = mapNextTx.find(output.GetIndex());
-            if (iter != mapNextTx.end()) {
-                txiter childit = mapTx.find(iter->second->GetHash());
+            const CTransaction* child = mapNextTx.Get(output.GetIndex());
+            if (child) {
+                txiter childit = mapTx.find(child->GetHash());
                 assert(childit != mapTx.end()); // mapNextTx points to in-mempool transactions
                 if (setChildrenCheck.insert(*childit).second) {
                     child_sizes += childit->GetTxSize();
@@ -804,13 +808,11 @@ void CTxMemPool::check(const CCoinsViewCache *pcoins) const
             stepsSinceLastRemove = 0;
         }
     }
-    for (auto it = mapNextTx.cbegin(); it != mapNextTx.cend(); it++) {
-        uint256 hash = it->second->GetHash();
-        indexed_transaction_set::const_iterator it2 = mapTx.find(hash);
-        const CTransaction& tx = it2->GetTx();
+    mapNextTx.ForEachTx([&](const CTransaction* spending_tx) {
+        indexed_transaction_set::const_iterator it2 = mapTx.find(spending_tx->GetHash());
         assert(it2 != mapTx.end());
-        assert(&tx == it->second);
-    }
+        assert(&it2->GetTx() == spending_tx);
+    });
 
     assert(totalTxSize == checkTotal);
     assert(innerUsage == cachedInnerUsage);
@@ -965,8 +967,7 @@ void CTxMemPool::ClearPrioritisation(const uint256& hash)
 
 const CTransaction* CTxMemPool::GetConflictTx(const OutputIndex& prevout) const
 {
-    const auto it = mapNextTx.find(prevout);
-    return it == mapNextTx.end() ? nullptr : it->second;
+    return mapNextTx.Get(prevout);
 }
 
 Optional<CTxMemPool::txiter> CTxMemPool::GetIter(const uint256& txid) const
@@ -980,9 +981,9 @@ Optional<CTxMemPool::txiter> CTxMemPool::GetIter(const uint256& txid) const
 Optional<CTxMemPool::txiter> CTxMemPool::GetIter(const CTxInput& input) const
 {
     if (input.IsMWEB()) {
-        auto iter = mapTxOutputs_MWEB.find(input.ToMWEB());
-        if (iter != mapTxOutputs_MWEB.end()) {
-            return GetIter(iter->second->GetHash());
+        const CTransaction* creating_tx = mapTxOutputs_MWEB.Get(input.ToMWEB());
+        if (creating_tx) {
+            return GetIter(creating_tx->GetHash());
         }
     } else {
         return GetIter(input.GetTxIn().prevout.hash);
@@ -1005,7 +1006,7 @@ bool CTxMemPool::HasNoInputsOf(const CTransaction &tx) const
 {
     for (const CTxInput& input : tx.GetInputs()) {
         if (input.IsMWEB()) {
-            if (mapTxOutputs_MWEB.find(input.ToMWEB()) != mapTxOutputs_MWEB.end()) {
+            if (mapTxOutputs_MWEB.Get(input.ToMWEB())) {
                 return false;
             }
         } else if (exists(input.GetTxIn().prevout.hash)) {
@@ -1037,13 +1038,14 @@ bool CCoinsViewMemPool::GetCoin(const COutPoint &outpoint, Coin &coin) const {
 bool CCoinsViewMemPool::HaveCoin(const OutputIndex& index) const 
 {
     if (index.type() == typeid(mw::Hash)) {
-        if (mempool.mapNextTx.find(index) != mempool.mapNextTx.end()) {
+        const mw::Hash& output_id = boost::get<mw::Hash>(index);
+        if (mempool.mapNextTx.Get(output_id)) {
             return false;
         }
 
-        auto iter = mempool.mapTxOutputs_MWEB.find(boost::get<mw::Hash>(index));
-        if (iter != mempool.mapTxOutputs_MWEB.end()) {
-            assert(mempool.mapTx.count(iter->second->GetHash()) > 0);
+        const CTransaction* creating_tx = mempool.mapTxOutputs_MWEB.Get(output_id);
+        if (creating_tx) {
+            assert(mempool.mapTx.count(creating_tx->GetHash()) > 0);
             return true;
         }
 
@@ -1055,15 +1057,15 @@ bool CCoinsViewMemPool::HaveCoin(const OutputIndex& index) const
 
 bool CCoinsViewMemPool::GetMWEBCoin(const mw::Hash& output_id, Output& coin) const
 {
-    if (mempool.mapNextTx.find(output_id) != mempool.mapNextTx.end()) {
+    if (mempool.mapNextTx.Get(output_id)) {
         return false;
     }
 
-    auto iter = mempool.mapTxOutputs_MWEB.find(output_id);
-    if (iter != mempool.mapTxOutputs_MWEB.end()) {
-        //assert(mempool.mapTx.count(iter->second->GetHash()) > 0);
-        //assert(!iter->second->mweb_tx.IsNull());
-        return iter->second->mweb_tx.GetOutput(output_id, coin);
+    const CTransaction* creating_tx = mempool.mapTxOutputs_MWEB.Get(output_id);
+    if (creating_tx) {
+        //assert(mempool.mapTx.count(creating_tx->GetHash()) > 0);
+        //assert(!creating_tx->mweb_tx.IsNull());
+        return creating_tx->mweb_tx.GetOutput(output_id, coin);
     }
 
     UTXO::CPtr pUTXO = GetMWEBView()->GetUTXO(output_id);
@@ -1078,7 +1080,7 @@ bool CCoinsViewMemPool::GetMWEBCoin(const mw::Hash& output_id, Output& coin) con
 size_t CTxMemPool::DynamicMemoryUsage() const {
     LOCK(cs);
     // Estimate the overhead of mapTx to be 15 pointers + an allocation, as no exact formula for boost::multi_index_contained is implemented.
-    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + memusage::DynamicUsage(mapNextTx) + memusage::DynamicUsage(mapTxOutputs_MWEB) + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
+    return memusage::MallocUsage(sizeof(CTxMemPoolEntry) + 15 * sizeof(void*)) * mapTx.size() + mapNextTx.DynamicMemoryUsage() + mapTxOutputs_MWEB.DynamicMemoryUsage() + mapTxKernels_MWEB.DynamicMemoryUsage() + memusage::DynamicUsage(mapDeltas) + memusage::DynamicUsage(vTxHashes) + cachedInnerUsage;
 }
 
 void CTxMemPool::RemoveUnbroadcastTx(const uint256& txid, const bool unchecked) {
@@ -20,6 +20,7 @@
 #include <optional.h>
 #include <policy/feerate.h>
 #include <primitives/transaction.h>
+#include <spendindex.h>
 #include <sync.h>
 #include <random.h>
 
@@ -617,12 +618,17 @@ public:
     /**
      * Maps outputs to mempool transactions that spend them.
      */
-    std::map<OutputIndex, const CTransaction*> mapNextTx GUARDED_BY(cs);
+    SpendIndex mapNextTx GUARDED_BY(cs);
 
     /**
      * Maps MWEB output IDs to mempool transactions that create them.
      */
-    std::map<mw::Hash, const CTransaction*> mapTxOutputs_MWEB GUARDED_BY(cs);
+    SpendIndex mapTxOutputs_MWEB GUARDED_BY(cs);
+
+    /**
+     * Maps MWEB kernel IDs to mempool transactions that have them.
+     */
+    SpendIndex mapTxKernels_MWEB GUARDED_BY(cs);
 
     /**
      * FIFO cache of txs recently removed from the mempool keyed by kernel ID.
@@ -780,9 +786,9 @@ public:
     bool GetCreatedTx(const mw::Hash& output_id, uint256& hash) const
     {
         LOCK(cs);
-        auto iter = mapTxOutputs_MWEB.find(output_id);
-        if (iter != mapTxOutputs_MWEB.end()) {
-            hash = iter->second->GetHash();
+        const CTransaction* creating_tx = mapTxOutputs_MWEB.Get(output_id);
+        if (creating_tx) {
+            hash = creating_tx->GetHash();
             return true;
         }
         return false;
@@ -5,9 +5,13 @@
 #ifndef BITCOIN_UTIL_GOLOMBRICE_H
 #define BITCOIN_UTIL_GOLOMBRICE_H
 
+#include <crypto/common.h>
+#include <span.h>
 #include <streams.h>
 
 #include <cstdint>
+#include <ios>
+#include <vector>
 
 template <typename OStream>
 void GolombRiceEncode(BitStreamWriter<OStream>& bitwriter, uint8_t P, uint64_t x)
@@ -40,4 +44,150 @@ uint64_t GolombRiceDecode(BitStreamReader<IStream>& bitreader, uint8_t P)
     return (q << P) + r;
 }
 
+/**
+ * Golomb-Rice encoder that buffers output bits in a 64-bit word instead of going through a
+ * BitStreamWriter one call per field. The encoding is identical to GolombRiceEncode.
+ */
+class GolombRiceWriter
+{
+private:
+    std::vector<unsigned char>& m_out;
+
+    /** Pending output bits, most significant bit first. */
+    uint64_t m_buffer{0};
+
+    /** Number of pending bits in m_buffer. Always less than 8 between calls. */
+    int m_bits{0};
+
+    /** Append the nbits least significant bits of data. nbits must be at most 56. */
+    void Write(uint64_t data, int nbits)
+    {
+        if (nbits == 0) return;
+        m_buffer |= (data << (64 - nbits)) >> m_bits;
+        m_bits += nbits;
+        while (m_bits >= 8) {
+            m_out.push_back(static_cast<unsigned char>(m_buffer >> 56));
+            m_buffer <<= 8;
+            m_bits -= 8;
+        }
+    }
+
+public:
+    explicit GolombRiceWriter(std::vector<unsigned char>& out) : m_out(out) {}
+
+    void Encode(uint8_t P, uint64_t x)
+    {
+        // Write quotient as unary-encoded: q 1's followed by one 0.
+        uint64_t q = x >> P;
+        while (q >= 56) {
+            Write(~0ULL, 56);
+            q -= 56;
+        }
+        Write(~0ULL << 1, static_cast<int>(q) + 1);
+
+        // Write the remainder in P bits.
+        if (P > 56) {
+            Write(x >> 32, P - 32);
+            Write(x, 32);
+        } else {
+            Write(x, P);
+        }
+    }
+
+    /** Write any remaining bits, padding the last byte with zeros. */
+    void Flush()
+    {
+        if (m_bits > 0) {
+            m_out.push_back(static_cast<unsigned char>(m_buffer >> 56));
+            m_buffer = 0;
+            m_bits = 0;
+        }
+    }
+};
+
+/**
+ * Golomb-Rice decoder reading straight from a byte span through a 64-bit buffer. Unary-coded
+ * quotients are consumed a word at a time by counting leading one bits, rather than one bit per
+ * call as in GolombRiceDecode. Like BitStreamReader, a byte is only consumed once one of its bits
+ * is needed, so GetUnreadBytes() can be used to detect excess data after the last value.
+ */
+class GolombRiceReader
+{
+private:
+    const unsigned char* m_pos;
+    const unsigned char* const m_end;
+
+    /** Unread bits, most significant bit first. Bits past m_bits are always zero. */
+    uint64_t m_buffer{0};
+
+    /** Number of unread bits in m_buffer. */
+    int m_bits{0};
+
+    void Refill()
+    {
+        while (m_bits <= 56 && m_pos != m_end) {
+            m_buffer |= static_cast<uint64_t>(*m_pos++) << (56 - m_bits);
+            m_bits += 8;
+        }
+    }
+
+    void Consume(int nbits)
+    {
+        m_buffer = nbits < 64 ? m_buffer << nbits : 0;
+        m_bits -= nbits;
+    }
+
+    uint64_t Read(int nbits)
+    {
+        if (nbits == 0) return 0;
+        if (nbits > 56) {
+            uint64_t hi = Read(nbits - 32);
+            return (hi << 32) | Read(32);
+        }
+        if (m_bits < nbits) {
+            Refill();
+            if (m_bits < nbits) {
+                throw std::ios_base::failure("GolombRiceReader::Read(): end of data");
+            }
+        }
+        uint64_t data = m_buffer >> (64 - nbits);
+        Consume(nbits);
+        return data;
+    }
+
+public:
+    explicit GolombRiceReader(Span<const unsigned char> data)
+        : m_pos(data.data()), m_end(data.data() + data.size()) {}
+
+    uint64_t Decode(uint8_t P)
+    {
+        // Read unary-encoded quotient: q 1's followed by one 0.
+        uint64_t q = 0;
+        while (true) {
+            if (m_bits == 0) {
+                Refill();
+                if (m_bits == 0) {
+                    throw std::ios_base::failure("GolombRiceReader::Decode(): end of data");
+                }
+            }
+            // Bits past m_bits are zero, so this never counts beyond the buffered bits.
+            const int ones = 64 - static_cast<int>(CountBits(~m_buffer));
+            if (ones < m_bits) {
+                q += ones;
+                Consume(ones + 1);
+                break;
+            }
+            q += m_bits;
+            Consume(m_bits);
+        }
+
+        uint64_t r = Read(P);
+
+        return (q << P) + r;
+    }
+
+    /** Number of input bytes none of whose bits have been consumed yet. */
+    size_t GetUnreadBytes() const { return static_cast<size_t>(m_end - m_pos) + m_bits / 8; }
+};
+
 #endif // BITCOIN_UTIL_GOLOMBRICE_H
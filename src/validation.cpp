@@ -136,6 +136,8 @@ Mutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
 bool g_parallel_script_checks{false};
+bool g_parallel_header_checks{false};
+bool g_parallel_tx_prechecks{false};
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
 bool fHavePruned = false;
@@ -476,11 +478,17 @@ public:
         std::vector<OutputIndex>& m_coins_to_uncache;
         const bool m_test_accept;
         CAmount* m_fee_out;
+        // Whether PreCheckTransaction already passed for the transaction
+        const bool m_prechecked;
     };
 
     // Single transaction acceptance
     bool AcceptSingleTransaction(const CTransactionRef& ptx, ATMPArgs& args) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+    // Run only the policy checks of a single transaction acceptance. If they
+    // pass, return the outputs the transaction spends.
+    bool PolicyPreChecks(const CTransactionRef& ptx, ATMPArgs& args, std::vector<CTxOut>& spent_outputs) EXCLUSIVE_LOCKS_REQUIRED(cs_main, m_pool.cs);
+
 private:
     // All the intermediate state that gets passed between the various levels
     // of checking a given transaction.
@@ -572,7 +580,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     CAmount& nConflictingFees = ws.m_conflicting_fees;
     size_t& nConflictingSize = ws.m_conflicting_size;
 
-    if (!CheckTransaction(tx, state)) {
+    if (!args.m_prechecked && !CheckTransaction(tx, state)) {
         return false; // state filled in by CheckTransaction
     }
 
@@ -582,7 +590,7 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
     }
 
     // MWEB: Check MWEB tx
-    if (!MWEB::Node::CheckTransaction(tx, state)) {
+    if (!args.m_prechecked && !MWEB::Node::CheckTransaction(tx, state)) {
         return false; // state filled in by CheckTransaction
     }
 
@@ -870,9 +878,9 @@ bool MemPoolAccept::PreChecks(ATMPArgs& args, Workspace& ws)
 
             for (const CTxInput& txin : mi->GetTx().GetInputs()) {
                 if (txin.IsMWEB()) {
-                    auto parent_iter = m_pool.mapTxOutputs_MWEB.find(txin.ToMWEB());
-                    if (parent_iter != m_pool.mapTxOutputs_MWEB.end()) {
-                        setConflictsParents.insert(parent_iter->second->GetHash());
+                    const CTransaction* parent = m_pool.mapTxOutputs_MWEB.Get(txin.ToMWEB());
+                    if (parent) {
+                        setConflictsParents.insert(parent->GetHash());
                     }
                 } else {
                     setConflictsParents.insert(txin.GetTxIn().prevout.hash);
@@ -1057,6 +1065,22 @@ bool MemPoolAccept::Finalize(ATMPArgs& args, Workspace& ws)
     return true;
 }
 
+bool MemPoolAccept::PolicyPreChecks(const CTransactionRef& ptx, ATMPArgs& args, std::vector<CTxOut>& spent_outputs)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_pool.cs);
+
+    Workspace workspace(ptx);
+
+    if (!PreChecks(args, workspace)) return false;
+
+    spent_outputs.reserve(ptx->vin.size());
+    for (const CTxIn& txin : ptx->vin) {
+        spent_outputs.push_back(m_view.AccessCoin(txin.prevout).out);
+    }
+    return true;
+}
+
 bool MemPoolAccept::AcceptSingleTransaction(const CTransactionRef& ptx, ATMPArgs& args)
 {
     AssertLockHeld(cs_main);
@@ -1091,10 +1115,10 @@ bool MemPoolAccept::AcceptSingleTransaction(const CTransactionRef& ptx, ATMPArgs
 /** (try to) add transaction to memory pool with a specified acceptance time **/
 static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPool& pool, TxValidationState &state, const CTransactionRef &tx,
                         int64_t nAcceptTime, std::list<CTransactionRef>* plTxnReplaced,
-                        bool bypass_limits, bool test_accept, CAmount* fee_out=nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+                        bool bypass_limits, bool test_accept, CAmount* fee_out=nullptr, bool prechecked=false) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     std::vector<OutputIndex> coins_to_uncache;
-    MemPoolAccept::ATMPArgs args { chainparams, state, nAcceptTime, plTxnReplaced, bypass_limits, coins_to_uncache, test_accept, fee_out };
+    MemPoolAccept::ATMPArgs args { chainparams, state, nAcceptTime, plTxnReplaced, bypass_limits, coins_to_uncache, test_accept, fee_out, prechecked };
     bool res = MemPoolAccept(pool).AcceptSingleTransaction(tx, args);
     if (!res) {
         // Remove coins that were not present in the coins cache before calling ATMPW;
@@ -1113,10 +1137,55 @@ static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPo
 
 bool AcceptToMemoryPool(CTxMemPool& pool, TxValidationState &state, const CTransactionRef &tx,
                         std::list<CTransactionRef>* plTxnReplaced,
-                        bool bypass_limits, bool test_accept, CAmount* fee_out)
+                        bool bypass_limits, bool test_accept, CAmount* fee_out, bool prechecked)
 {
     const CChainParams& chainparams = Params();
-    return AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, GetTime(), plTxnReplaced, bypass_limits, test_accept, fee_out);
+    return AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, GetTime(), plTxnReplaced, bypass_limits, test_accept, fee_out, prechecked);
+}
+
+bool PreCheckTransaction(CTxMemPool& pool, const CTransactionRef& ptx, TxValidationState& state, bool context_free_checked)
+{
+    AssertLockNotHeld(cs_main);
+    const CTransaction& tx = *ptx;
+    if (!context_free_checked && !CheckTransaction(tx, state)) {
+        return false; // state filled in by CheckTransaction
+    }
+
+    if (tx.HasMWEBTx() && !WITH_LOCK(cs_main, return IsMWEBEnabled(::ChainActive().Tip(), Params().GetConsensus()))) {
+        return state.Invalid(TxValidationResult::TX_NOT_STANDARD, "mweb-before-activation");
+    }
+
+    // MWEB: Check MWEB tx
+    if (!context_free_checked && !MWEB::Node::CheckTransaction(tx, state)) {
+        return false; // state filled in by CheckTransaction
+    }
+
+    // Scripts are only worth verifying, and their signatures only worth
+    // caching, if the transaction passes the cheap policy checks of
+    // AcceptToMemoryPool. Run those under the locks, as a test accept, and
+    // leave any failure for AcceptToMemoryPool to report.
+    std::vector<CTxOut> spent_outputs;
+    {
+        LOCK2(cs_main, pool.cs);
+        TxValidationState policy_state;
+        std::vector<OutputIndex> coins_to_uncache;
+        MemPoolAccept::ATMPArgs args{Params(), policy_state, GetTime(), /* replaced_transactions */ nullptr, /* bypass_limits */ false,
+                                     coins_to_uncache, /* test_accept */ true, /* fee_out */ nullptr, /* prechecked */ true};
+        const bool policy_ok = MemPoolAccept(pool).PolicyPreChecks(ptx, args, spent_outputs);
+        // As in AcceptToMemoryPool, don't let transactions that may be invalid fill the coins cache
+        for (const OutputIndex& index : coins_to_uncache) {
+            ::ChainstateActive().CoinsTip().Uncache(index);
+        }
+        if (!policy_ok || tx.vin.empty()) return true;
+    }
+
+    PrecomputedTransactionData txdata;
+    txdata.Init(tx, std::move(spent_outputs));
+    for (unsigned int i = 0; i < tx.vin.size(); ++i) {
+        CScriptCheck check(txdata.m_spent_outputs[i], tx, i, STANDARD_SCRIPT_VERIFY_FLAGS, /* cacheStore */ true, &txdata);
+        if (!check()) break;
+    }
+    return true;
 }
 
 CTransactionRef GetTransaction(const CBlockIndex* const block_index, const CTxMemPool* const mempool, const uint256& hash, const Consensus::Params& consensusParams, uint256& hashBlock)
@@ -1896,6 +1965,143 @@ void ThreadScriptCheck(int worker_num) {
     scriptcheckqueue.Thread();
 }
 
+/** Context-free proof of work check of a block header, to be run on the header check queue. */
+class CHeaderPoWCheck
+{
+private:
+    const CBlockHeader* m_header{nullptr};
+    const Consensus::Params* m_params{nullptr};
+
+public:
+    CHeaderPoWCheck() {}
+    CHeaderPoWCheck(const CBlockHeader& header, const Consensus::Params& params) : m_header(&header), m_params(&params) {}
+
+    bool operator()() { return CheckProofOfWork(m_header->GetPoWHash(), m_header->nBits, *m_params); }
+
+    void swap(CHeaderPoWCheck& check)
+    {
+        std::swap(m_header, check.m_header);
+        std::swap(m_params, check.m_params);
+    }
+};
+
+static CCheckQueue<CHeaderPoWCheck> headercheckqueue(128);
+
+void ThreadHeaderCheck(int worker_num) {
+    util::ThreadRename(strprintf("headerch.%i", worker_num));
+    headercheckqueue.Thread();
+}
+
+/** Check the proof of work of a batch of headers, in parallel if there are header check threads. */
+static bool CheckHeadersProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& params)
+{
+    if (!g_parallel_header_checks) {
+        for (const CBlockHeader& header : headers) {
+            if (!CheckProofOfWork(header.GetPoWHash(), header.nBits, params)) return false;
+        }
+        return true;
+    }
+
+    std::vector<CHeaderPoWCheck> checks;
+    checks.reserve(headers.size());
+    for (const CBlockHeader& header : headers) {
+        checks.emplace_back(header, params);
+    }
+    CCheckQueueControl<CHeaderPoWCheck> control(&headercheckqueue);
+    control.Add(checks);
+    return control.Wait();
+}
+
+/** PreCheckTransaction of a transaction, to be run on the transaction pre-check queue. */
+class CTxPreCheck
+{
+private:
+    CTxMemPool* m_pool{nullptr};
+    CTransactionRef* m_tx{nullptr};
+    TxValidationState* m_state{nullptr};
+    bool m_context_free_checked{false};
+    //! Serialized transaction to read into m_tx first, if any, and where it is in m_data
+    const std::vector<unsigned char>* m_data{nullptr};
+    size_t m_pos{0};
+    size_t m_size{0};
+
+public:
+    CTxPreCheck() {}
+    CTxPreCheck(CTxMemPool& pool, CTransactionRef& tx, TxValidationState& state, bool context_free_checked, const std::vector<unsigned char>* data, size_t pos, size_t size) :
+        m_pool(&pool), m_tx(&tx), m_state(&state), m_context_free_checked(context_free_checked), m_data(data), m_pos(pos), m_size(size) {}
+
+    // The outcome is in the state. Never fail, as the queue would skip the remaining checks.
+    bool operator()()
+    {
+        if (m_data) {
+            try {
+                VectorReader reader(SER_DISK, CLIENT_VERSION, *m_data, m_pos);
+                reader >> *m_tx;
+                // The transaction must take up exactly its recorded size
+                if (reader.size() + m_size != m_data->size() - m_pos) {
+                    throw std::ios_base::failure("transaction size mismatch");
+                }
+            } catch (const std::exception&) {
+                m_tx->reset();
+                return true;
+            }
+        }
+        PreCheckTransaction(*m_pool, *m_tx, *m_state, m_context_free_checked);
+        return true;
+    }
+
+    void swap(CTxPreCheck& check)
+    {
+        std::swap(m_pool, check.m_pool);
+        std::swap(m_tx, check.m_tx);
+        std::swap(m_state, check.m_state);
+        std::swap(m_context_free_checked, check.m_context_free_checked);
+        std::swap(m_data, check.m_data);
+        std::swap(m_pos, check.m_pos);
+        std::swap(m_size, check.m_size);
+    }
+};
+
+static CCheckQueue<CTxPreCheck> txprecheckqueue(16);
+
+void ThreadTxPreCheck(int worker_num) {
+    util::ThreadRename(strprintf("txprech.%i", worker_num));
+    txprecheckqueue.Thread();
+}
+
+/**
+ * PreCheckTransaction a batch of transactions, in parallel if there are
+ * pre-checking threads. If data is given, the transactions are deserialized
+ * from it first, at the given positions and sizes, and left null if that fails.
+ */
+static std::vector<TxValidationState> PreCheckTransactions(CTxMemPool& pool, std::vector<CTransactionRef>& txs, bool context_free_checked,
+                                                           const std::vector<unsigned char>* data, const std::vector<std::pair<size_t, size_t>>& positions)
+{
+    std::vector<TxValidationState> states(txs.size());
+    std::vector<CTxPreCheck> checks;
+    checks.reserve(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i) {
+        checks.emplace_back(pool, txs[i], states[i], context_free_checked, data, data ? positions[i].first : 0, data ? positions[i].second : 0);
+    }
+    if (!g_parallel_tx_prechecks) {
+        for (CTxPreCheck& check : checks) {
+            check();
+        }
+        return states;
+    }
+
+    CCheckQueueControl<CTxPreCheck> control(&txprecheckqueue);
+    control.Add(checks);
+    control.Wait();
+    return states;
+}
+
+std::vector<TxValidationState> PreCheckTransactions(CTxMemPool& pool, const std::vector<CTransactionRef>& txs)
+{
+    std::vector<CTransactionRef> txs_copy{txs};
+    return PreCheckTransactions(pool, txs_copy, /* context_free_checked */ false, /* data */ nullptr, {});
+}
+
 VersionBitsCache versionbitscache GUARDED_BY(cs_main);
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
@@ -3764,7 +3970,7 @@ static bool ContextualCheckBlock(const CBlock& block, BlockValidationState& stat
     return true;
 }
 
-bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fCheckPOW)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
@@ -3784,7 +3990,7 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus())) {
+        if (!CheckBlockHeader(block, state, chainparams.GetConsensus(), fCheckPOW)) {
             LogPrint(BCLog::VALIDATION, "%s: Consensus::CheckBlockHeader: %s, %s\n", __func__, hash.ToString(), state.ToString());
             return false;
         }
@@ -3856,12 +4062,21 @@ bool BlockManager::AcceptBlockHeader(const CBlockHeader& block, BlockValidationS
 bool ChainstateManager::ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, BlockValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
 {
     AssertLockNotHeld(cs_main);
+    // Check the proof of work of the whole batch up front, outside cs_main, so
+    // that only the contextual checks are done while holding it. If the last
+    // header is already known the batch is most likely redundant, and the
+    // checks are left to AcceptBlockHeader, which skips known headers. If any
+    // header fails, AcceptBlockHeader checks them one by one, to find out which.
+    bool pow_checked{false};
+    if (!headers.empty() && WITH_LOCK(cs_main, return m_blockman.m_block_index.count(headers.back().GetHash())) == 0) {
+        pow_checked = CheckHeadersProofOfWork(headers, chainparams.GetConsensus());
+    }
     {
         LOCK(cs_main);
         for (const CBlockHeader& header : headers) {
             CBlockIndex *pindex = nullptr; // Use a temp pindex instead of ppindex to avoid a const_cast
             bool accepted = m_blockman.AcceptBlockHeader(
-                header, state, chainparams, &pindex);
+                header, state, chainparams, &pindex, /* fCheckPOW */ !pow_checked);
             ::ChainstateActive().CheckBlockIndex(chainparams.GetConsensus());
 
             if (!accepted) {
@@ -5186,7 +5401,36 @@ int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::D
     return VersionBitsStateSinceHeight(::ChainActive().Tip(), params, pos, versionbitscache);
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/** mempool.dat with all transactions in one stream */
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_CHUNKS = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+/** Most transactions in a chunk of mempool.dat */
+static const size_t MEMPOOL_DUMP_CHUNK_SIZE = 1000;
+/** Size of the transactions after which a chunk of mempool.dat is ended, well below MAX_SIZE */
+static const size_t MEMPOOL_DUMP_CHUNK_BYTES = 4 * 1024 * 1024;
+
+namespace {
+/**
+ * A chunk of mempool.dat: a fixed-size record for each of its transactions,
+ * followed by the transactions themselves. Readers find any transaction of a
+ * chunk from the records alone, so that they can be deserialized in parallel,
+ * and expired ones don't need to be deserialized at all.
+ */
+struct MempoolDumpChunk {
+    struct Entry {
+        int64_t time;
+        int64_t fee_delta;
+        uint32_t tx_size;
+
+        SERIALIZE_METHODS(Entry, obj) { READWRITE(obj.time, obj.fee_delta, obj.tx_size); }
+    };
+
+    std::vector<Entry> entries;
+    std::vector<unsigned char> tx_data;
+
+    SERIALIZE_METHODS(MempoolDumpChunk, obj) { READWRITE(obj.entries, obj.tx_data); }
+};
+} // namespace
 
 bool LoadMempool(CTxMemPool& pool)
 {
@@ -5206,51 +5450,147 @@ bool LoadMempool(CTxMemPool& pool)
     int64_t unbroadcast = 0;
     int64_t nNow = GetTime();
 
+    // Time spent reading from disk, deserializing and pre-checking
+    // transactions in parallel, and accepting them under cs_main
+    const int64_t load_start = GetTimeMicros();
+    int64_t read_time = 0;
+    int64_t check_time = 0;
+    int64_t accept_time = 0;
+    size_t chunks = 0;
+
+    // Accept a batch of pre-checked transactions in the order of the file,
+    // which has parents before their children. Returns false on shutdown.
+    const auto accept_transactions = [&](const std::vector<CTransactionRef>& txs, const std::vector<int64_t>& times,
+                                         const std::vector<int64_t>& fee_deltas, std::vector<TxValidationState>& states) {
+        const int64_t accept_start = GetTimeMicros();
+        for (size_t i = 0; i < txs.size(); ++i) {
+            const CTransactionRef& tx = txs[i];
+            if (!tx) {
+                ++failed;
+                continue;
+            }
+            if (fee_deltas[i]) {
+                pool.PrioritiseTransaction(tx->GetHash(), fee_deltas[i]);
+            }
+            TxValidationState& state = states[i];
+            if (state.IsValid()) {
+                LOCK(cs_main);
+                AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, times[i],
+                                           nullptr /* plTxnReplaced */, false /* bypass_limits */,
+                                           false /* test_accept */, nullptr /* fee_out */, true /* prechecked */);
+            }
+            if (state.IsValid()) {
+                ++count;
+            } else {
+                // mempool may contain the transaction already, e.g. from
+                // wallet(s) having loaded it while we were processing
+                // mempool transactions; consider these as valid, instead of
+                // failed, but mark them as 'already there'
+                if (pool.exists(tx->GetHash())) {
+                    ++already_there;
+                } else {
+                    ++failed;
+                }
+            }
+            if (ShutdownRequested()) return false;
+        }
+        accept_time += GetTimeMicros() - accept_start;
+        return true;
+    };
+
     try {
         uint64_t version;
         file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        if (version != MEMPOOL_DUMP_VERSION && version != MEMPOOL_DUMP_VERSION_NO_CHUNKS) {
             return false;
         }
-        uint64_t num;
-        file >> num;
-        while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                pool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+
+        if (version == MEMPOOL_DUMP_VERSION) {
+            // The transactions passed the context-free checks of the version
+            // that wrote the file, which are only repeated if it was another one.
+            int writer_version;
+            file >> writer_version;
+            const bool context_free_checked = writer_version == CLIENT_VERSION;
+
+            while (true) {
+                const int64_t read_start = GetTimeMicros();
+                MempoolDumpChunk chunk;
+                file >> chunk;
+                read_time += GetTimeMicros() - read_start;
+                if (chunk.entries.empty()) break;
+                ++chunks;
+
+                std::vector<CTransactionRef> txs;
+                std::vector<int64_t> times;
+                std::vector<int64_t> fee_deltas;
+                std::vector<std::pair<size_t, size_t>> positions;
+                size_t pos = 0;
+                for (const MempoolDumpChunk::Entry& entry : chunk.entries) {
+                    pos += entry.tx_size;
+                }
+                if (pos != chunk.tx_data.size()) {
+                    throw std::ios_base::failure("mempool chunk size mismatch");
+                }
+                pos = 0;
+                for (const MempoolDumpChunk::Entry& entry : chunk.entries) {
+                    if (entry.time > nNow - nExpiryTimeout) {
+                        times.push_back(entry.time);
+                        fee_deltas.push_back(entry.fee_delta);
+                        positions.emplace_back(pos, entry.tx_size);
+                    } else {
+                        // Only expired transactions with a fee delta need to be deserialized, to keep the delta
+                        if (entry.fee_delta) {
+                            CTransactionRef tx;
+                            VectorReader(SER_DISK, CLIENT_VERSION, chunk.tx_data, pos, tx);
+                            pool.PrioritiseTransaction(tx->GetHash(), entry.fee_delta);
+                        }
+                        ++expired;
+                    }
+                    pos += entry.tx_size;
+                }
+                txs.resize(positions.size());
+
+                const int64_t check_start = GetTimeMicros();
+                std::vector<TxValidationState> states = PreCheckTransactions(pool, txs, context_free_checked, &chunk.tx_data, positions);
+                check_time += GetTimeMicros() - check_start;
+
+                if (!accept_transactions(txs, times, fee_deltas, states)) return false;
             }
-            TxValidationState state;
-            if (nTime > nNow - nExpiryTimeout) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, nTime,
-                                           nullptr /* plTxnReplaced */, false /* bypass_limits */,
-                                           false /* test_accept */);
-                if (state.IsValid()) {
-                    ++count;
-                } else {
-                    // mempool may contain the transaction already, e.g. from
-                    // wallet(s) having loaded it while we were processing
-                    // mempool transactions; consider these as valid, instead of
-                    // failed, but mark them as 'already there'
-                    if (pool.exists(tx->GetHash())) {
-                        ++already_there;
+        } else {
+            uint64_t num;
+            file >> num;
+            while (num) {
+                std::vector<CTransactionRef> txs;
+                std::vector<int64_t> times;
+                std::vector<int64_t> fee_deltas;
+                const int64_t read_start = GetTimeMicros();
+                for (; num && txs.size() < MEMPOOL_DUMP_CHUNK_SIZE; --num) {
+                    CTransactionRef tx;
+                    int64_t nTime;
+                    int64_t nFeeDelta;
+                    file >> tx;
+                    file >> nTime;
+                    file >> nFeeDelta;
+                    if (nTime > nNow - nExpiryTimeout) {
+                        txs.push_back(std::move(tx));
+                        times.push_back(nTime);
+                        fee_deltas.push_back(nFeeDelta);
                     } else {
-                        ++failed;
+                        if (nFeeDelta) pool.PrioritiseTransaction(tx->GetHash(), nFeeDelta);
+                        ++expired;
                     }
                 }
-            } else {
-                ++expired;
+                read_time += GetTimeMicros() - read_start;
+                ++chunks;
+
+                const int64_t check_start = GetTimeMicros();
+                std::vector<TxValidationState> states = PreCheckTransactions(pool, txs);
+                check_time += GetTimeMicros() - check_start;
+
+                if (!accept_transactions(txs, times, fee_deltas, states)) return false;
             }
-            if (ShutdownRequested())
-                return false;
         }
+
         std::map<uint256, CAmount> mapDeltas;
         file >> mapDeltas;
 
@@ -5278,6 +5618,8 @@ bool LoadMempool(CTxMemPool& pool)
     }
 
     LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there, %i waiting for initial broadcast\n", count, failed, expired, already_there, unbroadcast);
+    LogPrintf("Loaded mempool in %u chunks: %.2fs (%.2fs reading, %.2fs deserializing and checking, %.2fs accepting)\n",
+              chunks, (GetTimeMicros() - load_start) * MICRO, read_time * MICRO, check_time * MICRO, accept_time * MICRO);
     return true;
 }
 
@@ -5313,14 +5655,22 @@ bool DumpMempool(const CTxMemPool& pool)
 
         uint64_t version = MEMPOOL_DUMP_VERSION;
         file << version;
+        file << int{CLIENT_VERSION};
 
-        file << (uint64_t)vinfo.size();
+        MempoolDumpChunk chunk;
         for (const auto& i : vinfo) {
-            file << *(i.tx);
-            file << int64_t{count_seconds(i.m_time)};
-            file << int64_t{i.nFeeDelta};
+            const size_t tx_start = chunk.tx_data.size();
+            CVectorWriter(SER_DISK, CLIENT_VERSION, chunk.tx_data, tx_start, *i.tx);
+            chunk.entries.push_back({int64_t{count_seconds(i.m_time)}, int64_t{i.nFeeDelta}, uint32_t(chunk.tx_data.size() - tx_start)});
             mapDeltas.erase(i.tx->GetHash());
+            if (chunk.entries.size() == MEMPOOL_DUMP_CHUNK_SIZE || chunk.tx_data.size() >= MEMPOOL_DUMP_CHUNK_BYTES) {
+                file << chunk;
+                chunk = MempoolDumpChunk{};
+            }
         }
+        if (!chunk.entries.empty()) file << chunk;
+        // An empty chunk ends the transactions
+        file << MempoolDumpChunk{};
 
         file << mapDeltas;
 
@@ -123,6 +123,12 @@ extern std::atomic_bool fReindex;
  * False indicates all script checking is done on the main threadMessageHandler thread.
  */
 extern bool g_parallel_script_checks;
+/** Whether there are dedicated header-checking threads running, to check the proof of work of
+ * batches of headers in parallel. */
+extern bool g_parallel_header_checks;
+/** Whether there are dedicated transaction pre-checking threads running, to run the checks
+ * of batches of transactions that don't need cs_main in parallel. */
+extern bool g_parallel_tx_prechecks;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
@@ -162,6 +168,10 @@ bool LoadGenesisBlock(const CChainParams& chainparams);
 void UnloadBlockIndex(CTxMemPool* mempool, ChainstateManager& chainman);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck(int worker_num);
+/** Run an instance of the header proof of work checking thread */
+void ThreadHeaderCheck(int worker_num);
+/** Run an instance of the transaction pre-checking thread */
+void ThreadTxPreCheck(int worker_num);
 /**
  * Return transaction from the block at block_index.
  * If block_index is not provided, fall back to mempool.
@@ -209,10 +219,32 @@ void PruneBlockFilesManual(int nManualPruneHeight);
 
 /** (try to) add transaction to memory pool
  * plTxnReplaced will be appended to with all transactions replaced from mempool
- * @param[out] fee_out optional argument to return tx fee to the caller **/
+ * @param[out] fee_out optional argument to return tx fee to the caller
+ * @param[in] prechecked whether PreCheckTransaction passed for tx, so that its checks can be skipped **/
 bool AcceptToMemoryPool(CTxMemPool& pool, TxValidationState &state, const CTransactionRef &tx,
                         std::list<CTransactionRef>* plTxnReplaced,
-                        bool bypass_limits, bool test_accept=false, CAmount* fee_out=nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+                        bool bypass_limits, bool test_accept=false, CAmount* fee_out=nullptr, bool prechecked=false) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+/**
+ * Run the checks of AcceptToMemoryPool that don't need cs_main or the mempool
+ * lock to be held throughout: CheckTransaction, validation of the MWEB
+ * transaction and script verification. Scripts are only verified if the
+ * transaction passes the policy checks of AcceptToMemoryPool, which are run
+ * under the locks first, so that transactions we'd reject cheaply don't cost
+ * signature checks or fill the signature cache. The signatures are stored in
+ * the signature cache, so that the script checks of AcceptToMemoryPool don't
+ * verify them again. Policy and script failures are left for
+ * AcceptToMemoryPool to report.
+ *
+ * If context_free_checked is set, the transaction is known to have passed
+ * CheckTransaction and the MWEB validation already, and they are skipped.
+ *
+ * Returns false, with state filled in, if the transaction can't be accepted.
+ */
+bool PreCheckTransaction(CTxMemPool& pool, const CTransactionRef& ptx, TxValidationState& state, bool context_free_checked=false) LOCKS_EXCLUDED(cs_main);
+
+/** PreCheckTransaction a batch of transactions, in parallel if there are pre-checking threads */
+std::vector<TxValidationState> PreCheckTransactions(CTxMemPool& pool, const std::vector<CTransactionRef>& txs) LOCKS_EXCLUDED(cs_main);
 
 /** Get the BIP9 state for a given deployment at the current tip. */
 ThresholdState VersionBitsTipState(const Consensus::Params& params, Consensus::DeploymentPos pos);
@@ -447,12 +479,15 @@ public:
     /**
      * If a block header hasn't already been seen, call CheckBlockHeader on it, ensure
      * that it doesn't descend from an invalid block, and then add it to m_block_index.
+     * The proof of work check is skipped if fCheckPOW is false, because the caller
+     * already checked it.
      */
     bool AcceptBlockHeader(
         const CBlockHeader& block,
         BlockValidationState& state,
         const CChainParams& chainparams,
-        CBlockIndex** ppindex) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+        CBlockIndex** ppindex,
+        bool fCheckPOW = true) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
     ~BlockManager() {
         Unload();
@@ -989,7 +1024,7 @@ CBlockFileInfo* GetBlockFileInfo(size_t n);
 /** Dump the mempool to disk. */
 bool DumpMempool(const CTxMemPool& pool);
 
-/** Load the mempool from disk. */
+/** Load the mempool from disk, pre-checking the transactions of each chunk of the file in parallel. */
 bool LoadMempool(CTxMemPool& pool);
 
 //! Check whether the block associated with this index entry is pruned or not.
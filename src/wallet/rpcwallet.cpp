@@ -14,6 +14,7 @@
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <policy/rbf.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/rawtransaction_util.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
@@ -1585,6 +1586,15 @@ static RPCHelpMan listtransactions()
         nCount = ret.size() - nFrom;
 
     const std::vector<UniValue>& txs = ret.getValues();
+    if (JSONWriter* writer = request.BeginStreamedResult()) {
+        writer->BeginArray();
+        for (auto it = txs.rend() - nFrom - nCount; it != txs.rend() - nFrom; ++it) { // Oldest to newest
+            writer->Value(*it);
+            writer->Drain();
+        }
+        writer->EndArray();
+        return NullUniValue;
+    }
     UniValue result{UniValue::VARR};
     result.push_backV({ txs.rend() - nFrom - nCount, txs.rend() - nFrom }); // Return oldest to newest
     return result;
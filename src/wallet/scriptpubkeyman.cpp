@@ -2470,4 +2470,10 @@ const std::vector<DestinationAddr> DescriptorScriptPubKeyMan::GetScriptPubKeys()
         script_pub_keys.push_back(script_pub_key.first);
     }
     return script_pub_keys;
-}
\ No newline at end of file
+}
+
+size_t DescriptorScriptPubKeyMan::GetScriptPubKeyCount() const
+{
+    LOCK(cs_desc_man);
+    return m_map_script_pub_keys.size();
+}
@@ -652,6 +652,8 @@ public:
 
     const WalletDescriptor GetWalletDescriptor() const EXCLUSIVE_LOCKS_REQUIRED(cs_desc_man);
     const std::vector<DestinationAddr> GetScriptPubKeys() const;
+    //! Number of scriptPubKeys derived so far. Grows as the descriptor range is topped up.
+    size_t GetScriptPubKeyCount() const;
 };
 
 #endif // BITCOIN_WALLET_SCRIPTPUBKEYMAN_H
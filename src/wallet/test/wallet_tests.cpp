@@ -9,10 +9,19 @@
 #include <stdint.h>
 #include <vector>
 
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/validation.h>
+#include <index/blockfilterindex.h>
 #include <interfaces/chain.h>
+#include <key_io.h>
+#include <miner.h>
 #include <node/context.h>
 #include <policy/policy.h>
+#include <pow.h>
 #include <rpc/server.h>
+#include <script/descriptor.h>
+#include <script/interpreter.h>
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 #include <util/ref.h>
@@ -21,6 +30,8 @@
 #include <wallet/coincontrol.h>
 #include <wallet/test/wallet_test_fixture.h>
 
+#include <test_framework/TxBuilder.h>
+
 #include <boost/test/unit_test.hpp>
 #include <univalue.h>
 
@@ -175,6 +186,148 @@ BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions, TestChain100Setup)
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(scan_for_wallet_transactions_mweb, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    const CScript p2pk_scriptPubKey = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Mine a block on the mempool, which includes the HogEx once MWEB is active
+    const auto mine = [&]() {
+        auto block = std::make_shared<CBlock>(BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(p2pk_scriptPubKey)->block);
+        block->hashMerkleRoot = BlockMerkleRoot(*block);
+        while (!CheckProofOfWork(block->GetPoWHash(), block->nBits, chainparams.GetConsensus())) ++block->nNonce;
+        BOOST_REQUIRE(Assert(m_node.chainman)->ProcessNewBlock(chainparams, block, true, nullptr));
+        return block;
+    };
+    const auto accept = [&](CMutableTransaction& mtx) {
+        std::vector<unsigned char> sig;
+        const uint256 hash = SignatureHash(p2pk_scriptPubKey, mtx, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+        BOOST_REQUIRE(coinbaseKey.Sign(hash, sig));
+        sig.push_back((unsigned char)SIGHASH_ALL);
+        mtx.vin[0].scriptSig << sig;
+
+        LOCK(cs_main);
+        TxValidationState state;
+        const bool accepted = AcceptToMemoryPool(*m_node.mempool, state, MakeTransactionRef(mtx), nullptr /* plTxnReplaced */, true /* bypass_limits */);
+        BOOST_REQUIRE_MESSAGE(accepted, state.ToString());
+    };
+    // Peg the output of a coinbase transaction, less a fee, into an MWEB output to the receiver
+    const auto peg_in = [&](const CTransactionRef& coinbase, const StealthAddress& receiver) {
+        const CAmount amount = coinbase->vout[0].nValue - 10000;
+        const test::Tx pegin = test::TxBuilder()
+            .AddPeginKernel(amount)
+            .AddOutput(amount, SecretKey::Random(), receiver)
+            .Build();
+        CMutableTransaction mtx;
+        mtx.nVersion = 2;
+        mtx.vin.emplace_back(COutPoint(coinbase->GetHash(), 0));
+        mtx.vout.emplace_back(amount, GetScriptForPegin(pegin.GetKernels().front().GetKernelID()));
+        mtx.mweb_tx = MWEB::Tx(pegin.GetTransaction());
+        accept(mtx);
+        return pegin;
+    };
+    const auto set_last_block = [](CWallet& wallet) {
+        LOCK2(cs_main, wallet.cs_wallet);
+        wallet.SetLastBlockProcessed(::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash());
+    };
+
+    NodeContext node;
+    auto chain = interfaces::MakeChain(node);
+
+    // A legacy HD wallet, which has an MWEB keychain
+    CWallet legacy_wallet(chain.get(), "", CreateDummyWalletDatabase());
+    legacy_wallet.SetMinVersion(FEATURE_LATEST);
+    LegacyScriptPubKeyMan* legacy_spk_man = legacy_wallet.GetOrCreateLegacyScriptPubKeyMan();
+    legacy_spk_man->SetHDSeed(legacy_spk_man->GenerateNewSeed());
+    BOOST_REQUIRE(legacy_spk_man->TopUp());
+    BOOST_REQUIRE(legacy_spk_man->GetMWEBKeychain());
+    // The first receive address, after the change and peg-in addresses
+    const StealthAddress mweb_address = legacy_spk_man->GetMWEBKeychain()->GetStealthAddress(2);
+
+    // A blank descriptor wallet with one imported descriptor, since
+    // SetupDescriptorScriptPubKeyMans fails on the MWEB descriptor, which has
+    // no scan key. The wallet has no MWEB keychain and rescans using block
+    // filters.
+    CWallet descriptor_wallet(chain.get(), "", CreateDummyWalletDatabase());
+    descriptor_wallet.SetMinVersion(FEATURE_LATEST);
+    descriptor_wallet.SetWalletFlag(WALLET_FLAG_DESCRIPTORS | WALLET_FLAG_BLANK_WALLET);
+    CKey descriptor_key;
+    descriptor_key.MakeNewKey(true);
+    FlatSigningProvider provider;
+    std::string error;
+    WalletDescriptor w_desc(Parse("wpkh(" + EncodeSecret(descriptor_key) + ")", provider, error, false), 0, 0, 0, 0);
+    BOOST_REQUIRE(descriptor_wallet.AddWalletDescriptor(w_desc, provider, "", false));
+    const CScript descriptor_script = GetScriptForDestination(WitnessV0KeyHash(descriptor_key.GetPubKey()));
+
+    while (!IsMWEBEnabled(WITH_LOCK(cs_main, return ::ChainActive().Tip()), chainparams.GetConsensus())) {
+        mine();
+    }
+    const CBlockIndex* start_index = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+
+    // The MWEB receive and the canonical receive are in different MWEB blocks,
+    // among MWEB blocks that concern neither wallet. The first MWEB
+    // block needs a peg-in, as its HogEx has no previous HogEx to spend.
+    const test::Tx mweb_receive = peg_in(m_coinbase_txns[0], mweb_address);
+    mine();
+    peg_in(m_coinbase_txns[1], StealthAddress::Random());
+    mine();
+    CMutableTransaction canonical_receive;
+    canonical_receive.nVersion = 2;
+    canonical_receive.vin.emplace_back(COutPoint(m_coinbase_txns[2]->GetHash(), 0));
+    canonical_receive.vout.emplace_back(m_coinbase_txns[2]->vout[0].nValue - 10000, descriptor_script);
+    accept(canonical_receive);
+    const std::shared_ptr<CBlock> canonical_block = mine();
+    BOOST_REQUIRE(!canonical_block->mweb_block.IsNull());
+    peg_in(m_coinbase_txns[3], StealthAddress::Random());
+    mine();
+    mine();
+
+    // The legacy wallet reads every block and finds the MWEB output.
+    {
+        set_last_block(legacy_wallet);
+        WalletRescanReserver reserver(legacy_wallet);
+        reserver.reserve();
+        CWallet::ScanResult result = legacy_wallet.ScanForWalletTransactions(start_index->GetBlockHash(), start_index->nHeight, {} /* max_height */, reserver, false /* update */);
+        BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, ::ChainActive().Height());
+
+        const mw::Hash& output_id = mweb_receive.GetOutputs().front().GetOutputID();
+        mw::Coin coin;
+        BOOST_CHECK(legacy_wallet.GetCoin(output_id, coin) && coin.IsMine());
+        BOOST_CHECK_EQUAL(coin.amount, mweb_receive.GetOutputs().front().GetAmount());
+        BOOST_CHECK(legacy_wallet.FindWalletTx(output_id) != nullptr);
+    }
+
+    // The descriptor wallet skips the MWEB blocks whose filter doesn't match
+    // and finds the canonical output.
+    BOOST_REQUIRE(InitBlockFilterIndex(BlockFilterType::BASIC, 1 << 20, true));
+    BlockFilterIndex* filter_index = GetBlockFilterIndex(BlockFilterType::BASIC);
+    filter_index->Start();
+    const int64_t time_start = GetTimeMillis();
+    while (!filter_index->BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + 10 * 1000 > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    {
+        set_last_block(descriptor_wallet);
+        WalletRescanReserver reserver(descriptor_wallet);
+        reserver.reserve();
+        ASSERT_DEBUG_LOG("fast variant using block filters");
+        CWallet::ScanResult result = descriptor_wallet.ScanForWalletTransactions(start_index->GetBlockHash(), start_index->nHeight, {} /* max_height */, reserver, false /* update */);
+        BOOST_CHECK_EQUAL(result.status, CWallet::ScanResult::SUCCESS);
+        BOOST_CHECK_EQUAL(*result.last_scanned_height, ::ChainActive().Height());
+
+        LOCK(descriptor_wallet.cs_wallet);
+        const CWalletTx* wtx = descriptor_wallet.GetWalletTx(canonical_receive.GetHash());
+        BOOST_REQUIRE(wtx != nullptr);
+        BOOST_CHECK(wtx->m_confirm.hashBlock == canonical_block->GetHash());
+    }
+
+    filter_index->Stop();
+    DestroyBlockFilterIndex(BlockFilterType::BASIC);
+    SyncWithValidationInterfaceQueue();
+}
+
 BOOST_FIXTURE_TEST_CASE(importmulti_rescan, TestChain100Setup)
 {
     // Cap last block file size, and mine new block in a new block file.
@@ -2079,6 +2079,65 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+namespace {
+/**
+ * The scriptPubKeys of a descriptor wallet, for skipping blocks whose BIP 158
+ * basic filter matches none of them during a rescan. Descriptors are topped up
+ * as the scan finds used keys, so the set is extended whenever a descriptor
+ * has derived more scripts since the last update.
+ */
+class FastWalletRescanFilter
+{
+public:
+    explicit FastWalletRescanFilter(const CWallet& wallet) : m_wallet(wallet)
+    {
+        UpdateIfNeeded();
+    }
+
+    void UpdateIfNeeded()
+    {
+        for (ScriptPubKeyMan* spk_man : m_wallet.GetAllScriptPubKeyMans()) {
+            auto desc_spk_man = dynamic_cast<DescriptorScriptPubKeyMan*>(spk_man);
+            assert(desc_spk_man != nullptr);
+            const size_t count = desc_spk_man->GetScriptPubKeyCount();
+            size_t& last_count = m_last_counts[desc_spk_man->GetID()];
+            if (count == last_count) continue;
+            for (const DestinationAddr& dest : desc_spk_man->GetScriptPubKeys()) {
+                // MWEB outputs are not part of the filter and are handled separately.
+                if (dest.IsMWEB()) continue;
+                const CScript& script = dest.GetScript();
+                m_filter_set.emplace(script.begin(), script.end());
+            }
+            last_count = count;
+        }
+    }
+
+    /** Returns nullopt if the block's filter is not available. */
+    Optional<bool> MatchesBlock(const uint256& block_hash) const
+    {
+        return m_wallet.chain().blockFilterMatchesAny(BlockFilterType::BASIC, block_hash, m_filter_set);
+    }
+
+    /**
+     * Whether blocks with MWEB data must be read even if their filter doesn't
+     * match. MWEB outputs are not in the filter, and only a wallet with an MWEB
+     * keychain can rewind them. Without one, the wallet's MWEB transactions are
+     * peg-ins, whose canonical inputs are matched by the filter.
+     */
+    bool ScansMWEB() const
+    {
+        const ScriptPubKeyMan* mweb_spk_man = m_wallet.GetScriptPubKeyMan(OutputType::MWEB, false);
+        return mweb_spk_man != nullptr && mweb_spk_man->GetMWEBKeychain() != nullptr;
+    }
+
+private:
+    const CWallet& m_wallet;
+    /** Number of scriptPubKeys of each descriptor when it was last added to the set. */
+    std::map<uint256, size_t> m_last_counts;
+    GCSFilter::ElementSet m_filter_set;
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -2096,6 +2155,13 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
  *         pruning or corruption). USER_ABORT if the rescan was aborted before
  *         it could complete.
  *
+ * With -blockfilterindex, descriptor wallets only read blocks whose basic
+ * filter matches one of their scriptPubKeys. MWEB outputs are not covered by
+ * the filter, so if the wallet has an MWEB keychain, non-matching blocks that
+ * have an MWEB header are still read, but only their MWEB data is scanned.
+ * Every block after MWEB activation has an MWEB header, so for such wallets
+ * only blocks before activation are skipped.
+ *
  * @pre Caller needs to make sure start_block (and the optional stop_block) are on
  * the main chain after to the addition of any new keys you want to detect
  * transactions for.
@@ -2110,7 +2176,13 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
     uint256 block_hash = start_block;
     ScanResult result;
 
-    WalletLogPrintf("Rescan started from block %s...\n", start_block.ToString());
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS) && chain().hasBlockFilterIndex(BlockFilterType::BASIC)) {
+        fast_rescan_filter = MakeUnique<FastWalletRescanFilter>(*this);
+    }
+
+    WalletLogPrintf("Rescan started from block %s (%s)...\n", start_block.ToString(),
+                    fast_rescan_filter ? "fast variant using block filters" : "slow variant inspecting all blocks");
 
     fAbortRescan = false;
     ShowProgress(strprintf("%s " + _("Rescanning...").translated, GetDisplayName()), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
@@ -2135,11 +2207,28 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", block_height, progress_current);
         }
 
+        // If the block filter matches none of our scripts, the canonical
+        // transactions can be skipped, and the block only needs to be read
+        // if it has MWEB data that could be ours.
+        bool fetch_block = true;
+        bool scan_transactions = true;
+        if (fast_rescan_filter) {
+            fast_rescan_filter->UpdateIfNeeded();
+            Optional<bool> matches_block = fast_rescan_filter->MatchesBlock(block_hash);
+            if (matches_block && !*matches_block) {
+                scan_transactions = false;
+                fetch_block = false;
+                if (fast_rescan_filter->ScansMWEB()) {
+                    chain().findBlock(block_hash, FoundBlock().hasMWEB(fetch_block));
+                }
+            }
+        }
+
         CBlock block;
         bool next_block;
         uint256 next_block_hash;
         bool reorg = false;
-        if (chain().findBlock(block_hash, FoundBlock().data(block)) && !block.IsNull()) {
+        if (!fetch_block || (chain().findBlock(block_hash, FoundBlock().data(block)) && !block.IsNull())) {
             LOCK(cs_wallet);
             next_block = chain().findNextBlock(block_hash, block_height, FoundBlock().hash(next_block_hash), &reorg);
             if (reorg) {
@@ -2151,7 +2240,7 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
                 result.status = ScanResult::FAILURE;
                 break;
             }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
+            for (size_t posInBlock = 0; scan_transactions && posInBlock < block.vtx.size(); ++posInBlock) {
                 SyncTransaction(block.vtx[posInBlock], boost::none, {CWalletTx::Status::CONFIRMED, block_height, block_hash, (int)posInBlock}, fUpdate);
             }
 
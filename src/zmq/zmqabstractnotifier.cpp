@@ -8,22 +8,32 @@
 
 const int CZMQAbstractNotifier::DEFAULT_ZMQ_SNDHWM;
 
+const std::vector<CZMQPayloads::Payload>* CZMQPayloads::Get(const std::string& topic, const Builder& build)
+{
+    auto it = m_payloads.find(topic);
+    if (it == m_payloads.end()) {
+        it = m_payloads.emplace(topic, std::make_pair(false, std::vector<Payload>{})).first;
+        it->second.first = build(it->second.second);
+    }
+    return it->second.first ? &it->second.second : nullptr;
+}
+
 CZMQAbstractNotifier::~CZMQAbstractNotifier()
 {
     assert(!psocket);
 }
 
-bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/)
+bool CZMQAbstractNotifier::NotifyBlock(const CBlockIndex * /*CBlockIndex*/, const std::shared_ptr<const CBlock>& /*block*/, CZMQPayloads& /*payloads*/)
 {
     return true;
 }
 
-bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/)
+bool CZMQAbstractNotifier::NotifyTransaction(const CTransaction &/*transaction*/, CZMQPayloads& /*payloads*/)
 {
     return true;
 }
 
-bool CZMQAbstractNotifier::NotifyBlockConnect(const CBlockIndex * /*CBlockIndex*/)
+bool CZMQAbstractNotifier::NotifyBlockConnect(const CBlockIndex * /*CBlockIndex*/, const CBlock& /*block*/, CZMQPayloads& /*payloads*/)
 {
     return true;
 }
@@ -42,3 +52,8 @@ bool CZMQAbstractNotifier::NotifyTransactionRemoval(const CTransaction &/*transa
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTemplate(const BinaryBlockTemplate &/*blocktemplate*/)
+{
+    return true;
+}
@@ -7,15 +7,42 @@
 
 #include <util/memory.h>
 
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+struct BinaryBlockTemplate;
+class CBlock;
 class CBlockIndex;
 class CTransaction;
 class CZMQAbstractNotifier;
 
 using CZMQNotifierFactory = std::unique_ptr<CZMQAbstractNotifier> (*)();
 
+/**
+ * Bodies of the messages published for one event. They are built on first
+ * use and shared by all notifiers publishing the event, so each is serialized
+ * once and sent on every socket without being copied.
+ */
+class CZMQPayloads
+{
+public:
+    using Payload = std::shared_ptr<const std::vector<unsigned char>>;
+    using Builder = std::function<bool(std::vector<Payload>& payloads)>;
+
+    /**
+     * Get the bodies of the messages published on topic, building them with
+     * build on first use. Returns nullptr if build failed.
+     */
+    const std::vector<Payload>* Get(const std::string& topic, const Builder& build);
+
+private:
+    //! Bodies by topic, and whether they could be built
+    std::map<std::string, std::pair<bool, std::vector<Payload>>> m_payloads;
+};
+
 class CZMQAbstractNotifier
 {
 public:
@@ -44,10 +71,11 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    // Notifies of ConnectTip result, i.e., new active tip only
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    // Notifies of ConnectTip result, i.e., new active tip only. block is
+    // nullptr if it isn't in memory anymore.
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads);
     // Notifies of every block connection
-    virtual bool NotifyBlockConnect(const CBlockIndex *pindex);
+    virtual bool NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads);
     // Notifies of every block disconnection
     virtual bool NotifyBlockDisconnect(const CBlockIndex *pindex);
     // Notifies of every mempool acceptance
@@ -55,7 +83,9 @@ public:
     // Notifies of every mempool removal, except inclusion in blocks
     virtual bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence);
     // Notifies of transactions added to mempool or appearing in blocks
-    virtual bool NotifyTransaction(const CTransaction &transaction);
+    virtual bool NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads);
+    // Notifies of new block templates
+    virtual bool NotifyBlockTemplate(const BinaryBlockTemplate &blocktemplate);
 
 protected:
     void *psocket;
@@ -37,6 +37,10 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
     factories["pubsequence"] = CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
+    factories["pubblocktemplate"] = CZMQAbstractNotifier::Create<CZMQPublishBlockTemplateNotifier>;
+    factories["pubrawmwebblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawMWEBBlockNotifier>;
+    factories["pubmwebkernel"] = CZMQAbstractNotifier::Create<CZMQPublishMWEBKernelNotifier>;
+    factories["pubmweboutput"] = CZMQAbstractNotifier::Create<CZMQPublishMWEBOutputNotifier>;
 
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
     for (const auto& entry : factories)
@@ -131,11 +135,18 @@ void TryForEachAndRemoveFailed(std::list<std::unique_ptr<CZMQAbstractNotifier>>&
 
 void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
+    // The new tip is normally the block that was just connected, which can then be published without reading it again
+    std::shared_ptr<const CBlock> block;
+    if (m_last_connected_index == pindexNew) block = std::move(m_last_connected_block);
+    m_last_connected_index = nullptr;
+    m_last_connected_block.reset();
+
     if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
         return;
 
-    TryForEachAndRemoveFailed(notifiers, [pindexNew](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyBlock(pindexNew);
+    CZMQPayloads payloads;
+    TryForEachAndRemoveFailed(notifiers, [pindexNew, &block, &payloads](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew, block, payloads);
     });
 }
 
@@ -143,8 +154,9 @@ void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef&
 {
     const CTransaction& tx = *ptx;
 
-    TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyTransaction(tx) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
+    CZMQPayloads payloads;
+    TryForEachAndRemoveFailed(notifiers, [&tx, mempool_sequence, &payloads](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(tx, payloads) && notifier->NotifyTransactionAcceptance(tx, mempool_sequence);
     });
 }
 
@@ -162,23 +174,30 @@ void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBloc
 {
     for (const CTransactionRef& ptx : pblock->vtx) {
         const CTransaction& tx = *ptx;
-        TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
-            return notifier->NotifyTransaction(tx);
+        CZMQPayloads payloads;
+        TryForEachAndRemoveFailed(notifiers, [&tx, &payloads](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyTransaction(tx, payloads);
         });
     }
 
     // Next we notify BlockConnect listeners for *all* blocks
-    TryForEachAndRemoveFailed(notifiers, [pindexConnected](CZMQAbstractNotifier* notifier) {
-        return notifier->NotifyBlockConnect(pindexConnected);
+    const CBlock& block = *pblock;
+    CZMQPayloads payloads;
+    TryForEachAndRemoveFailed(notifiers, [pindexConnected, &block, &payloads](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockConnect(pindexConnected, block, payloads);
     });
+
+    m_last_connected_index = pindexConnected;
+    m_last_connected_block = pblock;
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected)
 {
     for (const CTransactionRef& ptx : pblock->vtx) {
         const CTransaction& tx = *ptx;
-        TryForEachAndRemoveFailed(notifiers, [&tx](CZMQAbstractNotifier* notifier) {
-            return notifier->NotifyTransaction(tx);
+        CZMQPayloads payloads;
+        TryForEachAndRemoveFailed(notifiers, [&tx, &payloads](CZMQAbstractNotifier* notifier) {
+            return notifier->NotifyTransaction(tx, payloads);
         });
     }
 
@@ -188,4 +207,11 @@ void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CB
     });
 }
 
+void CZMQNotificationInterface::NotifyBlockTemplate(const BinaryBlockTemplate& blocktemplate)
+{
+    TryForEachAndRemoveFailed(notifiers, [&blocktemplate](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockTemplate(blocktemplate);
+    });
+}
+
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
@@ -9,6 +9,7 @@
 #include <list>
 #include <memory>
 
+struct BinaryBlockTemplate;
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
@@ -19,6 +20,9 @@ public:
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
 
+    /** Publish a new block template. Must be called from the scheduler thread, like the validation callbacks. */
+    void NotifyBlockTemplate(const BinaryBlockTemplate& blocktemplate);
+
     static CZMQNotificationInterface* Create();
 
 protected:
@@ -37,6 +41,11 @@ private:
 
     void *pcontext;
     std::list<std::unique_ptr<CZMQAbstractNotifier>> notifiers;
+
+    //! Last connected block, which is normally the new tip announced by the
+    //! following UpdatedBlockTip. Only accessed from the validation callbacks.
+    const CBlockIndex* m_last_connected_index{nullptr};
+    std::shared_ptr<const CBlock> m_last_connected_block;
 };
 
 extern CZMQNotificationInterface* g_zmq_notification_interface;
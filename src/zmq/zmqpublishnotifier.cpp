@@ -6,6 +6,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <node/blocktemplate.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <util/system.h>
@@ -27,6 +28,10 @@ static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
 static const char *MSG_SEQUENCE  = "sequence";
+static const char *MSG_BLOCKTEMPLATE = "blocktemplate";
+static const char *MSG_RAWMWEBBLOCK = "rawmwebblock";
+static const char *MSG_MWEBKERNEL = "mwebkernel";
+static const char *MSG_MWEBOUTPUT = "mweboutput";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -71,6 +76,33 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+// Called by ZMQ once it is done with the body of a message
+static void zmq_free_payload(void* /*data*/, void* hint)
+{
+    delete static_cast<CZMQPayloads::Payload*>(hint);
+}
+
+template <typename T>
+static CZMQPayloads::Payload SerializePayload(const T& obj, int version)
+{
+    auto payload = std::make_shared<std::vector<unsigned char>>();
+    CVectorWriter(SER_NETWORK, version, *payload, 0, obj);
+    return payload;
+}
+
+/** Get the block, reading it from disk if it isn't in memory anymore. Returns nullptr if it can't be read. */
+static std::shared_ptr<const CBlock> GetBlock(const CBlockIndex* pindex, const std::shared_ptr<const CBlock>& block)
+{
+    if (block) return block;
+    auto disk_block = std::make_shared<CBlock>();
+    LOCK(cs_main);
+    if (!ReadBlockFromDisk(*disk_block, pindex, Params().GetConsensus())) {
+        zmqError("Can't read block from disk");
+        return nullptr;
+    }
+    return disk_block;
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -177,7 +209,38 @@ bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const void
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQAbstractPublishNotifier::SendZmqMessage(const char *command, const CZMQPayloads::Payload& payload)
+{
+    assert(psocket);
+
+    /* same parts as above, with the body referencing the shared payload */
+    zmq_msg_t msg;
+    auto hint = new CZMQPayloads::Payload(payload);
+    int rc = zmq_msg_init_data(&msg, const_cast<unsigned char*>(payload->data()), payload->size(), zmq_free_payload, hint);
+    if (rc != 0) {
+        zmqError("Unable to initialize ZMQ msg");
+        delete hint;
+        return false;
+    }
+
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], nSequence);
+    if (zmq_send(psocket, command, strlen(command), ZMQ_SNDMORE) == -1 ||
+        zmq_msg_send(&msg, psocket, ZMQ_SNDMORE) == -1 ||
+        zmq_send(psocket, msgseq, sizeof(msgseq), 0) == -1) {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
+    }
+    zmq_msg_close(&msg);
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return true;
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*block*/, CZMQPayloads& /*payloads*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s to %s\n", hash.GetHex(), this->address);
@@ -187,7 +250,7 @@ bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
     return SendZmqMessage(MSG_HASHBLOCK, data, 32);
 }
 
-bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &transaction, CZMQPayloads& /*payloads*/)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashtx %s to %s\n", hash.GetHex(), this->address);
@@ -197,39 +260,106 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendZmqMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
+    const auto* bodies = payloads.Get(MSG_RAWBLOCK, [&](std::vector<CZMQPayloads::Payload>& out) {
+        const std::shared_ptr<const CBlock> pblock = GetBlock(pindex, block);
+        if (!pblock) return false;
+        out.push_back(SerializePayload(*pblock, PROTOCOL_VERSION | RPCSerializationFlags()));
+        return true;
+    });
+    return bodies && SendZmqMessage(MSG_RAWBLOCK, bodies->front());
+}
+
+bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads)
+{
+    uint256 hash = transaction.GetHash();
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s to %s\n", hash.GetHex(), this->address);
+    const auto* bodies = payloads.Get(MSG_RAWTX, [&](std::vector<CZMQPayloads::Payload>& out) {
+        out.push_back(SerializePayload(transaction, PROTOCOL_VERSION | RPCSerializationFlags()));
+        return true;
+    });
+    return SendZmqMessage(MSG_RAWTX, bodies->front());
+}
+
+bool CZMQPublishRawMWEBBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads)
+{
+    const auto* bodies = payloads.Get(MSG_RAWMWEBBLOCK, [&](std::vector<CZMQPayloads::Payload>& out) {
+        const std::shared_ptr<const CBlock> pblock = GetBlock(pindex, block);
+        if (!pblock) return false;
+        // Blocks without MWEB data aren't published
+        if (!pblock->mweb_block.IsNull()) {
+            out.push_back(SerializePayload(*pblock->mweb_block.m_block, PROTOCOL_VERSION));
         }
+        return true;
+    });
+    if (!bodies) return false;
+    if (bodies->empty()) return true;
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawmwebblock %s to %s\n", pindex->GetBlockHash().GetHex(), this->address);
+    return SendZmqMessage(MSG_RAWMWEBBLOCK, bodies->front());
+}
 
-        ss << block;
+/** Publish each item, e.g. each kernel of a block, in a message of its own */
+template <typename Item>
+static bool PublishEach(CZMQAbstractPublishNotifier& notifier, const char* command, const std::vector<Item>& items, CZMQPayloads& payloads)
+{
+    const auto* bodies = payloads.Get(command, [&](std::vector<CZMQPayloads::Payload>& out) {
+        for (const Item& item : items) {
+            out.push_back(SerializePayload(item, PROTOCOL_VERSION));
+        }
+        return true;
+    });
+    for (const CZMQPayloads::Payload& body : *bodies) {
+        if (!notifier.SendZmqMessage(command, body)) return false;
     }
+    return true;
+}
 
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+bool CZMQPublishMWEBKernelNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads)
+{
+    if (block.mweb_block.IsNull()) return true;
+    const std::vector<Kernel>& kernels = block.mweb_block.m_block->GetKernels();
+    LogPrint(BCLog::ZMQ, "zmq: Publish %u mwebkernel of block %s to %s\n", kernels.size(), pindex->GetBlockHash().GetHex(), this->address);
+    return PublishEach(*this, MSG_MWEBKERNEL, kernels, payloads);
 }
 
-bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
+bool CZMQPublishMWEBKernelNotifier::NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads)
 {
-    uint256 hash = transaction.GetHash();
-    LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s to %s\n", hash.GetHex(), this->address);
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    if (!transaction.HasMWEBTx()) return true;
+    const std::vector<Kernel>& kernels = transaction.mweb_tx.m_transaction->GetKernels();
+    LogPrint(BCLog::ZMQ, "zmq: Publish %u mwebkernel of tx %s to %s\n", kernels.size(), transaction.GetHash().GetHex(), this->address);
+    return PublishEach(*this, MSG_MWEBKERNEL, kernels, payloads);
+}
+
+bool CZMQPublishMWEBOutputNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads)
+{
+    if (block.mweb_block.IsNull()) return true;
+    const std::vector<Output>& outputs = block.mweb_block.m_block->GetOutputs();
+    LogPrint(BCLog::ZMQ, "zmq: Publish %u mweboutput of block %s to %s\n", outputs.size(), pindex->GetBlockHash().GetHex(), this->address);
+    return PublishEach(*this, MSG_MWEBOUTPUT, outputs, payloads);
+}
+
+bool CZMQPublishMWEBOutputNotifier::NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads)
+{
+    if (!transaction.HasMWEBTx()) return true;
+    const std::vector<Output>& outputs = transaction.mweb_tx.m_transaction->GetOutputs();
+    LogPrint(BCLog::ZMQ, "zmq: Publish %u mweboutput of tx %s to %s\n", outputs.size(), transaction.GetHash().GetHex(), this->address);
+    return PublishEach(*this, MSG_MWEBOUTPUT, outputs, payloads);
+}
+
+bool CZMQPublishBlockTemplateNotifier::NotifyBlockTemplate(const BinaryBlockTemplate &blocktemplate)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish blocktemplate %u on %s to %s\n", blocktemplate.id, blocktemplate.prev_hash.GetHex(), this->address);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << blocktemplate;
+    return SendZmqMessage(MSG_BLOCKTEMPLATE, &(*ss.begin()), ss.size());
 }
 
 
 // TODO: Dedup this code to take label char, log string
-bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex)
+bool CZMQPublishSequenceNotifier::NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& /*block*/, CZMQPayloads& /*payloads*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish sequence block connect %s to %s\n", hash.GetHex(), this->address);
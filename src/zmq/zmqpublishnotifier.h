@@ -23,6 +23,8 @@ public:
           * message sequence number
     */
     bool SendZmqMessage(const char *command, const void* data, size_t size);
+    /* send zmq multipart message with a shared body, without copying it */
+    bool SendZmqMessage(const char *command, const CZMQPayloads::Payload& payload);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -31,31 +33,57 @@ public:
 class CZMQPublishHashBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads) override;
 };
 
 class CZMQPublishHashTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads) override;
 };
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlock(const CBlockIndex *pindex) override;
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyTransaction(const CTransaction &transaction) override;
+    bool NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads) override;
+};
+
+class CZMQPublishRawMWEBBlockNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block, CZMQPayloads& payloads) override;
+};
+
+class CZMQPublishMWEBKernelNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads) override;
+    bool NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads) override;
+};
+
+class CZMQPublishMWEBOutputNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads) override;
+    bool NotifyTransaction(const CTransaction &transaction, CZMQPayloads& payloads) override;
+};
+
+class CZMQPublishBlockTemplateNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTemplate(const BinaryBlockTemplate &blocktemplate) override;
 };
 
 class CZMQPublishSequenceNotifier : public CZMQAbstractPublishNotifier
 {
 public:
-    bool NotifyBlockConnect(const CBlockIndex *pindex) override;
+    bool NotifyBlockConnect(const CBlockIndex *pindex, const CBlock& block, CZMQPayloads& payloads) override;
     bool NotifyBlockDisconnect(const CBlockIndex *pindex) override;
     bool NotifyTransactionAcceptance(const CTransaction &transaction, uint64_t mempool_sequence) override;
     bool NotifyTransactionRemoval(const CTransaction &transaction, uint64_t mempool_sequence) override;
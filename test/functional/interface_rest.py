@@ -49,7 +49,7 @@ class RESTTest (BitcoinTestFramework):
     def skip_test_if_missing_module(self):
         self.skip_if_no_wallet()
 
-    def test_rest_request(self, uri, http_method='GET', req_type=ReqType.JSON, body='', status=200, ret_type=RetType.JSON):
+    def test_rest_request(self, uri, http_method='GET', req_type=ReqType.JSON, body='', status=200, ret_type=RetType.JSON, headers={}):
         rest_uri = '/rest' + uri
         if req_type == ReqType.JSON:
             rest_uri += '.json'
@@ -61,7 +61,7 @@ class RESTTest (BitcoinTestFramework):
         conn = http.client.HTTPConnection(self.url.hostname, self.url.port)
         self.log.debug('%s %s %s', http_method, rest_uri, body)
         if http_method == 'GET':
-            conn.request('GET', rest_uri)
+            conn.request('GET', rest_uri, headers=headers)
         elif http_method == 'POST':
             conn.request('POST', rest_uri, body)
         resp = conn.getresponse()
@@ -281,6 +281,43 @@ class RESTTest (BitcoinTestFramework):
         json_obj = self.test_rest_request("/headers/5/{}".format(bb_hash))
         assert_equal(len(json_obj), 5)  # now we should have 5 header objects
 
+        self.log.info("Test the /block/raw and /blocks/raw URIs")
+        # Raw blocks are served as stored, with witness and MWEB data
+        response = self.test_rest_request("/block/raw/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ)
+        raw_block = response.read()
+        assert_equal(raw_block.hex(), self.nodes[0].getblock(bb_hash, 0))
+        assert_equal(response.getheader('cache-control'), 'max-age=31536000, immutable')
+        etag = response.getheader('etag')
+        response_hex = self.test_rest_request("/block/raw/{}".format(bb_hash), req_type=ReqType.HEX, ret_type=RetType.OBJ)
+        assert_equal(response_hex.read().strip(b'\n'), binascii.hexlify(raw_block))
+        assert response_hex.getheader('etag') != etag
+
+        # Conditional requests are answered without the block
+        response = self.test_rest_request("/block/raw/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=304, headers={'If-None-Match': etag})
+        assert_equal(response.read(), b'')
+        self.test_rest_request("/block/raw/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, headers={'If-None-Match': '"other"'})
+
+        # Stripped variants
+        for variant in ['nomweb', 'nowitness']:
+            response_bytes = self.test_rest_request("/block/raw/{}/{}".format(variant, bb_hash), req_type=ReqType.BIN, ret_type=RetType.BYTES)
+            assert_equal(response_bytes[:BLOCK_HEADER_SIZE], raw_block[:BLOCK_HEADER_SIZE])
+            assert_greater_than_or_equal(len(raw_block), len(response_bytes))
+        self.test_rest_request("/block/raw/other/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400)
+        self.test_rest_request("/block/raw/{}".format(bb_hash), ret_type=RetType.OBJ, status=404)
+
+        # Consecutive blocks are concatenated
+        bb_height = self.nodes[0].getblock(bb_hash)['height']
+        response = self.test_rest_request("/blocks/raw/6/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ)
+        assert_equal(response.getheader('cache-control'), 'no-cache')
+        expected = ''.join(self.nodes[0].getblock(self.nodes[0].getblockhash(bb_height + i), 0) for i in range(6))
+        assert_equal(response.read().hex(), expected)
+        self.test_rest_request("/blocks/raw/6/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=304, headers={'If-None-Match': response.getheader('etag')})
+        # The range ends at the tip
+        response_bytes = self.test_rest_request("/blocks/raw/100/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.BYTES)
+        assert_equal(response_bytes.hex(), expected)
+        self.test_rest_request("/blocks/raw/0/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400)
+        self.test_rest_request("/blocks/raw/1001/{}".format(bb_hash), req_type=ReqType.BIN, ret_type=RetType.OBJ, status=400)
+
         self.log.info("Test tx inclusion in the /mempool and /block URIs")
 
         # Make 3 tx and mine them on node 1
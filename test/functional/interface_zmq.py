@@ -7,10 +7,12 @@ import struct
 
 from test_framework.address import ADDRESS_BCRT1_UNSPENDABLE, ADDRESS_BCRT1_P2WSH_OP_TRUE
 from test_framework.blocktools import create_block, create_coinbase, add_witness_commitment
+from test_framework.ltc_util import FIRST_MWEB_HEIGHT
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.messages import CTransaction, hash256, FromHex
 from test_framework.util import (
     assert_equal,
+    assert_raises,
     assert_raises_rpc_error,
 )
 from io import BytesIO
@@ -79,6 +81,7 @@ class ZMQTest (BitcoinTestFramework):
             self.test_mempool_sync()
             self.test_reorg()
             self.test_multiple_interfaces()
+            self.test_mweb()
         finally:
             # Destroy the ZMQ context.
             self.log.debug("Destroying ZMQ context")
@@ -533,5 +536,56 @@ class ZMQTest (BitcoinTestFramework):
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[0]['hashblock'].receive().hex())
         assert_equal(self.nodes[0].getbestblockhash(), subscribers[1]['hashblock'].receive().hex())
 
+    def test_mweb(self):
+        if not self.is_wallet_compiled():
+            self.log.info("Skipping MWEB test because wallet is disabled")
+            return
+
+        self.log.info("Testing the MWEB notifications")
+        address = 'tcp://127.0.0.1:28336'
+        sockets = []
+        subs = []
+        for service in [b"rawmwebblock", b"mwebkernel", b"mweboutput"]:
+            sockets.append(self.ctx.socket(zmq.SUB))
+            sockets[-1].set(zmq.RCVTIMEO, 60000)
+            subs.append(ZMQSubscriber(sockets[-1], service))
+        rawmwebblock, mwebkernel, mweboutput = subs
+
+        self.restart_node(0, ["-zmqpub%s=%s" % (sub.topic.decode(), address) for sub in subs])
+        for socket in sockets:
+            socket.connect(address)
+
+        # Relax so that the subscriber is ready before publishing zmq messages
+        sleep(0.2)
+
+        # Blocks without an MWEB publish nothing
+        node = self.nodes[0]
+        node.generate(FIRST_MWEB_HEIGHT - 1 - node.getblockcount())
+
+        self.log.info("Pegin and the first MWEB block publish the same kernels and outputs")
+        node.sendtoaddress(node.getnewaddress(address_type='mweb'), 1)
+        blockhash = node.generate(1)[0]
+        block = node.getblock(blockhash)
+        num_kernels = len(block['mweb']['kernels'])
+        num_outputs = len(block['mweb']['outputs'])
+        assert num_kernels > 0 and num_outputs > 0
+
+        # The pegin is the only MWEB transaction, so the mempool messages
+        # carry the same items as the block messages that follow them.
+        mempool_kernels = [mwebkernel.receive() for _ in range(num_kernels)]
+        block_kernels = [mwebkernel.receive() for _ in range(num_kernels)]
+        assert_equal(sorted(mempool_kernels), sorted(block_kernels))
+        mempool_outputs = [mweboutput.receive() for _ in range(num_outputs)]
+        block_outputs = [mweboutput.receive() for _ in range(num_outputs)]
+        assert_equal(sorted(mempool_outputs), sorted(block_outputs))
+
+        # Only the MWEB block publishes its MWEB data
+        assert len(rawmwebblock.receive()) > 0
+
+        # Nothing else was published
+        for socket in sockets:
+            socket.set(zmq.RCVTIMEO, 1000)
+            assert_raises(zmq.error.Again, socket.recv)
+
 if __name__ == '__main__':
     ZMQTest().main()
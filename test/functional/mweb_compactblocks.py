@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Litecoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test compact block relay of MWEB blocks using kernel short IDs (cmpctblock version 4).
+
+1. MWEB transactions already in the receiver's mempool are used to rebuild the MWEB block
+2. MWEB transactions missing from the receiver's mempool are requested with getblocktxn
+"""
+
+from decimal import Decimal
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.ltc_util import setup_mweb_chain
+from test_framework.util import assert_equal
+
+class MWEBCompactBlocksTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.extra_args = [['-whitelist=noban@127.0.0.1']] * 2  # immediate tx relay
+        self.num_nodes = 2
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def sync_handshake(self):
+        # Pings are answered in order, so once they are, sendcmpct has been processed as well.
+        for node in self.nodes:
+            node.ping()
+        self.wait_until(lambda: all('pingwait' not in peer for node in self.nodes for peer in node.getpeerinfo()))
+
+    def run_test(self):
+        node0 = self.nodes[0]
+        node1 = self.nodes[1]
+
+        self.log.info("Setup MWEB chain")
+        setup_mweb_chain(node0)
+        self.sync_all()
+
+        self.log.info("Relay an MWEB block whose transactions are in the receiver's mempool")
+        node0.sendtoaddress(node1.getnewaddress(address_type='mweb'), 0.5)
+        self.sync_mempools()
+        assert_equal(len(node1.getrawmempool()), 1)
+        with node1.assert_debug_log(expected_msgs=["kernels from mempool, 0 MWEB txn requested"]):
+            node0.generate(1)
+            self.sync_blocks()
+        assert_equal(node1.getrawmempool(), [])
+
+        self.log.info("Relay an MWEB block whose transactions are missing from the receiver's mempool")
+        self.disconnect_nodes(0, 1)
+        node0.sendtoaddress(node1.getnewaddress(address_type='mweb'), 0.2)
+        assert_equal(len(node0.getrawmempool()), 1)
+        self.connect_nodes(0, 1)
+        self.sync_handshake()
+        assert_equal(node1.getrawmempool(), [])
+        with node1.assert_debug_log(expected_msgs=["kernels from mempool, 1 MWEB txn requested"]):
+            node0.generate(1)
+            self.sync_blocks()
+
+        self.log.info("Check the receiver's MWEB balance")
+        self.sync_all()
+        assert_equal(node0.getbestblockhash(), node1.getbestblockhash())
+        mweb_utxos = [x for x in node1.listunspent() if x['address'].startswith('tmweb')]
+        assert_equal(sorted(x['amount'] for x in mweb_utxos), [Decimal('0.2'), Decimal('0.5')])
+
+if __name__ == '__main__':
+    MWEBCompactBlocksTest().main()
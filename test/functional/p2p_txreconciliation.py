@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Litecoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test transaction relay by set reconciliation (-txreconciliation).
+
+1. Relay transactions through a fully connected network by flooding and
+   measure the bytes spent announcing them.
+2. Restart the nodes with -txreconciliation and check that relaying the same
+   number of transactions costs less.
+3. Check that MWEB-only transactions, which are reconciled by kernel ID,
+   propagate as well.
+"""
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.ltc_util import setup_mweb_chain
+from test_framework.util import assert_equal, assert_greater_than
+
+NUM_NODES = 5
+TXS_PER_NODE = 20
+# Messages used to announce transactions, in either relay mode
+ANNOUNCEMENT_MSGS = ['inv', 'sendtxrcncl', 'reqrecon', 'sketch', 'reconcildiff']
+
+
+class TxReconciliationTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = NUM_NODES
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def setup_network(self):
+        self.setup_nodes()
+        self.connect_mesh()
+
+    def connect_mesh(self):
+        for a in range(self.num_nodes):
+            for b in range(a + 1, self.num_nodes):
+                self.connect_nodes(a, b)
+        self.sync_all()
+
+    def announcement_bytes(self):
+        total = 0
+        for node in self.nodes:
+            for peer in node.getpeerinfo():
+                total += sum(peer['bytessent_per_msg'].get(msg, 0) for msg in ANNOUNCEMENT_MSGS)
+        return total
+
+    def relay_transactions(self):
+        """Send TXS_PER_NODE transactions from every node and return the bytes spent announcing them."""
+        before = self.announcement_bytes()
+        addresses = [node.getnewaddress() for node in self.nodes]
+        for i, node in enumerate(self.nodes):
+            for j in range(TXS_PER_NODE):
+                node.sendtoaddress(addresses[(i + j + 1) % self.num_nodes], 0.1)
+        self.sync_mempools(timeout=120)
+        assert_equal(len(self.nodes[0].getrawmempool()), NUM_NODES * TXS_PER_NODE)
+        # Mine the transactions so they are not reconciled again after the restart
+        self.nodes[0].generate(1)
+        self.sync_all()
+        return self.announcement_bytes() - before
+
+    def run_test(self):
+        self.log.info("Activate MWEB and fund all nodes")
+        setup_mweb_chain(self.nodes[0])
+        for node in self.nodes[1:]:
+            for _ in range(TXS_PER_NODE):
+                self.nodes[0].sendtoaddress(node.getnewaddress(), 1)
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        self.log.info("Relay transactions by flooding")
+        flood_bytes = self.relay_transactions()
+        self.log.info("Announcement bytes when flooding: {}".format(flood_bytes))
+
+        self.log.info("Restart the nodes with -txreconciliation")
+        for i in range(self.num_nodes):
+            self.restart_node(i, extra_args=['-txreconciliation'])
+        self.connect_mesh()
+        for node in self.nodes:
+            for peer in node.getpeerinfo():
+                assert 'sendtxrcncl' in peer['bytessent_per_msg']
+                assert 'sendtxrcncl' in peer['bytesrecv_per_msg']
+
+        self.log.info("Relay transactions by reconciliation")
+        recon_bytes = self.relay_transactions()
+        self.log.info("Announcement bytes when reconciling: {}".format(recon_bytes))
+        for node in self.nodes:
+            for peer in node.getpeerinfo():
+                # Reconciliations are initiated by the side of the outbound connection
+                assert 'reqrecon' in peer['bytessent_per_msg' if not peer['inbound'] else 'bytesrecv_per_msg']
+        assert_greater_than(flood_bytes, recon_bytes)
+
+        self.log.info("Relay an MWEB-only transaction, identified by its kernel ID")
+        # A wallet with nothing but MWEB coins, so that it can't add canonical inputs
+        self.nodes[1].createwallet(wallet_name='mweb_only')
+        mweb_wallet = self.nodes[1].get_wallet_rpc('mweb_only')
+        self.nodes[0].sendtoaddress(mweb_wallet.getnewaddress(address_type='mweb'), 10)
+        self.nodes[0].generate(1)
+        self.sync_all()
+        mweb_txid = mweb_wallet.sendtoaddress(self.nodes[2].getnewaddress(address_type='mweb'), 5)
+        mweb_tx = mweb_wallet.getrawtransaction(mweb_txid, True)
+        assert_equal(len(mweb_tx['vin']), 0)
+        assert_equal(len(mweb_tx['vout']), 0)
+        self.sync_mempools()
+        for node in self.nodes:
+            assert_equal(node.getrawmempool(), [mweb_txid])
+
+
+if __name__ == '__main__':
+    TxReconciliationTest().main()
@@ -43,6 +43,22 @@ class RpcMiscTest(BitcoinTestFramework):
         assert_greater_than(memory['chunks_free'], 0)
         assert_equal(memory['used'] + memory['free'], memory['total'])
 
+        self.log.info("test getmemoryinfo leveldb stats")
+        leveldb = node.getmemoryinfo()['leveldb']
+        assert_equal(leveldb['chainstate']['profile'], 'default')
+        assert_greater_than(leveldb['chainstate']['memory_usage'], 0)
+        assert_equal(leveldb['chainstate']['table_caches'], {})
+        assert_equal(leveldb['blockindex']['table_caches'], {})
+
+        self.restart_node(0, self.extra_args[0] + ["-dbprofile=readheavy"])
+        leveldb = node.getmemoryinfo()['leveldb']
+        assert_equal(leveldb['chainstate']['profile'], 'readheavy')
+        mweb_cache = leveldb['chainstate']['table_caches']['mweb']
+        assert_greater_than(mweb_cache['max_usage'], 0)
+        assert_greater_than_or_equal(mweb_cache['max_usage'], mweb_cache['usage'])
+        assert_equal(leveldb['blockindex']['table_caches'], {})
+        self.restart_node(0, self.extra_args[0])
+
         self.log.info("test mallocinfo")
         try:
             mallocinfo = node.getmemoryinfo(mode="mallocinfo")
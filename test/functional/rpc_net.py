@@ -61,6 +61,7 @@ class NetTest(BitcoinTestFramework):
         self.test_connection_count()
         self.test_getpeerinfo()
         self.test_getnettotals()
+        self.test_getnetmsgstats()
         self.test_getnetworkinfo()
         self.test_getaddednodeinfo()
         self.test_service_flags()
@@ -118,6 +119,40 @@ class NetTest(BitcoinTestFramework):
             self.wait_until(lambda: peer_after()['bytesrecv_per_msg'].get('pong', 0) >= peer_before['bytesrecv_per_msg'].get('pong', 0) + 32, timeout=1)
             self.wait_until(lambda: peer_after()['bytessent_per_msg'].get('ping', 0) >= peer_before['bytessent_per_msg'].get('ping', 0) + 32, timeout=1)
 
+        # The pong payloads were received into pooled buffers, and buffers are reused across messages
+        recv_buffers = self.nodes[0].getnettotals()['recvbuffers']
+        assert recv_buffers['bytes_received'] >= net_totals_before['recvbuffers']['bytes_received'] + 8 * 2
+        assert recv_buffers['reuses'] > 0
+        send_calls = self.nodes[0].getnettotals()['sendcalls']
+        assert send_calls['calls'] > net_totals_before['sendcalls']['calls']
+        assert send_calls['bytes_per_call'] > 0
+        assert_equal(send_calls['zerocopy_bytes'], 0)
+
+    def test_getnetmsgstats(self):
+        self.log.info("Test getnetmsgstats")
+        peer_id = self.nodes[0].getpeerinfo()[0]['id']
+        pongs_before = self.nodes[0].getnetmsgstats(peer_id)['pong']['count']
+        self.nodes[0].ping()
+        self.wait_until(lambda: self.nodes[0].getnetmsgstats(peer_id)['pong']['count'] == pongs_before + 1, timeout=5)
+
+        stats = self.nodes[0].getnetmsgstats()
+        peer_stats = self.nodes[0].getnetmsgstats(peer_id)
+        for msg in ['version', 'verack', 'getheaders', 'ping', 'pong']:
+            assert_greater_than(stats[msg]['count'], 0)
+            assert stats[msg]['count'] >= peer_stats[msg]['count']
+        pong = peer_stats['pong']
+        # A pong carries the 8 byte nonce
+        assert_equal(pong['size']['total'], 8 * pong['count'])
+        assert_equal(pong['size']['max'], 8)
+        assert_equal(pong['size']['p50'], 8)
+        assert_equal(sum(pong['size']['buckets']), pong['count'])
+        for histogram in ['processing_time', 'cs_main_wait']:
+            assert_equal(sum(pong[histogram]['buckets']), pong['count'])
+            assert pong[histogram]['p50'] <= pong[histogram]['p99'] <= pong[histogram]['max']
+        assert pong['cs_main_wait']['total'] <= pong['processing_time']['total']
+
+        assert_raises_rpc_error(-29, "Node not found in connected nodes", self.nodes[0].getnetmsgstats, 1000)
+
     def test_getnetworkinfo(self):
         self.log.info("Test getnetworkinfo")
         info = self.nodes[0].getnetworkinfo()
@@ -125,6 +160,11 @@ class NetTest(BitcoinTestFramework):
         assert_equal(info['connections'], 2)
         assert_equal(info['connections_in'], 1)
         assert_equal(info['connections_out'], 1)
+        # Peers are sharded over the default two message handler threads
+        assert_equal([t['thread'] for t in info['messagehandlers']], [0, 1])
+        assert_equal(sum(t['peers'] for t in info['messagehandlers']), 2)
+        for t in info['messagehandlers']:
+            assert 0 <= t['utilization'] <= 1
 
         with self.nodes[0].assert_debug_log(expected_msgs=['SetNetworkActive: false\n']):
             self.nodes[0].setnetworkactive(state=False)
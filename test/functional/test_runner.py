@@ -107,6 +107,7 @@ BASE_SCRIPTS = [
     'p2p_segwit.py',
     'p2p_timeouts.py',
     'p2p_tx_download.py',
+    'p2p_txreconciliation.py',
     'mempool_updatefromblock.py',
     'wallet_dump.py --legacy-wallet',
     'wallet_listtransactions.py',
@@ -184,6 +185,7 @@ BASE_SCRIPTS = [
     'wallet_keypool.py',
     'wallet_keypool.py --descriptors',
     'wallet_descriptor.py --descriptors',
+    'wallet_fast_rescan.py',
     'p2p_nobloomfilter_messages.py',
     'p2p_filter.py',
     'rpc_setban.py',
@@ -249,6 +251,7 @@ BASE_SCRIPTS = [
     'mweb_mining.py',
     'mweb_reorg.py',
     'mweb_p2p.py',
+    'mweb_compactblocks.py',
     'mweb_pegout_all.py',
     'mweb_node_compatibility.py',
     'mweb_wallet_address.py',
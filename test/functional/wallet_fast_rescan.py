@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 The Litecoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that rescans using block filters find the same transactions as full rescans.
+
+Node 0 runs with -blockfilterindex, so descriptor wallet rescans skip blocks
+whose filter doesn't match any of the wallet's scripts. Node 1 has no filter
+index and inspects every block.
+"""
+import os
+import shutil
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+
+NUM_DESCRIPTOR_TXS = 10
+NUM_EMPTY_BLOCKS = 20
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.extra_args = [['-blockfilterindex=1'], []]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+        self.skip_if_no_sqlite()
+
+    def restore_wallet(self, node, backup_file, wallet_name):
+        wallet_dir = os.path.join(node.datadir, self.chain, 'wallets', wallet_name)
+        os.mkdir(wallet_dir)
+        shutil.copyfile(backup_file, os.path.join(wallet_dir, 'wallet.dat'))
+        node.loadwallet(wallet_name)
+        return node.get_wallet_rpc(wallet_name)
+
+    def get_wallet_txids(self, wallet):
+        return sorted(tx['txid'] for tx in wallet.listtransactions(count=1000))
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.createwallet(wallet_name='funder', descriptors=True)
+        funder = node.get_wallet_rpc('funder')
+        node.createwallet(wallet_name='w', descriptors=True)
+        w = node.get_wallet_rpc('w')
+
+        self.log.info("Back up the wallet before it receives any transactions")
+        backup_file = os.path.join(self.options.tmpdir, 'w.bak')
+        w.backupwallet(backup_file)
+
+        self.log.info("Create transactions to the wallet, interleaved with unrelated blocks")
+        node.generatetoaddress(101, funder.getnewaddress())
+        for i in range(NUM_DESCRIPTOR_TXS):
+            address_type = 'bech32' if i % 2 == 0 else 'p2sh-segwit'
+            funder.sendtoaddress(w.getnewaddress(address_type=address_type), 1)
+            node.generatetoaddress(1, funder.getnewaddress())
+            node.generatetoaddress(NUM_EMPTY_BLOCKS // NUM_DESCRIPTOR_TXS, funder.getnewaddress())
+        self.sync_blocks()
+        self.wait_until(lambda: node.getindexinfo()['basic block filter index']['synced'])
+        expected_txids = self.get_wallet_txids(w)
+        assert_equal(len(expected_txids), NUM_DESCRIPTOR_TXS)
+
+        self.log.info("Restore the backup with block filters, which rescans the missed blocks")
+        with node.assert_debug_log(['fast variant using block filters']):
+            w_fast = self.restore_wallet(node, backup_file, 'w_fast')
+        assert_equal(self.get_wallet_txids(w_fast), expected_txids)
+        assert_equal(w_fast.getbalance(), w.getbalance())
+
+        self.log.info("Restore the backup without block filters")
+        with self.nodes[1].assert_debug_log(['slow variant inspecting all blocks']):
+            w_slow = self.restore_wallet(self.nodes[1], backup_file, 'w_slow')
+        assert_equal(self.get_wallet_txids(w_slow), expected_txids)
+
+        self.log.info("Rescan the whole chain using block filters")
+        with node.assert_debug_log(['fast variant using block filters']):
+            w_fast.rescanblockchain()
+        assert_equal(self.get_wallet_txids(w_fast), expected_txids)
+
+
+if __name__ == '__main__':
+    WalletFastRescanTest().main()